@@ -0,0 +1,24 @@
+#pragma once
+
+// File sink used by SDCard. SdFat on the device, a directory on disk on the host (see Native/SimFileSystem.h)
+#ifdef ARDUINO
+
+class SdFat;
+class SdFile;
+class SdSpiCard;
+
+typedef SdFat FileSystem;
+typedef SdFile FileSink;
+typedef SdSpiCard BlockDevice;      // Raw block writes to the card
+
+#else
+
+class SimFileSystem;
+class SimFile;
+class SimSdCard;
+
+typedef SimFileSystem FileSystem;
+typedef SimFile FileSink;
+typedef SimSdCard BlockDevice;
+
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+
+// Thin hardware layer. Drivers talk to I2CBus/SPIBus and use the Arduino clock and GPIO functions
+// (micros, delay, digitalWrite...). On the device that's the Arduino core, on the host (native env)
+// it's the simulation in Native/ with the same API
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <SPI.h>
+
+#else
+
+#include "Native/NativeCore.h"
+#include "Native/SimBus.h"
+
+#endif
+
+#include "HALTypes.h"
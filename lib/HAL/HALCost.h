@@ -0,0 +1,16 @@
+#pragma once
+
+// Marks math the AVR does in software (float, 64 bit) so the native env charges its time (Native/SimTiming.h).
+// The firmware charges it where it calls the shared code (see LoggerApp), integer work isn't charged.
+// HAL_COST(FloatMul, 3) compiles to nothing on the device
+#ifdef ARDUINO
+
+#define HAL_COST(op, count) ((void)(count))
+
+#else
+
+#include "Native/SimTiming.h"
+
+#define HAL_COST(op, count) SimTiming::ChargeOps(SimOp::op, count)
+
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+// Forward declarations of the bus types, for headers that only hold a pointer (HAL.h has the definitions)
+#ifdef ARDUINO
+
+class TwoWire;
+class SPIClass;
+
+typedef TwoWire I2CBus;
+typedef SPIClass SPIBus;
+
+#else
+
+class SimI2CBus;
+class SimSPIBus;
+
+typedef SimI2CBus I2CBus;
+typedef SimSPIBus SPIBus;
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef ARDUINO
+
+#include "NativeCore.h"
+
+#include <stdio.h>
+
+SimSerial Serial;
+
+uint32_t micros()
+{
+    return (uint32_t)SimClock::GetTime();
+}
+
+uint32_t millis()
+{
+    return (uint32_t)(SimClock::GetTime() / 1000u);
+}
+
+void delay(uint32_t ms)
+{
+    SimTiming::Charge(SimCost::Delay, (uint64_t)ms * 1000u);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    SimTiming::Charge(SimCost::Delay, us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    SimGPIO::SetMode(pin, mode);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    SimGPIO::Write(pin, value == LOW ? LOW : HIGH);
+}
+
+int digitalRead(uint8_t pin)
+{
+    return SimGPIO::Read(pin);
+}
+
+void SimSerial::begin(unsigned long /*baud*/)
+{
+}
+
+SimSerial::operator bool()const
+{
+    return true;
+}
+
+size_t SimSerial::write(uint8_t value)
+{
+    return fputc(value, stdout) == EOF ? 0 : 1;
+}
+
+size_t SimSerial::write(const uint8_t* buffer, size_t size)
+{
+    return fwrite(buffer, 1, size, stdout);
+}
+
+#endif
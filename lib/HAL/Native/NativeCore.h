@@ -0,0 +1,63 @@
+#pragma once
+
+// The part of the Arduino core the project uses, for the native env. Time is virtual (see SimClock)
+// and pins go to SimGPIO
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+
+#include "Print.h"
+#include "SimClock.h"
+#include "SimTiming.h"
+#include "SimGPIO.h"
+
+#define LOW  0x0
+#define HIGH 0x1
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define LED_BUILTIN 13
+
+// Arduino has them as macros, the std ones are enough for how we use them (same types)
+using std::min;
+using std::max;
+
+uint32_t micros();
+
+uint32_t millis();
+
+void delay(uint32_t ms);
+
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+
+void digitalWrite(uint8_t pin, uint8_t value);
+
+int digitalRead(uint8_t pin);
+
+// Serial goes to stdout
+class SimSerial : public Print
+{
+public:
+    void begin(unsigned long baud);
+
+    operator bool()const;
+
+    size_t write(uint8_t value) override;
+
+    size_t write(const uint8_t* buffer, size_t size) override;
+
+    using Print::write;
+};
+
+extern SimSerial Serial;
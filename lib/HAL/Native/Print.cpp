@@ -0,0 +1,215 @@
+#ifndef ARDUINO
+
+#include "Print.h"
+
+#include "HALCost.h"
+
+#include <math.h>
+#include <string.h>
+
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+    size_t written = 0;
+    while(size-- > 0)
+    {
+        written += write(*buffer++);
+    }
+    return written;
+}
+
+size_t Print::write(const char* str)
+{
+    return str ? write((const uint8_t*)str, strlen(str)) : 0;
+}
+
+size_t Print::print(const __FlashStringHelper* str)
+{
+    return write(reinterpret_cast<const char*>(str));
+}
+
+size_t Print::print(const char* str)
+{
+    return write(str);
+}
+
+size_t Print::print(char value)
+{
+    return write((uint8_t)value);
+}
+
+size_t Print::print(unsigned char value, int base /*= DEC*/)
+{
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(int value, int base /*= DEC*/)
+{
+    return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base /*= DEC*/)
+{
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base /*= DEC*/)
+{
+    if(base == 0)
+    {
+        return write((uint8_t)value);
+    }
+    if(base == DEC && value < 0)
+    {
+        return print('-') + PrintNumber((unsigned long)-value, DEC);
+    }
+    return PrintNumber((unsigned long)value, (uint8_t)base);
+}
+
+size_t Print::print(unsigned long value, int base /*= DEC*/)
+{
+    if(base == 0)
+    {
+        return write((uint8_t)value);
+    }
+    return PrintNumber(value, (uint8_t)base);
+}
+
+size_t Print::print(double value, int digits /*= 2*/)
+{
+    return PrintFloat(value, (uint8_t)digits);
+}
+
+size_t Print::println()
+{
+    return write((const uint8_t*)"\r\n", 2);
+}
+
+size_t Print::println(const __FlashStringHelper* str)
+{
+    return print(str) + println();
+}
+
+size_t Print::println(const char* str)
+{
+    return print(str) + println();
+}
+
+size_t Print::println(char value)
+{
+    return print(value) + println();
+}
+
+size_t Print::println(unsigned char value, int base /*= DEC*/)
+{
+    return print(value, base) + println();
+}
+
+size_t Print::println(int value, int base /*= DEC*/)
+{
+    return print(value, base) + println();
+}
+
+size_t Print::println(unsigned int value, int base /*= DEC*/)
+{
+    return print(value, base) + println();
+}
+
+size_t Print::println(long value, int base /*= DEC*/)
+{
+    return print(value, base) + println();
+}
+
+size_t Print::println(unsigned long value, int base /*= DEC*/)
+{
+    return print(value, base) + println();
+}
+
+size_t Print::println(double value, int digits /*= 2*/)
+{
+    return print(value, digits) + println();
+}
+
+size_t Print::PrintNumber(unsigned long value, uint8_t base)
+{
+    // Most significant digit last, a 64 bit value in base 2 is the worst case
+    char buffer[8 * sizeof(unsigned long) + 1];
+    char* str = &buffer[sizeof(buffer) - 1];
+    *str = '\0';
+
+    if(base < 2)
+    {
+        base = 10;
+    }
+
+    do
+    {
+        HAL_COST(Int32Div, 1); // avr-libc gets the quotient and the remainder at once
+        const char digit = (char)(value % base);
+        value /= base;
+        *--str = digit < 10 ? digit + '0' : digit + 'A' - 10;
+    } while(value > 0);
+
+    return write(str);
+}
+
+size_t Print::PrintFloat(double value, uint8_t digits)
+{
+    // Same algorithm as the Arduino core. double is a float on the AVR, do the math in float so
+    // the digits come out the same
+    float number = (float)value;
+    if(isnan(number))
+    {
+        return print("nan");
+    }
+    if(isinf(number))
+    {
+        return print("inf");
+    }
+    if(number > 4294967040.0f || number < -4294967040.0f)
+    {
+        return print("ovf");
+    }
+
+    size_t written = 0;
+    if(number < 0.0f)
+    {
+        written += print('-');
+        number = -number;
+    }
+
+    float rounding = 0.5f;
+    for(uint8_t digit = 0; digit < digits; ++digit)
+    {
+        rounding /= 10.0f;
+    }
+    number += rounding;
+    HAL_COST(FloatDiv, digits);
+    HAL_COST(FloatAdd, 2);
+    HAL_COST(FloatToInt, 1);
+    HAL_COST(IntToFloat, 1);
+
+    const uint32_t intPart = (uint32_t)number;
+    float remainder = number - (float)intPart;
+    written += print((unsigned long)intPart);
+
+    if(digits > 0)
+    {
+        written += print('.');
+    }
+
+    while(digits-- > 0)
+    {
+        remainder *= 10.0f;
+        HAL_COST(FloatMul, 1);
+        HAL_COST(FloatToInt, 1);
+        HAL_COST(IntToFloat, 1);
+        HAL_COST(FloatAdd, 1);
+        const unsigned int toPrint = (unsigned int)remainder;
+        written += print(toPrint);
+        remainder -= (float)toPrint;
+    }
+
+    return written;
+}
+
+#endif
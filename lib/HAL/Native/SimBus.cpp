@@ -0,0 +1,321 @@
+#ifndef ARDUINO
+
+#include "SimBus.h"
+
+#include "SimTiming.h"
+
+#include <string.h>
+
+SimI2CBus Wire;
+SimSPIBus SPI;
+
+// Time (us) 'bits' take at 'clock' Hz. The fraction we can't charge yet is carried over
+static uint64_t GetBusTime(uint64_t bits, uint32_t clock, uint32_t& remainder)
+{
+    const uint64_t scaled = bits * 1000000ull + remainder;
+    remainder = (uint32_t)(scaled % clock);
+    return scaled / clock;
+}
+
+SimI2CBus::SimI2CBus()
+    : m_clock(100000)
+    , m_timeRemainder(0)
+    , m_txAddress(0)
+    , m_txSize(0)
+    , m_transmitting(false)
+    , m_rxSize(0)
+    , m_rxPos(0)
+{
+    memset(m_devices, 0, sizeof(m_devices));
+    ResetStats();
+}
+
+void SimI2CBus::Attach(uint8_t address, SimI2CDevice* device)
+{
+    if(address < k_numAddresses)
+    {
+        m_devices[address] = device;
+    }
+}
+
+void SimI2CBus::DetachAll()
+{
+    memset(m_devices, 0, sizeof(m_devices));
+}
+
+const SimBusStats& SimI2CBus::GetStats()const
+{
+    return m_stats;
+}
+
+void SimI2CBus::ResetStats()
+{
+    memset(&m_stats, 0, sizeof(SimBusStats));
+}
+
+uint32_t SimI2CBus::GetClock()const
+{
+    return m_clock;
+}
+
+void SimI2CBus::begin()
+{
+    // Wire.begin() doesn't change the clock, it's 100kHz unless setClock is called
+    m_transmitting = false;
+    m_rxSize = 0;
+    m_rxPos = 0;
+}
+
+void SimI2CBus::setClock(uint32_t clock)
+{
+    m_clock = clock > 0 ? clock : 100000;
+}
+
+void SimI2CBus::beginTransmission(uint8_t address)
+{
+    m_txAddress = address;
+    m_txSize = 0;
+    m_transmitting = true;
+}
+
+size_t SimI2CBus::write(uint8_t value)
+{
+    if(!m_transmitting || m_txSize >= BUFFER_LENGTH)
+    {
+        return 0;
+    }
+    m_txBuffer[m_txSize++] = value;
+    return 1;
+}
+
+size_t SimI2CBus::write(const uint8_t* data, size_t size)
+{
+    size_t written = 0;
+    while(written < size && write(data[written]) == 1)
+    {
+        ++written;
+    }
+    return written;
+}
+
+uint8_t SimI2CBus::endTransmission(bool /*sendStop = true*/)
+{
+    m_transmitting = false;
+    ChargeTransaction(m_txSize);
+
+    // Same codes as TwoWire, 2 is a NACK on the address
+    SimI2CDevice* device = m_txAddress < k_numAddresses ? m_devices[m_txAddress] : nullptr;
+    if(!device)
+    {
+        return 2;
+    }
+
+    device->OnWrite(m_txBuffer, m_txSize);
+    return 0;
+}
+
+uint8_t SimI2CBus::requestFrom(uint8_t address, size_t quantity, bool /*sendStop = true*/)
+{
+    const uint8_t numBytes = quantity < BUFFER_LENGTH ? (uint8_t)quantity : (uint8_t)BUFFER_LENGTH;
+    m_rxPos = 0;
+    m_rxSize = 0;
+
+    SimI2CDevice* device = address < k_numAddresses ? m_devices[address] : nullptr;
+    if(!device)
+    {
+        ChargeTransaction(0);
+        return 0;
+    }
+
+    m_rxSize = device->OnRead(m_rxBuffer, numBytes);
+    ChargeTransaction(numBytes);
+    return m_rxSize;
+}
+
+int SimI2CBus::available()
+{
+    return m_rxSize - m_rxPos;
+}
+
+int SimI2CBus::read()
+{
+    return m_rxPos < m_rxSize ? m_rxBuffer[m_rxPos++] : -1;
+}
+
+int SimI2CBus::peek()
+{
+    return m_rxPos < m_rxSize ? m_rxBuffer[m_rxPos] : -1;
+}
+
+size_t SimI2CBus::readBytes(uint8_t* buffer, size_t length)
+{
+    size_t numRead = 0;
+    while(numRead < length && m_rxPos < m_rxSize)
+    {
+        buffer[numRead++] = m_rxBuffer[m_rxPos++];
+    }
+    return numRead;
+}
+
+void SimI2CBus::ChargeTransaction(uint32_t numBytes)
+{
+    // 9 bits per byte (ACK included) plus start and stop
+    const uint64_t bits = (uint64_t)(numBytes + 1u) * 9u + 2u;
+    const uint64_t time = GetBusTime(bits, m_clock, m_timeRemainder);
+    SimTiming::Charge(SimCost::I2C, time);
+
+    // The Wire calls and the TWI interrupt for every byte
+    const SimTimingConfig& config = SimTiming::GetConfig();
+    SimTiming::ChargeCycles(SimCost::I2C, config.m_i2cTransactionCycles + (numBytes + 1u) * config.m_i2cByteCycles);
+
+    ++m_stats.m_transactions;
+    m_stats.m_bytes += numBytes + 1u;
+    m_stats.m_time += time;
+}
+
+SPISettings::SPISettings()
+    : m_clock(4000000)
+    , m_bitOrder(MSBFIRST)
+    , m_dataMode(SPI_MODE0)
+{
+}
+
+SPISettings::SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode)
+    : m_clock(clock > 0 ? clock : 4000000)
+    , m_bitOrder(bitOrder)
+    , m_dataMode(dataMode)
+{
+}
+
+uint32_t SPISettings::GetClock()const
+{
+    return m_clock;
+}
+
+SimSPIDevice::SimSPIDevice()
+    : m_selected(false)
+{
+}
+
+bool SimSPIDevice::IsSelected()const
+{
+    return m_selected;
+}
+
+void SimSPIDevice::OnPinChanged(uint8_t /*pin*/, uint8_t value)
+{
+    // Chip select is active low
+    const bool selected = value == 0;
+    if(selected != m_selected)
+    {
+        m_selected = selected;
+        OnSelect(m_selected);
+    }
+}
+
+SimSPIBus::SimSPIBus()
+    : m_numDevices(0)
+    , m_timeRemainder(0)
+{
+    memset(m_devices, 0, sizeof(m_devices));
+    memset(m_chipSelects, 0, sizeof(m_chipSelects));
+    ResetStats();
+}
+
+void SimSPIBus::Attach(uint8_t chipSelect, SimSPIDevice* device)
+{
+    if(m_numDevices >= k_maxDevices)
+    {
+        return;
+    }
+
+    m_devices[m_numDevices] = device;
+    m_chipSelects[m_numDevices] = chipSelect;
+    ++m_numDevices;
+    SimGPIO::SetListener(chipSelect, device);
+}
+
+void SimSPIBus::DetachAll()
+{
+    for(uint8_t deviceIdx = 0; deviceIdx < m_numDevices; ++deviceIdx)
+    {
+        SimGPIO::SetListener(m_chipSelects[deviceIdx], nullptr);
+    }
+    m_numDevices = 0;
+}
+
+const SimBusStats& SimSPIBus::GetStats()const
+{
+    return m_stats;
+}
+
+void SimSPIBus::ResetStats()
+{
+    memset(&m_stats, 0, sizeof(SimBusStats));
+}
+
+void SimSPIBus::begin()
+{
+}
+
+void SimSPIBus::end()
+{
+}
+
+void SimSPIBus::beginTransaction(const SPISettings& settings)
+{
+    m_settings = settings;
+    ++m_stats.m_transactions;
+}
+
+void SimSPIBus::endTransaction()
+{
+}
+
+uint8_t SimSPIBus::transfer(uint8_t value)
+{
+    ChargeBytes(1);
+
+    // Nobody driving MISO reads as ones
+    uint8_t result = 0xFF;
+    for(uint8_t deviceIdx = 0; deviceIdx < m_numDevices; ++deviceIdx)
+    {
+        if(m_devices[deviceIdx]->IsSelected())
+        {
+            result &= m_devices[deviceIdx]->OnTransfer(value);
+        }
+    }
+    return result;
+}
+
+uint16_t SimSPIBus::transfer16(uint16_t value)
+{
+    uint16_t result = (uint16_t)transfer((uint8_t)(value >> 8u)) << 8u;
+    result |= transfer((uint8_t)value);
+    return result;
+}
+
+void SimSPIBus::transfer(void* buffer, size_t count)
+{
+    // Like SPIClass, what we read overwrites the buffer
+    uint8_t* data = (uint8_t*)buffer;
+    for(size_t byteIdx = 0; byteIdx < count; ++byteIdx)
+    {
+        data[byteIdx] = transfer(data[byteIdx]);
+    }
+}
+
+void SimSPIBus::ChargeBytes(uint32_t numBytes)
+{
+    // The SPI clock divider can't go faster than half the CPU clock
+    const SimTimingConfig& config = SimTiming::GetConfig();
+    const uint32_t clock = m_settings.GetClock() < config.m_spiMaxClock ? m_settings.GetClock() : config.m_spiMaxClock;
+    const uint64_t time = GetBusTime((uint64_t)numBytes * 8u, clock, m_timeRemainder);
+    SimTiming::Charge(SimCost::SPI, time);
+    SimTiming::ChargeCycles(SimCost::SPI, numBytes * config.m_spiByteCycles);
+
+    m_stats.m_bytes += numBytes;
+    m_stats.m_time += time;
+}
+
+#endif
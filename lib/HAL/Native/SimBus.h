@@ -0,0 +1,165 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "SimGPIO.h"
+
+// Same as the AVR Wire, drivers size their bursts with it
+#define BUFFER_LENGTH 32
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+// Traffic on a simulated bus
+struct SimBusStats
+{
+    uint32_t m_transactions;
+    uint32_t m_bytes;       // Address and command bytes included
+    uint64_t m_time;        // us the bits took at the bus clock
+};
+
+// Device on the simulated I2C bus
+class SimI2CDevice
+{
+public:
+    virtual ~SimI2CDevice() {}
+
+    // The master wrote 'size' bytes in one transaction (0 bytes is an address probe)
+    virtual void OnWrite(const uint8_t* data, uint8_t size) = 0;
+
+    // The master reads 'size' bytes, returns how many the device gave
+    virtual uint8_t OnRead(uint8_t* data, uint8_t size) = 0;
+};
+
+// I2C master with the TwoWire API. Every transaction takes the time the bytes need at the bus clock
+class SimI2CBus
+{
+public:
+    SimI2CBus();
+
+    // The device answers at 'address' (7 bits), nullptr removes it
+    void Attach(uint8_t address, SimI2CDevice* device);
+
+    void DetachAll();
+
+    const SimBusStats& GetStats()const;
+
+    void ResetStats();
+
+    uint32_t GetClock()const;
+
+    // TwoWire
+    void begin();
+    void setClock(uint32_t clock);
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t value);
+    size_t write(const uint8_t* data, size_t size);
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, size_t quantity, bool sendStop = true);
+    int available();
+    int read();
+    int peek();
+    size_t readBytes(uint8_t* buffer, size_t length);
+
+private:
+    static const uint8_t k_numAddresses = 128;
+
+    // Start, address byte, 'numBytes' with their ACK and stop
+    void ChargeTransaction(uint32_t numBytes);
+
+    SimI2CDevice* m_devices[k_numAddresses];
+    uint32_t m_clock;           // Hz
+    uint32_t m_timeRemainder;   // Fraction of us not charged yet (1/m_clock units)
+
+    uint8_t m_txAddress;
+    uint8_t m_txBuffer[BUFFER_LENGTH];
+    uint8_t m_txSize;
+    bool m_transmitting;
+
+    uint8_t m_rxBuffer[BUFFER_LENGTH];
+    uint8_t m_rxSize;
+    uint8_t m_rxPos;
+
+    SimBusStats m_stats;
+};
+
+class SPISettings
+{
+public:
+    SPISettings();
+
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode);
+
+    uint32_t GetClock()const;
+
+private:
+    uint32_t m_clock; // Hz
+    uint8_t m_bitOrder;
+    uint8_t m_dataMode;
+};
+
+// Device on the simulated SPI bus, selected while its chip select pin is low
+class SimSPIDevice : public SimPinListener
+{
+public:
+    SimSPIDevice();
+
+    bool IsSelected()const;
+
+    // Chip select edges, a command starts on select and ends on deselect
+    virtual void OnSelect(bool selected) = 0;
+
+    // Full duplex, returns the byte shifted out while 'value' is shifted in
+    virtual uint8_t OnTransfer(uint8_t value) = 0;
+
+    void OnPinChanged(uint8_t pin, uint8_t value) override;
+
+private:
+    bool m_selected;
+};
+
+// SPI master with the SPIClass API. Bytes go to the selected devices and take their time at the transaction clock
+class SimSPIBus
+{
+public:
+    static const uint8_t k_maxDevices = 4;
+
+    SimSPIBus();
+
+    // The device listens to 'chipSelect' (see SimGPIO)
+    void Attach(uint8_t chipSelect, SimSPIDevice* device);
+
+    void DetachAll();
+
+    const SimBusStats& GetStats()const;
+
+    void ResetStats();
+
+    // SPIClass
+    void begin();
+    void end();
+    void beginTransaction(const SPISettings& settings);
+    void endTransaction();
+    uint8_t transfer(uint8_t value);
+    uint16_t transfer16(uint16_t value);
+    void transfer(void* buffer, size_t count);
+
+private:
+    void ChargeBytes(uint32_t numBytes);
+
+    SimSPIDevice* m_devices[k_maxDevices];
+    uint8_t m_chipSelects[k_maxDevices];
+    uint8_t m_numDevices;
+    SPISettings m_settings;
+    uint32_t m_timeRemainder;   // Fraction of us not charged yet (1/clock units)
+    SimBusStats m_stats;
+};
+
+extern SimI2CBus Wire;
+extern SimSPIBus SPI;
@@ -0,0 +1,24 @@
+#ifndef ARDUINO
+
+#include "SimClock.h"
+
+// Per thread, the simulated board runs on one. Host tools decoding logs on worker threads (the annotated
+// code charges the model) get their own clock
+static thread_local uint64_t g_time = 0;
+
+uint64_t SimClock::GetTime()
+{
+    return g_time;
+}
+
+void SimClock::Advance(uint64_t time)
+{
+    g_time += time;
+}
+
+void SimClock::Reset(uint64_t time /*= 0*/)
+{
+    g_time = time;
+}
+
+#endif
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+
+// Virtual time of the native env, micros() and millis() read it. It doesn't move on its own:
+// delays and bus transfers charge their time to it and the host loop skips the idle time
+class SimClock
+{
+public:
+    // us since Reset, 64 bits so long simulations don't wrap (micros() still does, like on the device)
+    static uint64_t GetTime();
+
+    static void Advance(uint64_t time);
+
+    static void Reset(uint64_t time = 0);
+};
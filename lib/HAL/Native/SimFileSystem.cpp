@@ -0,0 +1,326 @@
+#ifndef ARDUINO
+
+#include "SimFileSystem.h"
+
+#include "SimTiming.h"
+
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint16_t k_maxPathLength = 512;
+
+static char g_root[k_maxPathLength] = ".";
+static uint8_t g_speed = SPI_FULL_SPEED;
+static uint8_t g_cache[k_sdBlockSize];
+static SimSdCard g_card;
+
+// Block numbers handed to contiguous files, past where a FAT would be
+static uint32_t g_nextBlock = 0x1000;
+
+// The contiguous file the card writes to, one at a time like SDCard does
+static FILE* g_blockFile = nullptr;
+static uint32_t g_blockFileFirst = 0;
+static uint32_t g_blockFileBlocks = 0;
+static uint32_t g_writeBlock = 0;
+static bool g_writing = false;
+
+// SPI time of 'numBytes' to the card at the begin speed
+static void ChargeCardBytes(uint32_t numBytes)
+{
+    const SimTimingConfig& config = SimTiming::GetConfig();
+    const uint32_t clock = config.m_spiMaxClock >> g_speed;
+    SimTiming::Charge(SimCost::SPI, (uint64_t)numBytes * 8000000ull / clock);
+    SimTiming::ChargeCycles(SimCost::SPI, numBytes * config.m_spiByteCycles);
+}
+
+bool SimSdCard::writeStart(uint32_t blockNumber, uint32_t /*eraseCount*/)
+{
+    if(g_writing || !g_blockFile || blockNumber < g_blockFileFirst || blockNumber >= g_blockFileFirst + g_blockFileBlocks)
+    {
+        return false;
+    }
+    g_writeBlock = blockNumber;
+    g_writing = true;
+    return true;
+}
+
+bool SimSdCard::writeData(const uint8_t* src)
+{
+    if(!g_writing || !g_blockFile || g_writeBlock >= g_blockFileFirst + g_blockFileBlocks)
+    {
+        return false;
+    }
+
+    ChargeCardBytes(k_sdBlockSize);
+    SimTiming::Charge(SimCost::SPI, SimTiming::GetConfig().m_sdStreamBlockBusy);
+
+    const long offset = (long)(g_writeBlock - g_blockFileFirst) * k_sdBlockSize;
+    if(fseek(g_blockFile, offset, SEEK_SET) != 0 || fwrite(src, 1, k_sdBlockSize, g_blockFile) != k_sdBlockSize)
+    {
+        return false;
+    }
+    ++g_writeBlock;
+    return true;
+}
+
+bool SimSdCard::writeStop()
+{
+    if(!g_writing)
+    {
+        return false;
+    }
+    SimTiming::Charge(SimCost::SPI, SimTiming::GetConfig().m_sdBlockBusy);
+    g_writing = false;
+    return true;
+}
+
+static bool GetFullPath(const char* path, char* fullPath)
+{
+    const int length = snprintf(fullPath, k_maxPathLength, "%s/%s", g_root, path);
+    return length > 0 && length < k_maxPathLength;
+}
+
+void SimFileSystem::SetRoot(const char* root)
+{
+    snprintf(g_root, sizeof(g_root), "%s", root);
+}
+
+const char* SimFileSystem::GetRoot()
+{
+    return g_root;
+}
+
+bool SimFileSystem::begin(uint8_t /*chipSelect*/, uint8_t speed)
+{
+    g_speed = speed <= SPI_QUARTER_SPEED ? speed : SPI_QUARTER_SPEED;
+
+    struct stat info;
+    return stat(g_root, &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+bool SimFileSystem::exists(const char* path)
+{
+    char fullPath[k_maxPathLength];
+    struct stat info;
+    return GetFullPath(path, fullPath) && stat(fullPath, &info) == 0;
+}
+
+bool SimFileSystem::remove(const char* path)
+{
+    char fullPath[k_maxPathLength];
+    return GetFullPath(path, fullPath) && ::remove(fullPath) == 0;
+}
+
+void SimFileSystem::errorPrint(Print* stream)
+{
+    stream->print(F("SD error: "));
+    stream->println(g_root);
+}
+
+SimSdCard* SimFileSystem::card()
+{
+    return &g_card;
+}
+
+SimFileSystem* SimFileSystem::vol()
+{
+    return this;
+}
+
+uint8_t* SimFileSystem::cacheClear()
+{
+    return g_cache;
+}
+
+SimFile::SimFile()
+    : m_file(nullptr)
+    , m_error(0)
+    , m_firstBlock(0)
+    , m_numBlocks(0)
+{
+}
+
+SimFile::~SimFile()
+{
+    close();
+}
+
+bool SimFile::open(const char* path, int oflag)
+{
+    close();
+
+    char fullPath[k_maxPathLength];
+    if(!GetFullPath(path, fullPath))
+    {
+        m_error = 1;
+        return false;
+    }
+
+    if(oflag & O_TRUNC)
+    {
+        m_file = fopen(fullPath, "w+b");
+    }
+    else
+    {
+        m_file = fopen(fullPath, "r+b");
+        if(!m_file && (oflag & O_CREAT))
+        {
+            m_file = fopen(fullPath, "w+b");
+        }
+    }
+
+    m_error = m_file ? 0 : 1;
+    return m_file != nullptr;
+}
+
+bool SimFile::createContiguous(const char* path, uint32_t size)
+{
+    close();
+
+    char fullPath[k_maxPathLength];
+    struct stat info;
+    if(size == 0 || g_blockFile || !GetFullPath(path, fullPath) || stat(fullPath, &info) == 0)
+    {
+        m_error = 1;
+        return false;
+    }
+
+    m_file = fopen(fullPath, "w+b");
+    m_numBlocks = (size + k_sdBlockSize - 1u) / k_sdBlockSize;
+    if(!m_file || ftruncate(fileno(m_file), (off_t)m_numBlocks * k_sdBlockSize) != 0)
+    {
+        close();
+        m_error = 1;
+        return false;
+    }
+
+    // The card writes straight to this file
+    m_firstBlock = g_nextBlock;
+    g_nextBlock += m_numBlocks;
+    g_blockFile = m_file;
+    g_blockFileFirst = m_firstBlock;
+    g_blockFileBlocks = m_numBlocks;
+
+    m_error = 0;
+    return true;
+}
+
+bool SimFile::contiguousRange(uint32_t* bgnBlock, uint32_t* endBlock)
+{
+    if(!m_file || m_numBlocks == 0)
+    {
+        return false;
+    }
+    *bgnBlock = m_firstBlock;
+    *endBlock = m_firstBlock + m_numBlocks - 1u;
+    return true;
+}
+
+bool SimFile::truncate(uint32_t length)
+{
+    if(!m_file)
+    {
+        return false;
+    }
+    fflush(m_file);
+    return ftruncate(fileno(m_file), (off_t)length) == 0 && fseek(m_file, (long)length, SEEK_SET) == 0;
+}
+
+uint32_t SimFile::fileSize()const
+{
+    if(!m_file)
+    {
+        return 0;
+    }
+    fflush(m_file);
+    struct stat info;
+    return fstat(fileno(m_file), &info) == 0 ? (uint32_t)info.st_size : 0u;
+}
+
+int SimFile::read(void* buffer, size_t size)
+{
+    if(!m_file)
+    {
+        m_error = 1;
+        return -1;
+    }
+
+    // Every block we touch comes from the card (SdFat's cache holds one)
+    const long position = ftell(m_file);
+    const uint32_t numBlocks = size > 0 ? (uint32_t)((position + (long)size - 1) / k_sdBlockSize - position / k_sdBlockSize + 1) : 0u;
+    ChargeCardBytes(numBlocks * k_sdBlockSize);
+
+    const size_t numRead = fread(buffer, 1, size, m_file);
+    m_error = ferror(m_file) ? 1 : 0;
+    return m_error ? -1 : (int)numRead;
+}
+
+bool SimFile::seekSet(uint32_t position)
+{
+    if(!m_file)
+    {
+        return false;
+    }
+
+    // SdFat can't seek past the end
+    fflush(m_file);
+    struct stat info;
+    return fstat(fileno(m_file), &info) == 0 && position <= (uint32_t)info.st_size && fseek(m_file, (long)position, SEEK_SET) == 0;
+}
+
+bool SimFile::close()
+{
+    if(!m_file)
+    {
+        return false;
+    }
+
+    if(m_file == g_blockFile)
+    {
+        g_blockFile = nullptr;
+        g_writing = false;
+    }
+    m_numBlocks = 0;
+
+    const bool closed = fclose(m_file) == 0;
+    m_file = nullptr;
+    return closed;
+}
+
+bool SimFile::isOpen()const
+{
+    return m_file != nullptr;
+}
+
+uint8_t SimFile::getError()const
+{
+    return m_error;
+}
+
+size_t SimFile::write(uint8_t value)
+{
+    return write(&value, 1);
+}
+
+size_t SimFile::write(const uint8_t* buffer, size_t size)
+{
+    if(!m_file)
+    {
+        m_error = 1;
+        return 0;
+    }
+
+    // Per call, plus a single block write (SdFat's cache going to the card) for every block we fill
+    const long position = ftell(m_file);
+    const uint32_t numBlocks = (uint32_t)((position + (long)size) / k_sdBlockSize - position / k_sdBlockSize);
+    SimTiming::ChargeCycles(SimCost::Code, SimTiming::GetConfig().m_fileWriteCycles);
+    ChargeCardBytes(numBlocks * k_sdBlockSize);
+    SimTiming::Charge(SimCost::SPI, (uint64_t)numBlocks * SimTiming::GetConfig().m_sdBlockBusy);
+
+    const size_t written = fwrite(buffer, 1, size, m_file);
+    m_error = written == size ? 0 : 1;
+    return written;
+}
+
+#endif
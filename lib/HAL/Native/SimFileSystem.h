@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <fcntl.h>  // O_RDWR, O_CREAT, O_TRUNC (SdFat uses the same names)
+
+#include "Print.h"
+
+// SdFat speeds, the directory on disk doesn't care
+#define SPI_FULL_SPEED    0
+#define SPI_HALF_SPEED    1
+#define SPI_QUARTER_SPEED 2
+
+// Card block size
+static const uint16_t k_sdBlockSize = 512;
+
+// Raw block writes of the native SD card. The only blocks it has are the ones of the contiguous file
+// (see SimFile::createContiguous), written to that file
+class SimSdCard
+{
+public:
+    // Multi-block write starting at 'blockNumber', 'eraseCount' blocks get erased first
+    bool writeStart(uint32_t blockNumber, uint32_t eraseCount);
+
+    // A k_sdBlockSize block, at the next block number
+    bool writeData(const uint8_t* src);
+
+    bool writeStop();
+};
+
+// SD card of the native env, a directory on disk. Same subset of the SdFat API that SDCard uses. Writes charge
+// the SPI time of the card (SimTiming) at the speed passed to begin
+class SimFileSystem
+{
+public:
+    // Directory the card maps to, it has to exist ("." by default)
+    static void SetRoot(const char* root);
+
+    static const char* GetRoot();
+
+    // Fails if the root isn't a directory (like a missing card)
+    bool begin(uint8_t chipSelect, uint8_t speed);
+
+    bool exists(const char* path);
+
+    bool remove(const char* path);
+
+    void errorPrint(Print* stream);
+
+    SimSdCard* card();
+
+    // SdFat's volume, it owns the block cache
+    SimFileSystem* vol();
+
+    // The block cache, invalidated. Its k_sdBlockSize bytes can be used until the FAT is accessed again
+    uint8_t* cacheClear();
+};
+
+class SimFile : public Print
+{
+public:
+    SimFile();
+
+    ~SimFile();
+
+    SimFile(const SimFile& other) = delete;
+
+    // 'path' is relative to the root
+    bool open(const char* path, int oflag);
+
+    // Creates (it fails if the file exists) and opens a file of 'size' bytes in consecutive blocks
+    bool createContiguous(const char* path, uint32_t size);
+
+    // First and last block of a file made with createContiguous
+    bool contiguousRange(uint32_t* bgnBlock, uint32_t* endBlock);
+
+    bool truncate(uint32_t length);
+
+    uint32_t fileSize()const;
+
+    // Returns the bytes read, -1 on error
+    int read(void* buffer, size_t size);
+
+    bool seekSet(uint32_t position);
+
+    bool close();
+
+    bool isOpen()const;
+
+    uint8_t getError()const;
+
+    size_t write(uint8_t value) override;
+
+    size_t write(const uint8_t* buffer, size_t size) override;
+
+    using Print::write;
+
+private:
+    FILE* m_file;
+    uint8_t m_error;
+    uint32_t m_firstBlock;      // Contiguous files only
+    uint32_t m_numBlocks;       // 0 for the others
+};
@@ -0,0 +1,53 @@
+#ifndef ARDUINO
+
+#include "SimGPIO.h"
+
+#include <string.h>
+
+static uint8_t g_pinModes[SimGPIO::k_numPins] = {};
+static uint8_t g_pinValues[SimGPIO::k_numPins] = {};
+static SimPinListener* g_pinListeners[SimGPIO::k_numPins] = {};
+
+void SimGPIO::SetMode(uint8_t pin, uint8_t mode)
+{
+    if(pin < k_numPins)
+    {
+        g_pinModes[pin] = mode;
+    }
+}
+
+void SimGPIO::Write(uint8_t pin, uint8_t value)
+{
+    if(pin >= k_numPins || g_pinValues[pin] == value)
+    {
+        return;
+    }
+
+    g_pinValues[pin] = value;
+    if(g_pinListeners[pin])
+    {
+        g_pinListeners[pin]->OnPinChanged(pin, value);
+    }
+}
+
+uint8_t SimGPIO::Read(uint8_t pin)
+{
+    return pin < k_numPins ? g_pinValues[pin] : 0;
+}
+
+void SimGPIO::SetListener(uint8_t pin, SimPinListener* listener)
+{
+    if(pin < k_numPins)
+    {
+        g_pinListeners[pin] = listener;
+    }
+}
+
+void SimGPIO::Reset()
+{
+    memset(g_pinModes, 0, sizeof(g_pinModes));
+    memset(g_pinValues, 0, sizeof(g_pinValues));
+    memset(g_pinListeners, 0, sizeof(g_pinListeners));
+}
+
+#endif
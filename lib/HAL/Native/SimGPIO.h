@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+// Gets told when a pin changes, simulated SPI devices use it for their chip select
+class SimPinListener
+{
+public:
+    virtual ~SimPinListener() {}
+
+    virtual void OnPinChanged(uint8_t pin, uint8_t value) = 0;
+};
+
+// Digital pins of the native env, pinMode/digitalWrite/digitalRead end up here
+class SimGPIO
+{
+public:
+    static const uint8_t k_numPins = 32;
+
+    static void SetMode(uint8_t pin, uint8_t mode);
+
+    static void Write(uint8_t pin, uint8_t value);
+
+    static uint8_t Read(uint8_t pin);
+
+    // One listener per pin, nullptr removes it
+    static void SetListener(uint8_t pin, SimPinListener* listener);
+
+    // All pins low, no listeners
+    static void Reset();
+};
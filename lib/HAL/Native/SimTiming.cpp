@@ -0,0 +1,92 @@
+#ifndef ARDUINO
+
+#include "SimTiming.h"
+
+#include "SimClock.h"
+
+#include <string.h>
+
+static const char* const k_costNames[k_numSimCosts] = { "I2C", "SPI", "DELAY", "MATH", "CODE" };
+static const char* const k_opNames[k_numSimOps] = { "FADD", "FMUL", "FDIV", "FSQRT", "FPOW", "ITOF", "FTOI", "I64MUL", "I32DIV" };
+
+static SimTimingConfig g_config = GetDefaultTimingConfig();
+static thread_local SimTimingTotals g_totals; // Per thread, same as the SimClock
+static thread_local uint32_t g_cycleRemainder = 0; // Fraction of us not charged yet (1/m_cpuClock units)
+
+SimTimingConfig GetDefaultTimingConfig()
+{
+    // Estimates for avr-gcc -Os and avr-libc, tune them against the bench
+    SimTimingConfig config;
+    config.m_cpuClock = 16000000;
+    config.m_spiMaxClock = 8000000;
+    config.m_i2cTransactionCycles = 400;
+    config.m_i2cByteCycles = 100;
+    config.m_spiByteCycles = 12;
+    config.m_taskCycles = 300;
+    config.m_fileWriteCycles = 250;
+    config.m_sdBlockBusy = 1000;
+    config.m_sdStreamBlockBusy = 100;
+    config.m_opCycles[(uint8_t)SimOp::FloatAdd] = 110;
+    config.m_opCycles[(uint8_t)SimOp::FloatMul] = 150;
+    config.m_opCycles[(uint8_t)SimOp::FloatDiv] = 480;
+    config.m_opCycles[(uint8_t)SimOp::FloatSqrt] = 500;
+    config.m_opCycles[(uint8_t)SimOp::FloatPow] = 5000;
+    config.m_opCycles[(uint8_t)SimOp::IntToFloat] = 80;
+    config.m_opCycles[(uint8_t)SimOp::FloatToInt] = 70;
+    config.m_opCycles[(uint8_t)SimOp::Int64Mul] = 700;
+    config.m_opCycles[(uint8_t)SimOp::Int32Div] = 600;
+    return config;
+}
+
+void SimTiming::SetConfig(const SimTimingConfig& config)
+{
+    g_config = config;
+    g_cycleRemainder = 0;
+}
+
+const SimTimingConfig& SimTiming::GetConfig()
+{
+    return g_config;
+}
+
+void SimTiming::Charge(SimCost cost, uint64_t time)
+{
+    SimClock::Advance(time);
+    g_totals.m_time[(uint8_t)cost] += time;
+}
+
+void SimTiming::ChargeCycles(SimCost cost, uint32_t cycles)
+{
+    const uint64_t scaled = (uint64_t)cycles * 1000000ull + g_cycleRemainder;
+    g_cycleRemainder = (uint32_t)(scaled % g_config.m_cpuClock);
+    Charge(cost, scaled / g_config.m_cpuClock);
+}
+
+void SimTiming::ChargeOps(SimOp op, uint32_t count)
+{
+    g_totals.m_ops[(uint8_t)op] += count;
+    ChargeCycles(SimCost::Math, count * g_config.m_opCycles[(uint8_t)op]);
+}
+
+const SimTimingTotals& SimTiming::GetTotals()
+{
+    return g_totals;
+}
+
+void SimTiming::Reset()
+{
+    memset(&g_totals, 0, sizeof(SimTimingTotals));
+    g_cycleRemainder = 0;
+}
+
+const char* SimTiming::GetName(SimCost cost)
+{
+    return k_costNames[(uint8_t)cost];
+}
+
+const char* SimTiming::GetName(SimOp op)
+{
+    return k_opNames[(uint8_t)op];
+}
+
+#endif
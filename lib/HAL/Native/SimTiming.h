@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+
+// Where the time charged to the SimClock goes
+enum class SimCost : uint8_t
+{
+    I2C,        // Bus bits plus the Wire overhead
+    SPI,        // Bus bits plus the per byte loop
+    Delay,      // delay() and delayMicroseconds()
+    Math,       // Float and 64 bit math (see SimOp)
+    Code,       // Task dispatch and the rest of the loop
+};
+
+static const uint8_t k_numSimCosts = 5;
+
+// Operations the AVR does in software, code charges them with HAL_COST (HALCost.h)
+enum class SimOp : uint8_t
+{
+    FloatAdd,
+    FloatMul,
+    FloatDiv,
+    FloatSqrt,
+    FloatPow,
+    IntToFloat,
+    FloatToInt,
+    Int64Mul,
+    Int32Div,   // Division or modulo
+};
+
+static const uint8_t k_numSimOps = 9;
+
+// Clocks and cycle counts of the target (ATmega328 at 16MHz, avr-libc and the Arduino core)
+struct SimTimingConfig
+{
+    uint32_t m_cpuClock;                    // Hz
+    uint32_t m_spiMaxClock;                 // Hz, SPISettings asking for more get this (F_CPU / 2 on the AVR)
+    uint16_t m_i2cTransactionCycles;        // Wire calls, start and stop handling
+    uint16_t m_i2cByteCycles;               // TWI interrupt per byte
+    uint16_t m_spiByteCycles;               // SPI.transfer loop on top of the 8 clocks
+    uint16_t m_taskCycles;                  // TaskScheduler::RunNext and the task bookkeeping
+    uint16_t m_fileWriteCycles;             // A File::write call (SdFat cache bookkeeping), on top of the bytes
+    uint16_t m_sdBlockBusy;                 // us the SD card is busy programming a single block write
+    uint16_t m_sdStreamBlockBusy;           // us per block of a multi-block write to pre-erased blocks
+    uint16_t m_opCycles[k_numSimOps];       // SimOp order
+};
+
+SimTimingConfig GetDefaultTimingConfig();
+
+// Totals since the last Reset
+struct SimTimingTotals
+{
+    uint64_t m_time[k_numSimCosts];         // us, SimCost order
+    uint32_t m_ops[k_numSimOps];            // SimOp order
+};
+
+// Timing model of the native env: the buses, delays and the annotated math charge the time the target
+// would take to the SimClock, so the loop timing matches the board (roughly, it's not cycle exact).
+// Integer work (the compression, CRC16, buffer copies) isn't charged, the predicted loop time is a lower bound
+class SimTiming
+{
+public:
+    static void SetConfig(const SimTimingConfig& config);
+
+    static const SimTimingConfig& GetConfig();
+
+    // Advances the SimClock 'time' us
+    static void Charge(SimCost cost, uint64_t time);
+
+    static void ChargeCycles(SimCost cost, uint32_t cycles);
+
+    static void ChargeOps(SimOp op, uint32_t count);
+
+    static const SimTimingTotals& GetTotals();
+
+    // Clears the totals, the config stays
+    static void Reset();
+
+    static const char* GetName(SimCost cost);
+
+    static const char* GetName(SimOp op);
+};
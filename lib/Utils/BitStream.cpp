@@ -0,0 +1,105 @@
+#include "BitStream.h"
+
+BitWriter::BitWriter(uint8_t* buffer, uint16_t bufferSize, uint16_t bitOffset /*= 0*/)
+    : m_buffer(buffer)
+    , m_bufferSize(bufferSize)
+    , m_bitCount(bitOffset)
+{
+}
+
+bool BitWriter::Write(uint32_t value, uint8_t numBits)
+{
+    if((uint32_t)m_bitCount + numBits > (uint32_t)m_bufferSize * 8u)
+    {
+        return false;
+    }
+
+    // Fill the current byte, then whole bytes
+    while(numBits > 0)
+    {
+        uint16_t byteIdx = m_bitCount >> 3;
+        uint8_t bitIdx = m_bitCount & 0x7;
+        uint8_t bitsInByte = 8 - bitIdx;
+        if(bitsInByte > numBits)
+        {
+            bitsInByte = numBits;
+        }
+
+        uint8_t mask = (uint8_t)((1u << bitsInByte) - 1u);
+        if(bitIdx == 0)
+        {
+            m_buffer[byteIdx] = 0; // Starting a new byte
+        }
+        m_buffer[byteIdx] |= (uint8_t)((value & mask) << bitIdx);
+
+        value >>= bitsInByte;
+        numBits -= bitsInByte;
+        m_bitCount += bitsInByte;
+    }
+
+    return true;
+}
+
+bool BitWriter::WriteSigned(int32_t value, uint8_t numBits)
+{
+    return Write((uint32_t)value, numBits);
+}
+
+uint16_t BitWriter::GetBitCount()const
+{
+    return m_bitCount;
+}
+
+uint16_t BitWriter::GetByteCount()const
+{
+    return (m_bitCount + 7) >> 3;
+}
+
+BitReader::BitReader(const uint8_t* buffer, uint16_t bufferSize, uint16_t bitOffset /*= 0*/)
+    : m_buffer(buffer)
+    , m_bufferSize(bufferSize)
+    , m_bitCount(bitOffset)
+{
+}
+
+uint32_t BitReader::Read(uint8_t numBits)
+{
+    uint32_t value = 0;
+    uint8_t shift = 0;
+    while(numBits > 0)
+    {
+        uint16_t byteIdx = m_bitCount >> 3;
+        uint8_t bitIdx = m_bitCount & 0x7;
+        uint8_t bitsInByte = 8 - bitIdx;
+        if(bitsInByte > numBits)
+        {
+            bitsInByte = numBits;
+        }
+
+        uint8_t byte = byteIdx < m_bufferSize ? m_buffer[byteIdx] : 0;
+        uint8_t mask = (uint8_t)((1u << bitsInByte) - 1u);
+        value |= (uint32_t)((byte >> bitIdx) & mask) << shift;
+
+        shift += bitsInByte;
+        numBits -= bitsInByte;
+        m_bitCount += bitsInByte;
+    }
+    return value;
+}
+
+int32_t BitReader::ReadSigned(uint8_t numBits)
+{
+    uint32_t value = Read(numBits);
+
+    // Sign extend
+    if(numBits < 32 && (value & (1ul << (numBits - 1))))
+    {
+        value |= ~((1ul << numBits) - 1ul);
+    }
+    return (int32_t)value;
+}
+
+uint16_t BitReader::GetBitCount()const
+{
+    return m_bitCount;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+
+// Writes values of arbitrary bit width (up to 32) into a byte buffer, LSB first
+class BitWriter
+{
+public:
+    // 'bitOffset' allows appending to a partially written buffer
+    BitWriter(uint8_t* buffer, uint16_t bufferSize, uint16_t bitOffset = 0);
+
+    // Returns false if the value doesn't fit in the buffer (nothing is written)
+    bool Write(uint32_t value, uint8_t numBits);
+
+    // Two's complement, 'value' must fit in 'numBits'
+    bool WriteSigned(int32_t value, uint8_t numBits);
+
+    uint16_t GetBitCount()const;
+
+    // Bytes used so far (the last one may be partially written)
+    uint16_t GetByteCount()const;
+
+private:
+    uint8_t* m_buffer;
+    uint16_t m_bufferSize;
+    uint16_t m_bitCount;
+};
+
+class BitReader
+{
+public:
+    BitReader(const uint8_t* buffer, uint16_t bufferSize, uint16_t bitOffset = 0);
+
+    // Reading past the end of the buffer returns zeros
+    uint32_t Read(uint8_t numBits);
+
+    int32_t ReadSigned(uint8_t numBits);
+
+    uint16_t GetBitCount()const;
+
+private:
+    const uint8_t* m_buffer;
+    uint16_t m_bufferSize;
+    uint16_t m_bitCount;
+};
+
+// Range of a two's complement value with 'numBits'
+inline int32_t GetSignedMax(uint8_t numBits)
+{
+    return (int32_t)((1ul << (numBits - 1)) - 1);
+}
+
+inline int32_t GetSignedMin(uint8_t numBits)
+{
+    return -GetSignedMax(numBits) - 1;
+}
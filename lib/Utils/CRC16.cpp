@@ -0,0 +1,21 @@
+#include "CRC16.h"
+
+#include "HAL.h"
+
+// CRC of every nibble value, shifted to the top 4 bits. In flash, an lpm costs the same as the ld from SRAM
+static const uint16_t k_crc16Table[16] PROGMEM =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+uint16_t UpdateCRC16(uint16_t crc, const uint8_t* data, uint32_t size)
+{
+    for(uint32_t byteIdx = 0; byteIdx < size; ++byteIdx)
+    {
+        const uint8_t value = data[byteIdx];
+        crc = (uint16_t)((crc << 4) ^ pgm_read_word(&k_crc16Table[(crc >> 12) ^ (value >> 4)]));
+        crc = (uint16_t)((crc << 4) ^ pgm_read_word(&k_crc16Table[(crc >> 12) ^ (value & 0x0F)]));
+    }
+    return crc;
+}
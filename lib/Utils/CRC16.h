@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+// CRC-16/CCITT-FALSE: polynomial 0x1021, MSB first, no final xor
+static const uint16_t k_crc16Init = 0xFFFF;
+
+// Continues 'crc' (k_crc16Init to start) over 'size' bytes, the data can be fed in as many pieces as needed.
+// A nibble at a time, the table is 32 bytes
+uint16_t UpdateCRC16(uint16_t crc, const uint8_t* data, uint32_t size);
@@ -0,0 +1,184 @@
+#include "CSVWriter.h"
+
+#include "HAL.h"
+
+#include <math.h>
+#include <string.h>
+
+// 0.5 / 10^digits, divided the way Print::print does it so the rounding is the same
+static const float k_rounding[k_maxCSVDigits + 1] = { 0.5f, 0.5f / 10.0f, 0.5f / 10.0f / 10.0f, 0.5f / 10.0f / 10.0f / 10.0f };
+
+// Significant bits of a float
+static const uint8_t k_mantissaBits = 24;
+static const uint32_t k_mantissaEnd = 1ul << k_mantissaBits;
+
+// The next decimal of 'mantissa' * 2^-'shift' (less than 1), Print::print gets it with 'remainder' *= 10 and
+// the integer part taken off. This is the same float multiply (rounded to 24 bits, to nearest even) done with
+// integer math so the digits match on the ties, where the float rounding makes Print::print fall short
+static uint8_t NextDigit(uint32_t& mantissa, uint8_t& shift)
+{
+    mantissa *= 10u;
+
+    uint8_t extraBits = 0;
+    while((mantissa >> extraBits) >= k_mantissaEnd)
+    {
+        ++extraBits;
+    }
+    if(extraBits > 0)
+    {
+        const uint32_t dropped = mantissa & ((1ul << extraBits) - 1u);
+        const uint32_t half = 1ul << (extraBits - 1u);
+        mantissa >>= extraBits;
+        shift -= extraBits;
+        if(dropped > half || (dropped == half && (mantissa & 1u)))
+        {
+            ++mantissa; // 2^24 is still exact, no need to normalize it
+        }
+    }
+
+    if(shift >= 32u)
+    {
+        return 0;
+    }
+    const uint8_t digit = (uint8_t)(mantissa >> shift);
+    mantissa -= (uint32_t)digit << shift;
+    return digit;
+}
+
+static uint8_t CopyText(const char* text, char* out)
+{
+    const uint8_t length = (uint8_t)strlen(text);
+    memcpy(out, text, length);
+    return length;
+}
+
+uint8_t FormatFloat(float value, uint8_t digits, char* out)
+{
+    if(isnan(value))
+    {
+        return CopyText("nan", out);
+    }
+    if(isinf(value))
+    {
+        return CopyText("inf", out);
+    }
+    if(value > 4294967040.0f || value < -4294967040.0f)
+    {
+        return CopyText("ovf", out);
+    }
+    if(digits > k_maxCSVDigits)
+    {
+        digits = k_maxCSVDigits;
+    }
+
+    uint8_t length = 0;
+    if(value < 0.0f)
+    {
+        out[length++] = '-';
+        value = -value;
+    }
+
+    const float number = value + k_rounding[digits];
+    const uint32_t intPart = (uint32_t)number;
+    const float remainder = number - (float)intPart;
+
+    length += FormatUInt(intPart, out + length);
+    if(digits == 0)
+    {
+        return length;
+    }
+
+    // remainder = mantissa * 2^-shift, it's less than 1 so the shift is at least 24 (or it's 0)
+    uint32_t bits;
+    memcpy(&bits, &remainder, sizeof(bits));
+    uint32_t mantissa = remainder > 0.0f ? (bits & (k_mantissaEnd / 2u - 1u)) | k_mantissaEnd / 2u : 0u;
+    uint8_t shift = (uint8_t)(127u + k_mantissaBits - 1u - ((bits >> 23) & 0xFFu));
+
+    out[length++] = '.';
+    while(digits-- > 0)
+    {
+        out[length++] = (char)('0' + NextDigit(mantissa, shift));
+    }
+    return length;
+}
+
+uint8_t FormatUInt(uint32_t value, char* out)
+{
+    // Most significant digit last
+    char digits[10];
+    uint8_t numDigits = 0;
+    while(value > 0xFFFFu)
+    {
+        digits[numDigits++] = (char)('0' + value % 10u);
+        value /= 10u;
+    }
+
+    // value * 0xCCCD >> 19 is value / 10 for any 16 bit value, a multiply is much cheaper than a division on the AVR
+    uint16_t value16 = (uint16_t)value;
+    do
+    {
+        const uint16_t quotient = (uint16_t)(((uint32_t)value16 * 0xCCCDu) >> 19);
+        digits[numDigits++] = (char)('0' + (value16 - quotient * 10u));
+        value16 = quotient;
+    } while(value16 > 0);
+
+    for(uint8_t digitIdx = 0; digitIdx < numDigits; ++digitIdx)
+    {
+        out[digitIdx] = digits[numDigits - 1u - digitIdx];
+    }
+    return numDigits;
+}
+
+CSVWriter::CSVWriter(Print* stream)
+    : m_stream(stream)
+    , m_size(0)
+    , m_rowStarted(false)
+{
+}
+
+void CSVWriter::AddFloat(float value, uint8_t digits)
+{
+    char* out = BeginField(k_maxCSVFloatLength);
+    m_size += FormatFloat(value, digits, out);
+}
+
+void CSVWriter::AddUInt(uint32_t value)
+{
+    char* out = BeginField(10);
+    m_size += FormatUInt(value, out);
+}
+
+void CSVWriter::EndRow()
+{
+    if(m_size >= k_csvRowCapacity)
+    {
+        Flush();
+    }
+    m_buffer[m_size++] = '\n';
+    m_rowStarted = false;
+    Flush();
+}
+
+char* CSVWriter::BeginField(uint8_t size)
+{
+    // The separator plus the longest the field can be
+    if(m_size + 1u + size > k_csvRowCapacity)
+    {
+        Flush();
+    }
+    if(m_rowStarted)
+    {
+        m_buffer[m_size++] = ',';
+    }
+    m_rowStarted = true;
+    return m_buffer + m_size;
+}
+
+void CSVWriter::Flush()
+{
+    if(m_size > 0)
+    {
+        m_stream->write((const uint8_t*)m_buffer, m_size);
+        m_size = 0;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+
+class Print;
+
+// Most decimals FormatFloat does, the output matches Print::print up to them
+static const uint8_t k_maxCSVDigits = 3;
+
+// Longest FormatFloat output: sign, 10 integer digits, the point and the decimals
+static const uint8_t k_maxCSVFloatLength = 12 + k_maxCSVDigits;
+
+// Row buffer, a row longer than this gets written in more than one call
+static const uint8_t k_csvRowCapacity = 96;
+
+// Writes 'value' with 'digits' decimals (up to k_maxCSVDigits) to 'out', same text as Print::print(value, digits)
+// (including nan, inf and ovf) with a single float multiply. Returns the length, 'out' isn't null terminated
+uint8_t FormatFloat(float value, uint8_t digits, char* out);
+
+// Decimal, returns the length ('out' isn't null terminated)
+uint8_t FormatUInt(uint32_t value, char* out);
+
+// Builds CSV rows in a buffer and hands each one to the stream in a single write
+class CSVWriter
+{
+public:
+    explicit CSVWriter(Print* stream);
+
+    void AddFloat(float value, uint8_t digits);
+
+    void AddUInt(uint32_t value);
+
+    // Ends the row with '\n' and writes it
+    void EndRow();
+
+private:
+    // Separator before all but the first field of a row. Writes what's buffered if 'size' doesn't fit
+    char* BeginField(uint8_t size);
+
+    void Flush();
+
+    Print* m_stream;
+    uint8_t m_size;
+    bool m_rowStarted;
+    char m_buffer[k_csvRowCapacity];
+};
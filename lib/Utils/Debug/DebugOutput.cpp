@@ -1,9 +1,9 @@
 #include "DebugOutput.h"
 
-#include <Arduino.h>
-
 #if DEBUG_OUTPUT_ENABLED == 1
 
+#include "HAL.h"
+
 void MsgOutImpl(const char* msg, ...)
 {
     char buff[256];
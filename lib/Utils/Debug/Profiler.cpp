@@ -0,0 +1,95 @@
+#include "Profiler.h"
+
+#include "HAL.h"
+
+#include <string.h>
+
+static ProfileStats g_profileStats[k_maxProfileStages];
+
+static uint16_t Saturate(uint32_t value)
+{
+    return value > 0xFFFFu ? 0xFFFFu : (uint16_t)value;
+}
+
+void Profiler::Add(uint8_t stage, uint32_t time)
+{
+    if(stage >= k_maxProfileStages)
+    {
+        return;
+    }
+
+    ProfileStats& stats = g_profileStats[stage];
+    const uint16_t time16 = Saturate(time);
+    if(stats.m_count == 0 || time16 < stats.m_min)
+    {
+        stats.m_min = time16;
+    }
+    if(time16 > stats.m_max)
+    {
+        stats.m_max = time16;
+    }
+    ++stats.m_count;
+    stats.m_total += time;
+
+    uint8_t& bucket = stats.m_buckets[GetBucket(time)];
+    if(bucket == 0xFF)
+    {
+        for(uint8_t bucketIdx = 0; bucketIdx < k_profileBuckets; ++bucketIdx)
+        {
+            stats.m_buckets[bucketIdx] >>= 1;
+        }
+    }
+    ++bucket;
+}
+
+const ProfileStats& Profiler::GetStats(uint8_t stage)
+{
+    return g_profileStats[stage < k_maxProfileStages ? stage : 0];
+}
+
+void Profiler::Reset()
+{
+    memset(g_profileStats, 0, sizeof(g_profileStats));
+}
+
+void Profiler::Write(Print* stream, const char* const* stageNames, uint8_t numStages)
+{
+    stream->print(F("STAGE,COUNT,MIN_US,MEAN_US,MAX_US"));
+    for(uint8_t bucketIdx = 0; bucketIdx < k_profileBuckets; ++bucketIdx)
+    {
+        stream->print(',');
+        stream->print(bucketIdx == 0 ? 0ul : 1ul << bucketIdx);
+    }
+    stream->print('\n');
+
+    for(uint8_t stage = 0; stage < numStages && stage < k_maxProfileStages; ++stage)
+    {
+        const ProfileStats& stats = g_profileStats[stage];
+        stream->print(stageNames[stage]);
+        stream->print(',');
+        stream->print(stats.m_count);
+        stream->print(',');
+        stream->print(stats.m_min);
+        stream->print(',');
+        stream->print(stats.m_count > 0 ? stats.m_total / stats.m_count : 0ul);
+        stream->print(',');
+        stream->print(stats.m_max);
+        for(uint8_t bucketIdx = 0; bucketIdx < k_profileBuckets; ++bucketIdx)
+        {
+            stream->print(',');
+            stream->print(stats.m_buckets[bucketIdx]);
+        }
+        stream->print('\n');
+    }
+}
+
+uint8_t Profiler::GetBucket(uint32_t time)
+{
+    uint8_t bucket = 0;
+    while(time > 1u && bucket < k_profileBuckets - 1u)
+    {
+        time >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
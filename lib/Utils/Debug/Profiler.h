@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+
+class Print;
+
+// Buckets of the duration histogram. Bucket N counts durations of [2^N, 2^(N+1)) us (bucket 0 also
+// counts 0us), the last one everything longer
+static const uint8_t k_profileBuckets = 16;
+
+// Stages the profiler can track (the app names them, see Profiler::Write)
+static const uint8_t k_maxProfileStages = 8;
+
+// Stats of a profiled stage, a few bytes each so they can stay on while flying
+struct ProfileStats
+{
+    uint32_t m_count;
+    uint32_t m_total;                       // us, for the mean
+    uint16_t m_min;                         // us, saturated
+    uint16_t m_max;                         // us, saturated
+    uint8_t m_buckets[k_profileBuckets];    // All of them are halved when one fills up, the shape stays
+};
+
+// Accumulates micros() durations per stage. Use the PROFILE_ macros, they compile to nothing
+// unless PROFILER_ENABLED is defined
+class Profiler
+{
+public:
+    static void Add(uint8_t stage, uint32_t time);
+
+    static const ProfileStats& GetStats(uint8_t stage);
+
+    static void Reset();
+
+    // One CSV row per stage: STAGE,COUNT,MIN_US,MEAN_US,MAX_US and the histogram, its columns are titled
+    // with the lowest duration (us) of their bucket
+    static void Write(Print* stream, const char* const* stageNames, uint8_t numStages);
+
+    // Bucket for a duration (us)
+    static uint8_t GetBucket(uint32_t time);
+};
+
+#ifdef PROFILER_ENABLED
+
+#include "HAL.h"
+
+// Times the enclosing scope
+class ProfileScope
+{
+public:
+    explicit ProfileScope(uint8_t stage)
+        : m_start(micros())
+        , m_stage(stage)
+    {
+    }
+
+    ~ProfileScope()
+    {
+        Profiler::Add(m_stage, micros() - m_start);
+    }
+
+private:
+    uint32_t m_start;
+    uint8_t m_stage;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#define PROFILE_SCOPE(stage) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)((uint8_t)(stage))
+#define PROFILE_RESET() Profiler::Reset()
+
+#else
+
+#define PROFILE_SCOPE(stage)
+#define PROFILE_RESET()
+
+#endif
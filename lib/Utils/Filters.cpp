@@ -1,6 +1,6 @@
 #include "Filters.h"
 
-#include <Arduino.h>
+#include <string.h>
 
 MedianFilter::MedianFilter()
     : m_windowIndex(0)
@@ -0,0 +1,129 @@
+#include "FixedRateTimer.h"
+
+#include <string.h>
+
+FixedRateTimer::FixedRateTimer()
+    : m_period(0)
+    , m_periodMs(0)
+    , m_periodUs(0)
+    , m_deadline(0)
+    , m_nextTimeMs(0)
+    , m_nextTimeUs(0)
+    , m_timeMs(0)
+    , m_timeUs(0)
+    , m_ticked(false)
+{
+}
+
+void FixedRateTimer::Start(uint32_t now, uint32_t period)
+{
+    m_deadline = now;
+    m_nextTimeMs = 0;
+    m_nextTimeUs = 0;
+    m_timeMs = 0;
+    m_timeUs = 0;
+    m_ticked = false;
+    SetPeriod(period);
+}
+
+void FixedRateTimer::SetPeriod(uint32_t period)
+{
+    // Move the pending deadline to one new period after the last tick
+    if(m_ticked)
+    {
+        m_deadline -= m_period;
+        m_nextTimeMs = m_timeMs;
+        m_nextTimeUs = m_timeUs;
+    }
+
+    m_period = period;
+    m_periodMs = period / 1000u;
+    m_periodUs = (uint16_t)(period % 1000u);
+
+    if(m_ticked)
+    {
+        Advance();
+    }
+}
+
+uint32_t FixedRateTimer::GetPeriod()const
+{
+    return m_period;
+}
+
+bool FixedRateTimer::Poll(uint32_t now, TimerStats* stats /*= nullptr*/)
+{
+    // Unsigned subtraction handles micros() wrapping around
+    uint32_t lateness = now - m_deadline;
+    if((int32_t)lateness < 0)
+    {
+        return false;
+    }
+
+    m_timeMs = m_nextTimeMs;
+    m_timeUs = m_nextTimeUs;
+    Advance();
+
+    uint32_t overruns = 0;
+    while(lateness >= m_period && m_period > 0)
+    {
+        // Skip the tick we missed
+        lateness -= m_period;
+        m_timeMs = m_nextTimeMs;
+        m_timeUs = m_nextTimeUs;
+        Advance();
+        ++overruns;
+    }
+
+    m_ticked = true;
+    if(stats != nullptr)
+    {
+        ++stats->m_ticks;
+        stats->m_overruns += overruns;
+        stats->m_totalLateness += lateness;
+        if(lateness > stats->m_maxLateness)
+        {
+            stats->m_maxLateness = lateness;
+        }
+    }
+
+    return true;
+}
+
+uint32_t FixedRateTimer::GetTickDeadline()const
+{
+    // m_deadline already points to the next tick
+    return m_deadline - m_period;
+}
+
+uint32_t FixedRateTimer::GetNextDeadline()const
+{
+    return m_deadline;
+}
+
+uint32_t FixedRateTimer::GetTime()const
+{
+    return m_timeMs;
+}
+
+float FixedRateTimer::GetTimeSec()const
+{
+    return (float)m_timeMs * 0.001f + (float)m_timeUs * 0.000001f;
+}
+
+void ResetTimerStats(TimerStats& stats)
+{
+    memset(&stats, 0, sizeof(TimerStats));
+}
+
+void FixedRateTimer::Advance()
+{
+    m_deadline += m_period;
+    m_nextTimeMs += m_periodMs;
+    m_nextTimeUs += m_periodUs;
+    if(m_nextTimeUs >= 1000u)
+    {
+        m_nextTimeUs -= 1000u;
+        ++m_nextTimeMs;
+    }
+}
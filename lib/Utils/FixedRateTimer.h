@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+
+// Kept by the owner of the timer, only the ones it cares about get a set (see Poll)
+struct TimerStats
+{
+    uint32_t m_ticks;
+    uint32_t m_overruns;        // Ticks skipped because we were more than a period late
+    uint32_t m_maxLateness;     // us
+    uint32_t m_totalLateness;   // us, divide by m_ticks for the mean
+};
+
+void ResetTimerStats(TimerStats& stats);
+
+// Fixed rate ticks from a free running microsecond clock (micros()). Deadlines advance by the
+// period instead of from the time we noticed the tick, so late ticks don't make the rate drift.
+// The tick time is kept as integer ms plus a us remainder, no float accumulation
+class FixedRateTimer
+{
+public:
+    FixedRateTimer();
+
+    // First tick is due at 'now' (us)
+    void Start(uint32_t now, uint32_t period);
+
+    // Next deadline is one new period after the last tick
+    void SetPeriod(uint32_t period);
+
+    uint32_t GetPeriod()const;
+
+    // Returns true when a tick is due. If we fell a whole period (or more) behind, the missed
+    // ticks are skipped so we don't fire a burst to catch up. The tick goes into 'stats' if given
+    bool Poll(uint32_t now, TimerStats* stats = nullptr);
+
+    // micros() time the last tick was due at
+    uint32_t GetTickDeadline()const;
+
+    // micros() time the next tick is due at
+    uint32_t GetNextDeadline()const;
+
+    // Scheduled time of the last tick since Start, ms
+    uint32_t GetTime()const;
+
+    // Same as above, seconds
+    float GetTimeSec()const;
+
+private:
+    void Advance();
+
+    uint32_t m_period;          // us
+    uint32_t m_periodMs;        // m_period split in ms and us so the tick time stays exact
+    uint16_t m_periodUs;
+    uint32_t m_deadline;        // us, in micros() time (wraps around)
+    uint32_t m_nextTimeMs;      // Tick time of the next deadline
+    uint16_t m_nextTimeUs;
+    uint32_t m_timeMs;          // Tick time of the last tick
+    uint16_t m_timeUs;
+    bool m_ticked;              // At least one tick since Start
+};
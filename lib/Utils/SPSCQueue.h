@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+
+// Single producer, single consumer queue with a fixed capacity, nothing is allocated.
+// The producer can be an ISR: each side only writes its own index and both indices are
+// a single byte, so loads and stores are atomic on the AVR without disabling interrupts.
+// The __atomic builtins keep the compiler (and the CPU on the host) from reordering the
+// item copy around the index update
+template<typename T, uint8_t Capacity>
+class SPSCQueue
+{
+    static_assert(Capacity > 0 && Capacity <= 128 && (Capacity & (Capacity - 1)) == 0,
+        "Capacity has to be a power of two up to 128 (the indices wrap around at 256)");
+
+public:
+    SPSCQueue()
+        : m_head(0)
+        , m_tail(0)
+        , m_overflows(0)
+    {
+    }
+
+    // Producer side. If the queue is full the item is dropped and counted as an overflow
+    bool Push(const T& item)
+    {
+        const uint8_t head = __atomic_load_n(&m_head, __ATOMIC_RELAXED);
+        const uint8_t tail = __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE);
+        if((uint8_t)(head - tail) == Capacity)
+        {
+            m_overflows = m_overflows + 1u;
+            return false;
+        }
+
+        m_items[head & (Capacity - 1)] = item;
+        __atomic_store_n(&m_head, (uint8_t)(head + 1u), __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // Consumer side. Returns false if the queue is empty
+    bool Pop(T& item)
+    {
+        const uint8_t tail = __atomic_load_n(&m_tail, __ATOMIC_RELAXED);
+        const uint8_t head = __atomic_load_n(&m_head, __ATOMIC_ACQUIRE);
+        if(head == tail)
+        {
+            return false;
+        }
+
+        item = m_items[tail & (Capacity - 1)];
+        __atomic_store_n(&m_tail, (uint8_t)(tail + 1u), __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // Items waiting, exact from the consumer side (the producer may add more meanwhile)
+    uint8_t GetSize()const
+    {
+        return (uint8_t)(__atomic_load_n(&m_head, __ATOMIC_ACQUIRE) - __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE));
+    }
+
+    // Items dropped because the queue was full. Safe to call from the consumer side
+    uint32_t GetOverflows()const
+    {
+        // The counter is 4 bytes (not atomic on the AVR) but it only goes up, read it until it's stable
+        uint32_t overflows = 0;
+        uint32_t check = 0;
+        do
+        {
+            overflows = m_overflows;
+            check = m_overflows;
+        } while(overflows != check);
+        return overflows;
+    }
+
+    static constexpr uint8_t GetCapacity()
+    {
+        return Capacity;
+    }
+
+private:
+    T m_items[Capacity];
+    uint8_t m_head;         // Written by the producer only
+    uint8_t m_tail;         // Written by the consumer only
+    volatile uint32_t m_overflows; // Written by the producer only (__atomic would need libatomic on the AVR for 4 bytes)
+};
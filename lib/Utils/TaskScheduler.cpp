@@ -0,0 +1,218 @@
+#include "TaskScheduler.h"
+
+#include <string.h>
+
+TaskScheduler::TaskScheduler(ClockFunction clock)
+    : m_clock(clock)
+    , m_numTasks(0)
+    , m_timeBase(0)
+    , m_deadlineMisses(0)
+{
+    ResetTimerStats(m_timeBaseStats);
+}
+
+uint8_t TaskScheduler::AddTask(const char* name, TaskFunction function, void* context, uint32_t period, uint32_t deadline /*= 0*/)
+{
+    if(m_numTasks >= k_maxTasks)
+    {
+        return k_invalidTask;
+    }
+
+    Task& task = m_tasks[m_numTasks];
+    task.m_function = function;
+    task.m_context = context;
+    task.m_timer.Start(m_clock(), period);
+    task.m_deadline = deadline > 0 ? deadline : period;
+    task.m_enabled = true;
+    task.m_pending = false;
+    task.m_worstExecution = 0;
+#ifdef PROFILER_ENABLED
+    task.m_name = name;
+    memset(&task.m_stats, 0, sizeof(TaskStats));
+#else
+    (void)name;
+#endif
+
+    return m_numTasks++;
+}
+
+void TaskScheduler::Start()
+{
+    const uint32_t now = m_clock();
+    for(uint8_t taskIdx = 0; taskIdx < m_numTasks; ++taskIdx)
+    {
+        Task& task = m_tasks[taskIdx];
+        task.m_timer.Start(now, task.m_timer.GetPeriod());
+        task.m_pending = false;
+    }
+    ResetTimerStats(m_timeBaseStats);
+}
+
+void TaskScheduler::SetTimeBase(uint8_t task)
+{
+    m_timeBase = task;
+    ResetTimerStats(m_timeBaseStats);
+}
+
+void TaskScheduler::SetPeriod(uint8_t task, uint32_t period, uint32_t deadline /*= 0*/)
+{
+    m_tasks[task].m_timer.SetPeriod(period);
+    m_tasks[task].m_deadline = deadline > 0 ? deadline : period;
+}
+
+void TaskScheduler::SetEnabled(uint8_t task, bool enabled)
+{
+    m_tasks[task].m_enabled = enabled;
+    if(!enabled)
+    {
+        m_tasks[task].m_pending = false;
+    }
+}
+
+bool TaskScheduler::RunNext()
+{
+    const uint32_t now = m_clock();
+
+    // Release the tasks that are due and pick the one with the earliest deadline
+    uint8_t next = k_invalidTask;
+    int32_t nextSlack = 0;
+    for(uint8_t taskIdx = 0; taskIdx < m_numTasks; ++taskIdx)
+    {
+        Task& task = m_tasks[taskIdx];
+        const uint32_t due = task.m_timer.GetNextDeadline();
+        if(!task.m_pending && task.m_timer.Poll(now, taskIdx == m_timeBase ? &m_timeBaseStats : nullptr))
+        {
+            task.m_pending = task.m_enabled;
+
+            // Releases skipped because the task was still waiting to run missed their deadline too
+            const uint32_t skippedTime = task.m_timer.GetTickDeadline() - due;
+            if(task.m_enabled && skippedTime > 0)
+            {
+                const uint32_t skipped = skippedTime / task.m_timer.GetPeriod();
+                m_deadlineMisses += skipped;
+#ifdef PROFILER_ENABLED
+                task.m_stats.m_deadlineMisses += skipped;
+#endif
+            }
+        }
+
+        if(task.m_pending)
+        {
+            // Time left to the deadline (unsigned subtraction handles the clock wrapping around).
+            // The timer isn't polled while the task is pending, its last tick is the release
+            int32_t slack = (int32_t)(task.m_timer.GetTickDeadline() + task.m_deadline - now);
+            if(next == k_invalidTask || slack < nextSlack)
+            {
+                next = taskIdx;
+                nextSlack = slack;
+            }
+        }
+    }
+
+    if(next == k_invalidTask)
+    {
+        return false;
+    }
+
+    Task& task = m_tasks[next];
+    task.m_pending = false;
+
+    const uint32_t start = m_clock();
+    task.m_function(task.m_context);
+    const uint32_t end = m_clock();
+
+    const uint32_t execution = end - start;
+    const uint32_t response = end - task.m_timer.GetTickDeadline();
+    if(execution > task.m_worstExecution)
+    {
+        task.m_worstExecution = execution > 0xFFFFu ? 0xFFFFu : (uint16_t)execution;
+    }
+    if(response > task.m_deadline)
+    {
+        ++m_deadlineMisses;
+    }
+
+#ifdef PROFILER_ENABLED
+    TaskStats& stats = task.m_stats;
+    ++stats.m_runs;
+    if(response > task.m_deadline)
+    {
+        ++stats.m_deadlineMisses;
+    }
+    if(response > stats.m_worstResponse)
+    {
+        stats.m_worstResponse = response;
+    }
+#endif
+
+    return true;
+}
+
+uint32_t TaskScheduler::GetTimeToNextRelease(uint32_t now)const
+{
+    uint32_t timeToRelease = 0xFFFFFFFFu;
+    for(uint8_t taskIdx = 0; taskIdx < m_numTasks; ++taskIdx)
+    {
+        const Task& task = m_tasks[taskIdx];
+        const int32_t untilRelease = (int32_t)(task.m_timer.GetNextDeadline() - now);
+        if(task.m_pending || untilRelease <= 0)
+        {
+            return 0;
+        }
+        if((uint32_t)untilRelease < timeToRelease)
+        {
+            timeToRelease = (uint32_t)untilRelease;
+        }
+    }
+    return timeToRelease;
+}
+
+uint8_t TaskScheduler::GetNumTasks()const
+{
+    return m_numTasks;
+}
+
+const FixedRateTimer& TaskScheduler::GetTimer(uint8_t task)const
+{
+    return m_tasks[task].m_timer;
+}
+
+const TimerStats& TaskScheduler::GetTimeBaseStats()const
+{
+    return m_timeBaseStats;
+}
+
+uint16_t TaskScheduler::GetWorstExecution(uint8_t task)const
+{
+    return m_tasks[task].m_worstExecution;
+}
+
+uint32_t TaskScheduler::GetDeadlineMisses()const
+{
+    return m_deadlineMisses;
+}
+
+void TaskScheduler::ResetStats()
+{
+    ResetTimerStats(m_timeBaseStats);
+    m_deadlineMisses = 0;
+    for(uint8_t taskIdx = 0; taskIdx < m_numTasks; ++taskIdx)
+    {
+        m_tasks[taskIdx].m_worstExecution = 0;
+#ifdef PROFILER_ENABLED
+        memset(&m_tasks[taskIdx].m_stats, 0, sizeof(TaskStats));
+#endif
+    }
+}
+
+#ifdef PROFILER_ENABLED
+const char* TaskScheduler::GetName(uint8_t task)const
+{
+    return m_tasks[task].m_name;
+}
+
+const TaskStats& TaskScheduler::GetStats(uint8_t task)const
+{
+    return m_tasks[task].m_stats;
+}
+#endif
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "FixedRateTimer.h"
+
+typedef void (*TaskFunction)(void* context);
+
+// Returns the current time in us (micros() on the device)
+typedef uint32_t (*ClockFunction)();
+
+#ifdef PROFILER_ENABLED
+struct TaskStats
+{
+    uint32_t m_runs;
+    uint32_t m_deadlineMisses;  // Late runs and skipped releases
+    uint32_t m_worstResponse;   // us, from the release to the end of the run
+};
+#endif
+
+// Cooperative (non preemptive) scheduler for periodic tasks. Released tasks run one at a time,
+// earliest deadline first (ties go to the task added first). Tasks are stored in a fixed table,
+// nothing is allocated. Every build keeps the worst execution time of each task, the deadline misses of
+// all of them and the release lateness of the time base task (see SetTimeBase). The names and the per
+// task TaskStats are only kept with PROFILER_ENABLED
+class TaskScheduler
+{
+public:
+    static const uint8_t k_maxTasks = 6;
+    static const uint8_t k_invalidTask = 0xFF;
+
+    explicit TaskScheduler(ClockFunction clock);
+
+    // 'period' and 'deadline' in us, the deadline is relative to the release (0 means the period).
+    // Returns the task id or k_invalidTask if the table is full
+    uint8_t AddTask(const char* name, TaskFunction function, void* context, uint32_t period, uint32_t deadline = 0);
+
+    // All the tasks get released now, the time base stats are reset
+    void Start();
+
+    // The task whose releases are the time base (the first one by default), its TimerStats are kept
+    void SetTimeBase(uint8_t task);
+
+    // Applies from the next release, counted from the last one
+    void SetPeriod(uint8_t task, uint32_t period, uint32_t deadline = 0);
+
+    // Disabled tasks keep their timebase but don't run
+    void SetEnabled(uint8_t task, bool enabled);
+
+    // Runs the released task with the earliest deadline. Returns false if there was nothing to run
+    bool RunNext();
+
+    // us from 'now' to the next release (0 if a task is waiting to run). Disabled tasks count too,
+    // their timers have to be polled to keep the time base
+    uint32_t GetTimeToNextRelease(uint32_t now)const;
+
+    uint8_t GetNumTasks()const;
+
+    // Release timer of the task, it has the release time base
+    const FixedRateTimer& GetTimer(uint8_t task)const;
+
+    // Lateness and overruns of the time base task releases
+    const TimerStats& GetTimeBaseStats()const;
+
+    // us, it saturates at 0xFFFF
+    uint16_t GetWorstExecution(uint8_t task)const;
+
+    // Late runs and skipped releases of all the tasks
+    uint32_t GetDeadlineMisses()const;
+
+    void ResetStats();
+
+#ifdef PROFILER_ENABLED
+    // The pointer given to AddTask, the scheduler doesn't read it (it can be a PROGMEM string)
+    const char* GetName(uint8_t task)const;
+
+    const TaskStats& GetStats(uint8_t task)const;
+#endif
+
+private:
+    struct Task
+    {
+        TaskFunction m_function;
+        void* m_context;
+        FixedRateTimer m_timer; // The pending release is its last tick
+        uint32_t m_deadline;    // us, relative to the release
+        bool m_enabled;
+        bool m_pending;
+        uint16_t m_worstExecution; // us
+#ifdef PROFILER_ENABLED
+        const char* m_name;
+        TaskStats m_stats;
+#endif
+    };
+
+    ClockFunction m_clock;
+    Task m_tasks[k_maxTasks];
+    uint8_t m_numTasks;
+    uint8_t m_timeBase;
+    TimerStats m_timeBaseStats;
+    uint32_t m_deadlineMisses;
+};
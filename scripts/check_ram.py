@@ -0,0 +1,38 @@
+# Post build check of the static SRAM (Release and Debug envs).
+# PlatformIO only fails when .data + .bss is over the whole 2 KB, the stack grows down into what's left and
+# overwrites the globals without any error. This fails the build when less than custom_stack_reserve bytes are
+# left, and prints the avr-size numbers the budget is set from
+import re
+import subprocess
+
+Import("env")
+
+
+def read_sections(elf):
+    sections = {}
+    output = subprocess.check_output([env.subst("$SIZETOOL"), "-A", elf]).decode()
+    for line in output.splitlines():
+        match = re.match(r"^(\.\w+)\s+(\d+)\s+\d+", line)
+        if match:
+            sections[match.group(1)] = int(match.group(2))
+    return sections
+
+
+def check_ram(source, target, env):
+    elf = str(target[0])
+    sections = read_sections(elf)
+    ram = sections.get(".data", 0) + sections.get(".bss", 0) + sections.get(".noinit", 0)
+    flash = sections.get(".text", 0) + sections.get(".data", 0)
+    ram_size = int(env.BoardConfig().get("upload.maximum_ram_size"))
+    flash_size = int(env.BoardConfig().get("upload.maximum_size"))
+    stack_reserve = int(env.GetProjectOption("custom_stack_reserve"))
+
+    print("avr-size: .data = %d, .bss = %d, .noinit = %d, flash = %d of %d bytes" % (
+        sections.get(".data", 0), sections.get(".bss", 0), sections.get(".noinit", 0), flash, flash_size))
+    print("SRAM: %d static + %d stack reserve of %d bytes" % (ram, stack_reserve, ram_size))
+    if ram + stack_reserve > ram_size:
+        print("Error: the globals leave %d bytes for the stack, custom_stack_reserve is %d" % (ram_size - ram, stack_reserve))
+        env.Exit(1)
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", check_ram)
@@ -0,0 +1,279 @@
+#include "FRAMDirectory.h"
+
+#include "Storage/MB85RS2MTA/MB85RS2MTA.h"
+
+#include "CRC16.h"
+#include "HAL.h"
+
+#include <string.h>
+
+FRAMDirectory::FRAMDirectory()
+    : m_fram(nullptr)
+    , m_header()
+    , m_journalSequence(0)
+    , m_moveSequence(0)
+{
+}
+
+bool FRAMDirectory::Load(MB85RS2MTA* fram)
+{
+    m_fram = fram;
+    m_fram->Read(0, (uint8_t*)&m_header, sizeof(FRAMDirectoryHeader));
+    if(m_header.m_magic == k_framDirectoryMagic && m_header.m_version == k_framDirectoryVersion &&
+        m_header.m_numSegments <= k_maxFRAMSegments)
+    {
+        FRAMMove move;
+        m_moveSequence = 0;
+        if(ReadMove(move))
+        {
+            m_moveSequence = move.m_sequence;
+            if(move.m_size > 0)
+            {
+                MoveDown(move);
+            }
+        }
+        return true;
+    }
+
+    m_header.m_magic = k_framDirectoryMagic;
+    m_header.m_version = k_framDirectoryVersion;
+    m_header.m_numSegments = 0;
+    WriteHeader();
+
+    // Whatever was there could pass for a move
+    FRAMMove moves[2];
+    memset(moves, 0, sizeof(moves));
+    m_fram->Write(k_moveAddress, (const uint8_t*)moves, sizeof(moves));
+    m_moveSequence = 0;
+    return false;
+}
+
+uint8_t FRAMDirectory::GetNumSegments()const
+{
+    return m_header.m_numSegments;
+}
+
+bool FRAMDirectory::ReadSegment(uint8_t index, FRAMSegment& segment)
+{
+    if(index >= m_header.m_numSegments)
+    {
+        return false;
+    }
+    m_fram->Read(GetSlotAddress(index), (uint8_t*)&segment, sizeof(FRAMSegment));
+    return true;
+}
+
+void FRAMDirectory::WriteSegment(uint8_t index, const FRAMSegment& segment)
+{
+    m_fram->Write(GetSlotAddress(index), (const uint8_t*)&segment, sizeof(FRAMSegment));
+}
+
+bool FRAMDirectory::Allocate(uint32_t minSize, uint8_t& index, FRAMSegment& segment)
+{
+    if(m_header.m_numSegments == k_maxFRAMSegments)
+    {
+        return false;
+    }
+
+    if(GetFreeSpace() < minSize)
+    {
+        Compact();
+        if(GetFreeSpace() < minSize)
+        {
+            return false;
+        }
+    }
+
+    segment.m_start = GetDataEnd();
+    segment.m_size = m_fram->Capacity() - segment.m_start;
+    segment.m_logEnd = 0;
+    segment.m_numSamples = 0;
+    segment.m_flightTime = 0;
+    segment.m_apogee = 0.0f;
+    segment.m_state = FRAMSegmentState::Recording;
+    segment.m_flags = 0;
+
+    // A commit of the last flight could point to the same start
+    FlightJournal journals[2];
+    memset(journals, 0, sizeof(journals));
+    m_fram->Write(k_journalAddress, (const uint8_t*)journals, sizeof(journals));
+    m_journalSequence = 0;
+
+    // The slot goes first, a header counting it always points to a valid one
+    index = m_header.m_numSegments;
+    WriteSegment(index, segment);
+    ++m_header.m_numSegments;
+    WriteHeader();
+    return true;
+}
+
+void FRAMDirectory::Free(uint8_t index)
+{
+    if(index >= m_header.m_numSegments)
+    {
+        return;
+    }
+
+    FRAMSegment segment;
+    for(uint8_t slotIdx = index + 1; slotIdx < m_header.m_numSegments; ++slotIdx)
+    {
+        ReadSegment(slotIdx, segment);
+        WriteSegment(slotIdx - 1, segment);
+    }
+    --m_header.m_numSegments;
+    WriteHeader();
+}
+
+void FRAMDirectory::Compact()
+{
+    uint32_t address = k_dataStart;
+    FRAMSegment segment;
+    for(uint8_t slotIdx = 0; slotIdx < m_header.m_numSegments; ++slotIdx)
+    {
+        ReadSegment(slotIdx, segment);
+        if(segment.m_start != address)
+        {
+            FRAMMove move;
+            move.m_from = segment.m_start;
+            move.m_to = address;
+            move.m_size = segment.m_size;
+            move.m_done = 0;
+            move.m_slot = slotIdx;
+            WriteMove(move);
+            MoveDown(move);
+        }
+        address += segment.m_size;
+    }
+}
+
+uint32_t FRAMDirectory::GetFreeSpace()
+{
+    return m_fram->Capacity() - GetDataEnd();
+}
+
+void FRAMDirectory::Commit(uint32_t logEnd, uint32_t numSamples)
+{
+    FlightJournal journal;
+    journal.m_magic = k_flightJournalMagic;
+    journal.m_sequence = ++m_journalSequence;
+    journal.m_logEnd = logEnd;
+    journal.m_numSamples = numSamples;
+    journal.m_crc = GetJournalCRC(journal);
+    m_fram->Write(GetJournalAddress(journal.m_sequence), (const uint8_t*)&journal, sizeof(FlightJournal));
+}
+
+bool FRAMDirectory::ReadJournal(FlightJournal& journal)
+{
+    bool found = false;
+    FlightJournal slot;
+    for(uint8_t slotIdx = 0; slotIdx < 2; ++slotIdx)
+    {
+        m_fram->Read(GetJournalAddress(slotIdx), (uint8_t*)&slot, sizeof(FlightJournal));
+        if(slot.m_magic != k_flightJournalMagic || slot.m_crc != GetJournalCRC(slot))
+        {
+            continue;
+        }
+        if(!found || (int16_t)(slot.m_sequence - journal.m_sequence) > 0)
+        {
+            journal = slot;
+            found = true;
+        }
+    }
+    return found;
+}
+
+uint32_t FRAMDirectory::GetSlotAddress(uint8_t index)
+{
+    return sizeof(FRAMDirectoryHeader) + (uint32_t)index * sizeof(FRAMSegment);
+}
+
+uint32_t FRAMDirectory::GetDataEnd()
+{
+    if(m_header.m_numSegments == 0)
+    {
+        return k_dataStart;
+    }
+
+    FRAMSegment segment;
+    ReadSegment(m_header.m_numSegments - 1, segment);
+    return segment.m_start + segment.m_size;
+}
+
+void FRAMDirectory::MoveDown(FRAMMove& move)
+{
+    // Front to back, a chunk is read before anything overwrites it. A chunk isn't longer than the distance of the
+    // move so it doesn't overwrite its own source: after a power loss the copy starts again from the last m_done
+    // (the chunk in flight or a torn m_done write is copied twice, from the same bytes)
+    uint8_t chunk[MB85RS2MTA::k_writeBufferSize];
+    const uint32_t maxChunkSize = min((uint32_t)sizeof(chunk), move.m_from - move.m_to);
+    while(move.m_done < move.m_size)
+    {
+        const uint32_t chunkSize = min(move.m_size - move.m_done, maxChunkSize);
+        m_fram->FastRead(move.m_from + move.m_done, chunk, chunkSize);
+        m_fram->Write(move.m_to + move.m_done, chunk, chunkSize);
+        move.m_done += chunkSize;
+        WriteMove(move);
+    }
+
+    // The slot only points to the copy once it's all there. The move ends after it, a power loss in between
+    // writes the same slot again
+    FRAMSegment segment;
+    ReadSegment(move.m_slot, segment);
+    segment.m_start = move.m_to;
+    WriteSegment(move.m_slot, segment);
+    move.m_size = 0;
+    WriteMove(move);
+}
+
+void FRAMDirectory::WriteMove(FRAMMove& move)
+{
+    move.m_magic = k_framMoveMagic;
+    move.m_sequence = ++m_moveSequence;
+    move.m_crc = GetMoveCRC(move);
+    m_fram->Write(GetMoveAddress(move.m_sequence), (const uint8_t*)&move, sizeof(FRAMMove));
+}
+
+bool FRAMDirectory::ReadMove(FRAMMove& move)
+{
+    bool found = false;
+    FRAMMove slot;
+    for(uint8_t slotIdx = 0; slotIdx < 2; ++slotIdx)
+    {
+        m_fram->Read(GetMoveAddress(slotIdx), (uint8_t*)&slot, sizeof(FRAMMove));
+        if(slot.m_magic != k_framMoveMagic || slot.m_crc != GetMoveCRC(slot))
+        {
+            continue;
+        }
+        if(!found || (int16_t)(slot.m_sequence - move.m_sequence) > 0)
+        {
+            move = slot;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void FRAMDirectory::WriteHeader()
+{
+    m_fram->Write(0, (const uint8_t*)&m_header, sizeof(FRAMDirectoryHeader));
+}
+
+uint32_t FRAMDirectory::GetJournalAddress(uint16_t sequence)
+{
+    return k_journalAddress + (sequence & 1u) * (uint32_t)sizeof(FlightJournal);
+}
+
+uint16_t FRAMDirectory::GetJournalCRC(const FlightJournal& journal)
+{
+    return UpdateCRC16(k_crc16Init, (const uint8_t*)&journal, sizeof(FlightJournal) - sizeof(journal.m_crc));
+}
+
+uint32_t FRAMDirectory::GetMoveAddress(uint16_t sequence)
+{
+    return k_moveAddress + (sequence & 1u) * (uint32_t)sizeof(FRAMMove);
+}
+
+uint16_t FRAMDirectory::GetMoveCRC(const FRAMMove& move)
+{
+    return UpdateCRC16(k_crc16Init, (const uint8_t*)&move, sizeof(FRAMMove) - sizeof(move.m_crc));
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "RMath.h"
+
+#include "LoggerDefinitions.h"
+
+class MB85RS2MTA;
+
+// Flight segments in the FRAM, listed in a directory at its start (see FRAMDirectoryHeader). Segments are
+// variable length and packed in address order: a new one goes after the last one and takes the rest of the FRAM
+// while it's recording, then it's trimmed to its log. Freed segments leave a gap until the next Compact.
+// Only the header is kept in RAM, the slots are read from the FRAM when needed
+class FRAMDirectory
+{
+public:
+    FRAMDirectory();
+
+    // Reads the directory at boot and finishes a Compact the power cut in the middle of a move. A blank FRAM (or one
+    // with a log of the firmware before the directory) gets an empty one, returns false then
+    bool Load(MB85RS2MTA* fram);
+
+    uint8_t GetNumSegments()const;
+
+    // Slots are in address order
+    bool ReadSegment(uint8_t index, FRAMSegment& segment);
+
+    void WriteSegment(uint8_t index, const FRAMSegment& segment);
+
+    // Adds a Recording segment after the last one, up to the end of the FRAM, and clears the journal. The segments
+    // get compacted first if there are less than 'minSize' bytes left after the last one. Returns false if there's no
+    // room (or no slot)
+    bool Allocate(uint32_t minSize, uint8_t& index, FRAMSegment& segment);
+
+    // Removes the slot, the segments after it keep their addresses until Compact
+    void Free(uint8_t index);
+
+    // Moves the segments down, next to each other from the end of the directory. Every move is recorded in a FRAMMove
+    // before the copy starts, a power loss leaves the segment where it was or where the next Load puts it
+    void Compact();
+
+    // Bytes after the last segment
+    uint32_t GetFreeSpace();
+
+    // Journals that the records of the Recording segment up to 'logEnd' are in the FRAM. A single write of
+    // sizeof(FlightJournal) bytes
+    void Commit(uint32_t logEnd, uint32_t numSamples);
+
+    // The last commit of the Recording segment, false if there's none
+    bool ReadJournal(FlightJournal& journal);
+
+    static const uint32_t k_journalAddress = sizeof(FRAMDirectoryHeader) + k_maxFRAMSegments * sizeof(FRAMSegment);
+
+    static const uint32_t k_moveAddress = k_journalAddress + 2u * sizeof(FlightJournal);
+
+    // First segment address, past the slots
+    static const uint32_t k_dataStart = k_moveAddress + 2u * sizeof(FRAMMove);
+
+private:
+    static uint32_t GetSlotAddress(uint8_t index);
+
+    // First byte after the last segment
+    uint32_t GetDataEnd();
+
+    // Copies the segment of the move from m_done to its end, to a lower address (the ranges can overlap), then points
+    // its slot to m_to and ends the move
+    void MoveDown(FRAMMove& move);
+
+    // Writes the move to the slot after the latest one
+    void WriteMove(FRAMMove& move);
+
+    // The latest move, false if there's none
+    bool ReadMove(FRAMMove& move);
+
+    void WriteHeader();
+
+    // Slot of a commit, they alternate
+    static uint32_t GetJournalAddress(uint16_t sequence);
+
+    static uint16_t GetJournalCRC(const FlightJournal& journal);
+
+    static uint32_t GetMoveAddress(uint16_t sequence);
+
+    static uint16_t GetMoveCRC(const FRAMMove& move);
+
+    MB85RS2MTA* m_fram;
+    FRAMDirectoryHeader m_header;
+    uint16_t m_journalSequence;     // Last commit
+    uint16_t m_moveSequence;        // Last FRAMMove write
+};
@@ -0,0 +1,84 @@
+#include "FlightDetector.h"
+
+#include "HAL.h"
+
+FlightDetector::FlightDetector()
+    : m_settings()
+    , m_liftOffAltitude(0.0f)
+    , m_liftOffTime(0.0f)
+    , m_lastTime(0.0f)
+    , m_maxAltitude(0.0f)
+{
+}
+
+void FlightDetector::SetSettings(const DetectorSettings& settings)
+{
+    m_settings = settings;
+}
+
+const DetectorSettings& FlightDetector::GetSettings()const
+{
+    return m_settings;
+}
+
+DetectorSettings FlightDetector::ScaleSettings(const DetectorSettings& settings, float altitudeScale, float accelerationScale)
+{
+    DetectorSettings scaled = settings;
+    scaled.m_liftoffClimb *= altitudeScale;
+    scaled.m_liftoffAcceleration *= accelerationScale;
+    scaled.m_landingBand *= altitudeScale;
+    scaled.m_landingAcceleration *= accelerationScale;
+    scaled.m_landingStillBand *= altitudeScale;
+    scaled.m_apogeeDrop *= altitudeScale;
+    return scaled;
+}
+
+bool FlightDetector::CheckLiftoff(const State& current, const State& previous)const
+{
+    float deltaAltitude = current.m_altitude - previous.m_altitude;
+    return deltaAltitude >= m_settings.m_liftoffClimb && current.m_acceleration.y * k_standardGravity > m_settings.m_liftoffAcceleration;
+}
+
+void FlightDetector::BeginFlight(const State& liftoff)
+{
+    m_liftOffAltitude = liftoff.m_altitude;
+    m_liftOffTime = liftoff.m_timeStamp;
+    m_lastTime = liftoff.m_timeStamp;
+    m_maxAltitude = liftoff.m_altitude;
+    m_landingFilter = MedianFilter();
+}
+
+bool FlightDetector::CheckLanding(const State& current)
+{
+    // Check if we landed
+    // 0) Be past apogee. While coasting the accelerometer reads ~0 and the altitude can repeat
+    //    between barometer conversions, close to the pad that looks like a landing
+    // 1) Be within 10 meters of the lift off altitude
+    m_lastTime = current.m_timeStamp;
+    m_maxAltitude = max(m_maxAltitude, current.m_altitude);
+    bool pastApogee = m_maxAltitude - current.m_altitude >= m_settings.m_apogeeDrop;
+    float liftDelta = abs(m_liftOffAltitude - current.m_altitude);
+    if(!pastApogee || liftDelta > m_settings.m_landingBand)
+    {
+        return false;
+    }
+
+    // 2) Not be under power (total acceleration vector less than 10m/s2)
+    float accelLen = Length(current.m_acceleration) * k_standardGravity;
+
+    // 3) Altitude is not changing (median is within 30cm)
+    float altitudeMedian = m_landingFilter.ProcessEntry(current.m_altitude);
+    float altitudeDeltaMedian = abs(altitudeMedian - current.m_altitude);
+
+    return (accelLen <= m_settings.m_landingAcceleration) && (altitudeDeltaMedian < m_settings.m_landingStillBand);
+}
+
+float FlightDetector::GetApogee()const
+{
+    return m_maxAltitude - m_liftOffAltitude;
+}
+
+float FlightDetector::GetFlightTime()const
+{
+    return m_lastTime - m_liftOffTime;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "RMath.h"
+#include "Filters.h"
+
+#include "LoggerDefinitions.h"
+
+// The IMU gives G, the detection thresholds are in m/s2
+static const float k_standardGravity = 9.80665f;
+
+// Launch and landing detection over consecutive samples (see DetectorSettings). The logger runs it on
+// every sample it takes, the analysis tool re-runs it on the stored ones
+class FlightDetector
+{
+public:
+    FlightDetector();
+
+    void SetSettings(const DetectorSettings& settings);
+
+    const DetectorSettings& GetSettings()const;
+
+    // The same thresholds for samples in other units: 'altitudeScale' units per m, 'accelerationScale' units per G
+    static DetectorSettings ScaleSettings(const DetectorSettings& settings, float altitudeScale, float accelerationScale);
+
+    // Climbing under power since the 'previous' sample
+    bool CheckLiftoff(const State& current, const State& previous)const;
+
+    // Landing is tracked from the liftoff sample on
+    void BeginFlight(const State& liftoff);
+
+    // Past apogee, back close to the liftoff altitude, not under power and still
+    bool CheckLanding(const State& current);
+
+    // m from the liftoff altitude to the highest one so far
+    float GetApogee()const;
+
+    // s from the liftoff to the last sample checked
+    float GetFlightTime()const;
+
+private:
+    DetectorSettings m_settings;
+
+    // The altitude and time at the liftoff event
+    float m_liftOffAltitude;
+    float m_liftOffTime;
+
+    // Last sample checked (s)
+    float m_lastTime;
+
+    // Highest altitude since liftoff
+    float m_maxAltitude;
+
+    // Median filter used to figure out if we landed
+    MedianFilter m_landingFilter;
+};
@@ -0,0 +1,84 @@
+#include "LogCSV.h"
+
+#include "HAL.h"
+#include "CSVWriter.h"
+
+// The strings and the table both live in flash, read them with GetTaskName
+static const char k_baroTaskName[] PROGMEM = "BARO";
+static const char k_sampleTaskName[] PROGMEM = "SAMPLE";
+static const char k_recordTaskName[] PROGMEM = "RECORD";
+static const char k_detectorTaskName[] PROGMEM = "DETECTOR";
+static const char k_flushTaskName[] PROGMEM = "FLUSH";
+static const char k_dumpTaskName[] PROGMEM = "DUMP";
+
+static const char* const k_taskNames[k_numLoggerTasks] PROGMEM =
+{
+    k_baroTaskName, k_sampleTaskName, k_recordTaskName, k_detectorTaskName, k_flushTaskName, k_dumpTaskName
+};
+
+const char* GetTaskName(uint8_t task)
+{
+    return (const char*)pgm_read_ptr(&k_taskNames[task]);
+}
+
+// Decimals of the columns: the time has the ms the records store, the acceleration (G) mG
+static const uint8_t k_timeDigits = 3;
+static const uint8_t k_altitudeDigits = 2;
+static const uint8_t k_temperatureDigits = 2;
+static const uint8_t k_accelerationDigits = 3;
+static const uint8_t k_angularRateDigits = 2;
+
+// 9 floats, TEMP_AGE and the separators
+const uint16_t k_maxCSVRowLength = 9 * (k_maxCSVFloatLength + 1) + 4;
+
+void WriteCSVHeader(Print* stream)
+{
+    stream->print(F("TIME, ALTITUDE, TEMP, TEMP_AGE, ACCEL_X, ACCEL_Y, ACCEL_Z, RATE_X, RATE_Y, RATE_Z \n"));
+}
+
+void WriteCSVState(const State& state, Print* stream)
+{
+    CSVWriter row(stream);
+    row.AddFloat(state.m_timeStamp, k_timeDigits);
+    row.AddFloat(state.m_altitude, k_altitudeDigits);
+    row.AddFloat(state.m_temperature, k_temperatureDigits);
+    row.AddUInt(state.m_temperatureAge);
+    row.AddFloat(state.m_acceleration.x, k_accelerationDigits);
+    row.AddFloat(state.m_acceleration.y, k_accelerationDigits);
+    row.AddFloat(state.m_acceleration.z, k_accelerationDigits);
+    row.AddFloat(state.m_angularRate.x, k_angularRateDigits);
+    row.AddFloat(state.m_angularRate.y, k_angularRateDigits);
+    row.AddFloat(state.m_angularRate.z, k_angularRateDigits);
+    row.EndRow();
+}
+
+void WriteCSVSummary(const LogSummary& summary, Print* stream)
+{
+    // Not a sample, keep it as a comment line so the CSV still parses
+    stream->print(F("# SAMPLES="));
+    stream->print(summary.m_numSamples);
+    stream->print(F(", TICKS="));
+    stream->print(summary.m_ticks);
+    stream->print(F(", OVERRUNS="));
+    stream->print(summary.m_overruns);
+    stream->print(F(", MAX_LATENESS_US="));
+    stream->print(summary.m_maxLateness);
+    stream->print(F(", MEAN_LATENESS_US="));
+    stream->print(summary.m_meanLateness);
+    stream->print(F(", DEADLINE_MISSES="));
+    stream->print(summary.m_deadlineMisses);
+    stream->print(F(", QUEUE_OVERFLOWS="));
+    stream->print(summary.m_queueOverflows);
+    stream->print('\n');
+
+    // Worst case execution time per task
+    stream->print(F("# WCET_US"));
+    for(uint8_t taskIdx = 0; taskIdx < k_numLoggerTasks; ++taskIdx)
+    {
+        stream->print(taskIdx == 0 ? ' ' : ',');
+        stream->print(reinterpret_cast<const __FlashStringHelper*>(GetTaskName(taskIdx)));
+        stream->print('=');
+        stream->print(summary.m_taskWorstExecution[taskIdx]);
+    }
+    stream->print('\n');
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "RMath.h"
+
+#include "LoggerDefinitions.h"
+
+class Print;
+
+// Longest task name, without the terminator
+static const uint8_t k_maxTaskNameLength = 8;
+
+// Task name in LoggerTask order (the scheduler and the summary line use them). It's a PROGMEM string:
+// print it as a __FlashStringHelper or copy it with strcpy_P
+const char* GetTaskName(uint8_t task);
+
+// Longest a CSV row can be (see WriteCSVState)
+extern const uint16_t k_maxCSVRowLength;
+
+// The dumped CSV: a header line, a row per sample and the summary as comment lines. The logger writes
+// it to the card (DUMP_CSV) and the convert tool from a Log_N.bin, the output is the same
+void WriteCSVHeader(Print* stream);
+
+// A row, written to the stream in a single call (see CSVWriter)
+void WriteCSVState(const State& state, Print* stream);
+
+void WriteCSVSummary(const LogSummary& summary, Print* stream);
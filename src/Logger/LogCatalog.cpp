@@ -0,0 +1,108 @@
+#include "LogCatalog.h"
+
+#include "Storage/SD/SDCard.h"
+
+#include <stdio.h>
+#include <string.h>
+
+const char* const LogCatalog::k_path = "CATALOG.BIN";
+
+LogCatalog::LogCatalog()
+    : m_sd(nullptr)
+    , m_header()
+    , m_loaded(false)
+{
+}
+
+bool LogCatalog::Load(SDCard* sd)
+{
+    m_sd = sd;
+    m_loaded = false;
+    if(!m_sd->FileExists(k_path))
+    {
+        return true;
+    }
+
+    if(!m_sd->ReadFile(k_path, 0, (uint8_t*)&m_header, sizeof(CatalogHeader)) || m_header.m_magic != k_catalogMagic ||
+        m_header.m_version != k_catalogVersion || m_header.m_entrySize != sizeof(CatalogEntry))
+    {
+        return false;
+    }
+    m_loaded = true;
+    return true;
+}
+
+bool LogCatalog::Reserve(uint32_t& sequence)
+{
+    if(!m_loaded)
+    {
+        // A new catalog, past any log already there
+        m_header.m_magic = k_catalogMagic;
+        m_header.m_version = k_catalogVersion;
+        m_header.m_entrySize = sizeof(CatalogEntry);
+        m_header.m_reserved = 0;
+        m_header.m_nextSequence = FindFreeSequence();
+        m_header.m_numEntries = 0;
+    }
+
+    sequence = m_header.m_nextSequence++;
+    m_loaded = WriteHeader();
+    return m_loaded;
+}
+
+bool LogCatalog::Add(const CatalogEntry& entry)
+{
+    if(!m_loaded)
+    {
+        return false;
+    }
+
+    const uint32_t offset = sizeof(CatalogHeader) + m_header.m_numEntries * (uint32_t)sizeof(CatalogEntry);
+    if(!m_sd->WriteFile(k_path, offset, (const uint8_t*)&entry, sizeof(CatalogEntry)))
+    {
+        return false;
+    }
+    ++m_header.m_numEntries;
+    return WriteHeader();
+}
+
+uint32_t LogCatalog::GetNumEntries()const
+{
+    return m_loaded ? m_header.m_numEntries : 0u;
+}
+
+bool LogCatalog::ReadEntry(uint32_t index, CatalogEntry& entry)
+{
+    return index < GetNumEntries() &&
+        m_sd->ReadFile(k_path, sizeof(CatalogHeader) + index * (uint32_t)sizeof(CatalogEntry), (uint8_t*)&entry, sizeof(CatalogEntry));
+}
+
+void LogCatalog::GetLogName(uint32_t sequence, const char* extension, char* name)
+{
+    snprintf(name, k_maxLogNameLength, "Log_%lu.%s", (unsigned long)sequence, extension);
+}
+
+uint32_t LogCatalog::FindFreeSequence()
+{
+    // Only done once per card, the firmware before the catalog wrote up to Log_9
+    char name[k_maxLogNameLength];
+    uint32_t sequence = 0;
+    for(;; ++sequence)
+    {
+        GetLogName(sequence, "bin", name);
+        if(m_sd->FileExists(name))
+        {
+            continue;
+        }
+        GetLogName(sequence, "csv", name);
+        if(!m_sd->FileExists(name))
+        {
+            return sequence;
+        }
+    }
+}
+
+bool LogCatalog::WriteHeader()
+{
+    return m_sd->WriteFile(k_path, 0, (const uint8_t*)&m_header, sizeof(CatalogHeader));
+}
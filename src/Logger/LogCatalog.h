@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "RMath.h"
+
+#include "LoggerDefinitions.h"
+
+class SDCard;
+
+// Longest log name: "Log_4294967295.csv"
+static const uint8_t k_maxLogNameLength = 20;
+
+// Persistent list of the dumped logs (CATALOG.BIN, see CatalogHeader). It has the sequence number of the next
+// log, so naming a dump takes no directory lookups and there's no limit on the number of logs, and a
+// CatalogEntry per log with its flight summary
+class LogCatalog
+{
+public:
+    LogCatalog();
+
+    // Reads the header at boot. A card without a catalog gets one with the first dump
+    bool Load(SDCard* sd);
+
+    // Takes the next sequence number, it's saved right away so a dump that fails half way doesn't get
+    // overwritten by the next one. Returns false if the catalog can't be written
+    bool Reserve(uint32_t& sequence);
+
+    // Appends the entry of a finished dump
+    bool Add(const CatalogEntry& entry);
+
+    uint32_t GetNumEntries()const;
+
+    // Entries are in dump order
+    bool ReadEntry(uint32_t index, CatalogEntry& entry);
+
+    // "Log_<sequence>.<extension>"
+    static void GetLogName(uint32_t sequence, const char* extension, char* name);
+
+    static const char* const k_path;
+
+private:
+    // First sequence number without a log on the card (logs dumped before the catalog existed)
+    uint32_t FindFreeSequence();
+
+    bool WriteHeader();
+
+    SDCard* m_sd;
+    CatalogHeader m_header;
+    bool m_loaded;      // m_header matches the card
+};
@@ -0,0 +1,81 @@
+#include "LogDecoder.h"
+
+#include "Sensors/BMI160/BMI160.h"
+
+#include "Pressure.h"
+
+#include <string.h>
+
+static_assert(sizeof(RawState) <= k_maxRecordSize, "RawState doesn't fit in k_maxRecordSize");
+static_assert(k_packedRecordSize <= k_maxRecordSize, "Packed record doesn't fit in k_maxRecordSize");
+
+static uint32_t ReadU24(const uint8_t* data)
+{
+    return (uint32_t)data[0] << 16u | (uint32_t)data[1] << 8u | (uint32_t)data[2];
+}
+
+uint8_t GetRecordSize(RecordFormat format)
+{
+    switch(format)
+    {
+        case RecordFormat::Raw:         return (uint8_t)sizeof(RawState);
+        case RecordFormat::Packed:      return k_packedRecordSize;
+        case RecordFormat::Compressed:  return k_packedRecordSize;
+        default:                        return (uint8_t)sizeof(State);
+    }
+}
+
+RecordFormat GetFixedRecordFormat(RecordFormat format)
+{
+    return format == RecordFormat::Compressed ? RecordFormat::Packed : format;
+}
+
+LogDecoder::LogDecoder()
+    : m_header()
+{
+}
+
+void LogDecoder::Begin(const LogHeader& header)
+{
+    m_header = header;
+    m_baro.SetCalibration(header.m_baroCalibration);
+    m_packed.Reset(header.m_startTime, BMI160::GetAccRangeMult((AccRange)header.m_accRange));
+}
+
+void LogDecoder::DecodeRecord(RecordFormat format, const uint8_t* record, State& state)
+{
+    if(format == RecordFormat::Raw)
+    {
+        RawState rawState;
+        memcpy(&rawState, record, sizeof(RawState));
+
+        float pressure = 0.0f;
+        m_baro.Convert(ReadU24(rawState.m_pressure), ReadU24(rawState.m_temperature), pressure);
+
+        state.m_timeStamp = (float)rawState.m_timeStamp * 0.001f;
+        state.m_altitude = Pressure::GetAltitudeFromPa(Pressure::MBarToPascal(pressure), m_header.m_seaLevelPressure);
+        state.m_temperature = m_baro.GetLastTemperature();
+        state.m_temperatureAge = rawState.m_temperatureAge;
+
+        IMUSample sample;
+        for(uint8_t axis = 0; axis < 3; ++axis)
+        {
+            sample.m_acceleration[axis] = rawState.m_acceleration[axis];
+            sample.m_angularRate[axis] = rawState.m_angularRate[axis];
+        }
+        BMI160::ConvertSample(sample, (AccRange)m_header.m_accRange, state.m_acceleration, state.m_angularRate);
+    }
+    else if(format == RecordFormat::Packed)
+    {
+        m_packed.Decode(record, state);
+    }
+    else
+    {
+        memcpy(&state, record, sizeof(State));
+    }
+}
+
+void LogDecoder::DecodeChannels(const int32_t* channels, State& state)
+{
+    m_packed.Dequantize(channels, state);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "RMath.h"
+
+#include "LoggerDefinitions.h"
+#include "PackedRecord.h"
+
+#include "Sensors/MS5611/MS5611.h"
+
+// Biggest fixed size record (RecordFormat::Float)
+static const uint8_t k_maxRecordSize = sizeof(State);
+
+// Bytes used by a record in the given format (the worst case for RecordFormat::Compressed)
+uint8_t GetRecordSize(RecordFormat format);
+
+// Format used where every record needs the same size (the pre-trigger ring). It's the log
+// format unless that one is variable sized
+RecordFormat GetFixedRecordFormat(RecordFormat format);
+
+// Converts stored records back to State using the info in the LogHeader. Delta encoded
+// timestamps are tracked here so records have to be decoded in the order they were stored
+class LogDecoder
+{
+public:
+    LogDecoder();
+
+    void Begin(const LogHeader& header);
+
+    // Decodes a fixed size record (RecordFormat::Float, Raw or Packed)
+    void DecodeRecord(RecordFormat format, const uint8_t* record, State& state);
+
+    // Decodes a record of a RecordFormat::Compressed block (see StreamDecompressor)
+    void DecodeChannels(const int32_t* channels, State& state);
+
+private:
+    LogHeader m_header;
+
+    // Raw records are converted with the calibration stored with the log
+    MS5611 m_baro;
+
+    PackedRecordCodec m_packed;
+};
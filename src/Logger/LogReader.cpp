@@ -0,0 +1,181 @@
+#include "LogReader.h"
+
+#include <string.h>
+
+MemoryLogStorage::MemoryLogStorage(const uint8_t* data, uint32_t size)
+    : m_data(data)
+    , m_size(size)
+{
+}
+
+bool MemoryLogStorage::Read(uint32_t address, uint8_t* data, uint32_t size)
+{
+    if(address > m_size || size > m_size - address)
+    {
+        return false;
+    }
+    memcpy(data, m_data + address, size);
+    return true;
+}
+
+LogReader::LogReader(LogStorage* storage)
+    : m_storage(storage)
+    , m_header()
+    , m_preTriggerLeft(0)
+    , m_preTriggerSlot(0)
+    , m_address(0)
+    , m_logEnd(0)
+    , m_samplesLeft(0)
+{
+}
+
+bool LogReader::Begin(uint32_t logEnd, uint32_t numSamples)
+{
+    m_preTriggerLeft = 0;
+    m_samplesLeft = 0;
+    if(!m_storage->Read(0, (uint8_t*)&m_header, sizeof(LogHeader)) || m_header.m_magic != k_logHeaderMagic ||
+        m_header.m_recordSize == 0 || m_header.m_recordSize > k_maxRecordSize)
+    {
+        return false;
+    }
+
+    // Packed rings are delta encoded and the oldest record may refer to an overwritten one. The header has the time
+    // of the newest record, walk back from it to the time base of the ring
+    LogHeader decoderHeader = m_header;
+    if(m_header.m_version > k_logHeaderVersionRingBase && GetFixedRecordFormat(m_header.m_recordFormat) == RecordFormat::Packed)
+    {
+        decoderHeader.m_startTime -= GetPreTriggerDuration();
+    }
+    m_decoder.Begin(decoderHeader);
+
+    m_preTriggerLeft = m_header.m_preTriggerCount;
+    m_preTriggerSlot = m_header.m_preTriggerOldest;
+    m_address = GetLogStartAddress(m_header);
+    m_logEnd = logEnd;
+    m_samplesLeft = numSamples;
+
+    // An empty block, the first Next reads one
+    memset(m_block, 0, sizeof(m_block));
+    m_decompressor.BeginBlock(m_block);
+    return true;
+}
+
+const LogHeader& LogReader::GetHeader()const
+{
+    return m_header;
+}
+
+bool LogReader::Next(State& state)
+{
+    if(m_preTriggerLeft > 0)
+    {
+        return NextPreTrigger(state);
+    }
+    return NextActive(state);
+}
+
+bool LogReader::ReadSummary(LogSummary& summary)
+{
+    return m_storage->Read(m_logEnd, (uint8_t*)&summary, sizeof(LogSummary)) && summary.m_magic == k_logSummaryMagic;
+}
+
+uint32_t LogReader::GetPreTriggerAddress()
+{
+    return sizeof(LogHeader);
+}
+
+uint8_t LogReader::GetPreTriggerRecordSize(const LogHeader& header)
+{
+    const RecordFormat format = GetFixedRecordFormat(header.m_recordFormat);
+    return format == header.m_recordFormat ? header.m_recordSize : GetRecordSize(format);
+}
+
+uint32_t LogReader::GetLogStartAddress(const LogHeader& header)
+{
+    return GetPreTriggerAddress() + (uint32_t)header.m_preTriggerCapacity * GetPreTriggerRecordSize(header);
+}
+
+uint32_t LogReader::GetPreTriggerDuration()
+{
+    // The order doesn't matter for the sum, read the used slots as they are
+    const uint8_t recordSize = GetPreTriggerRecordSize(m_header);
+    uint32_t duration = 0;
+    uint8_t record[k_maxRecordSize];
+    int32_t channels[k_numPackedChannels];
+    for(uint16_t slot = 0; slot < m_header.m_preTriggerCount; ++slot)
+    {
+        if(!m_storage->Read(GetPreTriggerAddress() + (uint32_t)slot * recordSize, record, recordSize))
+        {
+            break;
+        }
+        PackedRecordCodec::Unpack(record, channels);
+        duration += (uint32_t)channels[(uint8_t)PackedChannel::TimeDelta];
+    }
+    return duration;
+}
+
+bool LogReader::NextPreTrigger(State& state)
+{
+    // Oldest to newest, wrapping around at the end of the ring
+    if(m_preTriggerSlot >= m_header.m_preTriggerCapacity)
+    {
+        m_preTriggerSlot = 0;
+    }
+
+    const uint8_t recordSize = GetPreTriggerRecordSize(m_header);
+    uint8_t record[k_maxRecordSize];
+    if(!m_storage->Read(GetPreTriggerAddress() + (uint32_t)m_preTriggerSlot * recordSize, record, recordSize))
+    {
+        m_preTriggerLeft = 0;
+        return NextActive(state);
+    }
+
+    --m_preTriggerLeft;
+    ++m_preTriggerSlot;
+    m_decoder.DecodeRecord(GetFixedRecordFormat(m_header.m_recordFormat), record, state);
+    return true;
+}
+
+bool LogReader::NextActive(State& state)
+{
+    if(m_samplesLeft == 0)
+    {
+        return false;
+    }
+
+    if(m_header.m_recordFormat == RecordFormat::Compressed)
+    {
+        // Move to the next block once we are done with the current one
+        int32_t channels[k_numPackedChannels];
+        if(!m_decompressor.Next(channels))
+        {
+            if(m_address + k_compressedBlockSize > m_logEnd || !m_storage->Read(m_address, m_block, k_compressedBlockSize))
+            {
+                m_samplesLeft = 0;
+                return false;
+            }
+            m_address += k_compressedBlockSize;
+            m_decompressor.BeginBlock(m_block);
+            if(!m_decompressor.Next(channels))
+            {
+                m_samplesLeft = 0; // Empty block, the log was cut short
+                return false;
+            }
+        }
+        m_decoder.DecodeChannels(channels, state);
+    }
+    else
+    {
+        uint8_t record[k_maxRecordSize];
+        if(m_address + m_header.m_recordSize > m_logEnd || !m_storage->Read(m_address, record, m_header.m_recordSize))
+        {
+            m_samplesLeft = 0;
+            return false;
+        }
+        m_address += m_header.m_recordSize;
+        m_decoder.DecodeRecord(m_header.m_recordFormat, record, state);
+    }
+
+    --m_samplesLeft;
+    return true;
+}
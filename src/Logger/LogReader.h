@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "RMath.h"
+
+#include "LoggerDefinitions.h"
+#include "LogDecoder.h"
+#include "StreamCompressor.h"
+
+// Bytes of a stored log, by segment offset: the flight segment in the FRAM on the device, a Log_N.bin image on the host
+class LogStorage
+{
+public:
+    virtual ~LogStorage() {}
+
+    // Returns false if the 'size' bytes at 'address' aren't all there
+    virtual bool Read(uint32_t address, uint8_t* data, uint32_t size) = 0;
+};
+
+// LogStorage over a buffer (a whole segment image)
+class MemoryLogStorage : public LogStorage
+{
+public:
+    MemoryLogStorage(const uint8_t* data, uint32_t size);
+
+    bool Read(uint32_t address, uint8_t* data, uint32_t size) override;
+
+private:
+    const uint8_t* m_data;
+    uint32_t m_size;
+};
+
+// Reads a stored log back in time order: the pre-trigger ring from its oldest record, then the active log.
+// The records are decoded to State with the LogHeader stored with them (see LogDecoder)
+class LogReader
+{
+public:
+    explicit LogReader(LogStorage* storage);
+
+    LogReader(const LogReader& other) = delete;
+
+    // The active log ends at 'logEnd' (segment offset) and has 'numSamples' records. Returns false if there's
+    // no valid LogHeader
+    bool Begin(uint32_t logEnd, uint32_t numSamples);
+
+    const LogHeader& GetHeader()const;
+
+    // Returns false once all the samples were read (or the log was cut short)
+    bool Next(State& state);
+
+    // The LogSummary after the active log, false if the log wasn't finished
+    bool ReadSummary(LogSummary& summary);
+
+    // Where the records of a fixed size format in the pre-trigger ring start, and their size. Float records
+    // use the stored size, the host adds padding at the end of State
+    static uint32_t GetPreTriggerAddress();
+
+    static uint8_t GetPreTriggerRecordSize(const LogHeader& header);
+
+    // First record of the active log (after the pre-trigger ring)
+    static uint32_t GetLogStartAddress(const LogHeader& header);
+
+private:
+    // Sum of the time deltas of the packed records in the pre-trigger ring (ms), they end at m_startTime
+    uint32_t GetPreTriggerDuration();
+
+    bool NextPreTrigger(State& state);
+
+    bool NextActive(State& state);
+
+    LogStorage* m_storage;
+    LogHeader m_header;
+    LogDecoder m_decoder;
+    StreamDecompressor m_decompressor;
+
+    uint16_t m_preTriggerLeft;      // Ring records not read yet
+    uint16_t m_preTriggerSlot;      // Next one
+    uint32_t m_address;             // Next active log address
+    uint32_t m_logEnd;
+    uint32_t m_samplesLeft;
+    uint8_t m_block[k_compressedBlockSize];
+};
@@ -4,19 +4,73 @@
 #include "Sensors/MS5611/MS5611.h"
 
 #include "Storage/MB85RS2MTA/MB85RS2MTA.h"
+#include "Storage/MB85RS2MTA/FRAMReader.h"
 #include "Storage/SD/SDCard.h"
 
+#include "LogCatalog.h"
+#include "LogCSV.h"
+#include "LogReader.h"
+
+#include "CRC16.h"
 #include "Pressure.h"
 #include "Debug/DebugOutput.h"
+#include "Debug/Profiler.h"
 
-#include <Wire.h>
-#include <SPI.h>
+#include "HAL.h"
+#include "HALCost.h"
 
 #define FRAM_CS 10
 #define SD_CS   9
 
 #define IDLE_DELTA (1.0f / 40.0f)
 
+// Highest barometer OSR, the planner lowers it (or raises the temperature decimation) when a measurement
+// takes longer than BARO_MAX_PERIODS sampling periods
+#define BARO_OSR OSR::OSR_4096
+#define BARO_MAX_PERIODS 2
+
+// Fraction of the CPU the sampling can take at boot (see PlanSampling), dispatch and detection use the rest
+#define SAMPLING_MAX_LOAD 0.7f
+
+#define SEA_LEVEL_PRESSURE 101500.0f
+
+// Launch and landing detection (see DetectorSettings)
+#define LIFTOFF_CLIMB 0.2f
+#define LIFTOFF_ACCELERATION 10.0f
+#define LANDING_BAND 10.0f
+#define LANDING_ACCELERATION 10.0f
+#define LANDING_STILL_BAND 0.3f
+#define APOGEE_DROP 1.0f
+
+// Only measure the temperature every N barometer samples (unless it's drifting more than TEMP_DRIFT_BAND C).
+// It's the lowest decimation, the planner can raise it
+#define TEMP_DECIMATION 8
+#define TEMP_DRIFT_BAND 0.5f
+
+// Capture the IMU through its FIFO, every sample gets stored while Active.
+// The planner picks the highest ODR (up to IMU_FIFO_ODR) the loop can drain with batches of up to IMU_FIFO_MAX_BATCH samples
+// #define IMU_FIFO_ENABLE
+#define IMU_FIFO_MAX_BATCH 16
+#define IMU_FIFO_ODR AccODR::ODR_1600_HZ
+
+// Seconds of Idle samples kept in a ring before liftoff, they end up in front of the active log (0 disables it)
+#define PRE_TRIGGER_TIME 1.0f
+
+// Dump the log as CSV (Log_N.csv) instead of the FRAM image (Log_N.bin, see DumpFileHeader). The convert tool
+// turns the image into the same CSV on the host, much faster than the AVR does
+// #define DUMP_CSV
+
+// Flights kept in the FRAM before they are dumped in one batch, after landing the logger waits for the next launch
+// until there are this many (or no room for another one). Flights whose dump failed stay too, they go with the next batch
+#define FLIGHTS_PER_DUMP 1
+
+// Records between the power loss journal commits (see FlightJournal), the journal is written with a FlushTask flush.
+// A power loss costs at most this many records and a flush period, every commit writes sizeof(FlightJournal) bytes
+#define JOURNAL_RECORDS 128
+
+// Seconds of active log a new flight needs at least. The flights waiting in the FRAM are dumped at boot to make room otherwise
+#define MIN_FLIGHT_TIME 20.0f
+
 // #define DISABLE_FRAM
 // #define TEST_ENABLE
 
@@ -26,6 +80,194 @@ void SetputPinAsCS(uint8_t pin, bool disable = true)
   digitalWrite(pin, disable ? HIGH : LOW);
 }
 
+static void WriteU24(uint32_t value, uint8_t* data)
+{
+    data[0] = (uint8_t)(value >> 16u);
+    data[1] = (uint8_t)(value >> 8u);
+    data[2] = (uint8_t)value;
+}
+
+// Float and 64 bit math the AVR does in software, charged to the native timing model (HALCost.h) where the
+// firmware calls the shared code. The drivers, codecs and host tools stay free of it
+
+// MS5611 compensation of a pressure conversion (unless it's off, see MS5611::SetPressureCompensation),
+// plus the temperature terms when D2 was just converted
+static void ChargeBaroCompensation(bool temperature, bool pressure = true)
+{
+    if(temperature)
+    {
+        HAL_COST(Int64Mul, 3);
+        HAL_COST(IntToFloat, 1);
+        HAL_COST(FloatMul, 1);
+    }
+    if(pressure)
+    {
+        HAL_COST(Int64Mul, 1);
+        HAL_COST(IntToFloat, 1);
+        HAL_COST(FloatMul, 1);
+    }
+}
+
+// Pressure::MBarToPascal and Pressure::GetAltitudeFromPa
+static void ChargeAltitude()
+{
+    HAL_COST(FloatMul, 2);
+    HAL_COST(FloatDiv, 1);
+    HAL_COST(FloatPow, 1);
+    HAL_COST(FloatAdd, 1);
+}
+
+// BMI160::ConvertSample
+static void ChargeIMUConversion(uint8_t numSamples)
+{
+    HAL_COST(IntToFloat, 6u * numSamples);
+    HAL_COST(FloatDiv, 3u * numSamples);
+    HAL_COST(FloatMul, 3u * numSamples);
+}
+
+// The raw detection values, D1 counts and three acceleration LSB (see LoggerApp::CalibrateRawDetection)
+static void ChargeRawAltitude()
+{
+    HAL_COST(IntToFloat, 1);
+}
+
+static void ChargeRawIMU()
+{
+    HAL_COST(IntToFloat, 3);
+}
+
+// PackedRecordCodec::Quantize
+static void ChargeQuantize()
+{
+    HAL_COST(FloatMul, 10);
+    HAL_COST(FloatAdd, 10);
+    HAL_COST(FloatDiv, 1);
+}
+
+// FlightDetector::CheckLiftoff
+static void ChargeLiftoffCheck()
+{
+    HAL_COST(FloatAdd, 1);
+    HAL_COST(FloatMul, 1);
+}
+
+// FlightDetector::CheckLanding in full, the early out away from the pad doesn't help the worst period
+static void ChargeLandingCheck()
+{
+    HAL_COST(FloatAdd, 10);
+    HAL_COST(FloatMul, 4);
+    HAL_COST(FloatSqrt, 1);
+    HAL_COST(FloatDiv, 1);
+}
+
+// WriteCSVState, FormatFloat on the nine float columns
+static void ChargeCSVRow()
+{
+    HAL_COST(FloatAdd, 18);
+    HAL_COST(FloatToInt, 9);
+    HAL_COST(IntToFloat, 9);
+}
+
+// The pre-trigger ring goes right after the header (segment offset)
+static const uint32_t k_preTriggerAddr = sizeof(LogHeader);
+
+#ifdef PROFILER_ENABLED
+static const char* const k_profileStageNames[k_numProfileStages] = { "BARO", "ALTITUDE", "IMU", "ENCODE", "FRAM", "DETECTOR", "DUMP" };
+static_assert(k_numProfileStages <= k_maxProfileStages, "Too many profile stages");
+#endif
+
+// Room for the CSV header and summary lines, the dump file is preallocated with them
+static const uint16_t k_maxDumpExtraLength = 512;
+
+// LogStorage over a flight segment in the FRAM, sequential reads are fetched ahead (FRAMReader)
+class FRAMLogStorage : public LogStorage
+{
+public:
+    FRAMLogStorage(MB85RS2MTA* fram, uint32_t segmentStart)
+        : m_fram(fram)
+        , m_segmentStart(segmentStart)
+        , m_reader(fram, segmentStart, fram->Capacity())
+    {
+    }
+
+    bool Read(uint32_t address, uint8_t* data, uint32_t size) override
+    {
+        // Start over when the LogReader moves elsewhere (from the ring to the active log)
+        address += m_segmentStart;
+        if(address != m_reader.GetAddress())
+        {
+            m_reader = FRAMReader(m_fram, address, m_fram->Capacity());
+        }
+        return m_reader.Read(data, size);
+    }
+
+private:
+    MB85RS2MTA* m_fram;
+    uint32_t m_segmentStart;
+    FRAMReader m_reader;
+};
+
+// Passes what's written on to 'stream' and keeps its CRC, to check the file once it's on the card
+class CRCPrint : public Print
+{
+public:
+    explicit CRCPrint(Print* stream)
+        : m_stream(stream)
+        , m_crc(k_crc16Init)
+        , m_size(0)
+    {
+    }
+
+    size_t write(uint8_t value) override
+    {
+        return write(&value, 1);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override
+    {
+        const size_t written = m_stream->write(buffer, size);
+        m_crc = UpdateCRC16(m_crc, buffer, (uint32_t)written);
+        m_size += (uint32_t)written;
+        return written;
+    }
+
+    using Print::write;
+
+    uint16_t GetCRC()const
+    {
+        return m_crc;
+    }
+
+    uint32_t GetSize()const
+    {
+        return m_size;
+    }
+
+private:
+    Print* m_stream;
+    uint16_t m_crc;
+    uint32_t m_size;
+};
+
+static uint32_t GetMicros()
+{
+    return micros();
+}
+
+static uint32_t SecondsToMicros(float seconds)
+{
+    return (uint32_t)lround(seconds * 1000000.0f);
+}
+
+static void SetRawIMU(const IMUSample& sample, RawState& rawState)
+{
+    for(uint8_t axis = 0; axis < 3; ++axis)
+    {
+        rawState.m_acceleration[axis] = sample.m_acceleration[axis];
+        rawState.m_angularRate[axis] = sample.m_angularRate[axis];
+    }
+}
+
 LoggerApp::LoggerApp()
     : m_state(LoggerState::Boot)
     , m_imu(nullptr)
@@ -34,19 +276,58 @@ LoggerApp::LoggerApp()
     , m_sd(nullptr)
     , m_currentState()
     , m_prevState()
+    , m_currentRaw()
+    , m_recordFormat(RecordFormat::Float)
+    , m_newBaroSample(false)
+    , m_imuBatch(nullptr)
+    , m_imuBatchCount(0)
+    , m_imuBatchTime(0)
+    , m_imuBatchQueued(false)
     , m_samplesPerSecond(0)
     , m_deltaTimeActive(0.0f)
-    , m_targetDeltaTime(0.0f)
+    , m_activePeriod(0)
+    , m_scheduler(GetMicros)
+    , m_stateToCheck(false)
+    , m_firstSample(true)
     , m_stateDataSize((uint8_t)sizeof(State))
     , m_currentFRAMAddr(0)
+    , m_logStartAddr(k_preTriggerAddr)
+    , m_segment()
+    , m_segmentIdx(0)
+    , m_minSegmentSize(0)
+    , m_committedSamples(0)
+    , m_preTriggerFormat(RecordFormat::Float)
+    , m_preTriggerRecordSize(0)
+    , m_preTriggerCapacity(0)
+    , m_preTriggerCount(0)
+    , m_preTriggerHead(0)
     , m_numSamples(0)
     , m_maxSamples(0)
     , m_maxActiveTime(0.0f)
-    , m_liftOffAltitude(0.0f)
+    , m_detector()
+    , m_baroReferenceD1(0)
+    , m_detectorAltitudeScale(1.0f)
+    , m_detectorAccelerationScale(1.0f)
+    , m_summary()
+    , m_plan()
+    , m_dumpStats()
+    , m_journalStats()
+    , m_catalog()
+    , m_directory()
+{
+    m_detector.SetSettings(GetDefaultDetectorSettings());
+}
+
+LoggerApp::~LoggerApp()
 {
+    delete[] m_imuBatch;
+    delete m_sd;
+    delete m_fram;
+    delete m_baro;
+    delete m_imu;
 }
 
-LoggerResult LoggerApp::Init(int samplesPerSecond)
+LoggerResult LoggerApp::Init(int samplesPerSecond, RecordFormat recordFormat /*= RecordFormat::Float*/)
 {
     // Init data protocols
     Wire.begin();
@@ -64,6 +345,10 @@ LoggerResult LoggerApp::Init(int samplesPerSecond)
             return LoggerResult::FailedInitIMU;
         }
 
+#ifdef IMU_FIFO_ENABLE
+        m_imuBatch = new IMUSample[IMU_FIFO_MAX_BATCH];
+#endif
+
         m_baro = new MS5611();
         if(!m_baro->Init(&Wire, MS5611::m_defaultAddr))
         {
@@ -85,28 +370,145 @@ LoggerResult LoggerApp::Init(int samplesPerSecond)
         }
 
         m_sd->TestWrite();
+
+        // Where the next log goes, read once so the dump doesn't look for a free name
+        if(!m_catalog.Load(m_sd))
+        {
+            DEBUG_LOG("Invalid log catalog, a new one is made with the next dump");
+        }
+
+        // Flights whose dump failed are still in the FRAM, they go with the next batch
+        if(!m_directory.Load(m_fram))
+        {
+            DEBUG_LOG("New FRAM directory");
+        }
+
+        // The power went while recording, what was journaled is dumped straight away
+        if(RecoverFlight())
+        {
+            DumpSegments();
+        }
     }
 
     // Setup delta times
     m_samplesPerSecond = samplesPerSecond;
     m_deltaTimeActive = 1.0f / (float)m_samplesPerSecond;
+    m_activePeriod = SecondsToMicros(m_deltaTimeActive);
+
+    // Record format
+    m_recordFormat = recordFormat;
+    m_stateDataSize = GetRecordSize(m_recordFormat); // Worst case for RecordFormat::Compressed, refined while recording
+
+    // Pre-trigger ring, the active log starts after it
+    m_preTriggerFormat = GetFixedRecordFormat(m_recordFormat);
+    m_preTriggerRecordSize = GetRecordSize(m_preTriggerFormat);
+    m_preTriggerCapacity = (uint16_t)ceil(PRE_TRIGGER_TIME / IDLE_DELTA);
+    m_logStartAddr = k_preTriggerAddr + (uint32_t)m_preTriggerCapacity * m_preTriggerRecordSize;
+
+    // The flight segment goes after the flights waiting in the FRAM, they are dumped now if there's no room for it.
+    // An empty FRAM always makes it
+    const uint32_t framCapacity = m_fram->Capacity();
+    const uint32_t minFlightSize = m_logStartAddr + (uint32_t)sizeof(LogSummary) + (uint32_t)(MIN_FLIGHT_TIME * m_samplesPerSecond) * m_stateDataSize;
+    m_minSegmentSize = min(minFlightSize, framCapacity - FRAMDirectory::k_dataStart);
+    if(!BeginSegment())
+    {
+        DumpSegments();
+        if(!BeginSegment())
+        {
+            return LoggerResult::FailedInitFRAM;
+        }
+    }
+    const uint32_t logCapacity = m_segment.m_size - sizeof(LogSummary) - m_logStartAddr;
+
+    // Time the pipeline stages and pick a sensor config that keeps up with the rate
+    {
+        StageCosts costs;
+        MeasureStageCosts(costs);
+
+        SamplingRequest request;
+        request.m_samplesPerSecond = samplesPerSecond > 0 ? (uint16_t)samplesPerSecond : 0;
+        request.m_idleSamplesPerSecond = (uint16_t)lround(1.0f / IDLE_DELTA);
+        request.m_recordSize = m_stateDataSize;
+        request.m_storageCapacity = logCapacity;
+        request.m_maxLoad = SAMPLING_MAX_LOAD;
+        request.m_baroOSR = BARO_OSR;
+        request.m_tempDecimation = TEMP_DECIMATION;
+        request.m_baroMaxPeriods = BARO_MAX_PERIODS;
+#ifdef IMU_FIFO_ENABLE
+        request.m_imuFIFO = true;
+#else
+        request.m_imuFIFO = false;
+#endif
+        request.m_imuFIFOODR = IMU_FIFO_ODR;
+        request.m_imuFIFOMaxBatch = IMU_FIFO_MAX_BATCH;
+
+        const LoggerResult planResult = PlanSampling(request, costs, m_plan);
+
+        DEBUG_LOG("Stage costs (us): IMU %u, FIFO %u + %u per sample, convert %u, baro %u + %u, record %u, FRAM block %u",
+            costs.m_imuRead, costs.m_imuFIFORead, costs.m_imuFIFOSample, costs.m_imuConvert, costs.m_baroConversion,
+            costs.m_baroCompute, costs.m_record, costs.m_storageBlock);
+        DEBUG_LOG("Load = %f, max samples per second = %u", m_plan.m_load, m_plan.m_maxSamplesPerSecond);
+        if(planResult != LoggerResult::Success)
+        {
+            return planResult;
+        }
+    }
+
+    m_baro->SetTemperatureDecimation(m_plan.m_tempDecimation, TEMP_DRIFT_BAND);
+    m_imu->Configure(m_plan.m_imuODR, AccRange::RANGE_2_G, (GyrODR)m_plan.m_imuODR, GyrRange::RANGE_2000_DPS);
+#ifdef IMU_FIFO_ENABLE
+    m_imu->EnableFIFO(true);
+#endif
+    m_maxActiveTime = m_plan.m_flightTime;
+
+    // Get a first pressure reading (blocking) so the launch detection starts from a valid altitude,
+    // from now on the barometer conversions run in the background (see PollSensors)
+    float pressure = 0.0f;
+    if(m_baro->ReadPressure(pressure, m_plan.m_baroOSR, m_plan.m_baroOSR))
+    {
+        m_newBaroSample = true;
+    }
+
+    if(m_recordFormat == RecordFormat::Raw)
+    {
+        // The raw altitude needs the boot pressure as reference
+        if(!m_newBaroSample)
+        {
+            return LoggerResult::FailedInitBarometer;
+        }
+        CalibrateRawDetection();
+    }
 
-    // Figur out some maxs given the current config and FRAM capacity
-    uint32_t framCapacity = m_fram->Capacity();
-    m_maxSamples = (uint32_t)floor((float)framCapacity / (float)m_stateDataSize) ;
-    m_maxActiveTime = m_maxSamples * m_deltaTimeActive;
+    BeginPreTrigger();
 
-    // TODO: check for brown out
+    // Tasks, added in LoggerTask order
+    {
+        const uint32_t idlePeriod = SecondsToMicros(IDLE_DELTA);
+        m_scheduler.AddTask(GetTaskName((uint8_t)LoggerTask::Baro), RunTask<&LoggerApp::PollSensors>, this, k_baroTaskPeriod);
+        m_scheduler.AddTask(GetTaskName((uint8_t)LoggerTask::Sample), RunTask<&LoggerApp::SampleTask>, this, idlePeriod, GetSampleTaskDeadline(idlePeriod));
+        m_scheduler.AddTask(GetTaskName((uint8_t)LoggerTask::Record), RunTask<&LoggerApp::RecordTask>, this, idlePeriod, GetSampleTaskDeadline(idlePeriod));
+        m_scheduler.AddTask(GetTaskName((uint8_t)LoggerTask::Detector), RunTask<&LoggerApp::DetectorTask>, this, idlePeriod, GetDetectorTaskDeadline(idlePeriod));
+        m_scheduler.AddTask(GetTaskName((uint8_t)LoggerTask::Flush), RunTask<&LoggerApp::FlushTask>, this, k_flushTaskPeriod);
+        m_scheduler.AddTask(GetTaskName((uint8_t)LoggerTask::Dump), RunTask<&LoggerApp::DumpTask>, this, k_dumpTaskPeriod);
+        m_scheduler.SetTimeBase((uint8_t)LoggerTask::Sample);
+    }
 
     m_state = LoggerState::Idle; // We are now waiting to detect launch
-    m_targetDeltaTime = IDLE_DELTA;
 
     // Log some useful info (we may want to serialize this to the SD card too)    
     {
         DEBUG_LOG("Samples per second = %i", m_samplesPerSecond);
         DEBUG_LOG("Active delta time: %f seconds", m_deltaTimeActive);
+        DEBUG_LOG("Active tick period = %lu us", (unsigned long)m_activePeriod);
+        DEBUG_LOG("Sample deadline = %lu us, ticks a period late are overruns (LogSummary)", (unsigned long)GetSampleTaskDeadline(m_activePeriod));
         DEBUG_LOG("Max FRAM = %f", (float)framCapacity);
+        DEBUG_LOG("Flight segment %i at %lu, %lu bytes", m_segmentIdx, (unsigned long)m_segment.m_start, (unsigned long)m_segment.m_size);
+        DEBUG_LOG("Barometer OSR = %i", (int)m_plan.m_baroOSR);
+        DEBUG_LOG("Temperature decimation = %i", m_plan.m_tempDecimation);
+        DEBUG_LOG("IMU ODR = %u Hz, FIFO batch = %i", GetIMUODRFrequency(m_plan.m_imuODR), m_plan.m_imuFIFOBatch);
+        DEBUG_LOG("Record format = %i", (int)m_recordFormat);
         DEBUG_LOG("State size = %i bytes", m_stateDataSize);
+        DEBUG_LOG("Pre-trigger records = %i", m_preTriggerCapacity);
         DEBUG_LOG("Max number of samples = %i", m_maxSamples);
         DEBUG_LOG("Max active time = %f seconds", m_maxActiveTime);
     }
@@ -116,75 +518,112 @@ LoggerResult LoggerApp::Init(int samplesPerSecond)
 
 void LoggerApp::Run()
 {
-    float totalTimeSec = 0.0f;
-    float elapsed = m_targetDeltaTime;
-    
+    Start();
+
     while(true)
     {
-        uint64_t startTime = millis();
+        m_scheduler.RunNext();
+    }
+}
 
-        if(elapsed >= m_targetDeltaTime)
-        {
-            Update(totalTimeSec, elapsed); // We pass the actual elapsed time (could be more than target)
-        }
-        else
-        {
-            delay(1);
-        }
+void LoggerApp::Start()
+{
+    m_scheduler.Start();
+}
 
-        // Update elapsed
-        uint64_t curTime = millis();
-        float deltaTime = (float)(curTime - startTime) * 0.001f;
+bool LoggerApp::Step()
+{
+    return m_scheduler.RunNext();
+}
 
-        elapsed += deltaTime;
-        totalTimeSec += deltaTime;
-    }
+uint32_t LoggerApp::GetIdleTime()const
+{
+    return m_scheduler.GetTimeToNextRelease(micros());
+}
+
+LoggerState LoggerApp::GetState()const
+{
+    return m_state;
+}
+
+bool LoggerApp::IsDone()const
+{
+    return m_state == LoggerState::End || m_state == LoggerState::Error;
+}
+
+const TaskScheduler& LoggerApp::GetScheduler()const
+{
+    return m_scheduler;
+}
+
+const LogSummary& LoggerApp::GetSummary()const
+{
+    return m_summary;
+}
+
+const SamplingPlan& LoggerApp::GetSamplingPlan()const
+{
+    return m_plan;
+}
+
+const DumpStats& LoggerApp::GetDumpStats()const
+{
+    return m_dumpStats;
+}
+
+const JournalStats& LoggerApp::GetJournalStats()const
+{
+    return m_journalStats;
+}
+
+DetectorSettings LoggerApp::GetDefaultDetectorSettings()
+{
+    DetectorSettings settings;
+    settings.m_liftoffClimb = LIFTOFF_CLIMB;
+    settings.m_liftoffAcceleration = LIFTOFF_ACCELERATION;
+    settings.m_landingBand = LANDING_BAND;
+    settings.m_landingAcceleration = LANDING_ACCELERATION;
+    settings.m_landingStillBand = LANDING_STILL_BAND;
+    settings.m_apogeeDrop = APOGEE_DROP;
+    return settings;
+}
+
+void LoggerApp::SetDetectorSettings(const DetectorSettings& settings)
+{
+    m_detector.SetSettings(FlightDetector::ScaleSettings(settings, m_detectorAltitudeScale, m_detectorAccelerationScale));
 }
 
 void LoggerApp::RunTest(float runTime)
 {
 #ifdef TEST_ENABLE
-    float totalTimeSec = 0.0f;
-    float elapsed = m_deltaTimeActive;
-    uint32_t numSamples = 0;
+    const uint32_t runTimeMs = (uint32_t)lround(runTime * 1000.0f);
+    const FixedRateTimer& sampleTimer = m_scheduler.GetTimer((uint8_t)LoggerTask::Sample);
+
+    // Record straight away, no detection
+    m_scheduler.SetEnabled((uint8_t)LoggerTask::Detector, false);
+    m_scheduler.SetEnabled((uint8_t)LoggerTask::Dump, false);
+    SetSamplingPeriod(m_activePeriod);
+    m_scheduler.Start();
+
+    WriteLogHeader();
+    m_currentFRAMAddr = m_logStartAddr;
+    m_numSamples = 0;
+    m_state = LoggerState::Active;
     
     pinMode(LED_BUILTIN, OUTPUT);
     digitalWrite(LED_BUILTIN, HIGH);
 
-    while(true)
+    // Stop if we are done for the test (or ran out of space)
+    while(m_state == LoggerState::Active && sampleTimer.GetTime() < runTimeMs)
     {    
-        uint64_t startTime = millis();  
-
-        if(elapsed >= m_deltaTimeActive)
-        {
-            elapsed = 0.0f; // Reset elapsed
-        
-            GatherCurrentState(totalTimeSec);
-
-            // Write state to the FRAM and increment the address
-            m_fram->Write(m_currentFRAMAddr, (uint8_t*)&m_currentState, m_stateDataSize);
-            m_currentFRAMAddr += m_stateDataSize;
-            ++numSamples;
-        }
-        else
-        {
-            // delay(2);
-        }
-        
-
-        // Update elapsed
-        uint64_t curTime = millis();
-        float deltaTime = (float)(curTime - startTime) * 0.001f;
-
-        elapsed += deltaTime;
-        totalTimeSec += deltaTime;
+        m_scheduler.RunNext();
+    }
 
-        // Stop if we are done for the test
-        if(totalTimeSec >= runTime)
-        {
-            break;
-        }
+    if(m_state == LoggerState::Active)
+    {
+        FinishLog();
     }
+    m_state = LoggerState::End;
 
     digitalWrite(LED_BUILTIN, LOW);
 
@@ -194,137 +633,156 @@ void LoggerApp::RunTest(float runTime)
     {
         return;
     }
-    SerializeHeader(file);
-    State parsedState = {};
-    for(uint32_t sampleIdx = 0; sampleIdx < numSamples; ++sampleIdx)
-    {
-        m_fram->Read(sampleIdx * m_stateDataSize, (uint8_t*)&parsedState, m_stateDataSize);
-        SerializeState(parsedState, file);
-    }
+    DumpLog(file, m_segment);
     m_sd->CloseFile();
 
     digitalWrite(LED_BUILTIN, HIGH);
+#else
+    (void)runTime;
 #endif
 }
 
-static bool k_first = true;
+template<void (LoggerApp::*Method)()>
+void LoggerApp::RunTask(void* context)
+{
+    (static_cast<LoggerApp*>(context)->*Method)();
+}
 
-void LoggerApp::Update(float totalTimeSec, float deltaTime)
+void LoggerApp::SampleTask()
 {
     // Sample the sensors to gather current state
-    GatherCurrentState(totalTimeSec);
+    GatherCurrentState();
 
     // Ensure we have valid previous state
-    if(k_first)
+    if(m_firstSample)
     {
         m_prevState = m_currentState;
-        k_first = false;
+        m_firstSample = false;
     }
 
-    switch (m_state)
+    CapturedState captured;
+    if(m_recordFormat == RecordFormat::Raw)
     {
-        case LoggerState::Boot:
-        {
-            break;
-        }
-        case LoggerState::Idle:
-        {
-            float deltaAltitude = m_currentState.m_altitude - m_prevState.m_altitude;
-            if(deltaAltitude >= 0.2f && m_currentState.m_acceleration.y > 10.0f)
-            {
-                m_currentFRAMAddr = 0; // Reset FRAM address 
-                m_state = LoggerState::Active;
-                m_liftOffAltitude = m_currentState.m_altitude;
-            }
-            break;
-        }
-        case LoggerState::Active:
-        {
-            // Store current state packet
-            m_fram->Write(m_currentFRAMAddr, (uint8_t*)&m_currentState, m_stateDataSize);
-            m_currentFRAMAddr += m_stateDataSize;
-            ++m_numSamples;
+        captured.m_raw = m_currentRaw;
+    }
+    else
+    {
+        captured.m_state = m_currentState;
+    }
 
-            // Early out if we ran out of space
-            if(m_numSamples >= m_maxSamples)
-            {
-                m_state = LoggerState::Dump;
-                break;
-            }
+#ifdef IMU_FIFO_ENABLE
+    // The batch is lost with the sample if the queue is full, the overflow counts it
+    captured.m_imuBatchCount = m_imuBatchCount;
+    if(m_imuBatchCount > 0)
+    {
+        __atomic_store_n(&m_imuBatchQueued, true, __ATOMIC_RELEASE);
+    }
+    if(!m_sampleQueue.Push(captured))
+    {
+        __atomic_store_n(&m_imuBatchQueued, false, __ATOMIC_RELEASE);
+    }
+#else
+    m_sampleQueue.Push(captured);
+#endif
 
-            // Check if we landed
-            // 1) Be within 10 meters of the lift off altitude
-            float liftDelta = abs(m_liftOffAltitude - m_currentState.m_altitude);
-            if(liftDelta <= 10.0f) 
-            {
-                // 2) Not be under power (total acceleration vector less than 10m/s2)
-                float accelLen = Length(m_currentState.m_acceleration);
-                
-                // 3) Altitude is not changing (median is within 30cm)
-                float altitudeMedian = m_landingFilter.ProcessEntry(m_currentState.m_altitude);
-                float altitudeDeltaMedian = abs(altitudeMedian - m_currentState.m_altitude);
-
-                if((accelLen <= 10.0f) && (altitudeDeltaMedian < 0.3f))
-                {
-                    m_state = LoggerState::Dump;
-                    break;
-                }
-            }
+    m_stateToCheck = true;
+}
 
-            break;
+void LoggerApp::RecordTask()
+{
+    CapturedState captured;
+    while(m_sampleQueue.Pop(captured))
+    {
+        // Only the one the record format uses is valid (see CapturedState)
+        const State& state = captured.m_state;
+        const RawState& rawState = captured.m_raw;
+
+        if(m_state == LoggerState::Idle)
+        {
+            StorePreTrigger(state, rawState);
         }
-        case LoggerState::Dump:
+        else if(m_state == LoggerState::Active)
         {
-            // Find free file
-            char fileName[] = "Log_0.csv";
-            bool found = false;
-            for(uint8_t fileIdx = 0; fileIdx < 10; ++fileIdx)
+#ifdef IMU_FIFO_ENABLE
+            // Store a state packet per IMU sample (barometer data is the latest we have).
+            // The batch is still the one read with this sample, the Sample task waits for us before reading the next.
+            // Only the member the format uses is copied, the other one isn't the active one
+            if(m_recordFormat == RecordFormat::Raw)
             {
-                fileName[4] = (char)(fileIdx + 48); // ASCII '0' is 48
-                if(!m_sd->FileExists(fileName))
+                RawState imuRawState = rawState;
+                for(uint8_t sampleIdx = 0; sampleIdx < captured.m_imuBatchCount && m_numSamples < m_maxSamples; ++sampleIdx)
                 {
-                    found = true;
-                    break;
+                    const IMUSample& sample = m_imuBatch[sampleIdx];
+                    const uint32_t sampleAge = m_imuBatchTime - sample.m_timeStamp; // us
+                    imuRawState.m_timeStamp = rawState.m_timeStamp - sampleAge / 1000u;
+                    SetRawIMU(sample, imuRawState);
+                    StoreSample(state, imuRawState);
                 }
             }
-
-            // If we can't find a slot, just override file 0 (should be the oldest one...)
-            if(!found)
-            {
-                fileName[4] = '0';
-            }
-
-            // Create the file
-            DEBUG_LOG("Creating log file: %s", fileName);
-            Print* file = m_sd->CreateFile(fileName);
-            if(!file)
+            else
             {
-                m_state = LoggerState::Error;
-                break;
+                State imuState = state;
+                for(uint8_t sampleIdx = 0; sampleIdx < captured.m_imuBatchCount && m_numSamples < m_maxSamples; ++sampleIdx)
+                {
+                    const IMUSample& sample = m_imuBatch[sampleIdx];
+                    const uint32_t sampleAge = m_imuBatchTime - sample.m_timeStamp; // us
+                    imuState.m_timeStamp = state.m_timeStamp - (float)sampleAge * 0.000001f;
+                    ChargeIMUConversion(1);
+                    m_imu->ConvertSample(sample, imuState.m_acceleration, imuState.m_angularRate);
+                    StoreSample(imuState, rawState);
+                }
             }
+#else
+            // Store current state packet
+            StoreSample(state, rawState);
+#endif
+        }
 
-            SerializeHeader(file);
-
-            State parsedState = {};
-            for(uint32_t sampleIdx = 0; sampleIdx < m_numSamples; ++sampleIdx)
-            {
-                m_fram->Read(sampleIdx * m_stateDataSize, (uint8_t*)&parsedState, m_stateDataSize);
-                SerializeState(parsedState, file);
-            }
-            m_sd->CloseFile();
-            
-            m_state = LoggerState::End;
-            m_targetDeltaTime = 5.0f; // We are done, just idle..
+#ifdef IMU_FIFO_ENABLE
+        if(captured.m_imuBatchCount > 0)
+        {
+            __atomic_store_n(&m_imuBatchQueued, false, __ATOMIC_RELEASE);
+        }
+#endif
 
+        // Early out if we ran out of space
+        if(m_state == LoggerState::Active && m_numSamples >= m_maxSamples)
+        {
+            EndLog();
             break;
         }
-        case LoggerState::End:
+    }
+}
+
+void LoggerApp::DetectorTask()
+{
+    if(!m_stateToCheck)
+    {
+        return;
+    }
+    m_stateToCheck = false;
+
+    PROFILE_SCOPE(ProfileStage::Detector);
+    if(m_state == LoggerState::Idle)
+    {
+        ChargeLiftoffCheck();
+        if(m_detector.CheckLiftoff(m_currentState, m_prevState))
         {
-            break;
+            WriteLogHeader();
+            m_currentFRAMAddr = m_logStartAddr; // Reset FRAM address 
+            m_state = LoggerState::Active;
+            SetSamplingPeriod(m_activePeriod);
+            m_scheduler.ResetStats(); // The summary only covers the active log
+            PROFILE_RESET();
+            m_detector.BeginFlight(m_currentState);
         }
-        case LoggerState::Error:
+    }
+    else if(m_state == LoggerState::Active)
+    {
+        ChargeLandingCheck();
+        if(m_detector.CheckLanding(m_currentState))
         {
-            break;
+            EndLog();
         }
     }
 
@@ -332,54 +790,773 @@ void LoggerApp::Update(float totalTimeSec, float deltaTime)
     SwapState();
 }
 
+void LoggerApp::FlushTask()
+{
+    // Bounds how much of the log sits in RAM
+    if(m_state == LoggerState::Idle || m_state == LoggerState::Active)
+    {
+        PROFILE_SCOPE(ProfileStage::FRAM);
+        m_fram->Flush();
+
+        // All the records are in the FRAM now
+        if(m_state == LoggerState::Active)
+        {
+            CommitJournal(false);
+        }
+    }
+}
+
+void LoggerApp::DumpTask()
+{
+    if(m_state != LoggerState::Dump)
+    {
+        return;
+    }
+
+    const bool dumped = DumpSegments();
+
+#ifdef PROFILER_ENABLED
+    // Covers the active log and the dump we just did
+    Print* profileFile = m_sd->CreateFile("PROFILE.csv");
+    if(profileFile)
+    {
+        Profiler::Write(profileFile, k_profileStageNames, k_numProfileStages);
+        m_sd->CloseFile();
+    }
+#endif
+    
+    m_state = dumped ? LoggerState::End : LoggerState::Error; // We are done, just idle..
+}
+
+void LoggerApp::SetSamplingPeriod(uint32_t period)
+{
+    m_scheduler.SetPeriod((uint8_t)LoggerTask::Sample, period, GetSampleTaskDeadline(period));
+    m_scheduler.SetPeriod((uint8_t)LoggerTask::Record, period, GetSampleTaskDeadline(period));
+    m_scheduler.SetPeriod((uint8_t)LoggerTask::Detector, period, GetDetectorTaskDeadline(period));
+}
+
+void LoggerApp::EndLog()
+{
+    FinishLog();
+
+    // Wait for the next launch until the batch is complete
+    if(m_directory.GetNumSegments() < FLIGHTS_PER_DUMP && BeginSegment())
+    {
+        m_state = LoggerState::Idle;
+        SetSamplingPeriod(SecondsToMicros(IDLE_DELTA));
+        BeginPreTrigger();
+        return;
+    }
+
+    m_state = LoggerState::Dump;
+
+    m_scheduler.SetEnabled((uint8_t)LoggerTask::Sample, false);
+    m_scheduler.SetEnabled((uint8_t)LoggerTask::Record, false);
+    m_scheduler.SetEnabled((uint8_t)LoggerTask::Detector, false);
+}
+
 void LoggerApp::SwapState()
 {
     // TO-DO: maybe make this a pointer swap.. ?
     m_prevState = m_currentState;
 }
 
-void LoggerApp::GatherCurrentState(float time)
+void LoggerApp::MeasureStageCosts(StageCosts& costs)
+{
+    static const uint8_t k_numRuns = 4;
+
+    // IMU, the sample read here is used to time the rest of the pipeline
+    IMUSample sample = {};
+    uint32_t start = micros();
+    for(uint8_t runIdx = 0; runIdx < k_numRuns; ++runIdx)
+    {
+        m_imu->ReadSample(sample);
+    }
+    costs.m_imuRead = (uint16_t)((micros() - start) / k_numRuns);
+
+    start = micros();
+    for(uint8_t runIdx = 0; runIdx < k_numRuns; ++runIdx)
+    {
+        SetCurrentIMU(sample);
+    }
+    costs.m_imuConvert = (uint16_t)((micros() - start) / k_numRuns);
+
+    costs.m_imuFIFORead = 0;
+    costs.m_imuFIFOSample = 0;
+#ifdef IMU_FIFO_ENABLE
+    // Empty FIFO (EnableFIFO flushes it) for the fixed part, then a full batch at the highest ODR
+    m_imu->Configure(IMU_FIFO_ODR, AccRange::RANGE_2_G, (GyrODR)IMU_FIFO_ODR, GyrRange::RANGE_2000_DPS);
+    m_imu->EnableFIFO(true);
+    start = micros();
+    m_imu->ReadFIFO(m_imuBatch, IMU_FIFO_MAX_BATCH);
+    costs.m_imuFIFORead = (uint16_t)(micros() - start);
+
+    delay(IMU_FIFO_MAX_BATCH * m_imu->GetSamplePeriod() / 1000u + 1u);
+    start = micros();
+    const uint8_t numSamples = m_imu->ReadFIFO(m_imuBatch, IMU_FIFO_MAX_BATCH);
+    const uint32_t drainTime = micros() - start;
+    if(numSamples > 0 && drainTime > costs.m_imuFIFORead)
+    {
+        costs.m_imuFIFOSample = (uint16_t)((drainTime - costs.m_imuFIFORead) / numSamples);
+    }
+    m_imu->EnableFIFO(false);
+#endif
+
+    // Barometer, a fetch and the start of the next conversion (at the lowest OSR, the time on the bus is the same).
+    // The pending conversion gets cancelled by the first ReadPressure
+    uint32_t D1 = 0;
+    uint32_t D2 = 0;
+    m_baro->StartConversion(DType::D_TEMPERATURE, OSR::OSR_256);
+    delayMicroseconds(MS5611::GetConversionTime(OSR::OSR_256));
+    m_baro->FetchConversion(D2);
+    m_baro->StartConversion(DType::D_PRESSURE, OSR::OSR_256);
+    delayMicroseconds(MS5611::GetConversionTime(OSR::OSR_256));
+
+    start = micros();
+    m_baro->FetchConversion(D1);
+    m_baro->StartConversion(DType::D_PRESSURE, OSR::OSR_256);
+    costs.m_baroConversion = (uint16_t)(micros() - start);
+
+    float pressure = 0.0f;
+    start = micros();
+    if(m_recordFormat == RecordFormat::Raw)
+    {
+        ChargeBaroCompensation(true, false);
+        ChargeRawAltitude();
+        m_baro->Convert(D1, D2, pressure); // Poll only works out the temperature terms, the pressure part keeps it conservative
+        m_currentState.m_altitude = (float)(int32_t)(m_baroReferenceD1 - D1);
+    }
+    else
+    {
+        ChargeBaroCompensation(true);
+        ChargeAltitude();
+        m_baro->Convert(D1, D2, pressure);
+        m_currentState.m_altitude = Pressure::GetAltitudeFromPa(Pressure::MBarToPascal(pressure), SEA_LEVEL_PRESSURE);
+    }
+    costs.m_baroCompute = (uint16_t)(micros() - start);
+
+    // Record, the encoders are reset when the log starts
+    start = micros();
+    for(uint8_t runIdx = 0; runIdx < k_numRuns; ++runIdx)
+    {
+        if(m_recordFormat == RecordFormat::Compressed)
+        {
+            int32_t channels[k_numPackedChannels];
+            ChargeQuantize();
+            m_packedEncoder.Quantize(m_currentState, channels);
+            m_compressor.Add(channels);
+        }
+        else
+        {
+            uint8_t packedRecord[k_packedRecordSize];
+            EncodeRecord(m_recordFormat, m_currentState, m_currentRaw, packedRecord);
+        }
+    }
+    costs.m_record = (uint16_t)((micros() - start) / k_numRuns);
+    m_compressor.Reset();
+
+    // Storage, a write buffer where the log goes (it gets overwritten)
+    uint8_t block[MB85RS2MTA::k_writeBufferSize] = {};
+    start = micros();
+    m_fram->Write(m_segment.m_start + m_logStartAddr, block, sizeof(block));
+    costs.m_storageBlock = (uint16_t)(micros() - start);
+}
+
+void LoggerApp::PollSensors()
+{
+    PROFILE_SCOPE(ProfileStage::Baro);
+    if(m_baro->Poll(m_plan.m_baroOSR, m_plan.m_baroOSR))
+    {
+        ChargeBaroCompensation(m_baro->GetTemperatureAge() == 0, m_recordFormat != RecordFormat::Raw);
+        m_newBaroSample = true;
+    }
+}
+
+void LoggerApp::GatherCurrentState()
+{
+    const FixedRateTimer& sampleTimer = m_scheduler.GetTimer((uint8_t)LoggerTask::Sample);
+    m_currentState.m_timeStamp = sampleTimer.GetTimeSec();
+    m_currentRaw.m_timeStamp = sampleTimer.GetTime();
+
+    // Make sure we use the latest barometer data
+    PollSensors();
+
+    // Get barometric altitude (only when it changed, otherwise we keep the last one)
+    if(m_newBaroSample)
+    {
+        PROFILE_SCOPE(ProfileStage::Altitude);
+        uint32_t D1 = 0;
+        uint32_t D2 = 0;
+        m_baro->GetLastRaw(D1, D2);
+        if(m_recordFormat == RecordFormat::Raw)
+        {
+            ChargeRawAltitude();
+            m_currentState.m_altitude = (float)(int32_t)(m_baroReferenceD1 - D1);
+        }
+        else
+        {
+            ChargeAltitude();
+            float curPressure = Pressure::MBarToPascal(m_baro->GetLastPressure());
+            m_currentState.m_altitude = Pressure::GetAltitudeFromPa(curPressure, SEA_LEVEL_PRESSURE);
+        }
+        m_currentState.m_temperature = m_baro->GetLastTemperature();
+        m_currentState.m_temperatureAge = m_baro->GetTemperatureAge();
+        m_newBaroSample = false;
+
+        WriteU24(D1, m_currentRaw.m_pressure);
+        WriteU24(D2, m_currentRaw.m_temperature);
+        m_currentRaw.m_temperatureAge = m_currentState.m_temperatureAge;
+    }
+
+    PROFILE_SCOPE(ProfileStage::IMU);
+#ifdef IMU_FIFO_ENABLE
+    // A queued sample still needs the batch, the new samples wait in the FIFO. The IMU values stay the last ones
+    m_imuBatchCount = 0;
+    if(__atomic_load_n(&m_imuBatchQueued, __ATOMIC_ACQUIRE))
+    {
+        return;
+    }
+
+    // While we are not recording we only care about the newest samples, drop the rest
+    do
+    {
+        m_imuBatchCount = m_imu->ReadFIFO(m_imuBatch, m_plan.m_imuFIFOBatch);
+    } while(m_state != LoggerState::Active && m_imuBatchCount == m_plan.m_imuFIFOBatch);
+
+    if(m_imuBatchCount > 0)
+    {
+        // The newest sample is taken as 'now'
+        const IMUSample& sample = m_imuBatch[m_imuBatchCount - 1];
+        m_imuBatchTime = sample.m_timeStamp;
+        SetCurrentIMU(sample);
+    }
+#else
+    IMUSample sample;
+    if(m_imu->ReadSample(sample))
+    {
+        SetCurrentIMU(sample);
+    }
+    else
+    {
+        DEBUG_LOG("Could not read IMU data");
+    }
+#endif
+}
+
+void LoggerApp::SetCurrentIMU(const IMUSample& sample)
+{
+    SetRawIMU(sample, m_currentRaw);
+    if(m_recordFormat == RecordFormat::Raw)
+    {
+        // Only the detector looks at the state, it doesn't use the angular rate
+        ChargeRawIMU();
+        m_currentState.m_acceleration.x = (float)sample.m_acceleration[0];
+        m_currentState.m_acceleration.y = (float)sample.m_acceleration[1];
+        m_currentState.m_acceleration.z = (float)sample.m_acceleration[2];
+    }
+    else
+    {
+        ChargeIMUConversion(1);
+        m_imu->ConvertSample(sample, m_currentState.m_acceleration, m_currentState.m_angularRate);
+    }
+}
+
+void LoggerApp::CalibrateRawDetection()
 {
-    m_currentState.m_timeStamp = time;
+    // Counts per m around the boot pressure (D1 drops as the rocket climbs). It's close enough to linear
+    // for the few hundred m of a flight, and the detector only compares altitudes close to each other
+    static const uint32_t k_calibrationCounts = 10000;
 
-    // Get barometric altitude
-    float curPressure = 0.0f;
-    m_baro->ReadPressure(curPressure, OSR::OSR_4096, OSR::OSR_4096);
-    curPressure = Pressure::MBarToPascal(curPressure);
+    uint32_t D1 = 0;
+    uint32_t D2 = 0;
+    m_baro->GetLastRaw(D1, D2);
 
-    m_currentState.m_altitude = Pressure::GetAltitudeFromPa(curPressure, 101500.0f);
+    float pressure = 0.0f;
+    m_baro->Convert(D1 - k_calibrationCounts, D2, pressure);
+    const float upperAltitude = Pressure::GetAltitudeFromPa(Pressure::MBarToPascal(pressure), SEA_LEVEL_PRESSURE);
+    m_baro->Convert(D1, D2, pressure); // Leaves the last pressure as it was
+    const float altitude = Pressure::GetAltitudeFromPa(Pressure::MBarToPascal(pressure), SEA_LEVEL_PRESSURE);
 
-    m_currentState.m_temperature = m_baro->GetLastTemperature();
+    m_baroReferenceD1 = D1;
+    m_detectorAltitudeScale = upperAltitude > altitude ? (float)k_calibrationCounts / (upperAltitude - altitude) : 1.0f;
+    m_detectorAccelerationScale = 32767.0f / BMI160::GetAccRangeMult(AccRange::RANGE_2_G);
+    m_detector.SetSettings(FlightDetector::ScaleSettings(m_detector.GetSettings(), m_detectorAltitudeScale, m_detectorAccelerationScale));
+    DEBUG_LOG("Raw detection: D1 %lu, %f counts per m", (unsigned long)D1, m_detectorAltitudeScale);
 
-    m_imu->ReadIMU(m_currentState.m_acceleration, m_currentState.m_angularRate);
+    m_baro->SetPressureCompensation(false);
 }
 
-void LoggerApp::SerializeHeader(Print* stream)
+void LoggerApp::StoreSample(const State& state, const RawState& rawState)
 {
-    stream->print(F("TIME, ALTITUDE, TEMP, ACCEL_X, ACCEL_Y, ACCEL_Z, RATE_X, RATE_Y, RATE_Z \n"));
+    if(m_recordFormat == RecordFormat::Compressed)
+    {
+        int32_t channels[k_numPackedChannels];
+        bool added = false;
+        {
+            PROFILE_SCOPE(ProfileStage::Encode);
+            ChargeQuantize();
+            m_packedEncoder.Quantize(state, channels);
+            added = m_compressor.Add(channels);
+        }
+        if(!added)
+        {
+            // Block is full, write it and start a new one with this sample
+            FlushCompressedBlock();
+            if(m_currentFRAMAddr + k_compressedBlockSize + sizeof(LogSummary) > m_segment.m_size)
+            {
+                m_maxSamples = m_numSamples;
+                return;
+            }
+            m_compressor.Add(channels);
+        }
+        ++m_numSamples;
+        return;
+    }
+
+    uint8_t packedRecord[k_packedRecordSize];
+    const uint8_t* record = nullptr;
+    {
+        PROFILE_SCOPE(ProfileStage::Encode);
+        record = EncodeRecord(m_recordFormat, state, rawState, packedRecord);
+    }
+    {
+        PROFILE_SCOPE(ProfileStage::FRAM);
+        m_fram->Append(record, m_stateDataSize);
+    }
+    m_currentFRAMAddr += m_stateDataSize;
+    ++m_numSamples;
 }
 
-void LoggerApp::SerializeItem(Print* stream, float value, char separator, bool printSeparator /*= true*/)
+const uint8_t* LoggerApp::EncodeRecord(RecordFormat format, const State& state, const RawState& rawState, uint8_t* packedRecord)
 {
-    stream->print(value);
-    if(printSeparator)
+    if(format == RecordFormat::Raw)
     {
-        stream->print(separator);
+        return (const uint8_t*)&rawState;
     }
+    else if(format == RecordFormat::Packed)
+    {
+        ChargeQuantize();
+        m_packedEncoder.Encode(state, packedRecord);
+        return packedRecord;
+    }
+    return (const uint8_t*)&state;
+}
+
+void LoggerApp::BeginPreTrigger()
+{
+    m_preTriggerCount = 0;
+    m_preTriggerHead = 0;
+    m_packedEncoder.Reset(0, BMI160::GetAccRangeMult(m_imu->GetAccRange()));
+    m_fram->BeginAppend(m_segment.m_start + k_preTriggerAddr);
 }
 
-void LoggerApp::SerializeState(const State& state, Print* stream)
+void LoggerApp::StorePreTrigger(const State& state, const RawState& rawState)
 {
-    static const char separator = ',';
+    if(m_preTriggerCapacity == 0)
+    {
+        return;
+    }
+
+    uint8_t packedRecord[k_packedRecordSize];
+    m_fram->Append(EncodeRecord(m_preTriggerFormat, state, rawState, packedRecord), m_preTriggerRecordSize);
 
-    SerializeItem(stream, state.m_timeStamp, separator); 
-    SerializeItem(stream, state.m_altitude, separator); 
-    SerializeItem(stream, state.m_acceleration.x, separator); 
-    SerializeItem(stream, state.m_acceleration.y, separator); 
-    SerializeItem(stream, state.m_acceleration.z, separator); 
-    SerializeItem(stream, state.m_angularRate.x, separator); 
-    SerializeItem(stream, state.m_angularRate.y, separator); 
-    SerializeItem(stream, state.m_angularRate.z, separator, false); 
+    if(m_preTriggerCount < m_preTriggerCapacity)
+    {
+        ++m_preTriggerCount;
+    }
+
+    // Wrap around, the next record overwrites the oldest one (the append address restarts at the ring start)
+    if(++m_preTriggerHead == m_preTriggerCapacity)
+    {
+        m_preTriggerHead = 0;
+        m_fram->BeginAppend(m_segment.m_start + k_preTriggerAddr);
+    }
+}
+
+void LoggerApp::WriteLogHeader()
+{
+    LogHeader header;
+    header.m_magic = k_logHeaderMagic;
+    header.m_version = k_logHeaderVersion;
+    header.m_recordFormat = m_recordFormat;
+    header.m_recordSize = m_stateDataSize;
+    header.m_accRange = (uint8_t)m_imu->GetAccRange();
+    header.m_gyrRange = (uint8_t)m_imu->GetGyrRange();
+    header.m_samplesPerSecond = (uint16_t)m_samplesPerSecond;
+    header.m_startTime = (uint32_t)lround(m_currentState.m_timeStamp * 1000.0f);
+    m_baro->GetCalibration(header.m_baroCalibration);
+    header.m_seaLevelPressure = SEA_LEVEL_PRESSURE;
 
-    stream->print('\n');
+    // Freeze the pre-trigger ring, once it wrapped the oldest record is the one we would overwrite next
+    header.m_preTriggerCapacity = m_preTriggerCapacity;
+    header.m_preTriggerCount = m_preTriggerCount;
+    header.m_preTriggerOldest = m_preTriggerCount < m_preTriggerCapacity ? 0 : m_preTriggerHead;
+
+    if(m_preTriggerFormat == RecordFormat::Packed && m_preTriggerCount > 0)
+    {
+        // The active log keeps the delta chain of the ring. The ring's own time base is worked out when it's read
+        // back (see LogReader), there's no time for it at liftoff
+        header.m_startTime = m_packedEncoder.GetTime();
+    }
+    else
+    {
+        m_packedEncoder.Reset(header.m_startTime, BMI160::GetAccRangeMult(m_imu->GetAccRange()));
+    }
+
+    m_fram->Write(m_segment.m_start, (const uint8_t*)&header, sizeof(LogHeader));
+    m_fram->BeginAppend(m_segment.m_start + m_logStartAddr);
+
+    m_compressor.Reset();
+
+    // The flight can be recovered from now on, the pre-trigger ring at least
+    m_journalStats.m_commits = 0;
+    m_journalStats.m_journalBytes = 0;
+    m_journalStats.m_logBytes = 0;
+    m_committedSamples = 0;
+    CommitJournal(true);
+}
+
+void LoggerApp::FinishLog()
+{
+    if(m_recordFormat == RecordFormat::Compressed && m_compressor.GetNumRecords() > 0)
+    {
+        FlushCompressedBlock();
+    }
+
+    // The summary goes right after the last record
+    const TimerStats& stats = m_scheduler.GetTimeBaseStats();
+    LogSummary& summary = m_summary;
+    summary.m_magic = k_logSummaryMagic;
+    summary.m_numSamples = m_numSamples;
+    summary.m_ticks = stats.m_ticks;
+    summary.m_overruns = stats.m_overruns;
+    summary.m_maxLateness = stats.m_maxLateness;
+    summary.m_meanLateness = stats.m_ticks > 0 ? stats.m_totalLateness / stats.m_ticks : 0;
+    summary.m_deadlineMisses = m_scheduler.GetDeadlineMisses();
+    for(uint8_t taskIdx = 0; taskIdx < k_numLoggerTasks; ++taskIdx)
+    {
+        summary.m_taskWorstExecution[taskIdx] = m_scheduler.GetWorstExecution(taskIdx);
+    }
+    summary.m_queueOverflows = m_sampleQueue.GetOverflows();
+    m_fram->Append((const uint8_t*)&summary, sizeof(LogSummary));
+    m_fram->Flush();
+
+    m_journalStats.m_logBytes = m_currentFRAMAddr - m_logStartAddr;
+    DEBUG_LOG("Journal: %lu commits, write amplification = %f", (unsigned long)m_journalStats.m_commits, GetWriteAmplification(m_journalStats));
+
+    // Trim the segment to the log, it keeps what the catalog needs until it's dumped
+    m_segment.m_size = m_currentFRAMAddr + sizeof(LogSummary);
+    m_segment.m_logEnd = m_currentFRAMAddr;
+    m_segment.m_numSamples = m_numSamples;
+    m_segment.m_flightTime = (uint32_t)lround(m_detector.GetFlightTime() * 1000.0f);
+    m_segment.m_apogee = m_detector.GetApogee() / m_detectorAltitudeScale;
+    m_segment.m_state = FRAMSegmentState::Recorded;
+    m_segment.m_flags = m_numSamples < m_maxSamples ? k_catalogLanded : 0u;
+    m_directory.WriteSegment(m_segmentIdx, m_segment);
+
+    DEBUG_LOG("Ticks = %lu, overruns = %lu", (unsigned long)summary.m_ticks, (unsigned long)summary.m_overruns);
+    DEBUG_LOG("Lateness: max = %lu us, mean = %lu us", (unsigned long)summary.m_maxLateness, (unsigned long)summary.m_meanLateness);
+    DEBUG_LOG("Sample queue overflows = %lu", (unsigned long)summary.m_queueOverflows);
+    LogTaskStats();
+}
+
+void LoggerApp::FlushCompressedBlock()
+{
+    {
+        PROFILE_SCOPE(ProfileStage::FRAM);
+        m_fram->Append(m_compressor.GetBlock(), k_compressedBlockSize);
+    }
+    m_currentFRAMAddr += k_compressedBlockSize;
+    m_compressor.Reset();
+
+    // Extrapolate how many samples fit with the compression ratio we got so far
+    const uint32_t usedBlocks = (m_currentFRAMAddr - m_logStartAddr) / k_compressedBlockSize;
+    const uint32_t totalBlocks = (m_segment.m_size - sizeof(LogSummary) - m_logStartAddr) / k_compressedBlockSize;
+    m_maxSamples = (uint32_t)((uint64_t)m_numSamples * totalBlocks / usedBlocks);
+}
+
+bool LoggerApp::BeginSegment()
+{
+    if(!m_directory.Allocate(m_minSegmentSize, m_segmentIdx, m_segment))
+    {
+        return false;
+    }
+
+    // Figur out some maxs given the current config and segment size
+    const uint32_t logCapacity = m_segment.m_size - sizeof(LogSummary) - m_logStartAddr;
+    m_maxSamples = (uint32_t)floor((float)logCapacity / (float)m_stateDataSize) ;
+    m_currentFRAMAddr = m_logStartAddr;
+    m_numSamples = 0;
+    return true;
+}
+
+void LoggerApp::CommitJournal(bool force)
+{
+    // Compressed records are only there once their block is written
+    uint32_t numSamples = m_numSamples;
+    if(m_recordFormat == RecordFormat::Compressed)
+    {
+        numSamples -= m_compressor.GetNumRecords();
+    }
+    if(!force && numSamples - m_committedSamples < JOURNAL_RECORDS)
+    {
+        return;
+    }
+
+    m_directory.Commit(m_currentFRAMAddr, numSamples);
+    m_committedSamples = numSamples;
+    ++m_journalStats.m_commits;
+    m_journalStats.m_journalBytes += sizeof(FlightJournal);
+}
+
+bool LoggerApp::RecoverFlight()
+{
+    const uint8_t numSegments = m_directory.GetNumSegments();
+    FRAMSegment segment;
+    if(numSegments == 0 || !m_directory.ReadSegment(numSegments - 1, segment) || segment.m_state != FRAMSegmentState::Recording)
+    {
+        return false;
+    }
+
+    // No commit, it didn't lift off
+    FlightJournal journal;
+    if(!m_directory.ReadJournal(journal))
+    {
+        m_directory.Free(numSegments - 1);
+        return false;
+    }
+
+    // The log ends at the last commit. It was never finished, the LogSummary is left blank (no magic)
+    DEBUG_LOG("Recovering an unfinished flight, %lu samples", (unsigned long)journal.m_numSamples);
+    LogSummary summary;
+    memset(&summary, 0, sizeof(LogSummary));
+    m_fram->Write(segment.m_start + journal.m_logEnd, (const uint8_t*)&summary, sizeof(LogSummary));
+
+    segment.m_size = journal.m_logEnd + sizeof(LogSummary);
+    segment.m_logEnd = journal.m_logEnd;
+    segment.m_numSamples = journal.m_numSamples;
+    segment.m_flightTime = 0; // Unknown, the detector state is gone (the analyze tool gets it from the log)
+    segment.m_apogee = 0.0f;
+    segment.m_state = FRAMSegmentState::Recorded;
+    segment.m_flags = k_catalogRecovered;
+    m_directory.WriteSegment(numSegments - 1, segment);
+    return true;
+}
+
+bool LoggerApp::DumpSegments()
+{
+    m_dumpStats.m_size = 0;
+    m_dumpStats.m_time = 0;
+    m_dumpStats.m_contiguous = true;
+    m_dumpStats.m_numLogs = 0;
+
+    bool dumped = true;
+    FRAMSegment segment;
+    for(uint8_t segmentIdx = 0; m_directory.ReadSegment(segmentIdx, segment);)
+    {
+        // Freeing moves the next slots down
+        if(segment.m_state == FRAMSegmentState::Recorded && DumpSegment(segment))
+        {
+            m_directory.Free(segmentIdx);
+            continue;
+        }
+        dumped = false;
+        ++segmentIdx;
+    }
+    return dumped;
+}
+
+bool LoggerApp::DumpSegment(const FRAMSegment& segment)
+{
+    LogHeader header;
+    LogSummary summary;
+    m_fram->Read(segment.m_start, (uint8_t*)&header, sizeof(LogHeader));
+    m_fram->Read(segment.m_start + segment.m_logEnd, (uint8_t*)&summary, sizeof(LogSummary));
+
+    // Next name in the catalog, it's taken even if the dump fails
+    uint32_t sequence = 0;
+    if(!m_catalog.Reserve(sequence))
+    {
+        DEBUG_LOG("Failed to update the log catalog");
+    }
+    char fileName[k_maxLogNameLength];
+#ifdef DUMP_CSV
+    LogCatalog::GetLogName(sequence, "csv", fileName);
+#else
+    LogCatalog::GetLogName(sequence, "bin", fileName);
+#endif
+
+    // Create the file, contiguous so it's streamed to the card. Through the FAT if there isn't the room for it
+    DEBUG_LOG("Creating log file: %s", fileName);
+    const uint32_t dumpStart = micros();
+#ifdef DUMP_CSV
+    const uint32_t maxSize = k_maxDumpExtraLength + (segment.m_numSamples + header.m_preTriggerCount) * k_maxCSVRowLength;
+#else
+    const uint32_t maxSize = GetDumpImageSize(segment);
+#endif
+    DumpStats stats;
+    Print* file = m_sd->CreateContiguousFile(fileName, maxSize);
+    stats.m_contiguous = file != nullptr;
+    if(!file)
+    {
+        file = m_sd->CreateFile(fileName);
+    }
+    if(!file)
+    {
+        return false;
+    }
+
+    CRCPrint stream(file);
+#ifdef DUMP_CSV
+    DumpLog(&stream, segment);
+#else
+    DumpImage(&stream, segment);
+#endif
+    stats.m_size = m_sd->CloseFile();
+    stats.m_time = micros() - dumpStart;
+    DEBUG_LOG("Dumped %lu bytes in %lu ms, %lu KB/s (%s)", (unsigned long)stats.m_size, (unsigned long)(stats.m_time / 1000u),
+        (unsigned long)GetDumpThroughput(stats), stats.m_contiguous ? "contiguous" : "FAT");
+
+    m_dumpStats.m_size += stats.m_size;
+    m_dumpStats.m_time += stats.m_time;
+    m_dumpStats.m_contiguous = m_dumpStats.m_contiguous && stats.m_contiguous;
+
+    // Read it back, the segment is only freed once the card has what was written
+    if(stats.m_size != stream.GetSize() || !VerifyFile(fileName, stream.GetSize(), stream.GetCRC()))
+    {
+        DEBUG_LOG("Failed to verify %s, the flight stays in the FRAM", fileName);
+        return false;
+    }
+    ++m_dumpStats.m_numLogs;
+
+    CatalogEntry entry;
+    entry.m_sequence = sequence;
+    entry.m_fileSize = stats.m_size;
+    entry.m_numSamples = segment.m_numSamples;
+    entry.m_samplesPerSecond = header.m_samplesPerSecond;
+    entry.m_recordFormat = header.m_recordFormat;
+    entry.m_flags = segment.m_flags;
+    if(stats.m_contiguous)
+    {
+        entry.m_flags |= k_catalogContiguous;
+    }
+#ifdef DUMP_CSV
+    entry.m_flags |= k_catalogCSV;
+#endif
+    entry.m_flightTime = segment.m_flightTime;
+    entry.m_apogee = segment.m_apogee;
+    entry.m_overruns = summary.m_overruns;
+    if(!m_catalog.Add(entry))
+    {
+        DEBUG_LOG("Failed to update the log catalog");
+    }
+    return true;
+}
+
+bool LoggerApp::VerifyFile(const char* path, uint32_t size, uint16_t crc)
+{
+    if(!m_sd->OpenFile(path))
+    {
+        return false;
+    }
+
+    uint8_t chunk[FRAMReader::k_bufferSize];
+    uint16_t fileCRC = k_crc16Init;
+    uint32_t fileSize = 0;
+    for(uint32_t read = m_sd->Read(chunk, sizeof(chunk)); read > 0; read = m_sd->Read(chunk, sizeof(chunk)))
+    {
+        fileCRC = UpdateCRC16(fileCRC, chunk, read);
+        fileSize += read;
+    }
+    m_sd->CloseFile();
+    return fileSize == size && fileCRC == crc;
+}
+
+void LoggerApp::DumpLog(Print* stream, const FRAMSegment& segment)
+{
+    FRAMLogStorage storage(m_fram, segment.m_start);
+    LogReader reader(&storage);
+
+    WriteCSVHeader(stream);
+    if(!reader.Begin(segment.m_logEnd, segment.m_numSamples))
+    {
+        return;
+    }
+
+    const bool rawRecords = reader.GetHeader().m_recordFormat == RecordFormat::Raw;
+    State parsedState = {};
+    for(;;)
+    {
+        PROFILE_SCOPE(ProfileStage::Dump);
+        if(!reader.Next(parsedState))
+        {
+            break;
+        }
+        if(rawRecords)
+        {
+            ChargeBaroCompensation(true);
+            ChargeAltitude();
+            ChargeIMUConversion(1);
+        }
+        ChargeCSVRow();
+        WriteCSVState(parsedState, stream);
+    }
+
+    LogSummary summary;
+    if(reader.ReadSummary(summary))
+    {
+        WriteCSVSummary(summary, stream);
+    }
+}
+
+uint32_t LoggerApp::GetDumpImageSize(const FRAMSegment& segment)
+{
+    return sizeof(DumpFileHeader) + segment.m_logEnd + sizeof(LogSummary);
+}
+
+void LoggerApp::DumpImage(Print* stream, const FRAMSegment& segment)
+{
+    DumpFileHeader fileHeader;
+    fileHeader.m_magic = k_dumpFileMagic;
+    fileHeader.m_version = k_dumpFileVersion;
+    fileHeader.m_headerSize = sizeof(DumpFileHeader);
+    fileHeader.m_firmwareVersion = k_firmwareVersion;
+    fileHeader.m_numSamples = segment.m_numSamples;
+    fileHeader.m_logEnd = segment.m_logEnd;
+    fileHeader.m_imageSize = segment.m_logEnd + sizeof(LogSummary);
+    stream->write((const uint8_t*)&fileHeader, sizeof(DumpFileHeader));
+
+    // The records are copied as they are, nothing to decode
+    uint8_t chunk[FRAMReader::k_bufferSize];
+    for(uint32_t address = 0; address < fileHeader.m_imageSize; address += sizeof(chunk))
+    {
+        PROFILE_SCOPE(ProfileStage::Dump);
+        uint32_t chunkSize = fileHeader.m_imageSize - address;
+        if(chunkSize > sizeof(chunk))
+        {
+            chunkSize = sizeof(chunk);
+        }
+        m_fram->FastRead(segment.m_start + address, chunk, chunkSize);
+        stream->write(chunk, chunkSize);
+    }
+}
+
+void LoggerApp::LogTaskStats()
+{
+#ifdef DEBUG_OUTPUT_ENABLED
+    for(uint8_t taskIdx = 0; taskIdx < m_scheduler.GetNumTasks(); ++taskIdx)
+    {
+        // The names are in flash, vsnprintf's %s reads SRAM
+        char name[k_maxTaskNameLength + 1];
+        strcpy_P(name, GetTaskName(taskIdx));
+#ifdef PROFILER_ENABLED
+        const TaskStats& stats = m_scheduler.GetStats(taskIdx);
+        DEBUG_LOG("Task %s: runs = %lu, WCET = %lu us, worst response = %lu us, misses = %lu", name,
+            (unsigned long)stats.m_runs, (unsigned long)m_scheduler.GetWorstExecution(taskIdx), (unsigned long)stats.m_worstResponse, (unsigned long)stats.m_deadlineMisses);
+#else
+        DEBUG_LOG("Task %s: WCET = %u us", name, m_scheduler.GetWorstExecution(taskIdx));
+#endif
+    }
+    DEBUG_LOG("Deadline misses = %lu", (unsigned long)m_scheduler.GetDeadlineMisses());
+#endif
 }
\ No newline at end of file
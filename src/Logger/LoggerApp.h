@@ -3,11 +3,20 @@
 #include <stdint.h>
 
 #include "RMath.h"
-#include "Filters.h"
+#include "TaskScheduler.h"
+#include "SPSCQueue.h"
 
 #include "LoggerDefinitions.h"
+#include "PackedRecord.h"
+#include "StreamCompressor.h"
+#include "LogDecoder.h"
+#include "FlightDetector.h"
+#include "LogCatalog.h"
+#include "FRAMDirectory.h"
+#include "SamplingPlanner.h"
 
 class BMI160;
+struct IMUSample;
 class MS5611;
 class MB85RS2MTA;
 class SDCard;
@@ -18,26 +27,143 @@ class LoggerApp
 public:
     LoggerApp();
 
-    LoggerResult Init(int samplesPerSecond);
+    ~LoggerApp();
+
+    LoggerApp(const LoggerApp& other) = delete;
+
+    LoggerResult Init(int samplesPerSecond, RecordFormat recordFormat = RecordFormat::Float);
 
     void Run();
 
+    // Run split in steps, for hosts that drive the loop themselves (native env). Call Start once
+    // after Init, then Step runs the next task and returns false if there was nothing to run
+    void Start();
+
+    bool Step();
+
+    // us until the next task is due, the host can skip that long when Step has nothing to run
+    uint32_t GetIdleTime()const;
+
+    LoggerState GetState()const;
+
+    // The log was dumped (or something failed), nothing else will happen
+    bool IsDone()const;
+
+    // Task stats and timers (see LoggerTask)
+    const TaskScheduler& GetScheduler()const;
+
+    // Summary stored at the end of the log, valid once the log is finished (Dump state onwards)
+    const LogSummary& GetSummary()const;
+
+    // Sensor config picked at Init for the sampling rate
+    const SamplingPlan& GetSamplingPlan()const;
+
+    // Valid once the logs were dumped (End state)
+    const DumpStats& GetDumpStats()const;
+
+    // Commits of the flight in progress (or the last one)
+    const JournalStats& GetJournalStats()const;
+
+    // Thresholds built in the firmware
+    static DetectorSettings GetDefaultDetectorSettings();
+
+    // Lets the host tune the detection (replay harness), the board runs with the defaults
+    void SetDetectorSettings(const DetectorSettings& settings);
+
     // For testing only. It will record data for 'runTime' and dump it to the SD card
     // frequency as defined by Init()
     void RunTest(float runTime);
 
 private:
-    void Update(float totalTimeSec, float deltaTime);
+    // Calls 'Method' on the LoggerApp passed as context, used as TaskFunction
+    template<void (LoggerApp::*Method)()>
+    static void RunTask(void* context);
+
+    // Tasks (see LoggerTask)
+    void SampleTask();
+    void RecordTask();
+    void DetectorTask();
+    void FlushTask();
+    void DumpTask();
+
+    // Sample, Record and Detector run at this period (us)
+    void SetSamplingPeriod(uint32_t period);
+
+    // Finishes the log and moves to LoggerState::Dump, sampling stops
+    void EndLog();
 
     void SwapState();
 
-    void GatherCurrentState(float time);
+    // Times each pipeline stage with micros(), for the planner (see PlanSampling). Leaves the sensors
+    // in their Init config, the IMU FIFO disabled
+    void MeasureStageCosts(StageCosts& costs);
+
+    // Advances the sensors that run asynchronously (barometer conversions). Call it as often as possible
+    void PollSensors();
+
+    // Samples the sensors, the state is stamped with the current tick time
+    void GatherCurrentState();
+
+    // Takes the IMU sample into the current state, in LSB for RecordFormat::Raw (see CalibrateRawDetection)
+    void SetCurrentIMU(const IMUSample& sample);
+
+    // RecordFormat::Raw runs the detection on the sensor words: the altitude is D1 counts below the last pressure
+    // and the acceleration is in LSB, the detector thresholds are scaled to match. Stops the barometer pressure compensation
+    void CalibrateRawDetection();
+
+    // Writes the sample (in the configured record format) to the FRAM and advances the address
+    void StoreSample(const State& state, const RawState& rawState);
+
+    // Returns the sample encoded as a fixed size 'format' record. 'packedRecord' is used as storage for RecordFormat::Packed
+    const uint8_t* EncodeRecord(RecordFormat format, const State& state, const RawState& rawState, uint8_t* packedRecord);
+
+    // Empties the pre-trigger ring, Idle samples get recorded into it until liftoff
+    void BeginPreTrigger();
+
+    // Writes the sample to the pre-trigger ring, overwriting the oldest one once it's full
+    void StorePreTrigger(const State& state, const RawState& rawState);
+
+    // Writes the LogHeader at the start of the segment, it freezes the pre-trigger ring and the active log goes after it
+    void WriteLogHeader();
+
+    // Writes anything still buffered and the LogSummary, call it when the log is done. The segment is trimmed
+    // to the log and waits for its dump
+    void FinishLog();
+
+    // Writes the current compressed block and refreshes the m_maxSamples estimate
+    void FlushCompressedBlock();
+
+    // Journals the records in the FRAM, every JOURNAL_RECORDS records unless 'force'. Call it after a flush
+    void CommitJournal(bool force);
 
-    void SerializeHeader(Print* stream);
+    // Turns a segment left Recording by a power loss into a Recorded one that ends at the last commit.
+    // Returns false if there's none (a segment that didn't lift off is freed)
+    bool RecoverFlight();
 
-    void SerializeItem(Print* stream, float value, char separator, bool printSeparator = true);
+    // Allocates the segment of the next flight (see FRAMDirectory), false if there's no room for m_minSegmentSize
+    bool BeginSegment();
 
-    void SerializeState(const State& state, Print* stream);
+    // Dumps every recorded segment to its own file, the ones that were verified are freed. Returns false if
+    // any is left in the FRAM
+    bool DumpSegments();
+
+    // Writes the segment to the next log of the catalog and reads it back, true if the card has it all
+    bool DumpSegment(const FRAMSegment& segment);
+
+    // The file has 'size' bytes with this CRC (see CRC16.h)
+    bool VerifyFile(const char* path, uint32_t size, uint16_t crc);
+
+    // Reads the log back from the FRAM, converts it to State and writes it as CSV (see LogCSV)
+    void DumpLog(Print* stream, const FRAMSegment& segment);
+
+    // Log_N.bin size: the DumpFileHeader and the segment up to the end of the LogSummary
+    static uint32_t GetDumpImageSize(const FRAMSegment& segment);
+
+    // Writes the DumpFileHeader and copies the segment image after it
+    void DumpImage(Print* stream, const FRAMSegment& segment);
+
+    // DEBUG_LOG the scheduler stats
+    void LogTaskStats();
 
     LoggerState m_state;
 
@@ -49,31 +175,98 @@ private:
     State m_currentState;
     State m_prevState;
 
+    // Raw sensor words for the current state (RecordFormat::Raw)
+    RawState m_currentRaw;
+
+    RecordFormat m_recordFormat;
+
+    // Encoder for RecordFormat::Packed (it also quantizes for RecordFormat::Compressed)
+    PackedRecordCodec m_packedEncoder;
+
+    StreamCompressor m_compressor;
+
+    // Set when the barometer finished a new measurement since the last GatherCurrentState
+    bool m_newBaroSample;
+
+    // IMU samples drained from the FIFO on the last GatherCurrentState (only with IMU_FIFO_ENABLE)
+    IMUSample* m_imuBatch;
+    uint8_t m_imuBatchCount;
+    uint32_t m_imuBatchTime; // us, when the batch was read
+
+    // The batch goes with a queued sample, the FIFO isn't read again until the Record task is done with it
+    bool m_imuBatchQueued;
+
     // The number of states to capture per second
     int m_samplesPerSecond;
 
     // Time in seconds between each sample (during Active state)
     float m_deltaTimeActive;
 
-    // Requested delta time (can change based on the current state)
-    float m_targetDeltaTime;
+    // Same as above, in us
+    uint32_t m_activePeriod;
+
+    // Runs the LoggerTask tasks. The Sample task timer is the log time base
+    TaskScheduler m_scheduler;
+
+    // Samples from the Sample task (the producer, it could be an ISR) to the Record task
+    SPSCQueue<CapturedState, k_sampleQueueSize> m_sampleQueue;
+
+    // Set by the Sample task, the Detector task consumes it
+    bool m_stateToCheck;
+
+    // The first sample has no previous state to compare with
+    bool m_firstSample;
 
     // The size (in bytes) of each state packet
     uint8_t m_stateDataSize;
 
+    // Segment offset of the next record
     uint32_t m_currentFRAMAddr;
 
+    // Where the first record is stored (after the LogHeader and the pre-trigger ring)
+    uint32_t m_logStartAddr;
+
+    // Flight being recorded, its slot in the directory
+    FRAMSegment m_segment;
+    uint8_t m_segmentIdx;
+
+    // Bytes a new flight needs at least (MIN_FLIGHT_TIME)
+    uint32_t m_minSegmentSize;
+
+    // Samples in the last journal commit
+    uint32_t m_committedSamples;
+
+    // Pre-trigger ring, a window of Idle samples so we don't lose the start of the boost
+    RecordFormat m_preTriggerFormat;
+    uint8_t m_preTriggerRecordSize;
+    uint16_t m_preTriggerCapacity;
+    uint16_t m_preTriggerCount;
+    uint16_t m_preTriggerHead; // Slot of the next record
+
     uint32_t m_numSamples;
 
-    // How many samples can we store in the FRAM?
+    // How many samples can we store in the FRAM? (an estimate for RecordFormat::Compressed)
     uint32_t m_maxSamples;
 
     // With the current sampling frequency, for how long can we cample?
     float m_maxActiveTime;
 
-    // The altitude at the liftoff event
-    float m_liftOffAltitude;
+    FlightDetector m_detector;
+
+    // RecordFormat::Raw detection units (see CalibrateRawDetection), 1 otherwise
+    uint32_t m_baroReferenceD1;
+    float m_detectorAltitudeScale;      // Units per m
+    float m_detectorAccelerationScale;  // Units per G
+
+    LogSummary m_summary;
+
+    SamplingPlan m_plan;
+
+    DumpStats m_dumpStats;
+
+    JournalStats m_journalStats;
+
+    LogCatalog m_catalog;
 
-    // Median filter used to figure out if we landed
-    MedianFilter m_landingFilter;
+    FRAMDirectory m_directory;
 };
\ No newline at end of file
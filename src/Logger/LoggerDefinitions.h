@@ -17,9 +17,64 @@ enum class LoggerResult : uint8_t
     FailedInitIMU,
     FailedInitFRAM,
     FailedInitSD,
+    InfeasibleSamplingRate,     // The loop can't keep up with the rate (see PlanSampling)
     COUNT,
 };
 
+// Tasks run by the LoggerApp scheduler (in the order they are added, it breaks deadline ties)
+enum class LoggerTask : uint8_t
+{
+    Baro,       // Barometer conversion state machine
+    Sample,     // IMU read, builds the current state
+    Record,     // Encodes the current state to the FRAM
+    Detector,   // Liftoff and landing detection
+    Flush,      // Writes the FRAM write buffer
+    Dump,       // FRAM to SD card once the log is done
+    COUNT,
+};
+
+static const uint8_t k_numLoggerTasks = (uint8_t)LoggerTask::COUNT;
+
+// Hot path stages timed by the profiler (PROFILER_ENABLED, see Profiler.h). Written to PROFILE.csv at dump time
+enum class ProfileStage : uint8_t
+{
+    Baro,       // Barometer poll (conversion fetch and start, compensation)
+    Altitude,   // Pressure to altitude, once per new pressure
+    IMU,        // IMU read (or FIFO drain) and conversion
+    Encode,     // Record encoding (quantize and compress for RecordFormat::Compressed)
+    FRAM,       // Appends and flushes to the FRAM
+    Detector,   // Liftoff and landing detection
+    Dump,       // A record decoded and written to the SD card
+    COUNT,
+};
+
+static const uint8_t k_numProfileStages = (uint8_t)ProfileStage::COUNT;
+
+// Task periods (us), Sample, Record and Detector run at the sampling period
+static const uint32_t k_baroTaskPeriod = 3000;
+static const uint32_t k_flushTaskPeriod = 100000;
+static const uint32_t k_dumpTaskPeriod = 100000;
+
+// Deadlines (us) of the tasks that run at the sampling period
+inline uint32_t GetSampleTaskDeadline(uint32_t samplingPeriod)
+{
+    return samplingPeriod / 2u;
+}
+
+inline uint32_t GetDetectorTaskDeadline(uint32_t samplingPeriod)
+{
+    return samplingPeriod;
+}
+
+// How samples are stored in the FRAM
+enum class RecordFormat : uint8_t
+{
+    Float,  // State as is
+    Raw,    // RawState, converted to State when dumping
+    Packed, // Fixed point, bit packed (see PackedRecord.h)
+    Compressed, // Packed channels, predicted and rice coded in blocks (see StreamCompressor.h)
+};
+
 struct State
 {
     float m_timeStamp;
@@ -27,4 +82,233 @@ struct State
     float m_temperature;
     Vec3 m_acceleration;
     Vec3 m_angularRate;
+    uint8_t m_temperatureAge; // Barometer samples since the temperature was measured
+};
+
+// What's stored in the FRAM (and dumped as is to Log_N.bin) has the AVR layout on every build, no padding,
+// so the host can read the device logs. State is fine as it is (floats first), the host only adds padding at the end
+#pragma pack(push, 1)
+
+// Raw sensor words, no float math is needed to build it
+struct RawState
+{
+    uint32_t m_timeStamp;       // ms
+    uint8_t m_pressure[3];      // MS5611 D1 (24 bits, big endian)
+    uint8_t m_temperature[3];   // MS5611 D2 (24 bits, big endian)
+    uint8_t m_temperatureAge;
+    int16_t m_acceleration[3];  // BMI160 LSB
+    int16_t m_angularRate[3];   // BMI160 LSB
+};
+
+// Stored once at the start of the flight segment (see FRAMSegment), it has all we need to convert the records.
+// The layout is: LogHeader, pre-trigger ring (fixed size records), active log
+struct LogHeader
+{
+    uint16_t m_magic;
+    uint8_t m_version;
+    RecordFormat m_recordFormat;
+    uint8_t m_recordSize;
+    uint8_t m_accRange;                 // AccRange
+    uint8_t m_gyrRange;                 // GyrRange
+    uint16_t m_samplesPerSecond;
+    uint32_t m_startTime;               // ms, time of the newest pre-trigger record (the liftoff sample without one).
+                                        // The active log's delta encoded timestamps continue from it
+    uint16_t m_baroCalibration[6];      // MS5611 C1 to C6
+    float m_seaLevelPressure;           // Pa
+    uint16_t m_preTriggerCapacity;      // Records in the pre-trigger ring (stored right after the header)
+    uint16_t m_preTriggerCount;         // Valid records in the ring
+    uint16_t m_preTriggerOldest;        // Slot of the oldest record, the ring wraps around at the end
+};
+
+static const uint16_t k_logHeaderMagic = 0x524C; // 'RL'
+static const uint8_t k_logHeaderVersion = 3;
+static const uint8_t k_logHeaderVersionRingBase = 2; // Up to it m_startTime is the time base of the oldest pre-trigger record
+
+// Written after the last record when the log is finished (it's not part of the records)
+struct LogSummary
+{
+    uint16_t m_magic;
+    uint32_t m_numSamples;
+    uint32_t m_ticks;                   // Sampling ticks while Active
+    uint32_t m_overruns;                // Ticks skipped because a sample took more than a period
+    uint32_t m_maxLateness;             // us
+    uint32_t m_meanLateness;            // us
+    uint32_t m_deadlineMisses;          // All tasks
+    uint32_t m_queueOverflows;          // Samples dropped because the Record task fell behind
+    uint16_t m_taskWorstExecution[k_numLoggerTasks]; // us, in LoggerTask order
+};
+
+static const uint16_t k_logSummaryMagic = 0x534C; // 'LS'
+
+// Log_N.bin: this header, then the flight segment from its start (the LogHeader) to the end of the LogSummary as it's stored.
+// The LogHeader has the schema (record format and size, IMU ranges), the sample rate and the barometer calibration
+struct DumpFileHeader
+{
+    uint32_t m_magic;
+    uint8_t m_version;
+    uint8_t m_headerSize;               // sizeof(DumpFileHeader), the FRAM image starts right after it
+    uint16_t m_firmwareVersion;         // k_firmwareVersion of the logger that wrote it
+    uint32_t m_numSamples;              // Records in the active log (the pre-trigger ones aren't counted)
+    uint32_t m_logEnd;                  // Segment offset past the active log, the LogSummary follows
+    uint32_t m_imageSize;               // FRAM bytes in the file
+};
+
+static const uint32_t k_dumpFileMagic = 0x42474C52; // 'RLGB'
+static const uint8_t k_dumpFileVersion = 1;
+
+// Major in the high byte, minor in the low one
+static const uint16_t k_firmwareVersion = 0x0100;
+
+// CATALOG.BIN on the card: this header, then a CatalogEntry per dumped log in dump order (see LogCatalog)
+struct CatalogHeader
+{
+    uint32_t m_magic;
+    uint8_t m_version;
+    uint8_t m_entrySize;                // sizeof(CatalogEntry)
+    uint16_t m_reserved;
+    uint32_t m_nextSequence;            // Log_<m_nextSequence> is the next dump
+    uint32_t m_numEntries;
+};
+
+// CatalogEntry::m_flags
+static const uint8_t k_catalogCSV = 0x01;           // Log_N.csv, Log_N.bin otherwise
+static const uint8_t k_catalogContiguous = 0x02;    // Streamed to a contiguous file (DumpStats)
+static const uint8_t k_catalogLanded = 0x04;        // The landing was detected, it ran out of FRAM otherwise
+static const uint8_t k_catalogRecovered = 0x08;     // The power went while recording, the log ends at the last FlightJournal commit
+
+// A dumped flight, enough to tell them apart without opening the logs
+struct CatalogEntry
+{
+    uint32_t m_sequence;                // Log_<m_sequence>
+    uint32_t m_fileSize;                // bytes
+    uint32_t m_numSamples;              // Active log
+    uint16_t m_samplesPerSecond;
+    RecordFormat m_recordFormat;
+    uint8_t m_flags;
+    uint32_t m_flightTime;              // ms from liftoff to the last sample
+    float m_apogee;                     // m above the liftoff altitude
+    uint32_t m_overruns;                // LogSummary
+};
+
+static const uint32_t k_catalogMagic = 0x54434C52; // 'RLCT'
+static const uint8_t k_catalogVersion = 1;
+
+// FRAM layout: a FRAMDirectoryHeader at address 0, k_maxFRAMSegments FRAMSegment slots, two FlightJournal slots,
+// two FRAMMove slots, then the flight segments.
+// A segment has a log as LogHeader describes it, its addresses are relative to the segment start (see FRAMDirectory)
+enum class FRAMSegmentState : uint8_t
+{
+    Recording,      // The flight in progress, the segment spans to the end of the FRAM
+    Recorded,       // Finished, waiting for its dump
+};
+
+struct FRAMDirectoryHeader
+{
+    uint16_t m_magic;
+    uint8_t m_version;
+    uint8_t m_numSegments;              // Slots in use, the segments are in address order
+};
+
+struct FRAMSegment
+{
+    uint32_t m_start;                   // FRAM address of the LogHeader
+    uint32_t m_size;                    // bytes
+    uint32_t m_logEnd;                  // Past the active log (segment offset), the LogSummary follows
+    uint32_t m_numSamples;              // Active log
+    uint32_t m_flightTime;              // ms, kept for the CatalogEntry (the detector doesn't store it)
+    float m_apogee;                     // m, same as above
+    FRAMSegmentState m_state;
+    uint8_t m_flags;                    // CatalogEntry::m_flags known at landing (k_catalogLanded)
+};
+
+static const uint16_t k_framDirectoryMagic = 0x4446; // 'FD'
+static const uint8_t k_framDirectoryVersion = 3;
+static const uint8_t k_maxFRAMSegments = 8;
+
+// How much of the Recording segment is in the FRAM, committed every few records so a flight survives a power loss.
+// The commits alternate between two slots, a torn write leaves the previous one. Both are cleared with a new segment
+struct FlightJournal
+{
+    uint16_t m_magic;
+    uint16_t m_sequence;                // Commit number (it wraps around), the valid slot with the newest one is the latest
+    uint32_t m_logEnd;                  // Segment offset past the committed records
+    uint32_t m_numSamples;              // Committed records of the active log
+    uint16_t m_crc;                     // CRC16 of the fields above
+};
+
+static const uint16_t k_flightJournalMagic = 0x4A46; // 'FJ'
+
+// The segment Compact is moving down, the progress is written after every chunk so a power loss in the middle of
+// the copy is finished at the next boot (FRAMDirectory::Load). Two slots and a CRC like the FlightJournal
+struct FRAMMove
+{
+    uint16_t m_magic;
+    uint16_t m_sequence;                // Write number (it wraps around), the valid slot with the newest one is the latest
+    uint32_t m_from;                    // Segment start before the move
+    uint32_t m_to;
+    uint32_t m_size;                    // bytes, 0 when no move is in progress
+    uint32_t m_done;                    // bytes already at m_to
+    uint8_t m_slot;                     // Directory slot of the segment, it gets m_to when the copy is done
+    uint16_t m_crc;                     // CRC16 of the fields above
+};
+
+static const uint16_t k_framMoveMagic = 0x4D46; // 'FM'
+
+#pragma pack(pop)
+
+// A sample as captured by the Sample task, queued for the Record task. Only what the log stores is queued,
+// the raw words with RecordFormat::Raw and the State otherwise
+struct CapturedState
+{
+    CapturedState() : m_state(), m_imuBatchCount(0) {}
+
+    union
+    {
+        State m_state;
+        RawState m_raw;
+    };
+    uint8_t m_imuBatchCount;            // IMU FIFO samples read with it, they wait in the batch until it's recorded
+};
+
+// Samples the Record task can fall behind before they get dropped
+static const uint8_t k_sampleQueueSize = 4;
+
+// How the dump went (see LoggerApp::DumpTask), all the logs of the batch
+struct DumpStats
+{
+    uint32_t m_size;                    // bytes
+    uint32_t m_time;                    // us, from creating the files to closing them (reading them back isn't counted)
+    bool m_contiguous;                  // Streamed to preallocated contiguous files, otherwise written through the FAT
+    uint8_t m_numLogs;                  // Verified and freed from the FRAM
+};
+
+// Power loss journal of the last flight (see FlightJournal)
+struct JournalStats
+{
+    uint32_t m_commits;
+    uint32_t m_journalBytes;            // Written to the FRAM by the commits
+    uint32_t m_logBytes;                // Active log written to the FRAM
+};
+
+// FRAM bytes written per log byte, 1 without the journal
+inline float GetWriteAmplification(const JournalStats& stats)
+{
+    return stats.m_logBytes > 0 ? (float)(stats.m_logBytes + stats.m_journalBytes) / (float)stats.m_logBytes : 1.0f;
+}
+
+// KB/s
+inline uint32_t GetDumpThroughput(const DumpStats& stats)
+{
+    return stats.m_time > 0 ? (uint32_t)((uint64_t)stats.m_size * 1000000ull / 1024u / stats.m_time) : 0u;
+}
+
+// Launch and landing detection thresholds (see LoggerApp::DetectorTask)
+struct DetectorSettings
+{
+    float m_liftoffClimb;               // m, minimum altitude gained between two samples
+    float m_liftoffAcceleration;        // m/s2, minimum acceleration along y
+    float m_landingBand;                // m, landing is only checked this close to the liftoff altitude
+    float m_landingAcceleration;        // m/s2, maximum total acceleration (not under power)
+    float m_landingStillBand;           // m, maximum distance between the altitude and its median
+    float m_apogeeDrop;                 // m below the highest altitude, landing is only checked past apogee
 };
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "PackedRecord.h"
+
+#include "BitStream.h"
+
+#include <math.h>
+
+static_assert(GetPackedRecordBits() <= k_packedRecordSize * 8, "Packed record schema doesn't fit");
+
+static int32_t QuantizeChannel(float value, float scale, PackedChannel channel)
+{
+    const uint8_t numBits = k_packedChannelBits[(uint8_t)channel];
+    int32_t quantized = (int32_t)lround(value * scale);
+    if(quantized > GetSignedMax(numBits))
+    {
+        return GetSignedMax(numBits);
+    }
+    if(quantized < GetSignedMin(numBits))
+    {
+        return GetSignedMin(numBits);
+    }
+    return quantized;
+}
+
+static uint32_t ClampUnsigned(uint32_t value, PackedChannel channel)
+{
+    const uint32_t maxValue = (1ul << k_packedChannelBits[(uint8_t)channel]) - 1ul;
+    return value > maxValue ? maxValue : value;
+}
+
+PackedRecordCodec::PackedRecordCodec()
+    : m_prevTime(0)
+    , m_accRange(1.0f)
+{
+}
+
+void PackedRecordCodec::Reset(uint32_t startTime, float accRange)
+{
+    m_prevTime = startTime;
+    m_accRange = accRange;
+}
+
+void PackedRecordCodec::Quantize(const State& state, int32_t* channels)
+{
+    // Keep the time base in sync with what the decoder will see if the delta gets clamped
+    uint32_t time = (uint32_t)lround(state.m_timeStamp * 1000.0f);
+    uint32_t timeDelta = time >= m_prevTime ? ClampUnsigned(time - m_prevTime, PackedChannel::TimeDelta) : 0;
+    m_prevTime += timeDelta;
+
+    const float accScale = 32767.0f / m_accRange;
+
+    channels[(uint8_t)PackedChannel::TimeDelta] = (int32_t)timeDelta;
+    channels[(uint8_t)PackedChannel::Altitude] = QuantizeChannel(state.m_altitude, 100.0f, PackedChannel::Altitude);
+    channels[(uint8_t)PackedChannel::Temperature] = QuantizeChannel(state.m_temperature, 100.0f, PackedChannel::Temperature);
+    channels[(uint8_t)PackedChannel::TemperatureAge] = state.m_temperatureAge;
+    channels[(uint8_t)PackedChannel::AccelX] = QuantizeChannel(state.m_acceleration.x, accScale, PackedChannel::AccelX);
+    channels[(uint8_t)PackedChannel::AccelY] = QuantizeChannel(state.m_acceleration.y, accScale, PackedChannel::AccelY);
+    channels[(uint8_t)PackedChannel::AccelZ] = QuantizeChannel(state.m_acceleration.z, accScale, PackedChannel::AccelZ);
+    channels[(uint8_t)PackedChannel::RateX] = QuantizeChannel(state.m_angularRate.x, 1.0f, PackedChannel::RateX);
+    channels[(uint8_t)PackedChannel::RateY] = QuantizeChannel(state.m_angularRate.y, 1.0f, PackedChannel::RateY);
+    channels[(uint8_t)PackedChannel::RateZ] = QuantizeChannel(state.m_angularRate.z, 1.0f, PackedChannel::RateZ);
+}
+
+void PackedRecordCodec::Dequantize(const int32_t* channels, State& state)
+{
+    m_prevTime += (uint32_t)channels[(uint8_t)PackedChannel::TimeDelta];
+
+    const float accScale = m_accRange / 32767.0f;
+
+    state.m_timeStamp = (float)m_prevTime * 0.001f;
+    state.m_altitude = (float)channels[(uint8_t)PackedChannel::Altitude] * 0.01f;
+    state.m_temperature = (float)channels[(uint8_t)PackedChannel::Temperature] * 0.01f;
+    state.m_temperatureAge = (uint8_t)channels[(uint8_t)PackedChannel::TemperatureAge];
+    state.m_acceleration.x = (float)channels[(uint8_t)PackedChannel::AccelX] * accScale;
+    state.m_acceleration.y = (float)channels[(uint8_t)PackedChannel::AccelY] * accScale;
+    state.m_acceleration.z = (float)channels[(uint8_t)PackedChannel::AccelZ] * accScale;
+    state.m_angularRate.x = (float)channels[(uint8_t)PackedChannel::RateX];
+    state.m_angularRate.y = (float)channels[(uint8_t)PackedChannel::RateY];
+    state.m_angularRate.z = (float)channels[(uint8_t)PackedChannel::RateZ];
+}
+
+void PackedRecordCodec::Pack(const int32_t* channels, uint8_t* record)
+{
+    BitWriter writer(record, k_packedRecordSize);
+    for(uint8_t channel = 0; channel < k_numPackedChannels; ++channel)
+    {
+        writer.Write((uint32_t)channels[channel], k_packedChannelBits[channel]);
+    }
+}
+
+void PackedRecordCodec::Unpack(const uint8_t* record, int32_t* channels)
+{
+    BitReader reader(record, k_packedRecordSize);
+    for(uint8_t channel = 0; channel < k_numPackedChannels; ++channel)
+    {
+        channels[channel] = k_packedChannelSigned[channel] ?
+            reader.ReadSigned(k_packedChannelBits[channel]) : (int32_t)reader.Read(k_packedChannelBits[channel]);
+    }
+}
+
+void PackedRecordCodec::Encode(const State& state, uint8_t* record)
+{
+    int32_t channels[k_numPackedChannels];
+    Quantize(state, channels);
+    Pack(channels, record);
+}
+
+void PackedRecordCodec::Decode(const uint8_t* record, State& state)
+{
+    int32_t channels[k_numPackedChannels];
+    Unpack(record, channels);
+    Dequantize(channels, state);
+}
+
+uint32_t PackedRecordCodec::GetTime()const
+{
+    return m_prevTime;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "RMath.h"
+
+#include "LoggerDefinitions.h"
+
+// Channels of a packed record (RecordFormat::Packed), all of them fixed point
+enum class PackedChannel : uint8_t
+{
+    TimeDelta,      // ms since the previous record
+    Altitude,       // cm
+    Temperature,    // 0.01 C
+    TemperatureAge,
+    AccelX,         // IMU LSB at the configured range
+    AccelY,
+    AccelZ,
+    RateX,          // IMU LSB
+    RateY,
+    RateZ,
+    COUNT,
+};
+
+static const uint8_t k_numPackedChannels = (uint8_t)PackedChannel::COUNT;
+
+// Record schema, bits used by each channel (in PackedChannel order)
+static constexpr uint8_t k_packedChannelBits[k_numPackedChannels] = { 16, 24, 15, 8, 16, 16, 16, 16, 16, 16 };
+
+// Channels stored as two's complement
+static constexpr bool k_packedChannelSigned[k_numPackedChannels] = { false, true, true, false, true, true, true, true, true, true };
+
+constexpr uint16_t GetPackedRecordBits(uint8_t channel = 0)
+{
+    return channel < k_numPackedChannels ? k_packedChannelBits[channel] + GetPackedRecordBits(channel + 1) : 0;
+}
+
+static const uint8_t k_packedRecordSize = (GetPackedRecordBits() + 7) / 8;
+
+// Converts State to packed records and back. Timestamps are delta encoded so records
+// have to be decoded in the same order they were encoded
+class PackedRecordCodec
+{
+public:
+    PackedRecordCodec();
+
+    // Call it before the first record of a log. 'startTime' (ms) is the time base of the first delta,
+    // 'accRange' the accelerometer range in G
+    void Reset(uint32_t startTime, float accRange);
+
+    // State to fixed point channels (values are clamped to the schema)
+    void Quantize(const State& state, int32_t* channels);
+
+    void Dequantize(const int32_t* channels, State& state);
+
+    static void Pack(const int32_t* channels, uint8_t* record);
+
+    static void Unpack(const uint8_t* record, int32_t* channels);
+
+    void Encode(const State& state, uint8_t* record);
+
+    void Decode(const uint8_t* record, State& state);
+
+    // Time (ms) of the last record encoded or decoded
+    uint32_t GetTime()const;
+
+private:
+    uint32_t m_prevTime; // ms
+    float m_accRange;
+};
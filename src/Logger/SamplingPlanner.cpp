@@ -0,0 +1,153 @@
+#include "SamplingPlanner.h"
+
+#include "Storage/MB85RS2MTA/MB85RS2MTA.h"
+
+// Temperature drifts slowly, MS5611 still converts it whenever it moves more than the drift band
+static const uint8_t k_maxTempDecimation = 64;
+
+// Spare FIFO samples per batch, the sampling ticks jitter
+static const uint8_t k_fifoBatchSpare = 1;
+
+// us between two pressures (one D1 per pressure, one D2 every 'tempDecimation')
+static uint32_t GetBaroPeriod(OSR osr, uint8_t tempDecimation)
+{
+    const uint32_t conversion = MS5611::GetConversionTime(osr);
+    return conversion + conversion / tempDecimation;
+}
+
+// Stage costs for a given IMU config (us)
+struct SamplingCosts
+{
+    float m_perTick;        // Sample task
+    float m_perRecord;      // Record task, for each record stored
+    float m_baro;           // Each new pressure
+    float m_baroPerSecond;
+};
+
+static void GetSamplingCosts(const SamplingRequest& request, const StageCosts& costs, const SamplingPlan& plan, SamplingCosts& samplingCosts)
+{
+    const float store = costs.m_record + (float)costs.m_storageBlock * request.m_recordSize / MB85RS2MTA::k_writeBufferSize;
+    if(request.m_imuFIFO)
+    {
+        // The newest sample makes the state, the whole batch gets converted and stored
+        samplingCosts.m_perTick = (float)costs.m_imuFIFORead + costs.m_imuConvert;
+        samplingCosts.m_perRecord = (float)costs.m_imuFIFOSample + costs.m_imuConvert + store;
+    }
+    else
+    {
+        samplingCosts.m_perTick = (float)costs.m_imuRead + costs.m_imuConvert;
+        samplingCosts.m_perRecord = store;
+    }
+
+    const float conversionsPerPressure = 1.0f + 1.0f / plan.m_tempDecimation;
+    samplingCosts.m_baro = conversionsPerPressure * costs.m_baroConversion + costs.m_baroCompute;
+    samplingCosts.m_baroPerSecond = samplingCosts.m_baro * 1000000.0f / GetBaroPeriod(plan.m_baroOSR, plan.m_tempDecimation);
+}
+
+// Fills the load, rates and flight time of the plan, returns false if the CPU can't keep up
+static bool EvaluatePlan(const SamplingRequest& request, const StageCosts& costs, SamplingPlan& plan)
+{
+    SamplingCosts samplingCosts;
+    GetSamplingCosts(request, costs, plan, samplingCosts);
+
+    const float samplesPerSecond = request.m_samplesPerSecond;
+    const float period = 1000000.0f / samplesPerSecond;
+    plan.m_recordsPerSecond = request.m_imuFIFO ? GetIMUODRFrequency(plan.m_imuODR) : request.m_samplesPerSecond;
+
+    const float recordBusy = plan.m_recordsPerSecond * samplingCosts.m_perRecord;
+    const float busy = samplesPerSecond * samplingCosts.m_perTick + recordBusy + samplingCosts.m_baroPerSecond;
+    plan.m_load = busy * 0.000001f;
+
+    // Worst tick: a pressure comes in with a full batch, it still has to be done before the next one
+    const float recordsPerTick = request.m_imuFIFO ? plan.m_imuFIFOBatch : 1.0f;
+    const float worstTick = samplingCosts.m_perTick + recordsPerTick * samplingCosts.m_perRecord + samplingCosts.m_baro;
+
+    // Solve the load for the rate (the records don't scale with it when the FIFO sets their rate)
+    const float budget = request.m_maxLoad * 1000000.0f - samplingCosts.m_baroPerSecond;
+    float maxSamplesPerSecond = request.m_imuFIFO ? (budget - recordBusy) / samplingCosts.m_perTick
+        : budget / (samplingCosts.m_perTick + samplingCosts.m_perRecord);
+    if(maxSamplesPerSecond > 1000000.0f / worstTick)
+    {
+        maxSamplesPerSecond = 1000000.0f / worstTick;
+    }
+    plan.m_maxSamplesPerSecond = maxSamplesPerSecond > 0.0f ? (uint16_t)(maxSamplesPerSecond < 65535.0f ? maxSamplesPerSecond : 65535.0f) : 0;
+
+    plan.m_flightTime = (float)(request.m_storageCapacity / request.m_recordSize) / plan.m_recordsPerSecond;
+
+    return plan.m_load <= request.m_maxLoad && worstTick <= period;
+}
+
+LoggerResult PlanSampling(const SamplingRequest& request, const StageCosts& costs, SamplingPlan& plan)
+{
+    if(request.m_samplesPerSecond == 0 || request.m_recordSize == 0)
+    {
+        return LoggerResult::InfeasibleSamplingRate;
+    }
+    const uint32_t period = 1000000ul / request.m_samplesPerSecond;
+
+    // 1) Barometer, the most resolution that refreshes the altitude in time. If not even OSR_256 does
+    // it the altitude just repeats for a few samples
+    plan.m_baroOSR = OSR::OSR_256;
+    plan.m_tempDecimation = k_maxTempDecimation;
+    bool baroFits = false;
+    for(int8_t osr = (int8_t)request.m_baroOSR; osr >= 0 && !baroFits; --osr)
+    {
+        for(uint8_t decimation = request.m_tempDecimation > 0 ? request.m_tempDecimation : 1; decimation <= k_maxTempDecimation; decimation *= 2)
+        {
+            if(GetBaroPeriod((OSR)osr, decimation) <= period * request.m_baroMaxPeriods)
+            {
+                plan.m_baroOSR = (OSR)osr;
+                plan.m_tempDecimation = decimation;
+                baroFits = true;
+                break;
+            }
+        }
+    }
+
+    // 2) IMU. Without the FIFO one sample is read per tick, the ODR has to keep up with Idle and Active sampling.
+    // With the FIFO every sample is stored, try the highest ODR first
+    const uint16_t tickRate = request.m_samplesPerSecond > request.m_idleSamplesPerSecond ? request.m_samplesPerSecond : request.m_idleSamplesPerSecond;
+    if(!request.m_imuFIFO)
+    {
+        plan.m_imuODR = AccODR::ODR_25_HZ;
+        while(GetIMUODRFrequency(plan.m_imuODR) < tickRate && plan.m_imuODR != AccODR::ODR_1600_HZ)
+        {
+            plan.m_imuODR = (AccODR)((uint8_t)plan.m_imuODR + 1);
+        }
+        plan.m_imuFIFOBatch = 0;
+        const bool fits = EvaluatePlan(request, costs, plan);
+        return fits && GetIMUODRFrequency(plan.m_imuODR) >= tickRate ? LoggerResult::Success : LoggerResult::InfeasibleSamplingRate;
+    }
+
+    // The plan is filled in even if nothing fits, so the caller can report what it would take
+    plan.m_imuODR = request.m_imuFIFOODR;
+    plan.m_imuFIFOBatch = request.m_imuFIFOMaxBatch;
+    EvaluatePlan(request, costs, plan);
+
+    bool fits = false;
+    for(uint8_t odr = (uint8_t)request.m_imuFIFOODR; odr >= (uint8_t)AccODR::ODR_25_HZ && !fits; --odr)
+    {
+        const uint16_t frequency = GetIMUODRFrequency((AccODR)odr);
+        if(frequency < request.m_samplesPerSecond)
+        {
+            break;
+        }
+
+        const uint32_t batch = (frequency + request.m_samplesPerSecond - 1u) / request.m_samplesPerSecond + k_fifoBatchSpare;
+        if(batch > request.m_imuFIFOMaxBatch)
+        {
+            continue;
+        }
+
+        plan.m_imuODR = (AccODR)odr;
+        plan.m_imuFIFOBatch = (uint8_t)batch;
+        fits = EvaluatePlan(request, costs, plan);
+    }
+    return fits ? LoggerResult::Success : LoggerResult::InfeasibleSamplingRate;
+}
+
+uint16_t GetIMUODRFrequency(AccODR odr)
+{
+    // ODR_25_HZ is 25Hz, every step doubles the rate
+    return (uint16_t)(25u << ((uint8_t)odr - (uint8_t)AccODR::ODR_25_HZ));
+}
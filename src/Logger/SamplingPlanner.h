@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "RMath.h"
+
+#include "LoggerDefinitions.h"
+
+#include "Sensors/BMI160/BMI160.h"
+#include "Sensors/MS5611/MS5611.h"
+
+// Cost (us) of each pipeline stage, measured at boot with micros() (see LoggerApp::MeasureStageCosts).
+// Task dispatch and the detector aren't measured, the load margin covers them
+struct StageCosts
+{
+    uint16_t m_imuRead;             // One sample from the IMU data registers
+    uint16_t m_imuFIFORead;         // FIFO length read, the fixed part of draining the FIFO
+    uint16_t m_imuFIFOSample;       // Each sample drained from the FIFO
+    uint16_t m_imuConvert;          // Raw IMU sample to G and dps
+    uint16_t m_baroConversion;      // Fetching a conversion and starting the next one
+    uint16_t m_baroCompute;         // Compensation and altitude of a new pressure
+    uint16_t m_record;              // Encoding a record
+    uint16_t m_storageBlock;        // Writing MB85RS2MTA::k_writeBufferSize bytes to the FRAM
+};
+
+// What the logger asks for, the Init arguments plus the compile time config
+struct SamplingRequest
+{
+    uint16_t m_samplesPerSecond;    // Active
+    uint16_t m_idleSamplesPerSecond;
+    uint8_t m_recordSize;           // bytes, worst case
+    uint32_t m_storageCapacity;     // bytes left for the active log
+    float m_maxLoad;                // Fraction of the CPU the sampling can take
+    OSR m_baroOSR;                  // Highest barometer OSR
+    uint8_t m_tempDecimation;       // Lowest temperature decimation
+    uint8_t m_baroMaxPeriods;       // Sampling periods a barometer measurement can take
+    bool m_imuFIFO;                 // Every IMU sample gets stored (IMU_FIFO_ENABLE)
+    AccODR m_imuFIFOODR;            // Highest IMU ODR with the FIFO
+    uint8_t m_imuFIFOMaxBatch;      // Samples the batch buffer holds
+};
+
+// Sensor config that keeps up with the request
+struct SamplingPlan
+{
+    OSR m_baroOSR;
+    uint8_t m_tempDecimation;
+    AccODR m_imuODR;                // The gyro runs at the same rate
+    uint8_t m_imuFIFOBatch;         // Samples drained per sampling period, 0 without the FIFO
+    uint16_t m_recordsPerSecond;    // Stored while Active (the IMU ODR with the FIFO)
+    float m_load;                   // CPU fraction at the requested rate
+    uint16_t m_maxSamplesPerSecond; // Highest sampling rate this config keeps up with
+    float m_flightTime;             // s of active log that fit in the storage
+};
+
+// Picks the highest barometer OSR (and the lowest temperature decimation) whose measurement fits in
+// m_baroMaxPeriods sampling periods, and the IMU ODR and FIFO batch that keep up with the rate.
+// Returns LoggerResult::InfeasibleSamplingRate if the CPU can't sample at the requested rate
+LoggerResult PlanSampling(const SamplingRequest& request, const StageCosts& costs, SamplingPlan& plan);
+
+// Output data rate in Hz
+uint16_t GetIMUODRFrequency(AccODR odr);
@@ -0,0 +1,258 @@
+#include "StreamCompressor.h"
+
+#include "BitStream.h"
+
+#include <string.h>
+
+// A block always holds a key frame and at least one worst case record
+static_assert(8 + GetPackedRecordBits() + GetCompressedRecordMaxBits() <= k_compressedBlockSize * 8, "Compressed block is too small");
+
+// Residual history used for the rice parameter, halved once it reaches this many samples
+static const uint8_t k_residualWindow = 16;
+
+static uint32_t ZigZag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t UnZigZag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1u);
+}
+
+static int32_t GetChannelMin(uint8_t channel)
+{
+    return k_packedChannelSigned[channel] ? GetSignedMin(k_packedChannelBits[channel]) : 0;
+}
+
+static int32_t GetChannelMax(uint8_t channel)
+{
+    return k_packedChannelSigned[channel] ? GetSignedMax(k_packedChannelBits[channel]) : (int32_t)((1ul << k_packedChannelBits[channel]) - 1ul);
+}
+
+void ChannelPredictor::Reset()
+{
+    memset(m_prev, 0, sizeof(m_prev));
+    memset(m_prev2, 0, sizeof(m_prev2));
+    memset(m_residualSum, 0, sizeof(m_residualSum));
+    m_residualCount = 0;
+    m_history = 0;
+}
+
+int32_t ChannelPredictor::Predict(uint8_t channel)const
+{
+    if(m_history < 2)
+    {
+        return m_prev[channel];
+    }
+
+    // Clamping keeps the residual within the channel bits + 1 (see the escape code)
+    int32_t prediction = 2 * m_prev[channel] - m_prev2[channel];
+    if(prediction > GetChannelMax(channel))
+    {
+        return GetChannelMax(channel);
+    }
+    if(prediction < GetChannelMin(channel))
+    {
+        return GetChannelMin(channel);
+    }
+    return prediction;
+}
+
+uint8_t ChannelPredictor::GetRiceParam(uint8_t channel)const
+{
+    // Smallest k so that count * 2^k >= sum (LOCO-I)
+    uint8_t k = 0;
+    while(((uint32_t)m_residualCount << k) < m_residualSum[channel] && k < k_packedChannelBits[channel])
+    {
+        ++k;
+    }
+    return k;
+}
+
+void ChannelPredictor::Update(const int32_t* channels, const uint32_t* residuals)
+{
+    for(uint8_t channel = 0; channel < k_numPackedChannels; ++channel)
+    {
+        m_residualSum[channel] += residuals[channel];
+        m_prev2[channel] = m_prev[channel];
+        m_prev[channel] = channels[channel];
+    }
+
+    if(++m_residualCount >= k_residualWindow)
+    {
+        m_residualCount >>= 1;
+        for(uint8_t channel = 0; channel < k_numPackedChannels; ++channel)
+        {
+            m_residualSum[channel] >>= 1;
+        }
+    }
+
+    m_history = 2;
+}
+
+void ChannelPredictor::SetKeyFrame(const int32_t* channels)
+{
+    Reset();
+    memcpy(m_prev, channels, sizeof(m_prev));
+    memcpy(m_prev2, channels, sizeof(m_prev2));
+    m_residualCount = 1;
+    m_history = 1;
+}
+
+StreamCompressor::StreamCompressor()
+{
+    Reset();
+}
+
+void StreamCompressor::Reset()
+{
+    memset(m_block, 0, sizeof(m_block));
+    m_bitCount = 8; // First byte is the number of records
+    m_predictor.Reset();
+}
+
+bool StreamCompressor::Add(const int32_t* channels)
+{
+    if(m_block[0] == 255)
+    {
+        return false;
+    }
+
+    // The first record of a block is stored as is
+    if(m_block[0] == 0)
+    {
+        BitWriter writer(m_block, k_compressedBlockSize, m_bitCount);
+        for(uint8_t channel = 0; channel < k_numPackedChannels; ++channel)
+        {
+            writer.Write((uint32_t)channels[channel], k_packedChannelBits[channel]);
+        }
+        m_bitCount = writer.GetBitCount();
+        m_predictor.SetKeyFrame(channels);
+        ++m_block[0];
+        return true;
+    }
+
+    // Work out the size of the record before touching the block
+    uint32_t residuals[k_numPackedChannels];
+    uint8_t riceParams[k_numPackedChannels];
+    uint16_t recordBits = 0;
+    for(uint8_t channel = 0; channel < k_numPackedChannels; ++channel)
+    {
+        residuals[channel] = ZigZag(channels[channel] - m_predictor.Predict(channel));
+        riceParams[channel] = m_predictor.GetRiceParam(channel);
+
+        uint32_t quotient = residuals[channel] >> riceParams[channel];
+        recordBits += quotient < k_riceEscape ?
+            (uint16_t)quotient + 1 + riceParams[channel] :
+            k_riceEscape + k_packedChannelBits[channel] + 1;
+    }
+
+    if(m_bitCount + recordBits > k_compressedBlockSize * 8)
+    {
+        return false;
+    }
+
+    BitWriter writer(m_block, k_compressedBlockSize, m_bitCount);
+    for(uint8_t channel = 0; channel < k_numPackedChannels; ++channel)
+    {
+        const uint8_t k = riceParams[channel];
+        uint32_t quotient = residuals[channel] >> k;
+        if(quotient < k_riceEscape)
+        {
+            // Unary quotient (ones terminated by a zero) followed by k bits
+            writer.Write((1ul << quotient) - 1ul, (uint8_t)quotient + 1);
+            writer.Write(residuals[channel], k);
+        }
+        else
+        {
+            writer.Write((1ul << k_riceEscape) - 1ul, k_riceEscape);
+            writer.Write(residuals[channel], k_packedChannelBits[channel] + 1);
+        }
+    }
+    m_bitCount = writer.GetBitCount();
+
+    m_predictor.Update(channels, residuals);
+    ++m_block[0];
+
+    return true;
+}
+
+uint8_t StreamCompressor::GetNumRecords()const
+{
+    return m_block[0];
+}
+
+const uint8_t* StreamCompressor::GetBlock()const
+{
+    return m_block;
+}
+
+StreamDecompressor::StreamDecompressor()
+    : m_block(nullptr)
+    , m_bitCount(0)
+    , m_recordIdx(0)
+{
+}
+
+void StreamDecompressor::BeginBlock(const uint8_t* block)
+{
+    m_block = block;
+    m_bitCount = 8;
+    m_recordIdx = 0;
+    m_predictor.Reset();
+}
+
+bool StreamDecompressor::Next(int32_t* channels)
+{
+    if(!m_block || m_recordIdx >= GetNumRecords())
+    {
+        return false;
+    }
+
+    BitReader reader(m_block, k_compressedBlockSize, m_bitCount);
+    if(m_recordIdx == 0)
+    {
+        for(uint8_t channel = 0; channel < k_numPackedChannels; ++channel)
+        {
+            channels[channel] = k_packedChannelSigned[channel] ?
+                reader.ReadSigned(k_packedChannelBits[channel]) : (int32_t)reader.Read(k_packedChannelBits[channel]);
+        }
+        m_predictor.SetKeyFrame(channels);
+    }
+    else
+    {
+        uint32_t residuals[k_numPackedChannels];
+        for(uint8_t channel = 0; channel < k_numPackedChannels; ++channel)
+        {
+            const uint8_t k = m_predictor.GetRiceParam(channel);
+
+            uint8_t quotient = 0;
+            while(quotient < k_riceEscape && reader.Read(1))
+            {
+                ++quotient;
+            }
+
+            if(quotient < k_riceEscape)
+            {
+                residuals[channel] = ((uint32_t)quotient << k) | reader.Read(k);
+            }
+            else
+            {
+                residuals[channel] = reader.Read(k_packedChannelBits[channel] + 1);
+            }
+            channels[channel] = m_predictor.Predict(channel) + UnZigZag(residuals[channel]);
+        }
+        m_predictor.Update(channels, residuals);
+    }
+
+    m_bitCount = reader.GetBitCount();
+    ++m_recordIdx;
+
+    return true;
+}
+
+uint8_t StreamDecompressor::GetNumRecords()const
+{
+    return m_block ? m_block[0] : 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "PackedRecord.h"
+
+// Compressed blocks are written to the FRAM as a whole, each of them can be decoded on its own
+static const uint8_t k_compressedBlockSize = 128;
+
+// Rice codes with a quotient above this are escaped (raw value follows), it bounds the cost of a sample
+static const uint8_t k_riceEscape = 14;
+
+// Worst case bits needed by a compressed record (every channel escaped)
+constexpr uint16_t GetCompressedRecordMaxBits(uint8_t channel = 0)
+{
+    return channel < k_numPackedChannels ? (k_riceEscape + k_packedChannelBits[channel] + 1) + GetCompressedRecordMaxBits(channel + 1) : 0;
+}
+
+// Per channel prediction state, shared by the compressor and decompressor so both stay in sync
+class ChannelPredictor
+{
+public:
+    void Reset();
+
+    // Linear prediction from the last two values (clamped to the channel range)
+    int32_t Predict(uint8_t channel)const;
+
+    // Rice parameter from the running mean of the residuals
+    uint8_t GetRiceParam(uint8_t channel)const;
+
+    void Update(const int32_t* channels, const uint32_t* residuals);
+
+    void SetKeyFrame(const int32_t* channels);
+
+private:
+    int32_t m_prev[k_numPackedChannels];
+    int32_t m_prev2[k_numPackedChannels];
+    uint32_t m_residualSum[k_numPackedChannels];
+    uint8_t m_residualCount;
+    uint8_t m_history;
+};
+
+// Streaming compressor of packed channels (see PackedRecordCodec::Quantize).
+// Block layout: [number of records][key frame, packed as PackedRecordCodec::Pack][rice coded residuals...]
+class StreamCompressor
+{
+public:
+    StreamCompressor();
+
+    void Reset();
+
+    // Returns false if the block is full, flush it (GetBlock) and call Reset before adding the record again
+    bool Add(const int32_t* channels);
+
+    uint8_t GetNumRecords()const;
+
+    // Unused bytes at the end are zero
+    const uint8_t* GetBlock()const;
+
+private:
+    uint8_t m_block[k_compressedBlockSize];
+    uint16_t m_bitCount;
+    ChannelPredictor m_predictor;
+};
+
+class StreamDecompressor
+{
+public:
+    StreamDecompressor();
+
+    // 'block' must stay valid while reading records from it
+    void BeginBlock(const uint8_t* block);
+
+    // Returns false once all the records in the block were read
+    bool Next(int32_t* channels);
+
+    uint8_t GetNumRecords()const;
+
+private:
+    const uint8_t* m_block;
+    uint16_t m_bitCount;
+    uint8_t m_recordIdx;
+    ChannelPredictor m_predictor;
+};
@@ -2,13 +2,25 @@
 
 #include "Debug/DebugOutput.h"
 
-#include <Arduino.h>
-#include <Wire.h>
+#include "HAL.h"
 
 #define BMI_EXTRA_CHECKS 1
 
 const uint8_t k_deviceID = 0xD1;
 
+const uint8_t k_normalFilterMode = 0x2 << 4; // acc_bwp / gyr_bwp normal mode [2.11.12]
+const uint8_t k_fifoGyrEnable = 1 << 7;
+const uint8_t k_fifoAccEnable = 1 << 6;
+const uint8_t k_fifoFrameSize = 12; // Headerless, gyro + accel [2.5.1]
+const uint8_t k_sampleBlockSize = 15; // DATA_8 to SENSORTIME_2
+
+// Wire can't buffer more than BUFFER_LENGTH bytes per transaction (32 on AVR)
+#ifdef BUFFER_LENGTH
+const uint8_t k_fifoBurstFrames = BUFFER_LENGTH / k_fifoFrameSize;
+#else
+const uint8_t k_fifoBurstFrames = 2;
+#endif
+
 BMI160::BMI160()
     : m_wire(nullptr)
     , m_address(0x0)
@@ -18,10 +30,11 @@ BMI160::BMI160()
     , m_gyrPowerMode(GyroPowerMode::Suspended)
     , m_gyrODR(GyrODR::ODR_100_HZ)
     , m_gyrRange(GyrRange::RANGE_2000_DPS)
+    , m_fifoEnabled(false)
 {
 }
 
-bool BMI160::Init(TwoWire* wire, uint8_t address)
+bool BMI160::Init(I2CBus* wire, uint8_t address)
 {
     m_wire = wire;
     m_address = address;
@@ -56,6 +69,9 @@ bool BMI160::Init(TwoWire* wire, uint8_t address)
 #endif
 
     SetPowerMode(AccPowerMode::Normal, GyroPowerMode::Normal);
+
+    // Make sure the chip matches our config
+    Configure(m_accODR, m_accRange, m_gyrODR, m_gyrRange);
     
     return true;
 }
@@ -84,53 +100,181 @@ bool BMI160::ReadIMU(Vec3& acceleration, Vec3& angularRate)
 
 bool BMI160::ReadData(Vec3& acceleration, Vec3& angularRate)
 {
-    // Start reading the gyro data
-    int16_t rawGyro[3];
-    if(!ReadRawData((uint8_t)Registers::DATA_8, rawGyro, 6u))
+    IMUSample sample;
+    if(!ReadSample(sample))
     {
         return false;
     }
 
-    // Now read the accelerometer data
-    int16_t rawAccel[3];
-    if(!ReadRawData((uint8_t)Registers::DATA_14, rawAccel, 6u))
+    ConvertSample(sample, acceleration, angularRate);
+    
+    return true;
+}
+
+bool BMI160::ReadSample(IMUSample& sample)
+{
+    // Gyro, accel and sensor time are contiguous (DATA_8 to SENSORTIME_2), grab them in one go
+    uint8_t data[k_sampleBlockSize];
+    if(!ReadRawData((uint8_t)Registers::DATA_8, data, k_sampleBlockSize))
     {
         return false;
-    }   
+    }
 
-    // Process the data
-    angularRate.x = rawGyro[0];
-    angularRate.y = rawGyro[1];
-    angularRate.z = rawGyro[2];
+    DecodeAxes(data, sample);
+    sample.m_timeStamp = micros();
+    sample.m_sensorTime = (uint32_t)data[12] | ((uint32_t)data[13] << 8) | ((uint32_t)data[14] << 16);
 
-    const float accRange = GetAccRangeMult(m_accRange);
-    acceleration.x = (float)rawAccel[0] / 32767.0f * accRange;
-    acceleration.y = (float)rawAccel[1] / 32767.0f * accRange;
-    acceleration.z = (float)rawAccel[2] / 32767.0f * accRange;
-    
     return true;
 }
 
-bool BMI160::ReadRawData(uint8_t dataRegister, int16_t* data, uint8_t count)
+void BMI160::Configure(AccODR accODR, AccRange accRange, GyrODR gyrODR, GyrRange gyrRange)
+{
+    // [2.11.12 - 2.11.15]
+    m_accODR = accODR;
+    m_accRange = accRange;
+    m_gyrODR = gyrODR;
+    m_gyrRange = gyrRange;
+
+    WriteRegister(Registers::ACC_CONF, k_normalFilterMode | (uint8_t)m_accODR);
+    WriteRegister(Registers::ACC_RANGE, (uint8_t)m_accRange);
+    WriteRegister(Registers::GYR_CONF, k_normalFilterMode | (uint8_t)m_gyrODR);
+    WriteRegister(Registers::GYR_RANGE, (uint8_t)m_gyrRange);
+}
+
+void BMI160::EnableFIFO(bool enable)
+{
+    // [2.11.20]
+    m_fifoEnabled = enable;
+    WriteRegister(Registers::FIFO_CONFIG_1, enable ? (k_fifoGyrEnable | k_fifoAccEnable) : 0);
+
+    // Start from an empty FIFO
+    WriteRegister(Registers::CMD, (uint8_t)CMDCodes::fifo_flush);
+}
+
+uint8_t BMI160::ReadFIFO(IMUSample* samples, uint8_t maxSamples)
+{
+    if(!m_fifoEnabled)
+    {
+        return 0;
+    }
+
+    // How many complete frames are waiting
+    uint8_t lengthBytes[2];
+    if(!ReadRawData((uint8_t)Registers::FIFO_LENGTH_0, lengthBytes, 2u))
+    {
+        return 0;
+    }
+    uint16_t fifoLength = ((uint16_t)(lengthBytes[1] & 0x7) << 8) | lengthBytes[0];
+    uint16_t numFrames = fifoLength / k_fifoFrameSize;
+    uint8_t numSamples = numFrames < maxSamples ? (uint8_t)numFrames : maxSamples;
+
+    // Drain in bursts as big as Wire allows
+    uint8_t frames[k_fifoBurstFrames * k_fifoFrameSize];
+    uint8_t sampleIdx = 0;
+    while(sampleIdx < numSamples)
+    {
+        uint8_t burstFrames = numSamples - sampleIdx;
+        if(burstFrames > k_fifoBurstFrames)
+        {
+            burstFrames = k_fifoBurstFrames;
+        }
+
+        if(!ReadRawData((uint8_t)Registers::FIFO_DATA, frames, burstFrames * k_fifoFrameSize))
+        {
+            break;
+        }
+
+        const uint8_t* frame = frames;
+        for(uint8_t i = 0; i < burstFrames; ++i, frame += k_fifoFrameSize)
+        {
+            IMUSample& sample = samples[sampleIdx++];
+            DecodeAxes(frame, sample);
+            sample.m_sensorTime = 0; // Not available in headerless mode
+        }
+    }
+
+    // Frames are produced at the ODR, the newest one is (roughly) now
+    uint32_t now = micros();
+    uint32_t period = GetSamplePeriod();
+    for(uint8_t i = 0; i < sampleIdx; ++i)
+    {
+        samples[i].m_timeStamp = now - (uint32_t)(sampleIdx - 1 - i) * period;
+    }
+
+    return sampleIdx;
+}
+
+void BMI160::ConvertSample(const IMUSample& sample, Vec3& acceleration, Vec3& angularRate)const
+{
+    ConvertSample(sample, m_accRange, acceleration, angularRate);
+}
+
+void BMI160::ConvertSample(const IMUSample& sample, AccRange accRange, Vec3& acceleration, Vec3& angularRate)
+{
+    angularRate.x = sample.m_angularRate[0];
+    angularRate.y = sample.m_angularRate[1];
+    angularRate.z = sample.m_angularRate[2];
+
+    const float accRangeMult = GetAccRangeMult(accRange);
+    acceleration.x = (float)sample.m_acceleration[0] / 32767.0f * accRangeMult;
+    acceleration.y = (float)sample.m_acceleration[1] / 32767.0f * accRangeMult;
+    acceleration.z = (float)sample.m_acceleration[2] / 32767.0f * accRangeMult;
+}
+
+uint32_t BMI160::GetSamplePeriod()const
+{
+    // ODR 8 is 100Hz, every step doubles the rate
+    const uint8_t odr = (uint8_t)m_gyrODR;
+    return odr >= 8 ? (10000ul >> (odr - 8)) : (10000ul << (8 - odr));
+}
+
+AccRange BMI160::GetAccRange()const
+{
+    return m_accRange;
+}
+
+GyrRange BMI160::GetGyrRange()const
+{
+    return m_gyrRange;
+}
+
+void BMI160::WriteRegister(Registers reg, uint8_t value)
+{
+    m_wire->beginTransmission(m_address);
+    m_wire->write((uint8_t)reg);
+    m_wire->write(value);
+    m_wire->endTransmission();
+}
+
+bool BMI160::ReadRawData(uint8_t dataRegister, uint8_t* data, uint8_t numBytes)
 {
     m_wire->beginTransmission(m_address);
     m_wire->write(dataRegister);
     m_wire->endTransmission();
 
-    if(m_wire->requestFrom(m_address, count) != count)
+    if(m_wire->requestFrom(m_address, numBytes) != numBytes)
     {
         return false;
     }
 
-    for(uint8_t i = 0; i < count; ++i)
+    for(uint8_t i = 0; i < numBytes; ++i)
     {
-        data[i]  = (uint8_t)m_wire->read();
-        data[i] |= (uint8_t)m_wire->read() << 8;
+        data[i] = (uint8_t)m_wire->read();
     }
 
     return true;
 }
 
+void BMI160::DecodeAxes(const uint8_t* data, IMUSample& sample)
+{
+    // Little endian, gyro x/y/z followed by accel x/y/z
+    for(uint8_t axis = 0; axis < 3; ++axis)
+    {
+        sample.m_angularRate[axis] = (int16_t)((uint16_t)data[axis * 2] | ((uint16_t)data[axis * 2 + 1] << 8));
+        sample.m_acceleration[axis] = (int16_t)((uint16_t)data[6 + axis * 2] | ((uint16_t)data[6 + axis * 2 + 1] << 8));
+    }
+}
+
 void BMI160::SetPowerMode(AccPowerMode accPM, GyroPowerMode gyrPM)
 {
     // [2.11.38]
@@ -160,7 +304,7 @@ void BMI160::SetPowerMode(AccPowerMode accPM, GyroPowerMode gyrPM)
     }
 }
 
-float BMI160::GetAccRangeMult(AccRange range)const
+float BMI160::GetAccRangeMult(AccRange range)
 {
     switch (range)
     {
@@ -172,7 +316,7 @@ float BMI160::GetAccRangeMult(AccRange range)const
     }
 }
 
-float BMI160::GetGyroRangeMult(GyrRange range)const
+float BMI160::GetGyroRangeMult(GyrRange range)
 {
     switch (range)
     {
@@ -3,8 +3,7 @@
 #include <stdint.h>
 
 #include "RMath.h"
-
-class TwoWire;
+#include "HALTypes.h"
 
 enum class AccODR : uint8_t
 {
@@ -46,6 +45,15 @@ enum class GyrRange : uint8_t
     RANGE_125_DPS  = 4,
 };
 
+// Raw IMU sample as stored by the sensor, see BMI160::ConvertSample
+struct IMUSample
+{
+    uint32_t m_timeStamp; // us (micros)
+    uint32_t m_sensorTime; // SENSORTIME register (39.0625us per tick), 0 if not available
+    int16_t m_angularRate[3];
+    int16_t m_acceleration[3];
+};
+
 // IMU BMI160
 // Datasheet: https://www.bosch-sensortec.com/media/boschsensortec/downloads/datasheets/bst-bmi160-ds000.pdf
 class BMI160
@@ -53,17 +61,52 @@ class BMI160
 public:
     BMI160();
     
-    bool Init(TwoWire* wire, uint8_t address = 0x69);
+    bool Init(I2CBus* wire, uint8_t address = 0x69);
 
     bool IsConnected();
 
     bool ReadIMU(Vec3& acceleration, Vec3& angularRate);
 
+    // Reads gyro, accel and sensor time in a single I2C transaction
+    bool ReadSample(IMUSample& sample);
+
+    // Writes the output data rate and range to the chip
+    void Configure(AccODR accODR, AccRange accRange, GyrODR gyrODR, GyrRange gyrRange);
+
+    // Headerless FIFO with gyro and accel frames. Both ODRs should match (see Configure)
+    void EnableFIFO(bool enable);
+
+    // Drains up to 'maxSamples' frames from the FIFO (oldest first), returns the number of samples read.
+    // Timestamps are reconstructed from the ODR, the newest sample being the time of the call
+    uint8_t ReadFIFO(IMUSample* samples, uint8_t maxSamples);
+
+    // Scales a raw sample the same way ReadIMU does
+    void ConvertSample(const IMUSample& sample, Vec3& acceleration, Vec3& angularRate)const;
+
+    // Same as above for a given range, used to convert stored samples without the sensor
+    static void ConvertSample(const IMUSample& sample, AccRange accRange, Vec3& acceleration, Vec3& angularRate);
+
+    // Time between two samples for the current gyro ODR
+    uint32_t GetSamplePeriod()const;
+
+    AccRange GetAccRange()const;
+
+    GyrRange GetGyrRange()const;
+
+    // Full scale values (G and degrees per second)
+    static float GetAccRangeMult(AccRange range);
+
+    static float GetGyroRangeMult(GyrRange range);
+
 private:
     
     bool ReadData(Vec3& acceleration, Vec3& angularRate);
 
-    bool ReadRawData(uint8_t dataRegister, int16_t* data, uint8_t count);
+    // Reads 'numBytes' starting at 'dataRegister' in a single transaction
+    bool ReadRawData(uint8_t dataRegister, uint8_t* data, uint8_t numBytes);
+
+    // Decodes the gyro + accel block (same layout for the data registers and FIFO frames)
+    static void DecodeAxes(const uint8_t* data, IMUSample& sample);
 
     enum class Registers : uint8_t
     {
@@ -72,10 +115,15 @@ private:
         PMU_STATUS  = 0x03,
         DATA_8      = 0x0C, // Gyro data start
         DATA_14     = 0x12, // Acc data start
+        SENSORTIME_0 = 0x18,
+        FIFO_LENGTH_0 = 0x22,
+        FIFO_DATA   = 0x24,
         ACC_CONF    = 0x40,
         ACC_RANGE   = 0x41,
         GYR_CONF    = 0x42,
         GYR_RANGE   = 0x43,
+        FIFO_CONFIG_0 = 0x46,
+        FIFO_CONFIG_1 = 0x47,
         CMD         = 0x7E,        
     };
 
@@ -108,11 +156,9 @@ private:
 
     void SetPowerMode(AccPowerMode accPM, GyroPowerMode gyrPM);
 
-    float GetAccRangeMult(AccRange range)const;
+    void WriteRegister(Registers reg, uint8_t value);
 
-    float GetGyroRangeMult(GyrRange range)const;
-    
-    TwoWire* m_wire;
+    I2CBus* m_wire;
     uint8_t m_address;
 
     AccPowerMode m_accPowerMode;
@@ -122,4 +168,6 @@ private:
     GyroPowerMode m_gyrPowerMode;
     GyrODR m_gyrODR;        // 100HZ default
     GyrRange m_gyrRange;    // +- 2000DPS default
+
+    bool m_fifoEnabled;
 };
\ No newline at end of file
@@ -2,8 +2,7 @@
 
 #include "Debug/DebugOutput.h"
 
-#include <Arduino.h>
-#include <Wire.h>
+#include "HAL.h"
 
 const uint8_t k_resetDelay = 10; // ms
 
@@ -12,6 +11,7 @@ const uint8_t k_readCommand  = 0xA0; // Starting addr, we can read from 0xA0 to
 const uint8_t k_adcReadCommand = 0x0;
 const uint8_t k_convertD1Commands [5] = {0x40, 0x42, 0x44, 0x46, 0x48 };
 const uint8_t k_convertD2Commands [5] = {0x50, 0x52, 0x54, 0x56, 0x58 };
+const uint16_t k_conversionTimes [5] = {600, 1170, 2280, 4540, 9040}; // us, max values from the data sheet
 
 #define MS_TEST      0
 #define MS_TEST_LOWT 0
@@ -30,6 +30,23 @@ MS5611::MS5611()
     : m_wire(nullptr)
     , m_address(0)
     , m_lastTemperature(0.0f)
+    , m_lastPressure(0.0f)
+    , m_converting(false)
+    , m_conversionType(DType::D_PRESSURE)
+    , m_conversionTime(0)
+    , m_conversionStart(0)
+    , m_pendingD1(0)
+    , m_lastD1(0)
+    , m_lastD2(0)
+    , m_offset(0)
+    , m_sensitivity(0)
+    , m_temperature(0)
+    , m_temperatureValid(false)
+    , m_temperatureDrifting(false)
+    , m_temperatureAge(0)
+    , m_temperatureDecimation(1)
+    , m_temperatureDriftBand(0)
+    , m_pressureCompensation(true)
 {
 }
 
@@ -37,7 +54,7 @@ MS5611::~MS5611()
 {
 }
 
-bool MS5611::Init(TwoWire* wire, uint8_t address)
+bool MS5611::Init(I2CBus* wire, uint8_t address)
 {
     m_wire = wire;
     m_address = address;
@@ -76,12 +93,20 @@ bool MS5611::ReadPressure(float& pressure, OSR tempOSR, OSR pressureOSR)
         return false;
     }
 
-    // Read digital temperature
-    uint32_t D2 = 0;
-    RequestConversionAndWait(DType::D_TEMPERATURE, tempOSR);
-    if(!ReadADC(D2))
+    // Read digital temperature (only when the cached one is too old)
+    if(NeedsTemperature())
     {
-        return false;
+        uint32_t D2 = 0;
+        RequestConversionAndWait(DType::D_TEMPERATURE, tempOSR);
+        if(!ReadADC(D2))
+        {
+            return false;
+        }
+        UpdateTemperature(D2);
+    }
+    else
+    {
+        AgeTemperature();
     }
 #else
 #if MS_TEST_LOWT != 0
@@ -92,52 +117,169 @@ bool MS5611::ReadPressure(float& pressure, OSR tempOSR, OSR pressureOSR)
     uint32_t D1 = 9085466;
     uint32_t D2 = 8569150;
 #endif
+    UpdateTemperature(D2);
 #endif
 
-    // Calculate temperature
-    int32_t dT = clamp(D2 - m_calibration[5], -16776960, 16777216);
-    int32_t TEMP = 2000 + dT * m_calibration[6] / 8388608; // max intermediate size 41 :U
+    UpdatePressure(D1, pressure);
 
-    int32_t T2 = 0;
-    int32_t OFF2 = 0;
-    int32_t SENS2 = 0;
+#if 0
+    Serial.print("Temperature: "); Serial.print(m_lastTemperature); 
+    Serial.print(" Pressure: "); Serial.println(pressure);
+#endif
 
-    if(TEMP < 2000)
+    return true;
+}
+
+float MS5611::GetLastTemperature()const
+{
+    return m_lastTemperature;
+}
+
+uint8_t MS5611::GetTemperatureAge()const
+{
+    return m_temperatureAge;
+}
+
+void MS5611::SetTemperatureDecimation(uint8_t samples, float driftBand)
+{
+    m_temperatureDecimation = samples > 0 ? samples : 1;
+    m_temperatureDriftBand = (int32_t)(driftBand * 100.0f);
+}
+
+void MS5611::SetPressureCompensation(bool enabled)
+{
+    m_pressureCompensation = enabled;
+}
+
+void MS5611::StartConversion(DType type, OSR osr)
+{
+    uint8_t osrIndex = (uint8_t)osr;
+    WriteCommand(
+        type == DType::D_PRESSURE ? k_convertD1Commands[osrIndex] : k_convertD2Commands[osrIndex]
+    );
+    m_converting = true;
+    m_conversionType = type;
+    m_conversionTime = k_conversionTimes[osrIndex];
+    m_conversionStart = micros();
+}
+
+bool MS5611::IsConversionReady()const
+{
+    // Unsigned subtraction handles micros() wrapping around
+    return m_converting && (uint32_t)(micros() - m_conversionStart) >= m_conversionTime;
+}
+
+bool MS5611::FetchConversion(uint32_t& value)
+{
+    if(!m_converting)
     {
-        T2 = (dT * dT) / 2147483648;
-        int32_t tmp = ((TEMP - 2000) * (TEMP - 2000)) * 5;
-        OFF2 = tmp / 2;
-        SENS2 = tmp / 4;
-        if(TEMP < -1500.0f)
+        return false;
+    }
+    m_converting = false;
+
+    // NOTE: the ADC returns 0 if the conversion didn't finish
+    return ReadADC(value) && value != 0;
+}
+
+bool MS5611::Poll(OSR tempOSR, OSR pressureOSR)
+{
+    // Kick off the sequence
+    if(!m_converting)
+    {
+        StartConversion(DType::D_PRESSURE, pressureOSR);
+        return false;
+    }
+
+    if(!IsConversionReady())
+    {
+        return false;
+    }
+
+    DType finishedType = m_conversionType;
+    uint32_t value = 0;
+    if(!FetchConversion(value))
+    {
+        // Restart the sequence on the next call
+        return false;
+    }
+
+    if(finishedType == DType::D_PRESSURE)
+    {
+        if(NeedsTemperature())
         {
-            tmp = (TEMP + 1500) * (TEMP + 1500);
-            OFF2 = OFF2 + 7 * tmp;
-            SENS2 = SENS2 + 11 * tmp / 2;
+            m_pendingD1 = value;
+            StartConversion(DType::D_TEMPERATURE, tempOSR);
+            return false;
         }
+
+        // Reuse the cached temperature terms
+        AgeTemperature();
+        m_pendingD1 = value;
+    }
+    else
+    {
+        UpdateTemperature(value);
     }
 
-    // Adjust TEMP
-    TEMP = TEMP - T2;
+    // We have D1 and a valid temperature, start the next pressure conversion straight away
+    if(m_pressureCompensation)
+    {
+        float pressure = 0.0f;
+        UpdatePressure(m_pendingD1, pressure);
+    }
+    else
+    {
+        m_lastD1 = m_pendingD1;
+    }
+    StartConversion(DType::D_PRESSURE, pressureOSR);
 
-    // Calculate temperature compensated pressure
-    int64_t OFF = clamp(((int64_t)m_calibration[2] + ((int64_t)m_calibration[4] * (int64_t)dT) / 128ll), -8589672450ll, 12884705280ll) - OFF2;
-    int64_t SENS = clamp(((int64_t)m_calibration[1] + ((int64_t)m_calibration[3] * (int64_t)dT) / 256ll), -4294836225ll, 6442352640ll) - SENS2;
-    int32_t P = ((int64_t)D1 * SENS / 2097152ll - OFF) / 32768ll;
+    return true;
+}
 
-    pressure = (float)P * 0.01f;
-    m_lastTemperature = (float)TEMP * 0.01f;
+float MS5611::GetLastPressure()const
+{
+    return m_lastPressure;
+}
 
-#if 0
-    Serial.print("Temperature: "); Serial.print(m_lastTemperature); 
-    Serial.print(" Pressure: "); Serial.println(pressure);
-#endif
+uint16_t MS5611::GetConversionTime(OSR osr)
+{
+    return k_conversionTimes[(uint8_t)osr];
+}
 
-    return true;
+void MS5611::GetLastRaw(uint32_t& D1, uint32_t& D2)const
+{
+    D1 = m_lastD1;
+    D2 = m_lastD2;
 }
 
-float MS5611::GetLastTemperature()const
+void MS5611::GetCalibration(uint16_t* coefficients)const
 {
-    return m_lastTemperature;
+    // Undo PrepareCalibration
+    coefficients[0] = (uint16_t)(m_calibration[1] / 32768);
+    coefficients[1] = (uint16_t)(m_calibration[2] / 65536);
+    coefficients[2] = (uint16_t)m_calibration[3];
+    coefficients[3] = (uint16_t)m_calibration[4];
+    coefficients[4] = (uint16_t)(m_calibration[5] / 256);
+    coefficients[5] = (uint16_t)m_calibration[6];
+}
+
+void MS5611::SetCalibration(const uint16_t* coefficients)
+{
+    m_calibration[0] = 0;
+    for(uint8_t index = 0; index < 6; ++index)
+    {
+        m_calibration[index + 1] = coefficients[index];
+    }
+    PrepareCalibration();
+
+    // Cached terms are no longer valid
+    m_temperatureValid = false;
+}
+
+void MS5611::Convert(uint32_t D1, uint32_t D2, float& pressure)
+{
+    UpdateTemperature(D2);
+    UpdatePressure(D1, pressure);
 }
 
 void MS5611::WriteCommand(uint8_t command)
@@ -149,6 +291,7 @@ void MS5611::WriteCommand(uint8_t command)
 
 void MS5611::RequestConversionAndWait(DType type, OSR osr)
 {
+    m_converting = false; // This cancels any async conversion
     uint8_t osrIndex = (uint8_t)osr;
     WriteCommand(
         type == DType::D_PRESSURE ? k_convertD1Commands[osrIndex] : k_convertD2Commands[osrIndex]
@@ -171,6 +314,71 @@ bool MS5611::ReadADC(uint32_t& value)
     return false;
 }
 
+bool MS5611::NeedsTemperature()const
+{
+    return !m_temperatureValid || m_temperatureDrifting || (m_temperatureAge + 1u) >= m_temperatureDecimation;
+}
+
+void MS5611::AgeTemperature()
+{
+    if(m_temperatureAge < 255)
+    {
+        ++m_temperatureAge;
+    }
+}
+
+void MS5611::UpdateTemperature(uint32_t D2)
+{
+    // Calculate temperature
+    int32_t dT = clamp(D2 - m_calibration[5], -16776960, 16777216);
+    int32_t TEMP = 2000 + (int32_t)((int64_t)dT * m_calibration[6] / 8388608); // max intermediate size 41 :U
+
+    int32_t T2 = 0;
+    int32_t OFF2 = 0;
+    int32_t SENS2 = 0;
+
+    if(TEMP < 2000)
+    {
+        T2 = (int32_t)(((int64_t)dT * dT) / INT64_C(2147483648));
+        int32_t tmp = ((TEMP - 2000) * (TEMP - 2000)) * 5;
+        OFF2 = tmp / 2;
+        SENS2 = tmp / 4;
+        if(TEMP < -1500.0f)
+        {
+            tmp = (TEMP + 1500) * (TEMP + 1500);
+            OFF2 = OFF2 + 7 * tmp;
+            SENS2 = SENS2 + 11 * tmp / 2;
+        }
+    }
+
+    // Adjust TEMP
+    TEMP = TEMP - T2;
+
+    // Cache the temperature dependent terms, these are reused until the next D2 conversion
+    m_offset = clamp(((int64_t)m_calibration[2] + ((int64_t)m_calibration[4] * (int64_t)dT) / INT64_C(128)), INT64_C(-8589672450), INT64_C(12884705280)) - OFF2;
+    m_sensitivity = clamp(((int64_t)m_calibration[1] + ((int64_t)m_calibration[3] * (int64_t)dT) / INT64_C(256)), INT64_C(-4294836225), INT64_C(6442352640)) - SENS2;
+
+    // If the temperature is moving faster than the drift band, keep measuring it
+    int32_t drift = TEMP - m_temperature;
+    m_temperatureDrifting = m_temperatureValid && (drift > m_temperatureDriftBand || -drift > m_temperatureDriftBand);
+
+    m_lastD2 = D2;
+    m_temperature = TEMP;
+    m_temperatureValid = true;
+    m_temperatureAge = 0;
+    m_lastTemperature = (float)TEMP * 0.01f;
+}
+
+void MS5611::UpdatePressure(uint32_t D1, float& pressure)
+{
+    // Calculate temperature compensated pressure
+    int32_t P = ((int64_t)D1 * m_sensitivity / 2097152ll - m_offset) / 32768ll;
+
+    pressure = (float)P * 0.01f;
+    m_lastPressure = pressure;
+    m_lastD1 = D1;
+}
+
 bool MS5611::ReadCalibration()
 {
 #if MS_TEST == 0    
@@ -204,13 +412,18 @@ bool MS5611::ReadCalibration()
     }
 #endif
 
-    
+
+    PrepareCalibration();
+
+    return true;
+}
+
+void MS5611::PrepareCalibration()
+{
     // Do this only once
     m_calibration[1] *= 32768;
     m_calibration[2] *= 65536;
     m_calibration[5] *= 256;
-
-    return true;
 }
 
 bool MS5611::ReadCalibrationValue(uint32_t& value)
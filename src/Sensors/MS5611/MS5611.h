@@ -2,7 +2,7 @@
 
 #include <stdint.h>
 
-class TwoWire;
+#include "HALTypes.h"
 
 enum class OSR : uint8_t
 {
@@ -32,7 +32,7 @@ public:
 
     MS5611(const MS5611& other) = delete;
 
-    bool Init(TwoWire* wire, uint8_t address);
+    bool Init(I2CBus* wire, uint8_t address);
 
     bool IsConnected();
 
@@ -44,6 +44,47 @@ public:
     // After succesfully running ReadPressure, this returns last valid temperature in C
     float GetLastTemperature()const;
 
+    // Number of pressure samples that reused the last temperature (0 means it was measured with the last pressure)
+    uint8_t GetTemperatureAge()const;
+
+    // Only convert D2 every 'samples' pressure readings, or on every reading while the temperature
+    // moves more than 'driftBand' (C) between two conversions. 1 measures temperature every time (default)
+    void SetTemperatureDecimation(uint8_t samples, float driftBand = 0.5f);
+
+    // Poll only keeps the raw D1 (see GetLastRaw) when the pressure compensation is off, GetLastPressure isn't updated.
+    // The temperature terms are still worked out on every D2, the decimation needs them to see drift. On by default
+    void SetPressureCompensation(bool enabled);
+
+    // Non blocking API. Start a conversion, poll until it's ready and then fetch the raw ADC value
+    void StartConversion(DType type, OSR osr);
+
+    bool IsConversionReady()const;
+
+    // Returns false if no conversion was running or the ADC didn't return a valid value
+    bool FetchConversion(uint32_t& value);
+
+    // Runs the D1 -> D2 conversion sequence without blocking, call it as often as possible.
+    // Returns true when a new pressure value is available (see GetLastPressure)
+    bool Poll(OSR tempOSR = OSR::OSR_512, OSR pressureOSR = OSR::OSR_512);
+
+    // Last pressure (mbar) computed by Poll or ReadPressure
+    float GetLastPressure()const;
+
+    // Worst case conversion time from the data sheet in microseconds
+    static uint16_t GetConversionTime(OSR osr);
+
+    // Raw ADC values used for the last pressure/temperature
+    void GetLastRaw(uint32_t& D1, uint32_t& D2)const;
+
+    // Factory calibration coefficients C1 to C6 as stored in the PROM
+    void GetCalibration(uint16_t* coefficients)const;
+
+    // Loads C1 to C6, allows converting raw values without a device (see Convert)
+    void SetCalibration(const uint16_t* coefficients);
+
+    // Converts raw ADC values into pressure (mbar), GetLastTemperature is updated too
+    void Convert(uint32_t D1, uint32_t D2, float& pressure);
+
     static const uint8_t m_defaultAddr = 0x77;
 
 private:
@@ -55,13 +96,47 @@ private:
     // Sends the ADC command internally
     bool ReadADC(uint32_t& value);
 
+    bool NeedsTemperature()const;
+
+    void AgeTemperature();
+
+    // Applies the calibration and second order compensation to D2, caches the terms used by UpdatePressure
+    void UpdateTemperature(uint32_t D2);
+
+    // Temperature compensated pressure using the cached temperature terms
+    void UpdatePressure(uint32_t D1, float& pressure);
+
     bool ReadCalibration();
 
+    // Applies the PROM values to m_calibration
+    void PrepareCalibration();
+
     // User must send the command outside
     bool ReadCalibrationValue(uint32_t& value);
 
-    TwoWire* m_wire;
+    I2CBus* m_wire;
     uint8_t m_address;
     uint32_t m_calibration[7];
     float m_lastTemperature;
+    float m_lastPressure;
+
+    // Async conversion state
+    bool m_converting;
+    DType m_conversionType;
+    uint16_t m_conversionTime; // us
+    uint32_t m_conversionStart; // us
+    uint32_t m_pendingD1;
+    uint32_t m_lastD1;
+    uint32_t m_lastD2;
+
+    // Temperature compensation terms (OFF, SENS and TEMP from the data sheet)
+    int64_t m_offset;
+    int64_t m_sensitivity;
+    int32_t m_temperature;
+    bool m_temperatureValid;
+    bool m_temperatureDrifting;
+    uint8_t m_temperatureAge;
+    uint8_t m_temperatureDecimation;
+    int32_t m_temperatureDriftBand; // 0.01C
+    bool m_pressureCompensation;
 };
\ No newline at end of file
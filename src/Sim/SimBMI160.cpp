@@ -0,0 +1,287 @@
+#ifndef ARDUINO
+
+#include "SimBMI160.h"
+
+#include <string.h>
+
+static const uint8_t k_chipID = 0xD1;
+
+// Registers [2.11]
+static const uint8_t k_regChipID = 0x00;
+static const uint8_t k_regPMUStatus = 0x03;
+static const uint8_t k_regData = 0x0C;         // DATA_8, gyro then accel
+static const uint8_t k_regSensorTime = 0x18;
+static const uint8_t k_regFIFOLength = 0x22;
+static const uint8_t k_regFIFOData = 0x24;
+static const uint8_t k_regAccConf = 0x40;
+static const uint8_t k_regAccRange = 0x41;
+static const uint8_t k_regGyrConf = 0x42;
+static const uint8_t k_regGyrRange = 0x43;
+static const uint8_t k_regFIFOConfig1 = 0x47;
+static const uint8_t k_regCMD = 0x7E;
+
+static const uint8_t k_fifoGyrAccEnable = 0xC0;
+
+static const float k_gravity = 9.80665f;
+
+static int16_t ToLSB(float value, float fullScale)
+{
+    const float lsb = value / fullScale * 32768.0f;
+    return lsb >= 32767.0f ? 32767 : (lsb <= -32768.0f ? -32768 : (int16_t)lroundf(lsb));
+}
+
+static float GetAccFullScale(uint8_t range)
+{
+    switch(range)
+    {
+        case 5:     return 4.0f;
+        case 8:     return 8.0f;
+        case 12:    return 16.0f;
+        default:    return 2.0f;
+    }
+}
+
+static float GetGyrFullScale(uint8_t range)
+{
+    return 2000.0f / (float)(1u << (range & 0x7u));
+}
+
+SimBMI160::SimBMI160()
+    : m_world(nullptr)
+    , m_accelNoise(0.0f)
+    , m_gyroNoise(0.0f)
+    , m_pointer(0)
+    , m_fifoOverflows(0)
+{
+    SoftReset();
+}
+
+void SimBMI160::Attach(I2CBus* bus, uint8_t address, SimWorld* world)
+{
+    m_world = world;
+    bus->Attach(address, this);
+}
+
+void SimBMI160::SetNoise(float accelNoise, float gyroNoise, uint32_t seed /*= 1u*/)
+{
+    m_accelNoise = accelNoise;
+    m_gyroNoise = gyroNoise;
+    m_random.Seed(seed);
+}
+
+uint16_t SimBMI160::GetFIFOFrames()const
+{
+    return m_fifoSize / k_frameSize;
+}
+
+uint32_t SimBMI160::GetFIFOOverflows()const
+{
+    return m_fifoOverflows;
+}
+
+void SimBMI160::OnWrite(const uint8_t* data, uint8_t size)
+{
+    // Empty writes are the driver checking we are there
+    if(size == 0)
+    {
+        return;
+    }
+
+    // Register address followed by the values to write (burst writes auto increment)
+    m_pointer = data[0] & 0x7F;
+    for(uint8_t byteIdx = 1; byteIdx < size; ++byteIdx)
+    {
+        WriteRegister(m_pointer, data[byteIdx]);
+        m_pointer = (m_pointer + 1u) & 0x7F;
+    }
+}
+
+uint8_t SimBMI160::OnRead(uint8_t* data, uint8_t size)
+{
+    UpdateFIFO();
+
+    // The data registers are shadowed, a burst read gets a single sample
+    const uint64_t now = SimClock::GetTime();
+    const uint64_t sampleTime = now - now % GetODRPeriod(m_registers[k_regGyrConf]);
+    if(!m_sampleValid || sampleTime != m_sampleTime)
+    {
+        GetSampleData(sampleTime, m_sampleData);
+        m_sampleTime = sampleTime;
+        m_sampleValid = true;
+    }
+
+    for(uint8_t byteIdx = 0; byteIdx < size; ++byteIdx)
+    {
+        data[byteIdx] = ReadRegister(m_pointer);
+
+        // Reading FIFO_DATA pops bytes, the address doesn't move
+        if(m_pointer != k_regFIFOData)
+        {
+            m_pointer = (m_pointer + 1u) & 0x7F;
+        }
+    }
+    return size;
+}
+
+void SimBMI160::SoftReset()
+{
+    // Power on values [2.11]
+    memset(m_registers, 0, sizeof(m_registers));
+    m_registers[k_regChipID] = k_chipID;
+    m_registers[k_regAccConf] = 0x28;
+    m_registers[k_regAccRange] = 0x03;
+    m_registers[k_regGyrConf] = 0x28;
+    m_registers[k_regGyrRange] = 0x00;
+    m_registers[k_regFIFOConfig1] = 0x10;
+
+    m_sampleTime = 0;
+    m_sampleValid = false;
+    m_fifoHead = 0;
+    m_fifoSize = 0;
+    m_nextFrameTime = 0;
+}
+
+void SimBMI160::WriteRegister(uint8_t reg, uint8_t value)
+{
+    if(reg == k_regCMD)
+    {
+        RunCommand(value);
+        return;
+    }
+
+    m_registers[reg] = value;
+    m_sampleValid = false;
+
+    if(reg == k_regFIFOConfig1)
+    {
+        // First frame one period after the FIFO gets enabled
+        m_nextFrameTime = SimClock::GetTime() + GetODRPeriod(m_registers[k_regGyrConf]);
+    }
+}
+
+uint8_t SimBMI160::ReadRegister(uint8_t reg)
+{
+    if(reg >= k_regData && reg < k_regData + k_frameSize)
+    {
+        return m_sampleData[reg - k_regData];
+    }
+
+    if(reg >= k_regSensorTime && reg < k_regSensorTime + 3)
+    {
+        // 24 bit counter, 39.0625us (625/16) per tick
+        const uint32_t sensorTime = (uint32_t)(SimClock::GetTime() * 16u / 625u) & 0xFFFFFFu;
+        return (uint8_t)(sensorTime >> ((reg - k_regSensorTime) * 8u));
+    }
+
+    if(reg == k_regFIFOLength)
+    {
+        return (uint8_t)m_fifoSize;
+    }
+    if(reg == k_regFIFOLength + 1)
+    {
+        return (uint8_t)(m_fifoSize >> 8u) & 0x7u;
+    }
+
+    if(reg == k_regFIFOData)
+    {
+        // Empty FIFO reads 0x80
+        if(m_fifoSize == 0)
+        {
+            return 0x80;
+        }
+        const uint8_t value = m_fifo[m_fifoHead];
+        m_fifoHead = (m_fifoHead + 1u) % k_fifoSize;
+        --m_fifoSize;
+        return value;
+    }
+
+    return m_registers[reg];
+}
+
+void SimBMI160::RunCommand(uint8_t command)
+{
+    if(command == 0xB6)
+    {
+        SoftReset();
+    }
+    else if((command & 0xFC) == 0x10)
+    {
+        // acc_set_pmu_mode, PMU_STATUS bits 5:4
+        m_registers[k_regPMUStatus] = (m_registers[k_regPMUStatus] & ~0x30) | ((command & 0x3) << 4u);
+    }
+    else if((command & 0xFC) == 0x14)
+    {
+        // gyr_set_pmu_mode, PMU_STATUS bits 3:2
+        m_registers[k_regPMUStatus] = (m_registers[k_regPMUStatus] & ~0x0C) | ((command & 0x3) << 2u);
+    }
+    else if(command == 0xB0)
+    {
+        // fifo_flush
+        m_fifoHead = 0;
+        m_fifoSize = 0;
+    }
+}
+
+void SimBMI160::UpdateFIFO()
+{
+    if((m_registers[k_regFIFOConfig1] & k_fifoGyrAccEnable) != k_fifoGyrAccEnable)
+    {
+        return;
+    }
+
+    const uint64_t now = SimClock::GetTime();
+    const uint32_t period = GetODRPeriod(m_registers[k_regGyrConf]);
+    uint8_t frame[k_frameSize];
+    while(m_nextFrameTime <= now)
+    {
+        // Stream mode, the oldest frame goes when it's full
+        if(m_fifoSize + k_frameSize > k_fifoSize)
+        {
+            m_fifoHead = (m_fifoHead + k_frameSize) % k_fifoSize;
+            m_fifoSize -= k_frameSize;
+            ++m_fifoOverflows;
+        }
+
+        GetSampleData(m_nextFrameTime, frame);
+        for(uint8_t byteIdx = 0; byteIdx < k_frameSize; ++byteIdx)
+        {
+            m_fifo[(m_fifoHead + m_fifoSize) % k_fifoSize] = frame[byteIdx];
+            ++m_fifoSize;
+        }
+        m_nextFrameTime += period;
+    }
+}
+
+void SimBMI160::GetSampleData(uint64_t time, uint8_t* data)
+{
+    SimPhysics physics;
+    m_world->GetPhysics(time, physics);
+
+    const float accFullScale = GetAccFullScale(m_registers[k_regAccRange] & 0xF);
+    const float gyrFullScale = GetGyrFullScale(m_registers[k_regGyrRange]);
+    const float rate[3] = { physics.m_angularRate.x, physics.m_angularRate.y, physics.m_angularRate.z };
+    const float accel[3] = { physics.m_acceleration.x, physics.m_acceleration.y, physics.m_acceleration.z };
+
+    for(uint8_t axis = 0; axis < 3; ++axis)
+    {
+        const int16_t gyr = ToLSB(rate[axis] + m_random.GetGaussian(m_gyroNoise), gyrFullScale);
+        const int16_t acc = ToLSB((accel[axis] + m_random.GetGaussian(m_accelNoise)) / k_gravity, accFullScale);
+        data[axis * 2] = (uint8_t)gyr;
+        data[axis * 2 + 1] = (uint8_t)((uint16_t)gyr >> 8u);
+        data[6 + axis * 2] = (uint8_t)acc;
+        data[6 + axis * 2 + 1] = (uint8_t)((uint16_t)acc >> 8u);
+    }
+}
+
+uint32_t SimBMI160::GetODRPeriod(uint8_t conf)
+{
+    // ODR 8 is 100Hz, every step doubles the rate (same as BMI160::GetSamplePeriod)
+    const uint8_t odr = conf & 0xF;
+    if(odr == 0)
+    {
+        return 10000u;
+    }
+    return odr >= 8 ? (10000u >> (odr - 8)) : (10000u << (8 - odr));
+}
+
+#endif
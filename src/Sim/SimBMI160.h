@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "HAL.h"
+#include "SimWorld.h"
+
+// BMI160 model on the simulated I2C bus: register map with auto increment, data registers sampled at the ODR,
+// SENSORTIME and a headerless gyro + accel FIFO. Power modes are only reflected in PMU_STATUS
+class SimBMI160 : public SimI2CDevice
+{
+public:
+    SimBMI160();
+
+    void Attach(I2CBus* bus, uint8_t address, SimWorld* world);
+
+    // m/s2 and degrees per second (1 sigma), added to every sample
+    void SetNoise(float accelNoise, float gyroNoise, uint32_t seed = 1u);
+
+    // Frames waiting in the FIFO
+    uint16_t GetFIFOFrames()const;
+
+    // Frames lost because the FIFO was full
+    uint32_t GetFIFOOverflows()const;
+
+    void OnWrite(const uint8_t* data, uint8_t size) override;
+
+    uint8_t OnRead(uint8_t* data, uint8_t size) override;
+
+    static const uint16_t k_fifoSize = 1024;
+    static const uint8_t k_frameSize = 12;
+
+private:
+    void SoftReset();
+
+    void WriteRegister(uint8_t reg, uint8_t value);
+
+    uint8_t ReadRegister(uint8_t reg);
+
+    void RunCommand(uint8_t command);
+
+    // Adds the FIFO frames due up to now
+    void UpdateFIFO();
+
+    // Data register block (gyro and accel, little endian) for the sample at 'time'
+    void GetSampleData(uint64_t time, uint8_t* data);
+
+    // us between samples for an ODR register value
+    static uint32_t GetODRPeriod(uint8_t conf);
+
+    SimWorld* m_world;
+    SimRandom m_random;
+    float m_accelNoise;
+    float m_gyroNoise;
+
+    uint8_t m_registers[128];
+    uint8_t m_pointer;
+
+    // Data registers of the last sample read (they only change at the ODR)
+    uint64_t m_sampleTime;
+    bool m_sampleValid;
+    uint8_t m_sampleData[k_frameSize];
+
+    uint8_t m_fifo[k_fifoSize];
+    uint16_t m_fifoHead;
+    uint16_t m_fifoSize;
+    uint64_t m_nextFrameTime;   // us, SimClock time
+    uint32_t m_fifoOverflows;
+};
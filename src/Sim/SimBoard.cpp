@@ -0,0 +1,72 @@
+#ifndef ARDUINO
+
+#include "SimBoard.h"
+
+#include "Logger/LoggerApp.h"
+#include "Native/SimFileSystem.h"
+
+SimBoard::SimBoard(SimWorld* world, const char* sdRoot /*= "."*/)
+{
+    SimClock::Reset();
+    SimTiming::Reset();
+    SimGPIO::Reset();
+
+    Wire.DetachAll();
+    Wire.ResetStats();
+    Wire.setClock(100000);
+    SPI.DetachAll();
+    SPI.ResetStats();
+
+    m_baro.Attach(&Wire, k_baroAddress, world);
+    m_imu.Attach(&Wire, k_imuAddress, world);
+    m_fram.Attach(&SPI, k_framChipSelect);
+
+    SimFileSystem::SetRoot(sdRoot);
+}
+
+SimBoard::~SimBoard()
+{
+    Wire.DetachAll();
+    SPI.DetachAll();
+}
+
+SimMS5611& SimBoard::GetBaro()
+{
+    return m_baro;
+}
+
+SimBMI160& SimBoard::GetIMU()
+{
+    return m_imu;
+}
+
+SimFRAM& SimBoard::GetFRAM()
+{
+    return m_fram;
+}
+
+uint32_t SimBoard::Run(LoggerApp& app, uint64_t endTime, StepCallback callback /*= nullptr*/, void* context /*= nullptr*/)
+{
+    uint32_t numTasks = 0;
+    app.Start();
+    while(!app.IsDone() && SimClock::GetTime() < endTime)
+    {
+        if(app.Step())
+        {
+            ++numTasks;
+            SimTiming::ChargeCycles(SimCost::Code, SimTiming::GetConfig().m_taskCycles);
+            if(callback && !callback(context))
+            {
+                break;
+            }
+            continue;
+        }
+
+        // Nothing to run, jump to the next release (at least 1us so we always move forward)
+        const uint32_t idleTime = app.GetIdleTime();
+        SimClock::Advance(idleTime > 0 ? idleTime : 1u);
+    }
+    return numTasks;
+}
+
+#endif
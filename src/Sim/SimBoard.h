@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "SimWorld.h"
+#include "SimMS5611.h"
+#include "SimBMI160.h"
+#include "SimFRAM.h"
+
+// The timing tool and main read the per task stats, the native env defines it
+#ifndef PROFILER_ENABLED
+#error "The simulated board needs PROFILER_ENABLED"
+#endif
+
+class LoggerApp;
+
+// The logger board on the host: barometer and IMU on Wire, the FRAM on SPI and the SD card in a directory.
+// Pins and addresses match LoggerApp. Only one board at a time, it owns the global buses and clock
+class SimBoard
+{
+public:
+    static const uint8_t k_framChipSelect = 10;    // FRAM_CS (LoggerApp.cpp)
+    static const uint8_t k_sdChipSelect = 9;       // SD_CS (LoggerApp.cpp)
+    static const uint8_t k_imuAddress = 0x69;
+    static const uint8_t k_baroAddress = 0x77;
+
+    // Resets the clock (and the SimTiming totals), pins and buses and attaches the devices. 'sdRoot' has to exist
+    explicit SimBoard(SimWorld* world, const char* sdRoot = ".");
+
+    ~SimBoard();
+
+    SimBoard(const SimBoard& other) = delete;
+
+    SimMS5611& GetBaro();
+
+    SimBMI160& GetIMU();
+
+    SimFRAM& GetFRAM();
+
+    // Called after every task the app runs, return false to stop the run
+    typedef bool (*StepCallback)(void* context);
+
+    // Runs the app (after Init) until it's done, the SimClock reaches 'endTime' (us) or 'callback' stops it.
+    // Idle time is skipped, returns the number of tasks run
+    static uint32_t Run(LoggerApp& app, uint64_t endTime, StepCallback callback = nullptr, void* context = nullptr);
+
+private:
+    SimMS5611 m_baro;
+    SimBMI160 m_imu;
+    SimFRAM m_fram;
+};
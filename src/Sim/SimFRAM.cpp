@@ -0,0 +1,152 @@
+#ifndef ARDUINO
+
+#include "SimFRAM.h"
+
+#include <string.h>
+
+static const uint8_t k_deviceID[4] = { 0x04, 0x7F, 0x48, 0x03 }; // Fujitsu, continuation code, 2Mbit
+
+SimFRAM::SimFRAM()
+    : m_data(new uint8_t[k_capacity])
+    , m_writeEnabled(false)
+    , m_status(0)
+    , m_rejectedWrites(0)
+    , m_writtenBytes(0)
+    , m_writeBudget(UINT32_MAX)
+    , m_opcode(0)
+    , m_byteIdx(0)
+    , m_address(0)
+{
+    Fill(0xFF);
+}
+
+SimFRAM::~SimFRAM()
+{
+    delete[] m_data;
+}
+
+void SimFRAM::Attach(SPIBus* bus, uint8_t chipSelect)
+{
+    bus->Attach(chipSelect, this);
+}
+
+uint8_t* SimFRAM::GetData()
+{
+    return m_data;
+}
+
+void SimFRAM::Fill(uint8_t value)
+{
+    memset(m_data, value, k_capacity);
+}
+
+uint32_t SimFRAM::GetRejectedWrites()const
+{
+    return m_rejectedWrites;
+}
+
+void SimFRAM::CutPowerAfter(uint32_t numBytes)
+{
+    m_writeBudget = numBytes;
+}
+
+void SimFRAM::RestorePower()
+{
+    m_writeBudget = UINT32_MAX;
+}
+
+uint32_t SimFRAM::GetWrittenBytes()const
+{
+    return m_writtenBytes;
+}
+
+void SimFRAM::OnSelect(bool selected)
+{
+    if(selected)
+    {
+        m_byteIdx = 0;
+        return;
+    }
+
+    // The latch is cleared on the rising edge of CS after a WRITE (or WRSR)
+    if(m_byteIdx > 0 && (m_opcode == (uint8_t)OPCodes::WRITE || m_opcode == (uint8_t)OPCodes::WRSR))
+    {
+        if(m_opcode == (uint8_t)OPCodes::WRITE && !m_writeEnabled)
+        {
+            ++m_rejectedWrites;
+        }
+        m_writeEnabled = false;
+    }
+}
+
+uint8_t SimFRAM::OnTransfer(uint8_t value)
+{
+    const uint32_t byteIdx = m_byteIdx++;
+    if(byteIdx == 0)
+    {
+        m_opcode = value;
+        if(m_opcode == (uint8_t)OPCodes::WREN)
+        {
+            m_writeEnabled = true;
+        }
+        else if(m_opcode == (uint8_t)OPCodes::WRDI)
+        {
+            m_writeEnabled = false;
+        }
+        return 0;
+    }
+
+    switch((OPCodes)m_opcode)
+    {
+        case OPCodes::RDSR:
+            return m_status | (m_writeEnabled ? 0x2 : 0x0);
+
+        case OPCodes::WRSR:
+            if(m_writeEnabled && byteIdx == 1)
+            {
+                m_status = value & 0x8C;
+            }
+            return 0;
+
+        case OPCodes::RDID:
+            return byteIdx <= 4 ? k_deviceID[byteIdx - 1] : 0;
+
+        case OPCodes::READ:
+        case OPCodes::FSTRD:
+        case OPCodes::WRITE:
+        {
+            // 3 address bytes (18 bits used), FSTRD has a dummy byte after them
+            if(byteIdx <= 3)
+            {
+                m_address = ((m_address << 8u) | value) & (k_capacity - 1u);
+                return 0;
+            }
+            if(m_opcode == (uint8_t)OPCodes::FSTRD && byteIdx == 4)
+            {
+                return 0;
+            }
+
+            const uint32_t address = m_address;
+            m_address = (m_address + 1u) & (k_capacity - 1u);
+            if(m_opcode == (uint8_t)OPCodes::WRITE)
+            {
+                if(m_writeEnabled && m_writeBudget > 0)
+                {
+                    m_data[address] = value;
+                    ++m_writtenBytes;
+                    if(m_writeBudget != UINT32_MAX)
+                    {
+                        --m_writeBudget;
+                    }
+                }
+                return 0;
+            }
+            return m_data[address];
+        }
+
+        default:
+            return 0;
+    }
+}
+
+#endif
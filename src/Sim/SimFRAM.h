@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "HAL.h"
+
+// MB85RS2MTA model on the simulated SPI bus: 256KB array, READ/FSTRD/WRITE with the address wrapping around,
+// the write enable latch (cleared at the end of every WRITE) and RDID
+class SimFRAM : public SimSPIDevice
+{
+public:
+    static const uint32_t k_capacity = 262144;
+
+    SimFRAM();
+
+    ~SimFRAM();
+
+    SimFRAM(const SimFRAM& other) = delete;
+
+    void Attach(SPIBus* bus, uint8_t chipSelect);
+
+    // Direct access to the array, no bus traffic
+    uint8_t* GetData();
+
+    // Fills the array, a new FRAM has whatever was there before (not zeros)
+    void Fill(uint8_t value);
+
+    // WRITE commands ignored because the latch wasn't set
+    uint32_t GetRejectedWrites()const;
+
+    // A power loss: the WRITE commands store 'numBytes' more bytes and drop the rest until RestorePower
+    void CutPowerAfter(uint32_t numBytes);
+
+    void RestorePower();
+
+    // Bytes the WRITE commands stored
+    uint32_t GetWrittenBytes()const;
+
+    void OnSelect(bool selected) override;
+
+    uint8_t OnTransfer(uint8_t value) override;
+
+private:
+    enum class OPCodes : uint8_t
+    {
+        WREN   = 0x6,
+        WRDI   = 0x4,
+        RDSR   = 0x5,
+        WRSR   = 0x1,
+        READ   = 0x3,
+        WRITE  = 0x2,
+        RDID   = 0x9F,
+        FSTRD  = 0xB,
+        SLEEP  = 0xB9,
+    };
+
+    uint8_t* m_data;
+    bool m_writeEnabled;
+    uint8_t m_status;
+    uint32_t m_rejectedWrites;
+    uint32_t m_writtenBytes;
+    uint32_t m_writeBudget;         // Bytes stored before the power goes, UINT32_MAX while it's on
+
+    // Command in progress (since chip select went low)
+    uint8_t m_opcode;
+    uint32_t m_byteIdx;
+    uint32_t m_address;
+};
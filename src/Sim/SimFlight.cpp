@@ -0,0 +1,141 @@
+#ifndef ARDUINO
+
+#include "SimFlight.h"
+
+#include <math.h>
+
+static const float k_gravity = 9.80665f;            // m/s2
+static const float k_seaLevelPressure = 101325.0f;  // Pa, standard atmosphere
+
+SimFlightProfile GetDefaultFlightProfile()
+{
+    SimFlightProfile profile;
+    profile.m_padTime = 3.0f;
+    profile.m_thrustAccel = 12.0f * k_gravity;
+    profile.m_boostTime = 0.3f;
+    profile.m_descentRate = 6.0f;
+    profile.m_landedTime = 5.0f;
+    profile.m_groundAltitude = 100.0f;
+    profile.m_temperature = 15.0f;
+    profile.m_spinRate = 90.0f;
+    return profile;
+}
+
+SimFlightProfile GetRandomFlightProfile(SimRandom& random)
+{
+    // Burnout velocity from 10 to 60m/s (apogees from ~5m to ~200m) over a short or long burn
+    SimFlightProfile profile;
+    const float burnoutVelocity = 10.0f + 50.0f * random.GetUniform();
+    profile.m_padTime = 2.0f + 4.0f * random.GetUniform();
+    profile.m_boostTime = 0.2f + 0.8f * random.GetUniform();
+    profile.m_thrustAccel = burnoutVelocity / profile.m_boostTime + k_gravity;
+    profile.m_descentRate = 4.0f + 6.0f * random.GetUniform();
+    profile.m_landedTime = 5.0f;
+    profile.m_groundAltitude = 1500.0f * random.GetUniform();
+    profile.m_temperature = -5.0f + 40.0f * random.GetUniform();
+    profile.m_spinRate = 360.0f * random.GetUniform();
+    return profile;
+}
+
+SimFlight::SimFlight(const SimFlightProfile& profile)
+    : m_profile(profile)
+{
+    const float boostAccel = m_profile.m_thrustAccel - k_gravity;
+    m_burnoutVelocity = boostAccel * m_profile.m_boostTime;
+    m_burnoutHeight = 0.5f * boostAccel * m_profile.m_boostTime * m_profile.m_boostTime;
+    m_apogeeHeight = m_burnoutHeight + m_burnoutVelocity * m_burnoutVelocity / (2.0f * k_gravity);
+    m_apogeeTime = GetBurnoutTime() + m_burnoutVelocity / k_gravity;
+    m_landingTime = m_apogeeTime + (m_profile.m_descentRate > 0.0f ? m_apogeeHeight / m_profile.m_descentRate : 0.0f);
+}
+
+void SimFlight::GetPhysics(uint64_t time, SimPhysics& physics)
+{
+    const float seconds = (float)((double)time * 0.000001);
+    const float altitude = m_profile.m_groundAltitude + GetHeight(seconds);
+
+    // Inverse of Pressure::GetAltitudeFromPa
+    physics.m_pressure = k_seaLevelPressure * powf(1.0f - altitude / 44330.0f, 1.0f / 0.190294f);
+    physics.m_temperature = m_profile.m_temperature;
+
+    // The accelerometer measures thrust while boosting, nothing while coasting (free fall)
+    // and gravity's reaction while on the ground or under the parachute
+    const bool boosting = seconds >= GetLiftoffTime() && seconds < GetBurnoutTime();
+    const bool coasting = seconds >= GetBurnoutTime() && seconds < m_apogeeTime;
+    physics.m_acceleration = Vec3();
+    physics.m_acceleration.y = boosting ? m_profile.m_thrustAccel : (coasting ? 0.0f : k_gravity);
+
+    physics.m_angularRate = Vec3();
+    physics.m_angularRate.y = boosting ? m_profile.m_spinRate : 0.0f;
+}
+
+void SimFlight::GetEvents(SimFlightEvents& events)const
+{
+    events.m_liftoffTime = GetLiftoffTime();
+    events.m_apogeeTime = m_apogeeTime;
+    events.m_landingTime = m_landingTime;
+    events.m_endTime = GetEndTime();
+}
+
+float SimFlight::GetHeight(float time)const
+{
+    if(time < GetLiftoffTime())
+    {
+        return 0.0f;
+    }
+
+    if(time < GetBurnoutTime())
+    {
+        const float boostTime = time - GetLiftoffTime();
+        return 0.5f * (m_profile.m_thrustAccel - k_gravity) * boostTime * boostTime;
+    }
+
+    if(time < m_apogeeTime)
+    {
+        const float coastTime = time - GetBurnoutTime();
+        return m_burnoutHeight + m_burnoutVelocity * coastTime - 0.5f * k_gravity * coastTime * coastTime;
+    }
+
+    if(time < m_landingTime)
+    {
+        return m_apogeeHeight - (time - m_apogeeTime) * m_profile.m_descentRate;
+    }
+
+    return 0.0f;
+}
+
+float SimFlight::GetLiftoffTime()const
+{
+    return m_profile.m_padTime;
+}
+
+float SimFlight::GetBurnoutTime()const
+{
+    return m_profile.m_padTime + m_profile.m_boostTime;
+}
+
+float SimFlight::GetApogeeTime()const
+{
+    return m_apogeeTime;
+}
+
+float SimFlight::GetLandingTime()const
+{
+    return m_landingTime;
+}
+
+float SimFlight::GetEndTime()const
+{
+    return m_landingTime + m_profile.m_landedTime;
+}
+
+float SimFlight::GetApogeeHeight()const
+{
+    return m_apogeeHeight;
+}
+
+const SimFlightProfile& SimFlight::GetProfile()const
+{
+    return m_profile;
+}
+
+#endif
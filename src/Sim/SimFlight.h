@@ -0,0 +1,57 @@
+#pragma once
+
+#include "SimWorld.h"
+
+struct SimFlightProfile
+{
+    float m_padTime;            // s on the pad before the motor lights up
+    float m_thrustAccel;        // m/s2 of thrust while boosting (specific force, gravity not included)
+    float m_boostTime;          // s
+    float m_descentRate;        // m/s under the parachute, from apogee to the ground
+    float m_landedTime;         // s on the ground after landing (the end of the simulation)
+    float m_groundAltitude;     // m above sea level
+    float m_temperature;        // C, inside the airframe
+    float m_spinRate;           // degrees per second around y while boosting
+};
+
+// Default profile: a small motor (12G for 0.3s), ~58m apogee and a 6m/s descent
+SimFlightProfile GetDefaultFlightProfile();
+
+// Random profile (motor, descent, pad time, site), for batches of synthetic flights
+SimFlightProfile GetRandomFlightProfile(SimRandom& random);
+
+// Synthetic vertical flight: pad, boost at constant thrust, ballistic coast to apogee and a steady descent.
+// No drag and no tilt, y is up the whole flight
+class SimFlight : public SimWorld
+{
+public:
+    explicit SimFlight(const SimFlightProfile& profile);
+
+    void GetPhysics(uint64_t time, SimPhysics& physics) override;
+
+    void GetEvents(SimFlightEvents& events)const override;
+
+    // m above the ground at 'time' (s)
+    float GetHeight(float time)const;
+
+    // Phase times (s)
+    float GetLiftoffTime()const;
+    float GetBurnoutTime()const;
+    float GetApogeeTime()const;
+    float GetLandingTime()const;
+
+    // Time when the simulation is done (landed for m_landedTime)
+    float GetEndTime()const;
+
+    float GetApogeeHeight()const;
+
+    const SimFlightProfile& GetProfile()const;
+
+private:
+    SimFlightProfile m_profile;
+    float m_burnoutVelocity;    // m/s
+    float m_burnoutHeight;      // m
+    float m_apogeeHeight;       // m
+    float m_apogeeTime;         // s
+    float m_landingTime;        // s
+};
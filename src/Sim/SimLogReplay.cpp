@@ -0,0 +1,312 @@
+#ifndef ARDUINO
+
+#include "SimLogReplay.h"
+
+#include "Tools/LogConverter.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const float k_gravity = 9.80665f;            // m/s2
+static const float k_seaLevelPressure = 101500.0f;  // Pa, SEA_LEVEL_PRESSURE (LoggerApp.cpp) the altitudes were computed with
+
+// CSV header names (WriteCSVHeader), in Field order
+static const char* const k_fieldNames[] = { "TIME", "ALTITUDE", "TEMP", "ACCEL_X", "ACCEL_Y", "ACCEL_Z", "RATE_X", "RATE_Y", "RATE_Z" };
+
+// The boost starts with this many rows above k_liftoffAccel (G)
+static const uint8_t k_liftoffRows = 3;
+static const float k_liftoffAccel = 1.5f;
+
+// Back on the pad when this close to the first altitude (m)
+static const float k_landedBand = 1.0f;
+
+static float Lerp(float from, float to, float alpha)
+{
+    return from + (to - from) * alpha;
+}
+
+static Vec3 Lerp(const Vec3& from, const Vec3& to, float alpha)
+{
+    Vec3 result;
+    result.x = Lerp(from.x, to.x, alpha);
+    result.y = Lerp(from.y, to.y, alpha);
+    result.z = Lerp(from.z, to.z, alpha);
+    return result;
+}
+
+SimLogReplay::SimLogReplay()
+    : m_events()
+    , m_rowIdx(0)
+{
+    memset(m_columns, -1, sizeof(m_columns));
+}
+
+bool SimLogReplay::Load(const char* path, float padTime /*= 5.0f*/, float landedTime /*= 10.0f*/)
+{
+    m_rows.clear();
+    m_rowIdx = 0;
+
+    // A Log_N.bin is decoded straight away, anything else is parsed as CSV
+    LogFile image;
+    if(image.Open(path))
+    {
+        return LoadImage(image, padTime, landedTime);
+    }
+
+    FILE* file = fopen(path, "r");
+    if(!file)
+    {
+        return false;
+    }
+
+    char line[256];
+    bool valid = fgets(line, sizeof(line), file) && ParseHeader(line);
+    while(valid && fgets(line, sizeof(line), file))
+    {
+        // The summary lines go after the records
+        if(line[0] == '#')
+        {
+            break;
+        }
+
+        Row row;
+        if(ParseRow(line, row))
+        {
+            m_rows.push_back(row);
+        }
+    }
+    fclose(file);
+
+    if(!valid || m_rows.empty())
+    {
+        m_rows.clear();
+        return false;
+    }
+
+    Finish(padTime, landedTime);
+    return true;
+}
+
+bool SimLogReplay::LoadImage(LogFile& image, float padTime, float landedTime)
+{
+    LogReader reader(image.GetStorage());
+    if(!image.BeginRead(reader))
+    {
+        return false;
+    }
+
+    State state = {};
+    while(reader.Next(state))
+    {
+        Row row;
+        row.m_time = state.m_timeStamp;
+        row.m_altitude = state.m_altitude;
+        row.m_temperature = state.m_temperature;
+        row.m_acceleration = state.m_acceleration;
+        row.m_angularRate = state.m_angularRate;
+        m_rows.push_back(row);
+    }
+    if(m_rows.empty())
+    {
+        return false;
+    }
+
+    Finish(padTime, landedTime);
+    return true;
+}
+
+void SimLogReplay::GetPhysics(uint64_t time, SimPhysics& physics)
+{
+    const float seconds = (float)((double)time * 0.000001);
+
+    // After the last row it's held (the first row is at 0)
+    if(m_rowIdx >= m_rows.size() || m_rows[m_rowIdx].m_time > seconds)
+    {
+        m_rowIdx = 0;
+    }
+    while(m_rowIdx + 1 < m_rows.size() && m_rows[m_rowIdx + 1].m_time <= seconds)
+    {
+        ++m_rowIdx;
+    }
+
+    const Row& row = m_rows[m_rowIdx];
+    const Row& next = m_rowIdx + 1 < m_rows.size() ? m_rows[m_rowIdx + 1] : row;
+    const float span = next.m_time - row.m_time;
+    const float alpha = span > 0.0f ? (seconds - row.m_time) / span : 0.0f;
+
+    const float altitude = Lerp(row.m_altitude, next.m_altitude, alpha);
+
+    // Inverse of Pressure::GetAltitudeFromPa
+    physics.m_pressure = k_seaLevelPressure * powf(1.0f - altitude / 44330.0f, 1.0f / 0.190294f);
+    physics.m_temperature = Lerp(row.m_temperature, next.m_temperature, alpha);
+    physics.m_acceleration = Lerp(row.m_acceleration, next.m_acceleration, alpha);
+    physics.m_acceleration.x *= k_gravity;
+    physics.m_acceleration.y *= k_gravity;
+    physics.m_acceleration.z *= k_gravity;
+    physics.m_angularRate = Lerp(row.m_angularRate, next.m_angularRate, alpha);
+}
+
+void SimLogReplay::GetEvents(SimFlightEvents& events)const
+{
+    events = m_events;
+}
+
+uint32_t SimLogReplay::GetNumRows()const
+{
+    return (uint32_t)m_rows.size();
+}
+
+bool SimLogReplay::ParseHeader(char* line)
+{
+    memset(m_columns, -1, sizeof(m_columns));
+
+    int8_t column = 0;
+    for(char* name = strtok(line, ",\r\n"); name; name = strtok(nullptr, ",\r\n"), ++column)
+    {
+        // "TIME, ALTITUDE, ..." has spaces around the names
+        while(*name == ' ')
+        {
+            ++name;
+        }
+        size_t length = strlen(name);
+        while(length > 0 && name[length - 1] == ' ')
+        {
+            --length;
+        }
+
+        for(uint8_t fieldIdx = 0; fieldIdx < k_numFields; ++fieldIdx)
+        {
+            if(strlen(k_fieldNames[fieldIdx]) == length && strncmp(name, k_fieldNames[fieldIdx], length) == 0)
+            {
+                m_columns[fieldIdx] = column;
+            }
+        }
+    }
+
+    // Time and altitude are the minimum, the rest is 0 (or 1G on y) if it's missing
+    return m_columns[(uint8_t)Field::Time] >= 0 && m_columns[(uint8_t)Field::Altitude] >= 0;
+}
+
+bool SimLogReplay::ParseRow(char* line, Row& row)const
+{
+    float values[k_numFields];
+    for(uint8_t fieldIdx = 0; fieldIdx < k_numFields; ++fieldIdx)
+    {
+        values[fieldIdx] = fieldIdx == (uint8_t)Field::AccelY ? 1.0f : 0.0f;
+    }
+
+    int8_t column = 0;
+    uint8_t numValues = 0;
+    for(char* value = strtok(line, ",\r\n"); value; value = strtok(nullptr, ",\r\n"), ++column)
+    {
+        for(uint8_t fieldIdx = 0; fieldIdx < k_numFields; ++fieldIdx)
+        {
+            if(m_columns[fieldIdx] == column)
+            {
+                values[fieldIdx] = strtof(value, nullptr);
+                ++numValues;
+            }
+        }
+    }
+    if(numValues < 2)
+    {
+        return false;
+    }
+
+    row.m_time = values[(uint8_t)Field::Time];
+    row.m_altitude = values[(uint8_t)Field::Altitude];
+    row.m_temperature = values[(uint8_t)Field::Temperature];
+    row.m_acceleration.x = values[(uint8_t)Field::AccelX];
+    row.m_acceleration.y = values[(uint8_t)Field::AccelY];
+    row.m_acceleration.z = values[(uint8_t)Field::AccelZ];
+    row.m_angularRate.x = values[(uint8_t)Field::RateX];
+    row.m_angularRate.y = values[(uint8_t)Field::RateY];
+    row.m_angularRate.z = values[(uint8_t)Field::RateZ];
+    return true;
+}
+
+void SimLogReplay::Finish(float padTime, float landedTime)
+{
+    // Log time to SimClock time, the logger needs some time on the pad to settle
+    const float startTime = m_rows.front().m_time;
+    for(Row& row : m_rows)
+    {
+        row.m_time = row.m_time - startTime + padTime;
+    }
+    Row pad = m_rows.front();
+    pad.m_time = 0.0f;
+    m_rows.insert(m_rows.begin(), pad);
+
+    const float padAltitude = pad.m_altitude;
+
+    // Liftoff
+    m_events.m_liftoffTime = -1.0f;
+    uint8_t boostRows = 0;
+    for(const Row& row : m_rows)
+    {
+        boostRows = row.m_acceleration.y >= k_liftoffAccel ? boostRows + 1 : 0;
+        if(boostRows == 1)
+        {
+            m_events.m_liftoffTime = row.m_time;
+        }
+        if(boostRows == k_liftoffRows)
+        {
+            break;
+        }
+    }
+    if(boostRows < k_liftoffRows)
+    {
+        m_events.m_liftoffTime = -1.0f;
+    }
+
+    // Apogee
+    uint32_t apogeeIdx = 0;
+    for(uint32_t rowIdx = 0; rowIdx < m_rows.size(); ++rowIdx)
+    {
+        if(m_rows[rowIdx].m_altitude > m_rows[apogeeIdx].m_altitude)
+        {
+            apogeeIdx = rowIdx;
+        }
+    }
+    m_events.m_apogeeTime = m_rows[apogeeIdx].m_time;
+
+    // Keep descending at the rate of the last second until we get to the pad
+    const Row last = m_rows.back();
+    if(m_events.m_liftoffTime >= 0.0f && last.m_altitude > padAltitude + k_landedBand)
+    {
+        uint32_t rowIdx = (uint32_t)m_rows.size() - 1;
+        while(rowIdx > apogeeIdx && last.m_time - m_rows[rowIdx].m_time < 1.0f)
+        {
+            --rowIdx;
+        }
+        const float span = last.m_time - m_rows[rowIdx].m_time;
+        const float descentRate = span > 0.0f ? (m_rows[rowIdx].m_altitude - last.m_altitude) / span : 0.0f;
+        if(descentRate > 0.5f)
+        {
+            Row landed = last;
+            landed.m_time = last.m_time + (last.m_altitude - padAltitude) / descentRate;
+            landed.m_altitude = padAltitude;
+            landed.m_acceleration = Vec3();
+            landed.m_acceleration.y = 1.0f;
+            landed.m_angularRate = Vec3();
+            m_rows.push_back(landed);
+        }
+    }
+
+    // Landing, the first time it's back on the pad after apogee
+    m_events.m_landingTime = -1.0f;
+    for(uint32_t rowIdx = apogeeIdx; rowIdx < m_rows.size(); ++rowIdx)
+    {
+        if(m_events.m_liftoffTime >= 0.0f && m_rows[rowIdx].m_altitude <= padAltitude + k_landedBand)
+        {
+            m_events.m_landingTime = m_rows[rowIdx].m_time;
+            break;
+        }
+    }
+
+    m_events.m_endTime = m_rows.back().m_time + landedTime;
+}
+
+#endif
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "SimWorld.h"
+
+class LogFile;
+
+// Replays a flight dumped by the logger (Log_N.bin or .csv) as the world the simulated sensors measure.
+// The first row is held on the pad for a while, rows are interpolated and, since the log ends when the
+// landing was detected (up to LANDING_BAND above the pad), the descent is extrapolated down to the pad.
+// The events are estimated from the data: liftoff when the boost starts, apogee at the highest altitude
+// and landing when it's back on the pad
+class SimLogReplay : public SimWorld
+{
+public:
+    SimLogReplay();
+
+    // Loads the dump, the CSV columns are found by name. Returns false if it can't be read or has no records
+    bool Load(const char* path, float padTime = 5.0f, float landedTime = 10.0f);
+
+    void GetPhysics(uint64_t time, SimPhysics& physics) override;
+
+    void GetEvents(SimFlightEvents& events)const override;
+
+    uint32_t GetNumRows()const;
+
+private:
+    struct Row
+    {
+        float m_time;           // s of SimClock time (the pad time is added)
+        float m_altitude;       // m
+        float m_temperature;    // C
+        Vec3 m_acceleration;    // G
+        Vec3 m_angularRate;     // degrees per second
+    };
+
+    bool LoadImage(LogFile& image, float padTime, float landedTime);
+
+    bool ParseHeader(char* line);
+
+    bool ParseRow(char* line, Row& row)const;
+
+    // Adds the rest of the descent (if the log ends above the pad) and finds the events
+    void Finish(float padTime, float landedTime);
+
+    std::vector<Row> m_rows;
+
+    // Column of each Row field in the CSV, -1 if the log doesn't have it
+    enum class Field : uint8_t
+    {
+        Time,
+        Altitude,
+        Temperature,
+        AccelX,
+        AccelY,
+        AccelZ,
+        RateX,
+        RateY,
+        RateZ,
+    };
+    static const uint8_t k_numFields = 9;
+    int8_t m_columns[k_numFields];
+
+    SimFlightEvents m_events;
+
+    // Last row used, the time only goes forward while the app runs
+    uint32_t m_rowIdx;
+};
@@ -0,0 +1,220 @@
+#ifndef ARDUINO
+
+#include "SimLoopTiming.h"
+
+#include "SimBoard.h"
+#include "SimFlight.h"
+
+#include "Logger/LoggerApp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const int k_sweepRates[] = { 25, 50, 100, 200, 400, 800 };
+
+// Cuts the run in sampling periods while Active
+struct LoopTimingContext
+{
+    const LoggerApp* m_app;
+    LoopTimingReport* m_report;
+    bool m_active;
+    uint32_t m_sampleRuns;
+    SimTimingTotals m_start;    // At the start of the current period
+};
+
+static bool OnTimingStep(void* context)
+{
+    LoopTimingContext* timing = (LoopTimingContext*)context;
+    const LoggerState state = timing->m_app->GetState();
+    const uint32_t sampleRuns = timing->m_app->GetScheduler().GetStats((uint8_t)LoggerTask::Sample).m_runs;
+    if(sampleRuns == timing->m_sampleRuns && state == LoggerState::Active)
+    {
+        return true;
+    }
+    timing->m_sampleRuns = sampleRuns;
+
+    // A period goes from one Sample run to the next
+    const SimTimingTotals& totals = SimTiming::GetTotals();
+    LoopTimingReport& report = *timing->m_report;
+    if(timing->m_active && state == LoggerState::Active)
+    {
+        uint32_t busy = 0;
+        for(uint8_t costIdx = 0; costIdx < k_numSimCosts; ++costIdx)
+        {
+            const uint32_t time = (uint32_t)(totals.m_time[costIdx] - timing->m_start.m_time[costIdx]);
+            report.m_total[costIdx] += time;
+            report.m_worst[costIdx] = max(report.m_worst[costIdx], time);
+            busy += time;
+        }
+        for(uint8_t opIdx = 0; opIdx < k_numSimOps; ++opIdx)
+        {
+            report.m_ops[opIdx] += totals.m_ops[opIdx] - timing->m_start.m_ops[opIdx];
+        }
+        report.m_worstBusy = max(report.m_worstBusy, busy);
+        ++report.m_iterations;
+    }
+    timing->m_active = state == LoggerState::Active;
+    timing->m_start = totals;
+
+    // Nothing to measure once the log is finished
+    return state != LoggerState::Dump;
+}
+
+bool SimLoopTiming::Measure(SimWorld* world, int samplesPerSecond, RecordFormat recordFormat, uint32_t i2cClock, LoopTimingReport& report)
+{
+    memset(&report, 0, sizeof(LoopTimingReport));
+    report.m_period = 1000000u / (uint32_t)samplesPerSecond;
+
+    SimFlightEvents events;
+    world->GetEvents(events);
+
+    SimBoard board(world);
+    if(i2cClock > 0)
+    {
+        Wire.setClock(i2cClock);
+    }
+
+    LoggerApp app;
+    report.m_result = app.Init(samplesPerSecond, recordFormat);
+    report.m_plan = app.GetSamplingPlan();
+    if(report.m_result != LoggerResult::Success)
+    {
+        return false;
+    }
+
+    LoopTimingContext context = { &app, &report, false, 0, SimTiming::GetTotals() };
+    SimBoard::Run(app, (uint64_t)((double)events.m_endTime * 1000000.0), OnTimingStep, &context);
+
+    report.m_overruns = app.GetScheduler().GetTimeBaseStats().m_overruns;
+    return report.m_iterations > 0;
+}
+
+static void PrintPlan(const SamplingPlan& plan)
+{
+    printf("Plan: baro OSR %i, temperature decimation %i, IMU ODR %u Hz, FIFO batch %i, load %.0f%%, max %u samples/s, %.0f s of log\n",
+        256 << (int)plan.m_baroOSR, plan.m_tempDecimation, GetIMUODRFrequency(plan.m_imuODR), plan.m_imuFIFOBatch, 100.0f * plan.m_load,
+        plan.m_maxSamplesPerSecond, plan.m_flightTime);
+}
+
+void SimLoopTiming::Print(const LoopTimingReport& report)
+{
+    const float iterations = (float)max(report.m_iterations, 1u);
+    const SimTimingConfig& config = SimTiming::GetConfig();
+    printf("CPU %.1f MHz, I2C %lu kHz, period %lu us, %lu periods, %lu overruns\n", config.m_cpuClock * 0.000001f,
+        (unsigned long)(Wire.GetClock() / 1000u), (unsigned long)report.m_period, (unsigned long)report.m_iterations, (unsigned long)report.m_overruns);
+
+    PrintPlan(report.m_plan);
+
+    printf("%-8s %10s %10s %8s\n", "COST", "MEAN_US", "WORST_US", "PERIOD%");
+    uint64_t totalBusy = 0;
+    for(uint8_t costIdx = 0; costIdx < k_numSimCosts; ++costIdx)
+    {
+        const float mean = report.m_total[costIdx] / iterations;
+        printf("%-8s %10.1f %10lu %7.1f%%\n", SimTiming::GetName((SimCost)costIdx), mean, (unsigned long)report.m_worst[costIdx], 100.0f * mean / report.m_period);
+        totalBusy += report.m_total[costIdx];
+    }
+    const float meanBusy = totalBusy / iterations;
+    printf("%-8s %10.1f %10lu %7.1f%%\n", "BUSY", meanBusy, (unsigned long)report.m_worstBusy, 100.0f * meanBusy / report.m_period);
+
+    // Only the float and 64 bit math is annotated, the integer work (Rice coding, BitStream, CRC16, queue and buffer
+    // copies) isn't charged, so the busy time is a lower bound
+    printf("Math ops per period (integer work isn't modeled):");
+    for(uint8_t opIdx = 0; opIdx < k_numSimOps; ++opIdx)
+    {
+        printf(" %s=%.1f", SimTiming::GetName((SimOp)opIdx), report.m_ops[opIdx] / iterations);
+    }
+    printf("\n");
+
+    // The worst period has to fit for the log to keep its rate, on average we could go up to the mean
+    printf("Sustainable rate: %.0f Hz (worst period), %.0f Hz (mean)\n",
+        report.m_worstBusy > 0 ? 1000000.0f / report.m_worstBusy : 0.0f, meanBusy > 0.0f ? 1000000.0f / meanBusy : 0.0f);
+}
+
+static void PrintUsage()
+{
+    printf("Usage: program timing [options]\n");
+    printf("Flies the default flight with the target timing model and breaks down the time of each sampling period\n");
+    printf("  -r <samples/s>        Init rate (100)\n");
+    printf("  -f <format>           float, raw, packed or compressed (compressed)\n");
+    printf("  --cpu <MHz>           CPU clock (16)\n");
+    printf("  --i2c <kHz>           I2C clock (100)\n");
+    printf("  --spi <MHz>           Fastest SPI clock (8)\n");
+    printf("  --sweep               One line per rate from 25 to 800Hz\n");
+}
+
+int SimLoopTiming::RunTool(int argc, char** argv)
+{
+    SimTimingConfig config = GetDefaultTimingConfig();
+    int samplesPerSecond = 100;
+    RecordFormat recordFormat = RecordFormat::Compressed;
+    uint32_t i2cClock = 0;
+    bool sweep = false;
+
+    for(int argIdx = 0; argIdx < argc; ++argIdx)
+    {
+        const char* option = argv[argIdx];
+        if(strcmp(option, "--sweep") == 0)
+        {
+            sweep = true;
+            continue;
+        }
+        if(argIdx + 1 >= argc)
+        {
+            PrintUsage();
+            return 1;
+        }
+
+        const char* value = argv[++argIdx];
+        if(strcmp(option, "-r") == 0)           samplesPerSecond = atoi(value);
+        else if(strcmp(option, "--cpu") == 0)   config.m_cpuClock = (uint32_t)(atof(value) * 1000000.0);
+        else if(strcmp(option, "--i2c") == 0)   i2cClock = (uint32_t)(atof(value) * 1000.0);
+        else if(strcmp(option, "--spi") == 0)   config.m_spiMaxClock = (uint32_t)(atof(value) * 1000000.0);
+        else if(strcmp(option, "-f") == 0 && strcmp(value, "float") == 0)      recordFormat = RecordFormat::Float;
+        else if(strcmp(option, "-f") == 0 && strcmp(value, "raw") == 0)        recordFormat = RecordFormat::Raw;
+        else if(strcmp(option, "-f") == 0 && strcmp(value, "packed") == 0)     recordFormat = RecordFormat::Packed;
+        else if(strcmp(option, "-f") == 0 && strcmp(value, "compressed") == 0) recordFormat = RecordFormat::Compressed;
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+    SimTiming::SetConfig(config);
+
+    SimFlight flight(GetDefaultFlightProfile());
+    LoopTimingReport report;
+    if(!sweep)
+    {
+        if(!SimLoopTiming::Measure(&flight, samplesPerSecond, recordFormat, i2cClock, report))
+        {
+            printf("The logger didn't get to log anything (Init = %i)\n", (int)report.m_result);
+            PrintPlan(report.m_plan);
+            return 1;
+        }
+        SimLoopTiming::Print(report);
+        return 0;
+    }
+
+    printf("%6s %10s %10s %8s %9s %9s %8s\n", "RATE", "MEAN_US", "WORST_US", "PERIOD%", "OVERRUNS", "PLAN_MAX", "PLAN_OSR");
+    for(int rate : k_sweepRates)
+    {
+        if(!SimLoopTiming::Measure(&flight, rate, recordFormat, i2cClock, report))
+        {
+            printf("%6i rejected at Init (%i) %25u %8i\n", rate, (int)report.m_result, report.m_plan.m_maxSamplesPerSecond, 256 << (int)report.m_plan.m_baroOSR);
+            continue;
+        }
+
+        uint64_t totalBusy = 0;
+        for(uint8_t costIdx = 0; costIdx < k_numSimCosts; ++costIdx)
+        {
+            totalBusy += report.m_total[costIdx];
+        }
+        const float meanBusy = (float)totalBusy / report.m_iterations;
+        printf("%6i %10.1f %10lu %7.1f%% %9lu %9u %8i\n", rate, meanBusy, (unsigned long)report.m_worstBusy, 100.0f * meanBusy / report.m_period,
+            (unsigned long)report.m_overruns, report.m_plan.m_maxSamplesPerSecond, 256 << (int)report.m_plan.m_baroOSR);
+    }
+    return 0;
+}
+
+#endif
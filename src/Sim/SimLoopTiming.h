@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "HAL.h"
+
+#include "RMath.h"
+#include "Logger/LoggerDefinitions.h"
+#include "Logger/SamplingPlanner.h"
+
+class SimWorld;
+
+// Time charged (SimTiming) per sampling period while Active
+struct LoopTimingReport
+{
+    uint32_t m_period;                      // us
+    uint32_t m_iterations;                  // Sampling periods measured
+    uint64_t m_total[k_numSimCosts];        // us, SimCost order
+    uint32_t m_worst[k_numSimCosts];        // us, worst iteration of each cost
+    uint32_t m_worstBusy;                   // us, worst iteration (all costs)
+    uint32_t m_ops[k_numSimOps];            // SimOp order
+    uint32_t m_overruns;                    // Sampling ticks skipped
+    LoggerResult m_result;                  // Init
+    SamplingPlan m_plan;                    // Picked at Init, filled in even if Init rejected the rate
+};
+
+// Predicts the on-target loop time: flies the default flight with the SimTiming model and breaks the
+// busy time of every sampling period down by cost
+class SimLoopTiming
+{
+public:
+    // 'i2cClock' 0 keeps the board one (100kHz)
+    static bool Measure(SimWorld* world, int samplesPerSecond, RecordFormat recordFormat, uint32_t i2cClock, LoopTimingReport& report);
+
+    static void Print(const LoopTimingReport& report);
+
+    // Command line front end (native build: program timing ...)
+    static int RunTool(int argc, char** argv);
+};
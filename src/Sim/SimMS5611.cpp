@@ -0,0 +1,175 @@
+#ifndef ARDUINO
+
+#include "SimMS5611.h"
+
+#include <string.h>
+
+static const uint8_t k_resetCommand = 0x1E;
+static const uint8_t k_adcReadCommand = 0x0;
+static const uint8_t k_promReadCommand = 0xA0;
+static const uint8_t k_convertD1Command = 0x40;
+static const uint8_t k_convertD2Command = 0x50;
+static const uint16_t k_typicalConversionTimes[5] = {540, 1060, 2080, 4130, 8220}; // us
+static const uint16_t k_defaultCalibration[6] = {40127, 36924, 23317, 23282, 33464, 28312}; // Data sheet example
+static const uint32_t k_maxADC = 0xFFFFFF;
+
+static uint32_t ClampADC(int64_t value)
+{
+    return value < 0 ? 0u : (value > k_maxADC ? k_maxADC : (uint32_t)value);
+}
+
+SimMS5611::SimMS5611()
+    : m_world(nullptr)
+    , m_pressureNoise(0.0f)
+    , m_converting(false)
+    , m_conversionEnd(0)
+    , m_conversionValue(0)
+    , m_numConversions(0)
+    , m_readMode(ReadMode::None)
+    , m_readValue(0)
+    , m_promAddress(0)
+{
+    memset(m_prom, 0, sizeof(m_prom));
+    SetCalibration(k_defaultCalibration);
+}
+
+void SimMS5611::Attach(I2CBus* bus, uint8_t address, SimWorld* world)
+{
+    m_world = world;
+    bus->Attach(address, this);
+}
+
+void SimMS5611::SetCalibration(const uint16_t* coefficients)
+{
+    memcpy(&m_prom[1], coefficients, sizeof(uint16_t) * 6);
+}
+
+void SimMS5611::SetNoise(float pressureNoise, uint32_t seed /*= 1u*/)
+{
+    m_pressureNoise = pressureNoise;
+    m_random.Seed(seed);
+}
+
+void SimMS5611::GetRaw(float pressure, float temperature, uint32_t& D1, uint32_t& D2)const
+{
+    // The driver's compensation run backwards (see MS5611::UpdateTemperature)
+    const int64_t C1 = m_prom[1];
+    const int64_t C2 = m_prom[2];
+    const int64_t C3 = m_prom[3];
+    const int64_t C4 = m_prom[4];
+    const int64_t C5 = m_prom[5];
+    const int64_t C6 = m_prom[6];
+
+    // TEMP = 2000 + dT * C6 / 2^23 - T2, T2 (below 20C) is small so a couple of iterations get dT
+    const int64_t targetTemp = (int64_t)(temperature * 100.0f + (temperature >= 0.0f ? 0.5f : -0.5f));
+    int64_t dT = (targetTemp - 2000) * 8388608 / C6;
+    for(uint8_t iteration = 0; iteration < 2; ++iteration)
+    {
+        const int64_t T2 = 2000 + dT * C6 / 8388608 < 2000 ? dT * dT / INT64_C(2147483648) : 0;
+        dT = (targetTemp + T2 - 2000) * 8388608 / C6;
+    }
+    D2 = ClampADC(C5 * 256 + dT);
+    dT = (int64_t)D2 - C5 * 256;
+
+    const int64_t temp = 2000 + dT * C6 / 8388608;
+    int64_t offset2 = 0;
+    int64_t sensitivity2 = 0;
+    if(temp < 2000)
+    {
+        const int64_t tmp = (temp - 2000) * (temp - 2000) * 5;
+        offset2 = tmp / 2;
+        sensitivity2 = tmp / 4;
+        if(temp < -1500)
+        {
+            const int64_t lowTmp = (temp + 1500) * (temp + 1500);
+            offset2 += 7 * lowTmp;
+            sensitivity2 += 11 * lowTmp / 2;
+        }
+    }
+
+    const int64_t offset = C2 * 65536 + C4 * dT / 128 - offset2;
+    const int64_t sensitivity = C1 * 32768 + C3 * dT / 256 - sensitivity2;
+
+    // P = (D1 * SENS / 2^21 - OFF) / 2^15, P in 0.01mbar (Pa)
+    const int64_t P = (int64_t)(pressure + 0.5f);
+    D1 = ClampADC(sensitivity > 0 ? ((P * 32768 + offset) * 2097152 + sensitivity / 2) / sensitivity : 0);
+}
+
+uint32_t SimMS5611::GetNumConversions()const
+{
+    return m_numConversions;
+}
+
+void SimMS5611::OnWrite(const uint8_t* data, uint8_t size)
+{
+    // Empty writes are the driver checking we are there
+    if(size == 0)
+    {
+        return;
+    }
+
+    const uint8_t command = data[0];
+    if(command == k_resetCommand)
+    {
+        m_converting = false;
+        m_readMode = ReadMode::None;
+    }
+    else if(command == k_adcReadCommand)
+    {
+        // 0 if the conversion isn't done, the result can only be read once
+        const bool ready = m_converting && SimClock::GetTime() >= m_conversionEnd;
+        m_readMode = ReadMode::ADC;
+        m_readValue = ready ? m_conversionValue : 0u;
+        m_converting = false;
+    }
+    else if((command & 0xF0) == k_promReadCommand)
+    {
+        m_readMode = ReadMode::PROM;
+        m_promAddress = (command >> 1u) & 0x7u;
+    }
+    else if((command & 0xF0) == k_convertD1Command || (command & 0xF0) == k_convertD2Command)
+    {
+        const uint8_t osrIndex = (command & 0x0F) >> 1u;
+        if(osrIndex >= 5)
+        {
+            return;
+        }
+
+        // Sample the world now, the ADC integrates over the conversion but it's close enough
+        SimPhysics physics;
+        m_world->GetPhysics(SimClock::GetTime(), physics);
+        uint32_t D1 = 0;
+        uint32_t D2 = 0;
+        GetRaw(physics.m_pressure + m_random.GetGaussian(m_pressureNoise), physics.m_temperature, D1, D2);
+
+        m_conversionValue = (command & 0xF0) == k_convertD1Command ? D1 : D2;
+        m_conversionEnd = SimClock::GetTime() + k_typicalConversionTimes[osrIndex];
+        m_converting = true;
+        ++m_numConversions;
+    }
+}
+
+uint8_t SimMS5611::OnRead(uint8_t* data, uint8_t size)
+{
+    uint8_t numBytes = 0;
+    if(m_readMode == ReadMode::ADC)
+    {
+        // 24 bits, MSB first
+        for(; numBytes < size && numBytes < 3; ++numBytes)
+        {
+            data[numBytes] = (uint8_t)(m_readValue >> (16u - numBytes * 8u));
+        }
+    }
+    else if(m_readMode == ReadMode::PROM)
+    {
+        for(; numBytes < size && numBytes < 2; ++numBytes)
+        {
+            data[numBytes] = (uint8_t)(m_prom[m_promAddress] >> (8u - numBytes * 8u));
+        }
+    }
+
+    m_readMode = ReadMode::None;
+    return numBytes;
+}
+
+#endif
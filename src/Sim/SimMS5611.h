@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "HAL.h"
+#include "SimWorld.h"
+
+// MS5611 model on the simulated I2C bus. Conversions take the typical time from the data sheet, the ADC
+// reads 0 if it's not done (or read twice) and D1/D2 come from inverting the compensation for the
+// pressure and temperature of the world when the conversion started
+class SimMS5611 : public SimI2CDevice
+{
+public:
+    SimMS5611();
+
+    void Attach(I2CBus* bus, uint8_t address, SimWorld* world);
+
+    // C1 to C6, the data sheet example by default
+    void SetCalibration(const uint16_t* coefficients);
+
+    // Pa (1 sigma), added to every pressure conversion
+    void SetNoise(float pressureNoise, uint32_t seed = 1u);
+
+    // Raw values for a pressure (Pa) and temperature (C), D1 and D2 are clamped to 24 bits
+    void GetRaw(float pressure, float temperature, uint32_t& D1, uint32_t& D2)const;
+
+    uint32_t GetNumConversions()const;
+
+    void OnWrite(const uint8_t* data, uint8_t size) override;
+
+    uint8_t OnRead(uint8_t* data, uint8_t size) override;
+
+private:
+    enum class ReadMode : uint8_t
+    {
+        None,
+        ADC,
+        PROM,
+    };
+
+    SimWorld* m_world;
+    SimRandom m_random;
+    float m_pressureNoise;
+
+    uint16_t m_prom[8];         // Reserved, C1 to C6 and CRC
+
+    bool m_converting;
+    uint64_t m_conversionEnd;   // us, SimClock time
+    uint32_t m_conversionValue;
+    uint32_t m_numConversions;
+
+    ReadMode m_readMode;
+    uint32_t m_readValue;
+    uint8_t m_promAddress;
+};
@@ -0,0 +1,307 @@
+#ifndef ARDUINO
+
+#include "SimReplay.h"
+
+#include "SimBoard.h"
+#include "SimFlight.h"
+#include "SimLogReplay.h"
+
+#include "Logger/LoggerApp.h"
+
+#include <chrono>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+ReplaySettings GetDefaultReplaySettings()
+{
+    ReplaySettings settings;
+    settings.m_samplesPerSecond = 100;
+    settings.m_recordFormat = RecordFormat::Compressed;
+    settings.m_detector = LoggerApp::GetDefaultDetectorSettings();
+    settings.m_pressureNoise = 0.0f;
+    settings.m_accelNoise = 0.0f;
+    settings.m_gyroNoise = 0.0f;
+    settings.m_seed = 1u;
+    settings.m_dump = false;
+    settings.m_sdRoot = ".";
+    return settings;
+}
+
+ReplayStats::ReplayStats()
+    : m_flights(0)
+    , m_failedInits(0)
+    , m_liftoffs(0)
+    , m_falseLiftoffs(0)
+    , m_landings(0)
+    , m_falseLandings(0)
+    , m_totalLiftoffLatency(0.0f)
+    , m_maxLiftoffLatency(0.0f)
+    , m_totalLandingDelay(0.0f)
+    , m_minLandingDelay(0.0f)
+    , m_maxLandingDelay(0.0f)
+    , m_samples(0)
+    , m_samplesLost(0)
+{
+}
+
+void ReplayStats::Add(const ReplayResult& result)
+{
+    ++m_flights;
+    if(!result.m_initialized)
+    {
+        ++m_failedInits;
+        return;
+    }
+
+    if(result.m_falseLiftoff)
+    {
+        ++m_falseLiftoffs;
+    }
+    else if(result.m_liftoffDetected)
+    {
+        ++m_liftoffs;
+        m_totalLiftoffLatency += result.m_liftoffLatency;
+        m_maxLiftoffLatency = max(m_maxLiftoffLatency, result.m_liftoffLatency);
+    }
+
+    if(result.m_falseLanding)
+    {
+        ++m_falseLandings;
+    }
+    else if(result.m_landingDetected)
+    {
+        m_minLandingDelay = m_landings > 0 ? min(m_minLandingDelay, result.m_landingDelay) : result.m_landingDelay;
+        m_maxLandingDelay = m_landings > 0 ? max(m_maxLandingDelay, result.m_landingDelay) : result.m_landingDelay;
+        m_totalLandingDelay += result.m_landingDelay;
+        ++m_landings;
+    }
+
+    m_samples += result.m_samples;
+    m_samplesLost += result.m_samplesLost;
+}
+
+void ReplayStats::Print()const
+{
+    printf("Flights: %lu (%lu failed to init)\n", (unsigned long)m_flights, (unsigned long)m_failedInits);
+    printf("Liftoff: %lu detected, %lu false, latency mean = %.1f ms, max = %.1f ms\n", (unsigned long)m_liftoffs, (unsigned long)m_falseLiftoffs,
+        m_liftoffs > 0 ? 1000.0f * m_totalLiftoffLatency / m_liftoffs : 0.0f, 1000.0f * m_maxLiftoffLatency);
+    printf("Landing: %lu detected, %lu false, delay mean = %.2f s, min = %.2f s, max = %.2f s\n", (unsigned long)m_landings, (unsigned long)m_falseLandings,
+        m_landings > 0 ? m_totalLandingDelay / m_landings : 0.0f, m_minLandingDelay, m_maxLandingDelay);
+    printf("Samples: %lu stored, %lu lost\n", (unsigned long)m_samples, (unsigned long)m_samplesLost);
+}
+
+uint32_t ReplayStats::GetNumFlights()const
+{
+    return m_flights;
+}
+
+// Follows the app state while it runs
+struct ReplayContext
+{
+    const LoggerApp* m_app;
+    SimBoard* m_board;
+    bool m_dump;
+    LoggerState m_state;
+    float m_liftoffTime;        // s, detected
+    float m_landingTime;        // s, detected
+    uint32_t m_fifoOverflows;   // While Active
+};
+
+static bool OnReplayStep(void* context)
+{
+    ReplayContext* replay = (ReplayContext*)context;
+    const LoggerState state = replay->m_app->GetState();
+    if(state == replay->m_state)
+    {
+        return true;
+    }
+
+    const float now = (float)((double)SimClock::GetTime() * 0.000001);
+    const uint32_t fifoOverflows = replay->m_board->GetIMU().GetFIFOOverflows();
+    if(replay->m_state == LoggerState::Idle && state == LoggerState::Active)
+    {
+        replay->m_liftoffTime = now;
+        replay->m_fifoOverflows = fifoOverflows;
+    }
+    else if(replay->m_state == LoggerState::Active)
+    {
+        replay->m_landingTime = now;
+        replay->m_fifoOverflows = fifoOverflows - replay->m_fifoOverflows;
+    }
+    replay->m_state = state;
+
+    // Once the log is finished we have all we need
+    return replay->m_dump || state != LoggerState::Dump;
+}
+
+ReplayResult SimReplay::Fly(SimWorld* world, const ReplaySettings& settings)
+{
+    ReplayResult result = {};
+
+    SimFlightEvents events;
+    world->GetEvents(events);
+
+    SimBoard board(world, settings.m_sdRoot);
+    board.GetBaro().SetNoise(settings.m_pressureNoise, settings.m_seed);
+    board.GetIMU().SetNoise(settings.m_accelNoise, settings.m_gyroNoise, settings.m_seed + 1u);
+
+    LoggerApp app;
+    if(app.Init(settings.m_samplesPerSecond, settings.m_recordFormat) != LoggerResult::Success)
+    {
+        return result;
+    }
+    app.SetDetectorSettings(settings.m_detector);
+    result.m_initialized = true;
+
+    ReplayContext context = { &app, &board, settings.m_dump, app.GetState(), -1.0f, -1.0f, 0 };
+    result.m_numTasks = SimBoard::Run(app, (uint64_t)((double)events.m_endTime * 1000000.0), OnReplayStep, &context);
+
+    result.m_liftoffDetected = context.m_liftoffTime >= 0.0f;
+    if(result.m_liftoffDetected)
+    {
+        result.m_falseLiftoff = events.m_liftoffTime < 0.0f || context.m_liftoffTime < events.m_liftoffTime;
+        result.m_liftoffLatency = context.m_liftoffTime - events.m_liftoffTime;
+
+        // The scheduler stats are reset at liftoff
+        const TimerStats& timerStats = app.GetScheduler().GetTimeBaseStats();
+        result.m_samplesLost = timerStats.m_overruns + app.GetSummary().m_queueOverflows;
+        result.m_samples = app.GetSummary().m_numSamples;
+    }
+
+    result.m_landingDetected = context.m_landingTime >= 0.0f;
+    if(result.m_landingDetected)
+    {
+        result.m_falseLanding = context.m_landingTime < events.m_apogeeTime;
+        result.m_landingDelay = context.m_landingTime - events.m_landingTime;
+        result.m_samplesLost += context.m_fifoOverflows;
+    }
+
+    return result;
+}
+
+static void PrintUsage()
+{
+    printf("Usage: program replay [options] [Log_N.bin or .csv ...]\n");
+    printf("Replays the logs, or synthetic flights if there are none, and prints the detection stats\n");
+    printf("  -n <flights>          Synthetic flights (200)\n");
+    printf("  -s <seed>             Flight profiles and sensor noise (1)\n");
+    printf("  -r <samples/s>        Sampling rate (100)\n");
+    printf("  -f <format>           float, raw, packed or compressed (compressed)\n");
+    printf("  -v                    One line per flight\n");
+    printf("  --climb <m>           Liftoff: altitude gained between two samples\n");
+    printf("  --liftoff-accel <m/s2>\n");
+    printf("  --landing-band <m>    Landing: distance to the liftoff altitude\n");
+    printf("  --landing-accel <m/s2>\n");
+    printf("  --still-band <m>      Landing: altitude to median distance\n");
+    printf("  --apogee-drop <m>     Landing: distance below the highest altitude\n");
+    printf("  --baro-noise <Pa>     Sensor noise (1 sigma)\n");
+    printf("  --accel-noise <m/s2>\n");
+    printf("  --gyro-noise <dps>\n");
+}
+
+static void PrintResult(const char* name, const ReplayResult& result)
+{
+    printf("%-24s liftoff %s %7.1f ms, landing %s %6.2f s, samples %5lu, lost %3lu\n", name,
+        result.m_falseLiftoff ? "FALSE" : (result.m_liftoffDetected ? "ok   " : "MISS "), 1000.0f * result.m_liftoffLatency,
+        result.m_falseLanding ? "FALSE" : (result.m_landingDetected ? "ok   " : "MISS "), result.m_landingDelay,
+        (unsigned long)result.m_samples, (unsigned long)result.m_samplesLost);
+}
+
+int SimReplay::RunTool(int argc, char** argv)
+{
+    ReplaySettings settings = GetDefaultReplaySettings();
+    uint32_t numFlights = 200;
+    uint32_t seed = 1u;
+    bool verbose = false;
+
+    int argIdx = 0;
+    for(; argIdx < argc && argv[argIdx][0] == '-'; ++argIdx)
+    {
+        const char* option = argv[argIdx];
+        if(strcmp(option, "-v") == 0)
+        {
+            verbose = true;
+            continue;
+        }
+        if(argIdx + 1 >= argc)
+        {
+            PrintUsage();
+            return 1;
+        }
+
+        const char* value = argv[++argIdx];
+        if(strcmp(option, "-n") == 0)                   numFlights = (uint32_t)atoi(value);
+        else if(strcmp(option, "-s") == 0)              seed = (uint32_t)atoi(value);
+        else if(strcmp(option, "-r") == 0)              settings.m_samplesPerSecond = atoi(value);
+        else if(strcmp(option, "-f") == 0 && strcmp(value, "float") == 0)      settings.m_recordFormat = RecordFormat::Float;
+        else if(strcmp(option, "-f") == 0 && strcmp(value, "raw") == 0)        settings.m_recordFormat = RecordFormat::Raw;
+        else if(strcmp(option, "-f") == 0 && strcmp(value, "packed") == 0)     settings.m_recordFormat = RecordFormat::Packed;
+        else if(strcmp(option, "-f") == 0 && strcmp(value, "compressed") == 0) settings.m_recordFormat = RecordFormat::Compressed;
+        else if(strcmp(option, "--climb") == 0)         settings.m_detector.m_liftoffClimb = (float)atof(value);
+        else if(strcmp(option, "--liftoff-accel") == 0) settings.m_detector.m_liftoffAcceleration = (float)atof(value);
+        else if(strcmp(option, "--landing-band") == 0)  settings.m_detector.m_landingBand = (float)atof(value);
+        else if(strcmp(option, "--landing-accel") == 0) settings.m_detector.m_landingAcceleration = (float)atof(value);
+        else if(strcmp(option, "--still-band") == 0)    settings.m_detector.m_landingStillBand = (float)atof(value);
+        else if(strcmp(option, "--apogee-drop") == 0)   settings.m_detector.m_apogeeDrop = (float)atof(value);
+        else if(strcmp(option, "--baro-noise") == 0)    settings.m_pressureNoise = (float)atof(value);
+        else if(strcmp(option, "--accel-noise") == 0)   settings.m_accelNoise = (float)atof(value);
+        else if(strcmp(option, "--gyro-noise") == 0)    settings.m_gyroNoise = (float)atof(value);
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    const auto wallStart = std::chrono::steady_clock::now();
+
+    ReplayStats stats;
+    if(argIdx < argc)
+    {
+        for(; argIdx < argc; ++argIdx)
+        {
+            SimLogReplay log;
+            if(!log.Load(argv[argIdx]))
+            {
+                printf("Can't load %s\n", argv[argIdx]);
+                continue;
+            }
+
+            settings.m_seed = seed + stats.GetNumFlights();
+            const ReplayResult result = SimReplay::Fly(&log, settings);
+            stats.Add(result);
+            if(verbose)
+            {
+                PrintResult(argv[argIdx], result);
+            }
+        }
+    }
+    else
+    {
+        SimRandom random(seed);
+        for(uint32_t flightIdx = 0; flightIdx < numFlights; ++flightIdx)
+        {
+            SimFlight flight(GetRandomFlightProfile(random));
+            settings.m_seed = seed + flightIdx;
+            const ReplayResult result = SimReplay::Fly(&flight, settings);
+            stats.Add(result);
+            if(verbose)
+            {
+                char name[32];
+                snprintf(name, sizeof(name), "Flight %lu (%.0fm)", (unsigned long)flightIdx, flight.GetApogeeHeight());
+                PrintResult(name, result);
+            }
+        }
+    }
+
+    const double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    stats.Print();
+    printf("%lu flights in %.3f s (%.0f flights/s)\n", (unsigned long)stats.GetNumFlights(), wallTime,
+        wallTime > 0.0 ? stats.GetNumFlights() / wallTime : 0.0);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "RMath.h"
+#include "Logger/LoggerDefinitions.h"
+
+class SimWorld;
+
+struct ReplaySettings
+{
+    int m_samplesPerSecond;
+    RecordFormat m_recordFormat;
+    DetectorSettings m_detector;
+    float m_pressureNoise;      // Pa (1 sigma), on top of whatever the world has
+    float m_accelNoise;         // m/s2
+    float m_gyroNoise;          // degrees per second
+    uint32_t m_seed;            // Sensor noise
+    bool m_dump;                // Let the app dump the log to the SD card (slow), otherwise stop once it's finished
+    const char* m_sdRoot;
+};
+
+// What the logger runs with on the board, no extra noise and no dump
+ReplaySettings GetDefaultReplaySettings();
+
+// How the detection did on one flight. Times in s against the world's SimFlightEvents
+struct ReplayResult
+{
+    bool m_initialized;
+    bool m_liftoffDetected;
+    bool m_falseLiftoff;        // Detected before the liftoff (or on a flight that never left the pad)
+    float m_liftoffLatency;     // From the real liftoff to the detection
+    bool m_landingDetected;     // The log was finished (landed or out of FRAM)
+    bool m_falseLanding;        // Finished before apogee
+    float m_landingDelay;       // From the real landing to the detection, negative if the log stopped before touchdown
+    uint32_t m_samples;         // Stored while Active
+    uint32_t m_samplesLost;     // Sampling ticks skipped, samples dropped by the queue and IMU FIFO overflows
+    uint32_t m_numTasks;
+};
+
+// Batch totals
+class ReplayStats
+{
+public:
+    ReplayStats();
+
+    void Add(const ReplayResult& result);
+
+    void Print()const;
+
+    uint32_t GetNumFlights()const;
+
+private:
+    uint32_t m_flights;
+    uint32_t m_failedInits;
+    uint32_t m_liftoffs;
+    uint32_t m_falseLiftoffs;
+    uint32_t m_landings;
+    uint32_t m_falseLandings;
+    float m_totalLiftoffLatency;
+    float m_maxLiftoffLatency;
+    float m_totalLandingDelay;
+    float m_minLandingDelay;
+    float m_maxLandingDelay;
+    uint32_t m_samples;
+    uint32_t m_samplesLost;
+};
+
+// Flies an unmodified LoggerApp through a SimWorld on the SimBoard and measures the launch and landing detection
+class SimReplay
+{
+public:
+    static ReplayResult Fly(SimWorld* world, const ReplaySettings& settings);
+
+    // Command line front end (native build: program replay ...)
+    static int RunTool(int argc, char** argv);
+};
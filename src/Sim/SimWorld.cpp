@@ -0,0 +1,40 @@
+#ifndef ARDUINO
+
+#include "SimWorld.h"
+
+#include <math.h>
+
+SimRandom::SimRandom(uint32_t seed /*= 1u*/)
+{
+    Seed(seed);
+}
+
+void SimRandom::Seed(uint32_t seed)
+{
+    // Xorshift can't start from 0
+    m_state = seed != 0 ? seed : 0x9E3779B9u;
+}
+
+float SimRandom::GetUniform()
+{
+    // Xorshift32, the top 24 bits fit a float exactly
+    m_state ^= m_state << 13u;
+    m_state ^= m_state >> 17u;
+    m_state ^= m_state << 5u;
+    return (float)(m_state >> 8u) * (1.0f / 16777216.0f);
+}
+
+float SimRandom::GetGaussian(float sigma)
+{
+    if(sigma <= 0.0f)
+    {
+        return 0.0f;
+    }
+
+    // Box-Muller
+    const float u1 = 1.0f - GetUniform(); // (0, 1], log(0) is not a thing
+    const float u2 = GetUniform();
+    return sigma * sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "RMath.h"
+
+// What the sensors measure at some point in time
+struct SimPhysics
+{
+    float m_pressure;       // Pa
+    float m_temperature;    // C
+    Vec3 m_acceleration;    // m/s2, specific force in the IMU frame (y points up, 9.8 at rest)
+    Vec3 m_angularRate;     // degrees per second
+};
+
+// When things really happened (s of SimClock time), what the detection is measured against
+struct SimFlightEvents
+{
+    float m_liftoffTime;
+    float m_apogeeTime;
+    float m_landingTime;
+    float m_endTime;        // Nothing else happens after this
+};
+
+// Source of the physics the simulated sensors sample (a synthetic trajectory, a recorded flight...)
+class SimWorld
+{
+public:
+    virtual ~SimWorld() {}
+
+    // 'time' in us of SimClock time
+    virtual void GetPhysics(uint64_t time, SimPhysics& physics) = 0;
+
+    virtual void GetEvents(SimFlightEvents& events)const = 0;
+};
+
+// Deterministic noise for the sensor models, the same seed gives the same run
+class SimRandom
+{
+public:
+    explicit SimRandom(uint32_t seed = 1u);
+
+    void Seed(uint32_t seed);
+
+    // [0, 1)
+    float GetUniform();
+
+    // Normal distribution, mean 0
+    float GetGaussian(float sigma);
+
+private:
+    uint32_t m_state;
+};
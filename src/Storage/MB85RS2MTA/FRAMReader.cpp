@@ -0,0 +1,59 @@
+#include "FRAMReader.h"
+
+#include "MB85RS2MTA.h"
+
+#include <string.h>
+
+FRAMReader::FRAMReader(MB85RS2MTA* fram, uint32_t startAddress, uint32_t endAddress)
+    : m_fram(fram)
+    , m_fetchAddress(startAddress)
+    , m_endAddress(endAddress)
+    , m_bufferSize(0)
+    , m_bufferPos(0)
+{
+}
+
+bool FRAMReader::Read(uint8_t* data, uint32_t dataSize)
+{
+    if(GetAddress() + dataSize > m_endAddress)
+    {
+        return false;
+    }
+
+    while(dataSize > 0)
+    {
+        if(m_bufferPos == m_bufferSize)
+        {
+            Refill();
+        }
+
+        uint8_t available = m_bufferSize - m_bufferPos;
+        uint8_t copySize = dataSize < available ? (uint8_t)dataSize : available;
+        memcpy(data, &m_buffer[m_bufferPos], copySize);
+        m_bufferPos += copySize;
+        data += copySize;
+        dataSize -= copySize;
+    }
+
+    return true;
+}
+
+uint32_t FRAMReader::GetAddress()const
+{
+    return m_fetchAddress - (m_bufferSize - m_bufferPos);
+}
+
+bool FRAMReader::IsDone()const
+{
+    return GetAddress() >= m_endAddress;
+}
+
+void FRAMReader::Refill()
+{
+    uint32_t remaining = m_endAddress - m_fetchAddress;
+    m_bufferSize = remaining < k_bufferSize ? (uint8_t)remaining : k_bufferSize;
+    m_bufferPos = 0;
+
+    m_fram->FastRead(m_fetchAddress, m_buffer, m_bufferSize);
+    m_fetchAddress += m_bufferSize;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+
+class MB85RS2MTA;
+
+// Sequential reader over a FRAM region. Data is fetched ahead in chunks (one FSTRD transaction each)
+// so reading small records doesn't pay for the command, address and CS toggle every time.
+// NOTE: the transaction can't stay open for the whole region as the SD card shares the SPI bus
+class FRAMReader
+{
+public:
+    FRAMReader(MB85RS2MTA* fram, uint32_t startAddress, uint32_t endAddress);
+
+    // Returns false if there isn't 'dataSize' bytes left in the region
+    bool Read(uint8_t* data, uint32_t dataSize);
+
+    // Address of the next byte returned by Read
+    uint32_t GetAddress()const;
+
+    bool IsDone()const;
+
+    static const uint8_t k_bufferSize = 64;
+
+private:
+    void Refill();
+
+    MB85RS2MTA* m_fram;
+    uint32_t m_fetchAddress; // Next address to fetch from the FRAM
+    uint32_t m_endAddress;
+    uint8_t m_buffer[k_bufferSize];
+    uint8_t m_bufferSize;
+    uint8_t m_bufferPos;
+};
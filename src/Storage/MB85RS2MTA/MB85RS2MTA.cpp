@@ -2,18 +2,33 @@
 
 #include "Debug/DebugOutput.h"
 
-#include <SPI.h>
+#include "HAL.h"
 
 #define MB_EXTRA_CHECKS 1
 
+#include <string.h>
+
+// SPIClass::transfer(buf, count) overwrites the buffer with what it reads, writes go through this
+static const uint8_t k_transferChunkSize = 32;
+
+// The count of SPIClass::transfer is a size_t, 16 bits on AVR. Reads longer than this are split
+static const uint16_t k_maxReadChunkSize = 0x8000;
+
 MB85RS2MTA::MB85RS2MTA()
     : m_chipSelect(0)
     , m_spi(nullptr)
     , m_spiSettings(nullptr)
+    , m_writeBufferUsed(0)
+    , m_appendAddress(0)
+{
+}
+
+MB85RS2MTA::~MB85RS2MTA()
 {
+    delete m_spiSettings;
 }
 
-bool MB85RS2MTA::Init(uint8_t chipSelect, SPIClass* spi)
+bool MB85RS2MTA::Init(uint8_t chipSelect, SPIBus* spi)
 {
     m_chipSelect = chipSelect;
     m_spi = spi;
@@ -45,9 +60,6 @@ bool MB85RS2MTA::Init(uint8_t chipSelect, SPIClass* spi)
     }
 #endif
 
-    // Enable writes
-    WriteCommand(OPCodes::WREN);
-
     return true;
 }
 
@@ -56,20 +68,26 @@ void MB85RS2MTA::Write(const uint32_t address, uint8_t value)
     Write(address, &value, 1u);
 }
 
-void MB85RS2MTA::Write(const uint32_t address, uint8_t* data, uint8_t dataSize)
+void MB85RS2MTA::Write(const uint32_t address, const uint8_t* data, uint32_t dataSize)
 {
-    uint8_t addrBits[3];
-    SplitAddress(address, addrBits);
+    // Keep writes in order
+    Flush();
+
+    // The write enable latch is cleared at the end of every WRITE, set it again
+    WriteCommand(OPCodes::WREN);
 
     BeginTransaction();
     {
-        m_spi->transfer((uint8_t)OPCodes::WRITE);
-        m_spi->transfer(addrBits[0]);
-        m_spi->transfer(addrBits[1]);
-        m_spi->transfer(addrBits[2]);
-        for(uint8_t cur = 0; cur < dataSize; ++cur)
+        SendCommand(OPCodes::WRITE, address);
+
+        uint8_t chunk[k_transferChunkSize];
+        while(dataSize > 0)
         {
-            m_spi->transfer(((uint8_t*)data)[cur]);
+            uint8_t chunkSize = dataSize < k_transferChunkSize ? (uint8_t)dataSize : k_transferChunkSize;
+            memcpy(chunk, data, chunkSize);
+            m_spi->transfer(chunk, chunkSize);
+            data += chunkSize;
+            dataSize -= chunkSize;
         }
     }
     EndTransaction();
@@ -82,23 +100,81 @@ uint8_t MB85RS2MTA::Read(const uint32_t address)
     return value;
 }
 
-void MB85RS2MTA::Read(const uint32_t address, uint8_t* data, uint8_t dataSize)
+void MB85RS2MTA::Read(const uint32_t address, uint8_t* data, uint32_t dataSize)
 {
-    uint8_t addrBits[3];
-    SplitAddress(address, addrBits);
+    // Make sure we read what was appended
+    Flush();
 
     BeginTransaction();
     {
-        m_spi->transfer((uint8_t)OPCodes::READ);
-        m_spi->transfer(addrBits[0]);
-        m_spi->transfer(addrBits[1]);
-        m_spi->transfer(addrBits[2]);
-        for(uint8_t cur = 0; cur < dataSize; ++cur)
+        SendCommand(OPCodes::READ, address);
+        ReceiveData(data, dataSize);
+    }
+    EndTransaction();
+}
+
+void MB85RS2MTA::FastRead(const uint32_t address, uint8_t* data, uint32_t dataSize)
+{
+    Flush();
+
+    BeginTransaction();
+    {
+        SendCommand(OPCodes::FSTRD, address);
+        m_spi->transfer(0); // Dummy byte
+        ReceiveData(data, dataSize);
+    }
+    EndTransaction();
+}
+
+void MB85RS2MTA::BeginAppend(const uint32_t address)
+{
+    Flush();
+    m_appendAddress = address;
+}
+
+void MB85RS2MTA::Append(const uint8_t* data, uint32_t dataSize)
+{
+    while(dataSize > 0)
+    {
+        uint8_t freeSpace = k_writeBufferSize - m_writeBufferUsed;
+        uint8_t copySize = dataSize < freeSpace ? (uint8_t)dataSize : freeSpace;
+        memcpy(&m_writeBuffer[m_writeBufferUsed], data, copySize);
+        m_writeBufferUsed += copySize;
+        data += copySize;
+        dataSize -= copySize;
+
+        if(m_writeBufferUsed == k_writeBufferSize)
         {
-            m_spi->transfer((void*)&data[cur], 1);
+            Flush();
         }
     }
+}
+
+void MB85RS2MTA::Flush()
+{
+    if(m_writeBufferUsed == 0)
+    {
+        return;
+    }
+
+    WriteCommand(OPCodes::WREN);
+
+    BeginTransaction();
+    {
+        SendCommand(OPCodes::WRITE, m_appendAddress);
+
+        // We don't need the buffer afterwards, let the transfer overwrite it
+        m_spi->transfer(m_writeBuffer, m_writeBufferUsed);
+    }
     EndTransaction();
+
+    m_appendAddress += m_writeBufferUsed;
+    m_writeBufferUsed = 0;
+}
+
+uint32_t MB85RS2MTA::GetAppendAddress() const
+{
+    return m_appendAddress + m_writeBufferUsed;
 }
 
 uint32_t MB85RS2MTA::Capacity() const
@@ -136,4 +212,27 @@ void MB85RS2MTA::WriteCommand(const OPCodes command)
     BeginTransaction();
     m_spi->transfer((uint8_t)command);
     EndTransaction();
-}
\ No newline at end of file
+}
+
+void MB85RS2MTA::SendCommand(const OPCodes command, const uint32_t address)
+{
+    uint8_t addrBits[3];
+    SplitAddress(address, addrBits);
+
+    m_spi->transfer((uint8_t)command);
+    m_spi->transfer(addrBits[0]);
+    m_spi->transfer(addrBits[1]);
+    m_spi->transfer(addrBits[2]);
+}
+
+void MB85RS2MTA::ReceiveData(uint8_t* data, uint32_t dataSize)
+{
+    // The FRAM keeps streaming from the next address as long as the chip select stays low
+    while(dataSize > 0)
+    {
+        const uint16_t chunkSize = dataSize < k_maxReadChunkSize ? (uint16_t)dataSize : k_maxReadChunkSize;
+        m_spi->transfer(data, chunkSize);
+        data += chunkSize;
+        dataSize -= chunkSize;
+    }
+}
@@ -2,7 +2,8 @@
 
 #include <stdint.h>
 
-class SPIClass;
+#include "HALTypes.h"
+
 class SPISettings;
 
 // Memory FRAM
@@ -12,22 +13,42 @@ class MB85RS2MTA
 public:
     MB85RS2MTA();
 
-    bool Init(uint8_t chipSelect, SPIClass* spi);
+    ~MB85RS2MTA();
+
+    MB85RS2MTA(const MB85RS2MTA& other) = delete;
+
+    bool Init(uint8_t chipSelect, SPIBus* spi);
 
     // Writes a single value to address
     void Write(const uint32_t address, const uint8_t value);
 
     // Writes a block of data starting at address
-    void Write(const uint32_t address, uint8_t* data, uint8_t dataSize);
+    void Write(const uint32_t address, const uint8_t* data, uint32_t dataSize);
 
     // Reads single value from address
     uint8_t Read(const uint32_t address);
 
     // Reads a block of data starting at address
-    void Read(const uint32_t address, uint8_t* data, uint8_t dataSize);
+    void Read(const uint32_t address, uint8_t* data, uint32_t dataSize);
+
+    // Same as Read but using the fast read command (FSTRD)
+    void FastRead(const uint32_t address, uint8_t* data, uint32_t dataSize);
+
+    // Write combining: data appended is buffered and written in a single transaction once
+    // the buffer is full or Flush is called. Appends are sequential starting at 'address'
+    void BeginAppend(const uint32_t address);
+
+    void Append(const uint8_t* data, uint32_t dataSize);
+
+    void Flush();
+
+    // Where the next appended byte goes
+    uint32_t GetAppendAddress() const;
 
     uint32_t Capacity() const;
 
+    static const uint8_t k_writeBufferSize = 64;
+
 private:
     enum class OPCodes : uint8_t
     {
@@ -52,7 +73,17 @@ private:
 
     void WriteCommand(const OPCodes command);
 
+    // Sends the opcode and address bytes, must be inside a transaction
+    void SendCommand(const OPCodes command, const uint32_t address);
+
+    // Reads dataSize bytes in place, must be inside a transaction after a read command
+    void ReceiveData(uint8_t* data, uint32_t dataSize);
+
     uint8_t m_chipSelect;
-    SPIClass* m_spi;
+    SPIBus* m_spi;
     SPISettings* m_spiSettings;
+
+    uint8_t m_writeBuffer[k_writeBufferSize];
+    uint8_t m_writeBufferUsed;
+    uint32_t m_appendAddress;
 };
\ No newline at end of file
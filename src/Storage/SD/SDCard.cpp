@@ -2,7 +2,12 @@
 
 #include "Debug/DebugOutput.h"
 
+#ifdef ARDUINO
 #include <SdFat.h>
+#else
+#include "HAL.h"
+#include "Native/SimFileSystem.h"
+#endif
 
  // #define SD_TEST_ENABLE
 
@@ -10,16 +15,24 @@ SDCard::SDCard()
     : m_chipSelect(0)
     , m_sd(nullptr)
     , m_file(nullptr)
+    , m_stream()
     , m_open(false)
 {
 }
 
+SDCard::~SDCard()
+{
+    CloseFile();
+    delete m_file;
+    delete m_sd;
+}
+
 bool SDCard::Init(uint8_t chipSelect)
 {    
     m_chipSelect = chipSelect;
-    m_sd = new SdFat();
+    m_sd = new FileSystem();
 
-    if(!m_sd->begin(chipSelect, SPI_HALF_SPEED))
+    if(!m_sd->begin(chipSelect, SPI_FULL_SPEED))
     {
         return false;
     }
@@ -43,7 +56,7 @@ Print* SDCard::CreateFile(const char* path)
     // Create it the first time
     if(!m_file)
     {
-        m_file = new SdFile;
+        m_file = new FileSink;
     }
 
     if(!m_file->open(path, O_RDWR | O_CREAT | O_TRUNC))
@@ -54,17 +67,148 @@ Print* SDCard::CreateFile(const char* path)
 
     m_open = true;
 
-    // SdFile inherits from Print (that's what we are mainly interested in)
+    // SdFile (and SimFile) inherits from Print (that's what we are mainly interested in)
     return m_file;
 }
 
-void SDCard::CloseFile()
+Print* SDCard::CreateContiguousFile(const char* path, uint32_t maxSize)
 {
-    if(m_file)
+    if(m_open)
+    {
+        return nullptr;
+    }
+
+    if(!m_file)
+    {
+        m_file = new FileSink;
+    }
+
+    // Only a new file gets consecutive clusters
+    if(m_sd->exists(path) && !m_sd->remove(path))
+    {
+        return nullptr;
+    }
+
+    uint32_t firstBlock = 0;
+    uint32_t lastBlock = 0;
+    if(!m_file->createContiguous(path, maxSize) || !m_file->contiguousRange(&firstBlock, &lastBlock))
+    {
+        DEBUG_LOG("Failed to allocate %lu contiguous bytes", (unsigned long)maxSize);
+        m_file->close();
+        return nullptr;
+    }
+
+    // SdFat's block cache is the sector buffer, nothing else uses it until CloseFile updates the FAT
+    uint8_t* sector = (uint8_t*)m_sd->vol()->cacheClear();
+    if(!m_stream.Begin(m_sd->card(), sector, firstBlock, lastBlock - firstBlock + 1u))
     {
         m_file->close();
-        m_open = false;
+        return nullptr;
+    }
+
+    m_open = true;
+    return &m_stream;
+}
+
+bool SDCard::OpenFile(const char* path)
+{
+    if(m_open)
+    {
+        return false;
+    }
+
+    if(!m_file)
+    {
+        m_file = new FileSink;
+    }
+
+    if(!m_file->open(path, O_RDONLY))
+    {
+        return false;
+    }
+
+    m_open = true;
+    return true;
+}
+
+uint32_t SDCard::Read(uint8_t* data, uint32_t size)
+{
+    if(!m_open || m_stream.IsActive())
+    {
+        return 0;
+    }
+
+    const int read = m_file->read(data, size);
+    return read > 0 ? (uint32_t)read : 0u;
+}
+
+uint32_t SDCard::CloseFile()
+{
+    if(!m_file)
+    {
+        return 0;
+    }
+
+    uint32_t size = 0;
+    if(m_stream.IsActive())
+    {
+        // Give back the preallocated clusters we didn't use
+        size = m_stream.GetSize();
+        if(!m_stream.End() || !m_file->truncate(size))
+        {
+            DEBUG_LOG("Failed to finish the contiguous file");
+        }
+    }
+    else
+    {
+        size = m_file->fileSize();
+    }
+
+    m_file->close();
+    m_open = false;
+    return size;
+}
+
+bool SDCard::ReadFile(const char* path, uint32_t offset, uint8_t* data, uint32_t size)
+{
+    if(m_open)
+    {
+        return false;
+    }
+
+    if(!m_file)
+    {
+        m_file = new FileSink;
+    }
+
+    if(!m_file->open(path, O_RDONLY))
+    {
+        return false;
+    }
+    const bool read = m_file->seekSet(offset) && m_file->read(data, size) == (int)size;
+    m_file->close();
+    return read;
+}
+
+bool SDCard::WriteFile(const char* path, uint32_t offset, const uint8_t* data, uint32_t size)
+{
+    if(m_open)
+    {
+        return false;
+    }
+
+    if(!m_file)
+    {
+        m_file = new FileSink;
+    }
+
+    if(!m_file->open(path, O_RDWR | O_CREAT))
+    {
+        m_sd->errorPrint(&Serial);
+        return false;
     }
+    const bool written = m_file->seekSet(offset) && m_file->write(data, size) == size;
+    return m_file->close() && written;
 }
 
 void SDCard::TestWrite()
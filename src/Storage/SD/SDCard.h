@@ -2,8 +2,9 @@
 
 #include <stdint.h>
 
-class SdFat;
-class SdFile;
+#include "FileSystem.h"
+#include "SDStreamWriter.h"
+
 class Print;
 
 class SDCard
@@ -11,19 +12,42 @@ class SDCard
 public:
     SDCard();
 
+    ~SDCard();
+
+    SDCard(const SDCard& other) = delete;
+
     bool Init(uint8_t chipSelect);
 
     bool FileExists(const char* path);
 
     Print* CreateFile(const char* path);
 
-    void CloseFile();
+    // New file of up to 'maxSize' bytes, preallocated in consecutive clusters (an existing one is replaced).
+    // What's printed goes to the card in sector sized multi-block writes, the FAT is only updated by
+    // CloseFile (it trims the file to what was written). Fails if there isn't that much free space in a row
+    Print* CreateContiguousFile(const char* path, uint32_t maxSize);
+
+    // Opens an existing file to Read it from the start, CloseFile closes it
+    bool OpenFile(const char* path);
+
+    // Reads up to 'size' bytes of the open file, returns how many (0 at the end of the file or on error)
+    uint32_t Read(uint8_t* data, uint32_t size);
+
+    // Returns the size of the file (bytes)
+    uint32_t CloseFile();
+
+    // Reads 'size' bytes at 'offset' of a file. Fails if they aren't all there or another file is open
+    bool ReadFile(const char* path, uint32_t offset, uint8_t* data, uint32_t size);
+
+    // Writes 'size' bytes at 'offset' (up to the end) of a file, it's created if missing
+    bool WriteFile(const char* path, uint32_t offset, const uint8_t* data, uint32_t size);
 
     void TestWrite();
 
 private:  
     uint8_t m_chipSelect;
-    SdFat* m_sd;
-    SdFile* m_file;
+    FileSystem* m_sd;
+    FileSink* m_file;
+    SDStreamWriter m_stream;    // Contiguous files
     bool m_open;
 };
\ No newline at end of file
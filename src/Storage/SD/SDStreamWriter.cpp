@@ -0,0 +1,112 @@
+#include "SDStreamWriter.h"
+
+#ifdef ARDUINO
+#include <SdFat.h>
+#else
+#include "Native/SimFileSystem.h"
+#endif
+
+#include <string.h>
+
+SDStreamWriter::SDStreamWriter()
+    : m_card(nullptr)
+    , m_sector(nullptr)
+    , m_blocksLeft(0)
+    , m_size(0)
+    , m_sectorSize(0)
+    , m_error(false)
+{
+}
+
+bool SDStreamWriter::Begin(BlockDevice* card, uint8_t* sector, uint32_t firstBlock, uint32_t numBlocks)
+{
+    m_card = nullptr;
+    m_sector = sector;
+    m_blocksLeft = numBlocks;
+    m_size = 0;
+    m_sectorSize = 0;
+    m_error = false;
+
+    if(!card->writeStart(firstBlock, numBlocks))
+    {
+        return false;
+    }
+    m_card = card;
+    return true;
+}
+
+bool SDStreamWriter::End()
+{
+    if(!m_card)
+    {
+        return false;
+    }
+
+    if(m_sectorSize > 0)
+    {
+        memset(m_sector + m_sectorSize, 0, k_sdSectorSize - m_sectorSize);
+        WriteSector();
+    }
+    if(!m_card->writeStop())
+    {
+        m_error = true;
+    }
+    m_card = nullptr;
+    return !m_error;
+}
+
+size_t SDStreamWriter::write(uint8_t value)
+{
+    return write(&value, 1);
+}
+
+size_t SDStreamWriter::write(const uint8_t* buffer, size_t size)
+{
+    if(!m_card || m_error)
+    {
+        return 0;
+    }
+
+    size_t written = 0;
+    while(written < size)
+    {
+        uint16_t chunk = k_sdSectorSize - m_sectorSize;
+        if(chunk > size - written)
+        {
+            chunk = (uint16_t)(size - written);
+        }
+        memcpy(m_sector + m_sectorSize, buffer + written, chunk);
+        m_sectorSize += chunk;
+        written += chunk;
+
+        if(m_sectorSize == k_sdSectorSize && !WriteSector())
+        {
+            break;
+        }
+    }
+
+    m_size += written;
+    return written;
+}
+
+uint32_t SDStreamWriter::GetSize()const
+{
+    return m_size;
+}
+
+bool SDStreamWriter::IsActive()const
+{
+    return m_card != nullptr;
+}
+
+bool SDStreamWriter::WriteSector()
+{
+    if(m_blocksLeft == 0 || !m_card->writeData(m_sector))
+    {
+        m_error = true;
+        return false;
+    }
+    --m_blocksLeft;
+    m_sectorSize = 0;
+    return true;
+}
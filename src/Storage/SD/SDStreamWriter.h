@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "HAL.h"
+#include "FileSystem.h"
+
+// Card block (sector) size
+static const uint16_t k_sdSectorSize = 512;
+
+// Streams to consecutive card blocks: the bytes are gathered in a sector buffer and every full sector goes out
+// in a single multi-block write, the FAT isn't touched. Used by SDCard for contiguous files
+class SDStreamWriter : public Print
+{
+public:
+    SDStreamWriter();
+
+    // Starts a multi-block write of the 'numBlocks' blocks from 'firstBlock' (erased first). 'sector' is the
+    // k_sdSectorSize buffer, it has to stay valid until End
+    bool Begin(BlockDevice* card, uint8_t* sector, uint32_t firstBlock, uint32_t numBlocks);
+
+    // Zero pads and writes the last sector, then ends the multi-block write. Returns false if a write failed
+    // or there were more bytes than blocks
+    bool End();
+
+    size_t write(uint8_t value) override;
+
+    size_t write(const uint8_t* buffer, size_t size) override;
+
+    using Print::write;
+
+    // Bytes written so far (the padding isn't counted)
+    uint32_t GetSize()const;
+
+    bool IsActive()const;
+
+private:
+    bool WriteSector();
+
+    BlockDevice* m_card;
+    uint8_t* m_sector;
+    uint32_t m_blocksLeft;
+    uint32_t m_size;
+    uint16_t m_sectorSize;      // Bytes in the sector buffer
+    bool m_error;
+};
@@ -0,0 +1,100 @@
+#ifndef ARDUINO
+
+#include "CatalogTool.h"
+
+#include "Logger/LogCatalog.h"
+
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static const char* const k_recordFormatNames[] = { "FLOAT", "RAW", "PACKED", "COMPRESSED" };
+
+bool CatalogTool::Read(const char* path, CatalogHeader& header, CatalogEntry* entries, uint32_t maxEntries, uint32_t& numEntries)
+{
+    numEntries = 0;
+    FILE* file = fopen(path, "rb");
+    if(!file)
+    {
+        return false;
+    }
+
+    bool valid = fread(&header, sizeof(CatalogHeader), 1, file) == 1 && header.m_magic == k_catalogMagic &&
+        header.m_version == k_catalogVersion && header.m_entrySize == sizeof(CatalogEntry);
+    if(valid)
+    {
+        const uint32_t toRead = header.m_numEntries < maxEntries ? header.m_numEntries : maxEntries;
+        numEntries = (uint32_t)fread(entries, sizeof(CatalogEntry), toRead, file);
+        valid = numEntries == toRead;
+    }
+    fclose(file);
+    return valid;
+}
+
+void CatalogTool::Print(const CatalogEntry* entries, uint32_t numEntries, FILE* output)
+{
+    fprintf(output, "%-20s %9s %8s %6s %-10s %9s %9s %8s %s\n", "LOG", "BYTES", "SAMPLES", "RATE", "FORMAT", "APOGEE_M",
+        "FLIGHT_S", "OVERRUNS", "FLAGS");
+    for(uint32_t entryIdx = 0; entryIdx < numEntries; ++entryIdx)
+    {
+        const CatalogEntry& entry = entries[entryIdx];
+        char name[k_maxLogNameLength];
+        LogCatalog::GetLogName(entry.m_sequence, (entry.m_flags & k_catalogCSV) ? "csv" : "bin", name);
+
+        const uint8_t format = (uint8_t)entry.m_recordFormat;
+        fprintf(output, "%-20s %9lu %8lu %6u %-10s %9.2f %9.3f %8lu %s%s\n", name, (unsigned long)entry.m_fileSize,
+            (unsigned long)entry.m_numSamples, (unsigned)entry.m_samplesPerSecond,
+            format < sizeof(k_recordFormatNames) / sizeof(k_recordFormatNames[0]) ? k_recordFormatNames[format] : "?",
+            entry.m_apogee, entry.m_flightTime * 0.001f, (unsigned long)entry.m_overruns,
+            (entry.m_flags & k_catalogRecovered) ? "recovered" : (entry.m_flags & k_catalogLanded) ? "landed" : "full",
+            (entry.m_flags & k_catalogContiguous) ? ",contiguous" : "");
+    }
+}
+
+static void PrintUsage()
+{
+    printf("Usage: program catalog <card directory or CATALOG.BIN>\n");
+    printf("Lists the dumped logs and their flight summaries\n");
+}
+
+int CatalogTool::RunTool(int argc, char** argv)
+{
+    if(argc != 1)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // A directory is the card root
+    char path[512];
+    struct stat info;
+    if(stat(argv[0], &info) == 0 && S_ISDIR(info.st_mode))
+    {
+        snprintf(path, sizeof(path), "%s/%s", argv[0], LogCatalog::k_path);
+    }
+    else
+    {
+        snprintf(path, sizeof(path), "%s", argv[0]);
+    }
+
+    // The file size bounds the entries
+    const uint32_t maxEntries = stat(path, &info) == 0 && (uint32_t)info.st_size > sizeof(CatalogHeader) ?
+        ((uint32_t)info.st_size - sizeof(CatalogHeader)) / sizeof(CatalogEntry) : 0u;
+    std::vector<CatalogEntry> entries(maxEntries + 1);
+
+    CatalogHeader header;
+    uint32_t numEntries = 0;
+    if(!Read(path, header, entries.data(), maxEntries, numEntries))
+    {
+        printf("Can't read the catalog %s\n", path);
+        return 1;
+    }
+
+    Print(entries.data(), numEntries, stdout);
+    printf("%lu logs, the next one is %lu\n", (unsigned long)numEntries, (unsigned long)header.m_nextSequence);
+    return 0;
+}
+
+#endif
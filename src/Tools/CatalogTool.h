@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "RMath.h"
+
+#include "Logger/LoggerDefinitions.h"
+
+// Reads the CATALOG.BIN of a card on the host (see LogCatalog), the flight summaries without the logs
+class CatalogTool
+{
+public:
+    // Reads the header and up to 'maxEntries' entries. Returns false if it isn't a valid catalog
+    static bool Read(const char* path, CatalogHeader& header, CatalogEntry* entries, uint32_t maxEntries, uint32_t& numEntries);
+
+    // A row per entry
+    static void Print(const CatalogEntry* entries, uint32_t numEntries, FILE* output);
+
+    // Command line front end (native build: program catalog ...)
+    static int RunTool(int argc, char** argv);
+};
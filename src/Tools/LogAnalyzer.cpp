@@ -0,0 +1,271 @@
+#ifndef ARDUINO
+
+#include "LogAnalyzer.h"
+
+#include "LogConverter.h"
+
+#include "HAL.h"
+
+#include "Logger/FlightDetector.h"
+#include "Logger/LoggerApp.h"
+#include "Logger/LogReader.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Least squares line through the descent samples, times relative to the apogee so the sums keep their precision
+struct DescentFit
+{
+    void Reset()
+    {
+        m_count = 0;
+        m_sumTime = m_sumAltitude = m_sumTimeTime = m_sumTimeAltitude = 0.0;
+    }
+
+    void Add(double time, double altitude)
+    {
+        ++m_count;
+        m_sumTime += time;
+        m_sumAltitude += altitude;
+        m_sumTimeTime += time * time;
+        m_sumTimeAltitude += time * altitude;
+    }
+
+    // m/s, positive down. 0 without two samples apart
+    float GetRate()const
+    {
+        const double denominator = m_count * m_sumTimeTime - m_sumTime * m_sumTime;
+        return m_count > 1 && denominator > 0.0 ? (float)(-(m_count * m_sumTimeAltitude - m_sumTime * m_sumAltitude) / denominator) : 0.0f;
+    }
+
+    uint32_t m_count;
+    double m_sumTime;
+    double m_sumAltitude;
+    double m_sumTimeTime;
+    double m_sumTimeAltitude;
+};
+
+FlightAnalysis LogAnalyzer::Analyze(LogFile& log, const DetectorSettings& settings)
+{
+    FlightAnalysis analysis = {};
+    analysis.m_apogeeTime = -1.0f;
+    analysis.m_burnoutTime = -1.0f;
+    analysis.m_liftoffTime = -1.0f;
+    analysis.m_landingTime = -1.0f;
+    analysis.m_endTime = -1.0f;
+
+    LogReader reader(log.GetStorage());
+    if(!log.BeginRead(reader))
+    {
+        return analysis;
+    }
+    analysis.m_valid = true;
+
+    FlightDetector detector;
+    detector.SetSettings(settings);
+    bool inFlight = false;
+
+    // Boost: the motor is burning until the acceleration along y falls under 1 G past its peak
+    const float boostAcceleration = settings.m_liftoffAcceleration / k_standardGravity;
+    float peakAcceleration = 0.0f;
+
+    float maxAltitude = 0.0f;
+    DescentFit descent;
+    descent.Reset();
+
+    State previous = {};
+    State state = {};
+    while(reader.Next(state))
+    {
+        const float time = state.m_timeStamp;
+        if(analysis.m_samples == 0)
+        {
+            analysis.m_padAltitude = state.m_altitude;
+            maxAltitude = state.m_altitude;
+            analysis.m_apogeeTime = time;
+            previous = state;
+        }
+        ++analysis.m_samples;
+        analysis.m_endTime = time;
+
+        analysis.m_maxAcceleration = max(analysis.m_maxAcceleration, Length(state.m_acceleration));
+
+        if(state.m_acceleration.y > peakAcceleration)
+        {
+            peakAcceleration = state.m_acceleration.y;
+            analysis.m_burnoutTime = -1.0f;
+        }
+        else if(analysis.m_burnoutTime < 0.0f && peakAcceleration > boostAcceleration && state.m_acceleration.y < 1.0f)
+        {
+            analysis.m_burnoutTime = time;
+        }
+
+        // The descent starts over at every new highest altitude, it's fitted once clear of the apogee
+        const float height = state.m_altitude - analysis.m_padAltitude;
+        if(state.m_altitude > maxAltitude)
+        {
+            maxAltitude = state.m_altitude;
+            analysis.m_apogeeTime = time;
+            descent.Reset();
+        }
+        else if(maxAltitude - state.m_altitude >= settings.m_apogeeDrop && height > settings.m_landingBand)
+        {
+            descent.Add(time - analysis.m_apogeeTime, height);
+        }
+
+        // Same calls the logger makes, one sample at a time
+        if(!inFlight)
+        {
+            if(detector.CheckLiftoff(state, previous))
+            {
+                inFlight = true;
+                analysis.m_liftoffTime = time;
+                detector.BeginFlight(state);
+            }
+        }
+        else if(analysis.m_landingTime < 0.0f && detector.CheckLanding(state))
+        {
+            analysis.m_landingTime = time;
+        }
+        previous = state;
+    }
+
+    analysis.m_apogee = maxAltitude - analysis.m_padAltitude;
+    analysis.m_descentRate = descent.GetRate();
+    return analysis;
+}
+
+uint64_t LogAnalyzer::AnalyzeBatch(const char* const* paths, uint32_t numPaths, const DetectorSettings& settings,
+    uint32_t numThreads, FlightAnalysis* results)
+{
+    // Logs are handed out one at a time, they don't take the same time
+    std::atomic<uint32_t> nextLog(0);
+    std::atomic<uint64_t> numSamples(0);
+    auto worker = [&]()
+    {
+        for(uint32_t logIdx = nextLog++; logIdx < numPaths; logIdx = nextLog++)
+        {
+            LogFile log;
+            results[logIdx] = FlightAnalysis();
+            if(log.Open(paths[logIdx]))
+            {
+                results[logIdx] = Analyze(log, settings);
+            }
+            numSamples += results[logIdx].m_samples;
+        }
+    };
+
+    numThreads = max(1u, min(numThreads, numPaths));
+    std::vector<std::thread> threads;
+    for(uint32_t threadIdx = 1; threadIdx < numThreads; ++threadIdx)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for(std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    return numSamples;
+}
+
+static void PrintTime(float time)
+{
+    if(time < 0.0f)
+    {
+        printf(" %9s", "-");
+    }
+    else
+    {
+        printf(" %9.3f", time);
+    }
+}
+
+void LogAnalyzer::PrintTable(const char* const* paths, uint32_t numPaths, const FlightAnalysis* results)
+{
+    printf("%-24s %8s %9s %9s %9s %9s %9s %9s %9s %9s\n", "LOG", "SAMPLES", "APOGEE_M", "APOGEE_S", "ACCEL_G", "BURNOUT_S",
+        "DESCENT", "LIFTOFF_S", "LANDING_S", "END_S");
+    for(uint32_t logIdx = 0; logIdx < numPaths; ++logIdx)
+    {
+        const FlightAnalysis& result = results[logIdx];
+        if(!result.m_valid)
+        {
+            printf("%-24s can't be read\n", paths[logIdx]);
+            continue;
+        }
+        printf("%-24s %8lu %9.2f", paths[logIdx], (unsigned long)result.m_samples, result.m_apogee);
+        PrintTime(result.m_apogeeTime);
+        printf(" %9.2f", result.m_maxAcceleration);
+        PrintTime(result.m_burnoutTime);
+        printf(" %9.2f", result.m_descentRate);
+        PrintTime(result.m_liftoffTime);
+        PrintTime(result.m_landingTime);
+        PrintTime(result.m_endTime);
+        printf("\n");
+    }
+}
+
+static void PrintUsage()
+{
+    printf("Usage: program analyze [options] Log_N.bin ...\n");
+    printf("Analyzes the flights in parallel and prints a row per log (times in s of log time, DESCENT in m/s)\n");
+    printf("  -j <threads>          Worker threads (all the cores)\n");
+    printf("  -b <runs>             Benchmark: analyze the batch this many times (1)\n");
+}
+
+int LogAnalyzer::RunTool(int argc, char** argv)
+{
+    uint32_t numThreads = std::thread::hardware_concurrency();
+    uint32_t numRuns = 1;
+
+    int argIdx = 0;
+    for(; argIdx < argc && argv[argIdx][0] == '-'; ++argIdx)
+    {
+        const char* option = argv[argIdx];
+        if(argIdx + 1 >= argc)
+        {
+            PrintUsage();
+            return 1;
+        }
+
+        const char* value = argv[++argIdx];
+        if(strcmp(option, "-j") == 0)         numThreads = (uint32_t)atoi(value);
+        else if(strcmp(option, "-b") == 0)    numRuns = (uint32_t)max(1, atoi(value));
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if(argIdx == argc)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    const uint32_t numPaths = (uint32_t)(argc - argIdx);
+    std::vector<FlightAnalysis> results(numPaths);
+    const DetectorSettings settings = LoggerApp::GetDefaultDetectorSettings();
+
+    const auto wallStart = std::chrono::steady_clock::now();
+    uint64_t numSamples = 0;
+    for(uint32_t runIdx = 0; runIdx < numRuns; ++runIdx)
+    {
+        numSamples += AnalyzeBatch(argv + argIdx, numPaths, settings, numThreads, results.data());
+    }
+    const double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    PrintTable(argv + argIdx, numPaths, results.data());
+    printf("%lu logs x %lu, %llu samples in %.2f ms on %lu threads, %.0f samples/s\n", (unsigned long)numPaths, (unsigned long)numRuns,
+        (unsigned long long)numSamples, wallTime * 1000.0, (unsigned long)max(1u, min(numThreads, numPaths)),
+        wallTime > 0.0 ? numSamples / wallTime : 0.0);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "RMath.h"
+
+#include "Logger/LoggerDefinitions.h"
+
+class LogFile;
+
+// What a stored flight tells. Times are log times (s, the TIME column), -1 for an event that wasn't found
+struct FlightAnalysis
+{
+    bool m_valid;               // The log could be read
+    uint32_t m_samples;         // Pre-trigger ones included
+    float m_padAltitude;        // m above sea level, first sample
+    float m_apogee;             // m above the pad
+    float m_apogeeTime;
+    float m_maxAcceleration;    // G, length of the vector
+    float m_burnoutTime;        // The acceleration along y drops under 1 G past its peak (only drag left)
+    float m_descentRate;        // m/s, least squares from apogee until the landing band, positive down
+    float m_liftoffTime;        // The on-board detection re-run on the samples (FlightDetector)
+    float m_landingTime;
+    float m_endTime;            // Last sample, the logger stops at the landing it detected
+};
+
+// Post-flight analysis of Log_N.bin dumps, built on the firmware decoding (LogReader) and detection
+class LogAnalyzer
+{
+public:
+    // A single pass over the samples
+    static FlightAnalysis Analyze(LogFile& log, const DetectorSettings& settings);
+
+    // Analyzes every log on 'numThreads' threads, results go in 'paths' order. Returns the samples read
+    static uint64_t AnalyzeBatch(const char* const* paths, uint32_t numPaths, const DetectorSettings& settings,
+        uint32_t numThreads, FlightAnalysis* results);
+
+    // One row per log
+    static void PrintTable(const char* const* paths, uint32_t numPaths, const FlightAnalysis* results);
+
+    // Command line front end (native build: program analyze ...)
+    static int RunTool(int argc, char** argv);
+};
@@ -0,0 +1,309 @@
+#ifndef ARDUINO
+
+#include "LogConverter.h"
+
+#include "Logger/LogCSV.h"
+
+#include "HAL.h"
+
+#include <chrono>
+#include <vector>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char* const k_logColumnNames[k_numLogColumns] = { "TIME", "ALTITUDE", "TEMP", "TEMP_AGE", "ACCEL_X", "ACCEL_Y", "ACCEL_Z", "RATE_X", "RATE_Y", "RATE_Z" };
+
+// stdio is buffered already, a row (CSVWriter) is a single fwrite
+static const size_t k_outputBufferSize = 1 << 16;
+
+// Print to a FILE
+class FilePrint : public Print
+{
+public:
+    explicit FilePrint(FILE* file)
+        : m_file(file)
+    {
+    }
+
+    size_t write(uint8_t value) override
+    {
+        return fputc(value, m_file) == EOF ? 0 : 1;
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override
+    {
+        return fwrite(buffer, 1, size, m_file);
+    }
+
+    using Print::write;
+
+private:
+    FILE* m_file;
+};
+
+LogFile::LogFile()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_mapping(nullptr)
+    , m_header()
+    , m_storage(nullptr, 0)
+{
+}
+
+LogFile::~LogFile()
+{
+    Close();
+}
+
+bool LogFile::Open(const char* path)
+{
+    Close();
+
+    const int file = open(path, O_RDONLY);
+    if(file < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    if(fstat(file, &info) == 0 && info.st_size > 0 && (uint64_t)info.st_size <= UINT32_MAX)
+    {
+        mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    }
+    close(file); // The mapping keeps the file
+    if(mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    // Read front to back
+    madvise(mapping, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+    if(!Load((const uint8_t*)mapping, (uint32_t)info.st_size))
+    {
+        munmap(mapping, (size_t)info.st_size);
+        return false;
+    }
+    m_mapping = mapping;
+    return true;
+}
+
+bool LogFile::Load(const uint8_t* data, uint32_t size)
+{
+    Close();
+    if(size < sizeof(DumpFileHeader))
+    {
+        return false;
+    }
+
+    // The header isn't aligned to anything in a buffer
+    memcpy(&m_header, data, sizeof(DumpFileHeader));
+    if(m_header.m_magic != k_dumpFileMagic || m_header.m_version != k_dumpFileVersion ||
+        m_header.m_headerSize < sizeof(DumpFileHeader) || m_header.m_headerSize > size ||
+        m_header.m_imageSize > size - m_header.m_headerSize ||
+        m_header.m_logEnd > m_header.m_imageSize)
+    {
+        return false;
+    }
+
+    m_data = data;
+    m_size = size;
+    m_storage = MemoryLogStorage(data + m_header.m_headerSize, m_header.m_imageSize);
+    return true;
+}
+
+void LogFile::Close()
+{
+    if(m_mapping)
+    {
+        munmap(m_mapping, m_size);
+        m_mapping = nullptr;
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_storage = MemoryLogStorage(nullptr, 0);
+}
+
+const DumpFileHeader& LogFile::GetHeader()const
+{
+    return m_header;
+}
+
+LogStorage* LogFile::GetStorage()
+{
+    return &m_storage;
+}
+
+bool LogFile::BeginRead(LogReader& reader)
+{
+    return m_data && reader.Begin(m_header.m_logEnd, m_header.m_numSamples);
+}
+
+uint32_t LogConverter::WriteCSV(LogFile& log, FILE* output)
+{
+    LogReader reader(log.GetStorage());
+    if(!log.BeginRead(reader))
+    {
+        return 0;
+    }
+
+    FilePrint stream(output);
+    WriteCSVHeader(&stream);
+
+    uint32_t numSamples = 0;
+    State state = {};
+    while(reader.Next(state))
+    {
+        WriteCSVState(state, &stream);
+        ++numSamples;
+    }
+
+    LogSummary summary;
+    if(reader.ReadSummary(summary))
+    {
+        WriteCSVSummary(summary, &stream);
+    }
+    return numSamples;
+}
+
+uint32_t LogConverter::WriteColumns(LogFile& log, const char* prefix)
+{
+    LogReader reader(log.GetStorage());
+    if(!log.BeginRead(reader))
+    {
+        return 0;
+    }
+
+    // Gathered in memory, each file is then a single write
+    const uint32_t maxSamples = log.GetHeader().m_numSamples + reader.GetHeader().m_preTriggerCount;
+    std::vector<float> columns[k_numLogColumns];
+    for(std::vector<float>& column : columns)
+    {
+        column.reserve(maxSamples);
+    }
+
+    State state = {};
+    while(reader.Next(state))
+    {
+        const float values[k_numLogColumns] =
+        {
+            state.m_timeStamp, state.m_altitude, state.m_temperature, (float)state.m_temperatureAge,
+            state.m_acceleration.x, state.m_acceleration.y, state.m_acceleration.z,
+            state.m_angularRate.x, state.m_angularRate.y, state.m_angularRate.z,
+        };
+        for(uint8_t columnIdx = 0; columnIdx < k_numLogColumns; ++columnIdx)
+        {
+            columns[columnIdx].push_back(values[columnIdx]);
+        }
+    }
+
+    for(uint8_t columnIdx = 0; columnIdx < k_numLogColumns; ++columnIdx)
+    {
+        char path[512];
+        snprintf(path, sizeof(path), "%s_%s.f32", prefix, k_logColumnNames[columnIdx]);
+        FILE* file = fopen(path, "wb");
+        if(!file)
+        {
+            return 0;
+        }
+        const size_t written = fwrite(columns[columnIdx].data(), sizeof(float), columns[columnIdx].size(), file);
+        fclose(file);
+        if(written != columns[columnIdx].size())
+        {
+            return 0;
+        }
+    }
+    return (uint32_t)columns[0].size();
+}
+
+static void PrintUsage()
+{
+    printf("Usage: program convert [--columns] Log_N.bin ...\n");
+    printf("  Writes Log_N.csv next to each dump, or Log_N_<COLUMN>.f32 (a float per sample) with --columns\n");
+}
+
+int LogConverter::RunTool(int argc, char** argv)
+{
+    bool toColumns = false;
+
+    int argIdx = 0;
+    for(; argIdx < argc && argv[argIdx][0] == '-'; ++argIdx)
+    {
+        if(strcmp(argv[argIdx], "--columns") == 0)
+        {
+            toColumns = true;
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if(argIdx == argc)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    int result = 0;
+    for(; argIdx < argc; ++argIdx)
+    {
+        const char* path = argv[argIdx];
+        const auto wallStart = std::chrono::steady_clock::now();
+
+        LogFile log;
+        if(!log.Open(path))
+        {
+            printf("Can't load %s\n", path);
+            result = 1;
+            continue;
+        }
+
+        // The outputs are named after the dump, without the extension
+        char prefix[480];
+        snprintf(prefix, sizeof(prefix), "%s", path);
+        char* extension = strrchr(prefix, '.');
+        if(extension && !strchr(extension, '/'))
+        {
+            *extension = '\0';
+        }
+
+        uint32_t numSamples = 0;
+        if(toColumns)
+        {
+            numSamples = LogConverter::WriteColumns(log, prefix);
+        }
+        else
+        {
+            char outputPath[512];
+            snprintf(outputPath, sizeof(outputPath), "%s.csv", prefix);
+            FILE* output = fopen(outputPath, "wb");
+            if(output)
+            {
+                setvbuf(output, nullptr, _IOFBF, k_outputBufferSize);
+                numSamples = LogConverter::WriteCSV(log, output);
+                fclose(output);
+            }
+        }
+
+        const double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+        if(numSamples == 0)
+        {
+            printf("%s: nothing converted\n", path);
+            result = 1;
+            continue;
+        }
+        printf("%s: %lu samples (firmware %u.%u) in %.2f ms, %.0f samples/s\n", path, (unsigned long)numSamples,
+            (unsigned)(log.GetHeader().m_firmwareVersion >> 8), (unsigned)(log.GetHeader().m_firmwareVersion & 0xFF),
+            wallTime * 1000.0, wallTime > 0.0 ? numSamples / wallTime : 0.0);
+    }
+    return result;
+}
+
+#endif
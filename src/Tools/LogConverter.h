@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "RMath.h"
+
+#include "Logger/LoggerDefinitions.h"
+#include "Logger/LogReader.h"
+
+// A Log_N.bin the logger dumped (see DumpFileHeader). Files are memory-mapped, nothing is copied
+class LogFile
+{
+public:
+    LogFile();
+
+    ~LogFile();
+
+    LogFile(const LogFile& other) = delete;
+
+    // Returns false if the file can't be mapped or isn't a valid dump
+    bool Open(const char* path);
+
+    // Same as Open over a buffer, it has to stay valid while the LogFile is used
+    bool Load(const uint8_t* data, uint32_t size);
+
+    void Close();
+
+    const DumpFileHeader& GetHeader()const;
+
+    // The segment image, by segment offset (for LogReader)
+    LogStorage* GetStorage();
+
+    // Starts 'reader' (over GetStorage) at the first record
+    bool BeginRead(LogReader& reader);
+
+private:
+    const uint8_t* m_data;
+    uint32_t m_size;
+    void* m_mapping;            // mmap of the file, nullptr for Load
+    DumpFileHeader m_header;
+    MemoryLogStorage m_storage;
+};
+
+// Output columns (WriteColumns), in State order: <prefix>_<NAME>.f32 each, a little endian float per sample
+static const uint8_t k_numLogColumns = 10;
+extern const char* const k_logColumnNames[k_numLogColumns];
+
+// Converts the dumps on the host, the CSV is the same the logger writes with DUMP_CSV
+class LogConverter
+{
+public:
+    // Returns the number of samples written (pre-trigger ones included)
+    static uint32_t WriteCSV(LogFile& log, FILE* output);
+
+    static uint32_t WriteColumns(LogFile& log, const char* prefix);
+
+    // Command line front end (native build: program convert ...)
+    static int RunTool(int argc, char** argv);
+};
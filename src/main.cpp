@@ -1,22 +1,121 @@
-#include <Arduino.h>
+#ifndef PIO_UNIT_TESTING
+
+#include "HAL.h"
 
 #include "Logger/LoggerApp.h"
 
+#ifdef ARDUINO
+
 LoggerApp g_app;
 
-void setup() 
+void setup()
 {
 #ifdef DEBUG_OUTPUT_ENABLED
   Serial.begin(9600);
   while(!Serial) {};
 #endif
 
-  g_app.Init(4);
+  g_app.Init(4, RecordFormat::Compressed);
 
   g_app.RunTest(10.0f);
 }
 
-void loop() 
+void loop()
 {
   g_app.Run();
-}
\ No newline at end of file
+}
+
+#else
+
+// Native env: the logger flies the default synthetic flight on the simulated board and we time it.
+// Usage: program [SD card directory] [samples per second]
+//        program replay ... (detection benchmark, see SimReplay::RunTool)
+//        program timing ... (target loop time breakdown, see SimLoopTiming::RunTool)
+//        program convert ... (Log_N.bin to CSV or columns, see LogConverter::RunTool)
+//        program analyze ... (flight summary of a batch of Log_N.bin, see LogAnalyzer::RunTool)
+//        program catalog ... (logs on a card, see CatalogTool::RunTool)
+
+#include "Sim/SimBoard.h"
+#include "Sim/SimFlight.h"
+#include "Sim/SimLoopTiming.h"
+#include "Sim/SimReplay.h"
+#include "Tools/CatalogTool.h"
+#include "Tools/LogAnalyzer.h"
+#include "Tools/LogConverter.h"
+
+#include <chrono>
+
+int main(int argc, char** argv)
+{
+  if(argc > 1 && strcmp(argv[1], "replay") == 0)
+  {
+    return SimReplay::RunTool(argc - 2, argv + 2);
+  }
+  if(argc > 1 && strcmp(argv[1], "timing") == 0)
+  {
+    return SimLoopTiming::RunTool(argc - 2, argv + 2);
+  }
+  if(argc > 1 && strcmp(argv[1], "convert") == 0)
+  {
+    return LogConverter::RunTool(argc - 2, argv + 2);
+  }
+  if(argc > 1 && strcmp(argv[1], "analyze") == 0)
+  {
+    return LogAnalyzer::RunTool(argc - 2, argv + 2);
+  }
+  if(argc > 1 && strcmp(argv[1], "catalog") == 0)
+  {
+    return CatalogTool::RunTool(argc - 2, argv + 2);
+  }
+
+  const char* sdRoot = argc > 1 ? argv[1] : ".";
+  const int samplesPerSecond = argc > 2 ? atoi(argv[2]) : 100;
+
+  SimFlight flight(GetDefaultFlightProfile());
+  SimBoard board(&flight, sdRoot);
+
+  const auto wallStart = std::chrono::steady_clock::now();
+
+  LoggerApp app;
+  LoggerResult result = app.Init(samplesPerSecond, RecordFormat::Compressed);
+  if(result != LoggerResult::Success)
+  {
+    printf("Init failed (%i)\n", (int)result);
+    return 1;
+  }
+
+  // Give it a minute past the end of the flight to dump the log
+  const uint64_t endTime = (uint64_t)((flight.GetEndTime() + 60.0f) * 1000000.0f);
+  const uint32_t numTasks = SimBoard::Run(app, endTime);
+
+  const double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  const double simTime = (double)SimClock::GetTime() * 0.000001;
+
+  printf("State = %i (%s)\n", (int)app.GetState(), app.GetState() == LoggerState::End ? "done" : "not done");
+  printf("Simulated %.2f s in %.3f s of wall time (%.0fx), %lu tasks\n", simTime, wallTime, wallTime > 0.0 ? simTime / wallTime : 0.0, (unsigned long)numTasks);
+  printf("I2C: %lu transactions, %lu bytes, %.3f s\n", (unsigned long)Wire.GetStats().m_transactions, (unsigned long)Wire.GetStats().m_bytes, (double)Wire.GetStats().m_time * 0.000001);
+  printf("SPI: %lu transactions, %lu bytes, %.3f s\n", (unsigned long)SPI.GetStats().m_transactions, (unsigned long)SPI.GetStats().m_bytes, (double)SPI.GetStats().m_time * 0.000001);
+
+  const DumpStats& dump = app.GetDumpStats();
+  printf("Dump: %lu bytes in %.3f s, %lu KB/s (%s)\n", (unsigned long)dump.m_size, (double)dump.m_time * 0.000001,
+    (unsigned long)GetDumpThroughput(dump), dump.m_contiguous ? "contiguous" : "FAT");
+
+  const JournalStats& journal = app.GetJournalStats();
+  printf("Journal: %lu commits, %lu bytes for %lu log bytes, write amplification %.4f\n", (unsigned long)journal.m_commits,
+    (unsigned long)journal.m_journalBytes, (unsigned long)journal.m_logBytes, (double)GetWriteAmplification(journal));
+
+  // Stats since liftoff (they are reset then)
+  const TaskScheduler& scheduler = app.GetScheduler();
+  for(uint8_t taskIdx = 0; taskIdx < scheduler.GetNumTasks(); ++taskIdx)
+  {
+    const TaskStats& stats = scheduler.GetStats(taskIdx);
+    printf("Task %-8s runs = %6lu, WCET = %5lu us, worst response = %6lu us, misses = %lu\n", scheduler.GetName(taskIdx),
+      (unsigned long)stats.m_runs, (unsigned long)scheduler.GetWorstExecution(taskIdx), (unsigned long)stats.m_worstResponse, (unsigned long)stats.m_deadlineMisses);
+  }
+
+  return app.GetState() == LoggerState::End ? 0 : 1;
+}
+
+#endif
+
+#endif
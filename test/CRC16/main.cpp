@@ -0,0 +1,59 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+
+#include "CRC16.h"
+
+void CRC16_CheckValue()
+{
+    // The catalogued check value of the algorithm
+    const uint8_t data[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, UpdateCRC16(k_crc16Init, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_HEX16(k_crc16Init, UpdateCRC16(k_crc16Init, data, 0));
+}
+
+void CRC16_Pieces()
+{
+    uint8_t data[100];
+    for(uint8_t byteIdx = 0; byteIdx < sizeof(data); ++byteIdx)
+    {
+        data[byteIdx] = (uint8_t)(byteIdx * 37u + 11u);
+    }
+    const uint16_t whole = UpdateCRC16(k_crc16Init, data, sizeof(data));
+
+    uint16_t crc = UpdateCRC16(k_crc16Init, data, 1);
+    crc = UpdateCRC16(crc, data + 1, 62);
+    crc = UpdateCRC16(crc, data + 63, sizeof(data) - 63);
+    TEST_ASSERT_EQUAL_HEX16(whole, crc);
+
+    // A single flipped bit shows
+    data[50] ^= 0x08;
+    TEST_ASSERT_TRUE(UpdateCRC16(k_crc16Init, data, sizeof(data)) != whole);
+}
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(CRC16_CheckValue);
+        RUN_TEST(CRC16_Pieces);
+    }
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup()
+{
+    delay(2000);
+    RunTests();
+}
+
+void loop() { }
+#else
+int main()
+{
+    RunTests();
+    return 0;
+}
+#endif
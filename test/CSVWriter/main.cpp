@@ -0,0 +1,284 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+
+#include "HAL.h"
+#include "CSVWriter.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef ARDUINO
+#include <chrono>
+#endif
+
+// Collects what gets printed, counting the write calls
+class StringPrint : public Print
+{
+public:
+    StringPrint()
+    {
+        Clear();
+    }
+
+    size_t write(uint8_t value) override
+    {
+        return write(&value, 1);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override
+    {
+        ++m_writes;
+        if(m_size + size >= sizeof(m_text))
+        {
+            return 0;
+        }
+        memcpy(m_text + m_size, buffer, size);
+        m_size += size;
+        m_text[m_size] = '\0';
+        return size;
+    }
+
+    void Clear()
+    {
+        m_text[0] = '\0';
+        m_size = 0;
+        m_writes = 0;
+    }
+
+    char m_text[160];
+    size_t m_size;
+    uint32_t m_writes;
+};
+
+static uint32_t g_random = 12345;
+
+static uint32_t NextRandom()
+{
+    g_random = g_random * 1664525ul + 1013904223ul;
+    return g_random;
+}
+
+// Compares FormatFloat with Print::print, returns the number of mismatches
+static uint32_t CountMismatches(float value)
+{
+    uint32_t mismatches = 0;
+    for(uint8_t digits = 0; digits <= k_maxCSVDigits; ++digits)
+    {
+        StringPrint expected;
+        expected.print(value, digits);
+
+        char text[k_maxCSVFloatLength + 1];
+        text[FormatFloat(value, digits, text)] = '\0';
+        if(strcmp(expected.m_text, text) != 0)
+        {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+static void ExpectFloat(const char* expected, float value, uint8_t digits)
+{
+    char text[k_maxCSVFloatLength + 1];
+    text[FormatFloat(value, digits, text)] = '\0';
+    TEST_ASSERT_EQUAL_STRING(expected, text);
+}
+
+void CSVWriter_FormatFloat()
+{
+    ExpectFloat("0.00", 0.0f, 2);
+    ExpectFloat("0.00", -0.0f, 2);
+    ExpectFloat("-0.00", -0.001f, 2);
+    ExpectFloat("1.50", 1.499999f, 2);
+    ExpectFloat("12.346", 12.3456f, 3);
+    ExpectFloat("-273", -273.15f, 0);
+    ExpectFloat("99.9", 99.94f, 1);
+    ExpectFloat("100.0", 99.96f, 1);
+    ExpectFloat("65536.00", 65536.0f, 2);
+    ExpectFloat("4294967040.0", 4294967040.0f, 1);
+    ExpectFloat("ovf", 5000000000.0f, 2);
+    ExpectFloat("ovf", -5000000000.0f, 2);
+    ExpectFloat("inf", -INFINITY, 2);
+    ExpectFloat("nan", NAN, 2);
+
+    // More digits than it does get clamped
+    ExpectFloat("3.142", 3.14159265f, 6);
+}
+
+void CSVWriter_FormatUInt()
+{
+    static const uint32_t values[] = { 0, 7, 10, 99, 65535, 65536, 100000, 4294967295ul };
+    static const char* const expected[] = { "0", "7", "10", "99", "65535", "65536", "100000", "4294967295" };
+    for(uint8_t valueIdx = 0; valueIdx < sizeof(values) / sizeof(values[0]); ++valueIdx)
+    {
+        char text[11];
+        text[FormatUInt(values[valueIdx], text)] = '\0';
+        TEST_ASSERT_EQUAL_STRING(expected[valueIdx], text);
+    }
+}
+
+void CSVWriter_MatchesPrint()
+{
+    uint32_t mismatches = 0;
+
+    // Logged ranges, with the ties of every precision (x.xx5) in the mix
+    for(int32_t value = -200000; value <= 200000; value += 13)
+    {
+        mismatches += CountMismatches((float)value * 0.0005f);
+    }
+
+    // Any float Print::print doesn't overflow on
+    for(uint16_t valueIdx = 0; valueIdx < 20000; ++valueIdx)
+    {
+        const uint32_t bits = NextRandom();
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        if(value > -4294967040.0f && value < 4294967040.0f)
+        {
+            mismatches += CountMismatches(value);
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+}
+
+void CSVWriter_Rows()
+{
+    StringPrint stream;
+    CSVWriter row(&stream);
+    row.AddFloat(1.0f, 3);
+    row.AddFloat(-2.5f, 2);
+    row.AddUInt(3);
+    row.EndRow();
+    TEST_ASSERT_EQUAL_STRING("1.000,-2.50,3\n", stream.m_text);
+    TEST_ASSERT_EQUAL_UINT32(1, stream.m_writes);
+
+    // Rows longer than the buffer still come out right, in more writes
+    stream.Clear();
+    char expected[sizeof(stream.m_text)] = "";
+    for(uint8_t fieldIdx = 0; fieldIdx < 12; ++fieldIdx)
+    {
+        row.AddFloat(-1234567.0f, 2);
+        strcat(expected, fieldIdx == 0 ? "-1234567.00" : ",-1234567.00");
+    }
+    row.EndRow();
+    strcat(expected, "\n");
+    TEST_ASSERT_EQUAL_STRING(expected, stream.m_text);
+    TEST_ASSERT_EQUAL_UINT32(2, stream.m_writes);
+}
+
+// A dumped row of typical values, the way LoggerApp::SerializeState did it before CSVWriter
+static void PrintRow(Print* stream, const float* values, uint8_t numValues)
+{
+    for(uint8_t valueIdx = 0; valueIdx < numValues; ++valueIdx)
+    {
+        stream->print(values[valueIdx]);
+        if(valueIdx + 1u < numValues)
+        {
+            stream->print(',');
+        }
+    }
+    stream->print('\n');
+}
+
+static void WriteRow(Print* stream, const float* values, uint8_t numValues)
+{
+    CSVWriter row(stream);
+    for(uint8_t valueIdx = 0; valueIdx < numValues; ++valueIdx)
+    {
+        row.AddFloat(values[valueIdx], 2);
+    }
+    row.EndRow();
+}
+
+void CSVWriter_Benchmark()
+{
+    // On the host micros() is the SimTiming model of the AVR, on the device it's the real thing
+    static const uint16_t k_numRows = 100;
+    static const float values[] = { 12.345f, 1523.67f, 21.5f, 3.0f, -0.52f, 9.81f, 152.3f, -12.5f, 0.03f, 245.9f };
+    static const uint8_t k_numValues = sizeof(values) / sizeof(values[0]);
+
+    StringPrint stream;
+    uint32_t start = micros();
+    for(uint16_t rowIdx = 0; rowIdx < k_numRows; ++rowIdx)
+    {
+        stream.Clear();
+        PrintRow(&stream, values, k_numValues);
+    }
+    const uint32_t printTime = micros() - start;
+    const uint32_t printWrites = stream.m_writes;
+    char expected[sizeof(stream.m_text)];
+    strcpy(expected, stream.m_text);
+
+    start = micros();
+    for(uint16_t rowIdx = 0; rowIdx < k_numRows; ++rowIdx)
+    {
+        stream.Clear();
+        WriteRow(&stream, values, k_numValues);
+    }
+    const uint32_t writerTime = micros() - start;
+    TEST_ASSERT_EQUAL_STRING(expected, stream.m_text);
+    TEST_ASSERT_EQUAL_UINT32(1, stream.m_writes);
+
+    char message[128];
+    snprintf(message, sizeof(message), "Row: print %lu us (%lu writes), CSVWriter %lu us (1 write)", (unsigned long)(printTime / k_numRows),
+        (unsigned long)printWrites, (unsigned long)(writerTime / k_numRows));
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(writerTime * 3u < printTime);
+
+#ifndef ARDUINO
+    // And what it takes on the host itself
+    static const uint32_t k_numHostRows = 100000;
+    auto wallStart = std::chrono::steady_clock::now();
+    for(uint32_t rowIdx = 0; rowIdx < k_numHostRows; ++rowIdx)
+    {
+        stream.Clear();
+        PrintRow(&stream, values, k_numValues);
+    }
+    const double printWallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    wallStart = std::chrono::steady_clock::now();
+    for(uint32_t rowIdx = 0; rowIdx < k_numHostRows; ++rowIdx)
+    {
+        stream.Clear();
+        WriteRow(&stream, values, k_numValues);
+    }
+    const double writerWallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    snprintf(message, sizeof(message), "Host row: print %.0f ns, CSVWriter %.0f ns", printWallTime * 1e9 / k_numHostRows,
+        writerWallTime * 1e9 / k_numHostRows);
+    TEST_MESSAGE(message);
+#endif
+}
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(CSVWriter_FormatFloat);
+        RUN_TEST(CSVWriter_FormatUInt);
+        RUN_TEST(CSVWriter_MatchesPrint);
+        RUN_TEST(CSVWriter_Rows);
+        RUN_TEST(CSVWriter_Benchmark);
+    }
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup()
+{
+    delay(2000);
+    RunTests();
+}
+
+void loop() { }
+#else
+int main()
+{
+    RunTests();
+    return 0;
+}
+#endif
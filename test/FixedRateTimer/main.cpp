@@ -0,0 +1,122 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+
+#include "FixedRateTimer.h"
+
+void FixedRateTimer_Ticks()
+{
+    FixedRateTimer timer;
+    TimerStats stats;
+    ResetTimerStats(stats);
+    timer.Start(1000, 2500);
+
+    TEST_ASSERT_TRUE(timer.Poll(1000, &stats));
+    TEST_ASSERT_EQUAL_UINT32(0, timer.GetTime());
+    TEST_ASSERT_FALSE(timer.Poll(3499, &stats));
+
+    // A late tick doesn't move the following deadlines
+    TEST_ASSERT_TRUE(timer.Poll(3700, &stats));
+    TEST_ASSERT_FALSE(timer.Poll(5999, &stats));
+    TEST_ASSERT_TRUE(timer.Poll(6000, &stats));
+    TEST_ASSERT_EQUAL_UINT32(5, timer.GetTime());
+
+    TEST_ASSERT_EQUAL_UINT32(3, stats.m_ticks);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.m_overruns);
+    TEST_ASSERT_EQUAL_UINT32(200, stats.m_maxLateness);
+    TEST_ASSERT_EQUAL_UINT32(200, stats.m_totalLateness);
+}
+
+void FixedRateTimer_Overruns()
+{
+    FixedRateTimer timer;
+    TimerStats stats;
+    ResetTimerStats(stats);
+    timer.Start(0, 1000);
+    TEST_ASSERT_TRUE(timer.Poll(0, &stats));
+
+    // Missed the 1000 and 2000 deadlines, we get a single tick for 3000
+    TEST_ASSERT_TRUE(timer.Poll(3100, &stats));
+    TEST_ASSERT_EQUAL_UINT32(3, timer.GetTime());
+    TEST_ASSERT_FALSE(timer.Poll(3999, &stats));
+    TEST_ASSERT_TRUE(timer.Poll(4000, &stats));
+
+    TEST_ASSERT_EQUAL_UINT32(3, stats.m_ticks);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.m_overruns);
+    TEST_ASSERT_EQUAL_UINT32(100, stats.m_maxLateness);
+}
+
+void FixedRateTimer_ExactTimebase()
+{
+    // 333 us periods don't add up exactly in float, the tick time has to
+    // stay in integer microseconds to land on 99900 ms after 300000 ticks
+    FixedRateTimer timer;
+    TimerStats stats;
+    ResetTimerStats(stats);
+    timer.Start(0, 333);
+
+    uint32_t now = 0;
+    for(uint32_t tick = 0; tick <= 300000; ++tick)
+    {
+        TEST_ASSERT_TRUE(timer.Poll(now, &stats));
+        now += 333;
+    }
+    TEST_ASSERT_EQUAL_UINT32(99900, timer.GetTime());
+    TEST_ASSERT_EQUAL_UINT32(0, stats.m_overruns);
+}
+
+void FixedRateTimer_MicrosWrap()
+{
+    FixedRateTimer timer;
+    timer.Start(0xFFFFFF00ul, 1000);
+    TEST_ASSERT_TRUE(timer.Poll(0xFFFFFF00ul));
+    TEST_ASSERT_FALSE(timer.Poll(0xFFFFFFFFul));
+    TEST_ASSERT_FALSE(timer.Poll(0x000002E7ul));
+    TEST_ASSERT_TRUE(timer.Poll(0x000002E8ul));
+    TEST_ASSERT_EQUAL_UINT32(1, timer.GetTime());
+}
+
+void FixedRateTimer_SetPeriod()
+{
+    FixedRateTimer timer;
+    timer.Start(0, 25000);
+    TEST_ASSERT_TRUE(timer.Poll(0));
+
+    // The new period counts from the last tick
+    timer.SetPeriod(2000);
+    TEST_ASSERT_FALSE(timer.Poll(1999));
+    TEST_ASSERT_TRUE(timer.Poll(2000));
+    TEST_ASSERT_EQUAL_UINT32(2, timer.GetTime());
+    TEST_ASSERT_TRUE(timer.Poll(4000));
+    TEST_ASSERT_EQUAL_UINT32(4, timer.GetTime());
+}
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(FixedRateTimer_Ticks);
+        RUN_TEST(FixedRateTimer_Overruns);
+        RUN_TEST(FixedRateTimer_ExactTimebase);
+        RUN_TEST(FixedRateTimer_MicrosWrap);
+        RUN_TEST(FixedRateTimer_SetPeriod);
+    }
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup()
+{
+    delay(2000);
+    RunTests();
+}
+
+void loop() { }
+#else
+int main()
+{
+    RunTests();
+    return 0;
+}
+#endif
@@ -0,0 +1,136 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+
+#include "Logger/FlightDetector.h"
+
+static DetectorSettings GetSettings(float apogeeDrop)
+{
+    DetectorSettings settings;
+    settings.m_liftoffClimb = 0.5f;
+    settings.m_liftoffAcceleration = 20.0f;
+    settings.m_landingBand = 10.0f;
+    settings.m_landingAcceleration = 10.0f;
+    settings.m_landingStillBand = 0.3f;
+    settings.m_apogeeDrop = apogeeDrop;
+    return settings;
+}
+
+static State MakeState(float time, float altitude, float accelerationY)
+{
+    State state = {};
+    state.m_timeStamp = time;
+    state.m_altitude = altitude;
+    state.m_acceleration.y = accelerationY;
+    return state;
+}
+
+// A slow coast close to the pad: ~0 G and the altitude repeats between barometer conversions.
+// Returns the sample the landing was detected on, -1 if it never was
+static int CoastAndLand(FlightDetector& detector)
+{
+    detector.BeginFlight(MakeState(0.0f, 100.0f, 3.0f));
+
+    int sampleIdx = 0;
+    for(; sampleIdx < 40; ++sampleIdx)
+    {
+        const float altitude = 100.0f + (sampleIdx / 4) * 0.2f;
+        if(detector.CheckLanding(MakeState(0.1f * (sampleIdx + 1), altitude, 0.0f)))
+        {
+            return sampleIdx;
+        }
+    }
+
+    // Back down on the pad, resting at 1 G
+    for(; sampleIdx < 80; ++sampleIdx)
+    {
+        const float drop = (sampleIdx - 40) * 0.5f;
+        const float altitude = drop < 1.8f ? 101.8f - drop : 100.0f;
+        if(detector.CheckLanding(MakeState(0.1f * (sampleIdx + 1), altitude, 1.0f)))
+        {
+            return sampleIdx;
+        }
+    }
+    return -1;
+}
+
+void FlightDetector_CoastIsNotLanding()
+{
+    // Without the apogee drop the coast already looks like a landing
+    FlightDetector unguarded;
+    unguarded.SetSettings(GetSettings(0.0f));
+    const int unguardedLanding = CoastAndLand(unguarded);
+    TEST_ASSERT_TRUE(unguardedLanding >= 0 && unguardedLanding < 40);
+
+    FlightDetector detector;
+    detector.SetSettings(GetSettings(1.0f));
+    const int landing = CoastAndLand(detector);
+    TEST_ASSERT_TRUE(landing >= 44 && landing < 80);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.8f, detector.GetApogee());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.1f * (landing + 1), detector.GetFlightTime());
+}
+
+void FlightDetector_Liftoff()
+{
+    FlightDetector detector;
+    detector.SetSettings(GetSettings(1.0f));
+
+    const State pad = MakeState(0.0f, 100.0f, 1.0f);
+    TEST_ASSERT_FALSE(detector.CheckLiftoff(MakeState(0.1f, 100.2f, 1.0f), pad));
+    TEST_ASSERT_FALSE(detector.CheckLiftoff(MakeState(0.1f, 101.0f, 1.0f), pad));
+    TEST_ASSERT_FALSE(detector.CheckLiftoff(MakeState(0.1f, 100.2f, 5.0f), pad));
+    TEST_ASSERT_TRUE(detector.CheckLiftoff(MakeState(0.1f, 101.0f, 5.0f), pad));
+}
+
+void FlightDetector_ScaledUnits()
+{
+    // Same flight in counts (50 per m) and LSB (16384 per G), the scaled thresholds give the same answers
+    const float altitudeScale = 50.0f;
+    const float accelerationScale = 16384.0f;
+    FlightDetector detector;
+    detector.SetSettings(FlightDetector::ScaleSettings(GetSettings(1.0f), altitudeScale, accelerationScale));
+
+    const State pad = MakeState(0.0f, 100.0f * altitudeScale, accelerationScale);
+    TEST_ASSERT_FALSE(detector.CheckLiftoff(MakeState(0.1f, 100.2f * altitudeScale, accelerationScale), pad));
+    TEST_ASSERT_FALSE(detector.CheckLiftoff(MakeState(0.1f, 100.2f * altitudeScale, 5.0f * accelerationScale), pad));
+    TEST_ASSERT_TRUE(detector.CheckLiftoff(MakeState(0.1f, 101.0f * altitudeScale, 5.0f * accelerationScale), pad));
+
+    detector.BeginFlight(MakeState(0.0f, 100.0f * altitudeScale, 3.0f * accelerationScale));
+    TEST_ASSERT_FALSE(detector.CheckLanding(MakeState(1.0f, 150.0f * altitudeScale, 0.0f)));
+    TEST_ASSERT_FALSE(detector.CheckLanding(MakeState(2.0f, 149.5f * altitudeScale, 0.0f)));
+    bool landed = false;
+    for(int sampleIdx = 0; sampleIdx < 10 && !landed; ++sampleIdx)
+    {
+        landed = detector.CheckLanding(MakeState(3.0f + 0.1f * sampleIdx, 100.0f * altitudeScale, accelerationScale));
+    }
+    TEST_ASSERT_TRUE(landed);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 50.0f, detector.GetApogee() / altitudeScale);
+}
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(FlightDetector_CoastIsNotLanding);
+        RUN_TEST(FlightDetector_Liftoff);
+        RUN_TEST(FlightDetector_ScaledUnits);
+    }
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup()
+{
+    delay(2000);
+    RunTests();
+}
+
+void loop() { }
+#else
+int main()
+{
+    RunTests();
+    return 0;
+}
+#endif
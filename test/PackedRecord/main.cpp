@@ -0,0 +1,143 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+
+#include "BitStream.h"
+#include "Logger/PackedRecord.h"
+
+State MakeState(float time)
+{
+    State state = {};
+    state.m_timeStamp = time;
+    state.m_altitude = 123.45f;
+    state.m_temperature = -12.34f;
+    state.m_temperatureAge = 7;
+    state.m_acceleration.x = 1.5f;
+    state.m_acceleration.y = -0.25f;
+    state.m_acceleration.z = 15.9f;
+    state.m_angularRate.x = 1200.0f;
+    state.m_angularRate.y = -32768.0f;
+    state.m_angularRate.z = 0.0f;
+    return state;
+}
+
+void BitStream_RoundTrip()
+{
+    uint8_t buffer[8];
+    BitWriter writer(buffer, sizeof(buffer));
+    TEST_ASSERT_TRUE(writer.Write(5, 3));
+    TEST_ASSERT_TRUE(writer.WriteSigned(-1000, 17));
+    TEST_ASSERT_TRUE(writer.Write(0xDEADBEEF, 32));
+    TEST_ASSERT_EQUAL_UINT16(52, writer.GetBitCount());
+    TEST_ASSERT_FALSE(writer.Write(0, 13)); // Doesn't fit
+
+    BitReader reader(buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL_UINT32(5, reader.Read(3));
+    TEST_ASSERT_EQUAL_INT32(-1000, reader.ReadSigned(17));
+    TEST_ASSERT_EQUAL_UINT32(0xDEADBEEF, reader.Read(32));
+}
+
+void PackedRecord_Size()
+{
+    TEST_ASSERT_EQUAL_UINT16(159, GetPackedRecordBits());
+    TEST_ASSERT_EQUAL_UINT8(20, k_packedRecordSize);
+}
+
+void PackedRecord_PackExtremes()
+{
+    int32_t channels[k_numPackedChannels];
+    for(uint8_t channel = 0; channel < k_numPackedChannels; ++channel)
+    {
+        const uint8_t bits = k_packedChannelBits[channel];
+        channels[channel] = k_packedChannelSigned[channel] ? (channel % 2 ? GetSignedMin(bits) : GetSignedMax(bits)) : (int32_t)((1ul << bits) - 1);
+    }
+
+    uint8_t record[k_packedRecordSize];
+    PackedRecordCodec::Pack(channels, record);
+
+    int32_t unpacked[k_numPackedChannels];
+    PackedRecordCodec::Unpack(record, unpacked);
+    for(uint8_t channel = 0; channel < k_numPackedChannels; ++channel)
+    {
+        TEST_ASSERT_EQUAL_INT32(channels[channel], unpacked[channel]);
+    }
+}
+
+void PackedRecord_RoundTrip()
+{
+    PackedRecordCodec encoder;
+    PackedRecordCodec decoder;
+    encoder.Reset(1000, 16.0f);
+    decoder.Reset(1000, 16.0f);
+
+    uint8_t record[k_packedRecordSize];
+    for(uint8_t sampleIdx = 0; sampleIdx < 10; ++sampleIdx)
+    {
+        const State state = MakeState(1.0f + sampleIdx * 0.01f);
+        encoder.Encode(state, record);
+
+        State decoded;
+        decoder.Decode(record, decoded);
+
+        TEST_ASSERT_FLOAT_WITHIN(0.0005f, state.m_timeStamp, decoded.m_timeStamp);
+        TEST_ASSERT_FLOAT_WITHIN(0.005f, state.m_altitude, decoded.m_altitude);
+        TEST_ASSERT_FLOAT_WITHIN(0.005f, state.m_temperature, decoded.m_temperature);
+        TEST_ASSERT_EQUAL_UINT8(state.m_temperatureAge, decoded.m_temperatureAge);
+        TEST_ASSERT_FLOAT_WITHIN(16.0f / 32767.0f, state.m_acceleration.x, decoded.m_acceleration.x);
+        TEST_ASSERT_FLOAT_WITHIN(16.0f / 32767.0f, state.m_acceleration.y, decoded.m_acceleration.y);
+        TEST_ASSERT_FLOAT_WITHIN(16.0f / 32767.0f, state.m_acceleration.z, decoded.m_acceleration.z);
+        TEST_ASSERT_EQUAL_FLOAT(state.m_angularRate.x, decoded.m_angularRate.x);
+        TEST_ASSERT_EQUAL_FLOAT(state.m_angularRate.y, decoded.m_angularRate.y);
+        TEST_ASSERT_EQUAL_FLOAT(state.m_angularRate.z, decoded.m_angularRate.z);
+    }
+}
+
+void PackedRecord_Saturates()
+{
+    PackedRecordCodec codec;
+    codec.Reset(0, 2.0f);
+
+    State state = MakeState(0.0f);
+    state.m_altitude = 100000.0f; // Above the 24 bit range in cm
+    state.m_acceleration.x = 5.0f; // Above the +-2G range
+
+    int32_t channels[k_numPackedChannels];
+    codec.Quantize(state, channels);
+    TEST_ASSERT_EQUAL_INT32(GetSignedMax(24), channels[(uint8_t)PackedChannel::Altitude]);
+    TEST_ASSERT_EQUAL_INT32(GetSignedMax(16), channels[(uint8_t)PackedChannel::AccelX]);
+
+    // A long gap gets clamped, following deltas stay consistent with the decoder
+    state.m_timeStamp = 100.0f;
+    codec.Quantize(state, channels);
+    TEST_ASSERT_EQUAL_INT32(65535, channels[(uint8_t)PackedChannel::TimeDelta]);
+}
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(BitStream_RoundTrip);
+        RUN_TEST(PackedRecord_Size);
+        RUN_TEST(PackedRecord_PackExtremes);
+        RUN_TEST(PackedRecord_RoundTrip);
+        RUN_TEST(PackedRecord_Saturates);
+    }
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup()
+{
+    delay(2000);
+    RunTests();
+}
+
+void loop() { }
+#else
+int main()
+{
+    RunTests();
+    return 0;
+}
+#endif
@@ -0,0 +1,130 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+
+#include "HAL.h"
+#include "Debug/Profiler.h"
+
+#include <string.h>
+
+// Collects what gets printed
+class StringPrint : public Print
+{
+public:
+    StringPrint()
+        : m_size(0)
+    {
+        m_text[0] = '\0';
+    }
+
+    size_t write(uint8_t value) override
+    {
+        if(m_size + 1u >= sizeof(m_text))
+        {
+            return 0;
+        }
+        m_text[m_size++] = (char)value;
+        m_text[m_size] = '\0';
+        return 1;
+    }
+
+    char m_text[256];
+    size_t m_size;
+};
+
+void Profiler_Buckets()
+{
+    TEST_ASSERT_EQUAL_UINT8(0, Profiler::GetBucket(0));
+    TEST_ASSERT_EQUAL_UINT8(0, Profiler::GetBucket(1));
+    TEST_ASSERT_EQUAL_UINT8(1, Profiler::GetBucket(2));
+    TEST_ASSERT_EQUAL_UINT8(1, Profiler::GetBucket(3));
+    TEST_ASSERT_EQUAL_UINT8(10, Profiler::GetBucket(1024));
+    TEST_ASSERT_EQUAL_UINT8(10, Profiler::GetBucket(2047));
+    TEST_ASSERT_EQUAL_UINT8(k_profileBuckets - 1, Profiler::GetBucket(32768));
+    TEST_ASSERT_EQUAL_UINT8(k_profileBuckets - 1, Profiler::GetBucket(10000000));
+}
+
+void Profiler_Stats()
+{
+    Profiler::Reset();
+    Profiler::Add(1, 100);
+    Profiler::Add(1, 300);
+    Profiler::Add(1, 80);
+    Profiler::Add(1, 100000); // Saturates min/max, not the total
+
+    const ProfileStats& stats = Profiler::GetStats(1);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.m_count);
+    TEST_ASSERT_EQUAL_UINT32(100480, stats.m_total);
+    TEST_ASSERT_EQUAL_UINT16(80, stats.m_min);
+    TEST_ASSERT_EQUAL_UINT16(0xFFFF, stats.m_max);
+    TEST_ASSERT_EQUAL_UINT8(2, stats.m_buckets[6]); // 64 to 127
+    TEST_ASSERT_EQUAL_UINT8(1, stats.m_buckets[8]); // 256 to 511
+    TEST_ASSERT_EQUAL_UINT8(1, stats.m_buckets[k_profileBuckets - 1]);
+
+    // Other stages are untouched, out of range ones are ignored
+    Profiler::Add(k_maxProfileStages, 10);
+    TEST_ASSERT_EQUAL_UINT32(0, Profiler::GetStats(0).m_count);
+}
+
+void Profiler_Halving()
+{
+    Profiler::Reset();
+    for(uint16_t sampleIdx = 0; sampleIdx < 255; ++sampleIdx)
+    {
+        Profiler::Add(0, 10);
+    }
+    Profiler::Add(0, 1000);
+
+    // The next one doesn't fit in the bucket, all of them get halved first
+    Profiler::Add(0, 10);
+    const ProfileStats& stats = Profiler::GetStats(0);
+    TEST_ASSERT_EQUAL_UINT32(257, stats.m_count);
+    TEST_ASSERT_EQUAL_UINT8(128, stats.m_buckets[3]);
+    TEST_ASSERT_EQUAL_UINT8(0, stats.m_buckets[9]);
+}
+
+void Profiler_Write()
+{
+    Profiler::Reset();
+    Profiler::Add(0, 5);
+    Profiler::Add(0, 7);
+
+    static const char* const names[] = { "A", "B" };
+    StringPrint stream;
+    Profiler::Write(&stream, names, 2);
+
+    const char* expected =
+        "STAGE,COUNT,MIN_US,MEAN_US,MAX_US,0,2,4,8,16,32,64,128,256,512,1024,2048,4096,8192,16384,32768\n"
+        "A,2,5,6,7,0,0,2,0,0,0,0,0,0,0,0,0,0,0,0,0\n"
+        "B,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0\n";
+    TEST_ASSERT_EQUAL_STRING(expected, stream.m_text);
+}
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(Profiler_Buckets);
+        RUN_TEST(Profiler_Stats);
+        RUN_TEST(Profiler_Halving);
+        RUN_TEST(Profiler_Write);
+    }
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup()
+{
+    delay(2000);
+    RunTests();
+}
+
+void loop() { }
+#else
+int main()
+{
+    RunTests();
+    return 0;
+}
+#endif
@@ -0,0 +1,207 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <atomic>
+#include <thread>
+#endif
+#include <unity.h>
+
+#include "SPSCQueue.h"
+
+void SPSCQueue_PushPop()
+{
+    SPSCQueue<uint16_t, 4> queue;
+    uint16_t value = 0;
+    TEST_ASSERT_FALSE(queue.Pop(value));
+
+    TEST_ASSERT_TRUE(queue.Push(1));
+    TEST_ASSERT_TRUE(queue.Push(2));
+    TEST_ASSERT_EQUAL_UINT8(2, queue.GetSize());
+
+    TEST_ASSERT_TRUE(queue.Pop(value));
+    TEST_ASSERT_EQUAL_UINT16(1, value);
+    TEST_ASSERT_TRUE(queue.Pop(value));
+    TEST_ASSERT_EQUAL_UINT16(2, value);
+    TEST_ASSERT_FALSE(queue.Pop(value));
+}
+
+void SPSCQueue_Overflow()
+{
+    SPSCQueue<uint16_t, 4> queue;
+    for(uint16_t item = 0; item < 6; ++item)
+    {
+        queue.Push(item);
+    }
+    TEST_ASSERT_EQUAL_UINT8(4, queue.GetSize());
+    TEST_ASSERT_EQUAL_UINT32(2, queue.GetOverflows());
+
+    // The newest items are the ones dropped
+    uint16_t value = 0;
+    for(uint16_t item = 0; item < 4; ++item)
+    {
+        TEST_ASSERT_TRUE(queue.Pop(value));
+        TEST_ASSERT_EQUAL_UINT16(item, value);
+    }
+}
+
+void SPSCQueue_IndexWrap()
+{
+    // Indices are a byte, go around them a few times
+    SPSCQueue<uint32_t, 128> queue;
+    uint32_t value = 0;
+    for(uint32_t item = 0; item < 1000; ++item)
+    {
+        TEST_ASSERT_TRUE(queue.Push(item));
+        TEST_ASSERT_TRUE(queue.Push(item + 1000000u));
+        TEST_ASSERT_TRUE(queue.Pop(value));
+        TEST_ASSERT_TRUE(queue.Pop(value));
+    }
+
+    for(uint32_t item = 0; item < 128; ++item)
+    {
+        TEST_ASSERT_TRUE(queue.Push(item));
+    }
+    TEST_ASSERT_FALSE(queue.Push(0));
+    TEST_ASSERT_EQUAL_UINT8(128, queue.GetSize());
+}
+
+#ifndef ARDUINO
+struct StressRecord
+{
+    uint32_t m_sequence;
+    uint32_t m_check;
+    uint8_t m_payload[16];
+};
+
+// Producer and consumer on their own threads, every record has to arrive once, in order and intact
+void SPSCQueue_ThreadStress()
+{
+    static const uint32_t k_numRecords = 200000;
+    static SPSCQueue<StressRecord, 8> queue;
+
+    std::thread producer([]()
+    {
+        StressRecord record;
+        for(uint32_t sequence = 0; sequence < k_numRecords; ++sequence)
+        {
+            record.m_sequence = sequence;
+            record.m_check = ~sequence;
+            for(uint8_t byteIdx = 0; byteIdx < sizeof(record.m_payload); ++byteIdx)
+            {
+                record.m_payload[byteIdx] = (uint8_t)(sequence + byteIdx);
+            }
+
+            // Spin until there is room, nothing can be lost
+            while(!queue.Push(record))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t expected = 0;
+    uint32_t errors = 0;
+    StressRecord record;
+    while(expected < k_numRecords)
+    {
+        if(!queue.Pop(record))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        bool valid = record.m_sequence == expected && record.m_check == ~expected;
+        for(uint8_t byteIdx = 0; byteIdx < sizeof(record.m_payload); ++byteIdx)
+        {
+            valid = valid && record.m_payload[byteIdx] == (uint8_t)(expected + byteIdx);
+        }
+        errors += valid ? 0 : 1;
+        ++expected;
+    }
+
+    producer.join();
+
+    StressRecord extra;
+    TEST_ASSERT_FALSE(queue.Pop(extra));
+    TEST_ASSERT_EQUAL_UINT32(0, errors);
+}
+
+// Same as above but the producer never waits (like an ISR), what doesn't arrive has to be in the overflow count
+void SPSCQueue_ThreadOverflowAccounting()
+{
+    static const uint32_t k_numRecords = 200000;
+    static SPSCQueue<StressRecord, 4> queue;
+    static std::atomic<bool> producerDone(false);
+
+    std::thread producer([]()
+    {
+        StressRecord record = {};
+        for(uint32_t sequence = 0; sequence < k_numRecords; ++sequence)
+        {
+            record.m_sequence = sequence;
+            record.m_check = ~sequence;
+            queue.Push(record);
+        }
+        producerDone = true;
+    });
+
+    uint32_t received = 0;
+    uint32_t errors = 0;
+    uint32_t lastSequence = 0;
+    StressRecord record;
+    while(true)
+    {
+        const bool done = producerDone;
+        if(!queue.Pop(record))
+        {
+            if(done)
+            {
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Records can be dropped but never reordered or torn
+        errors += (received > 0 && record.m_sequence <= lastSequence) || record.m_check != ~record.m_sequence ? 1 : 0;
+        lastSequence = record.m_sequence;
+        ++received;
+    }
+
+    producer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, errors);
+    TEST_ASSERT_EQUAL_UINT32(k_numRecords, received + queue.GetOverflows());
+}
+#endif
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(SPSCQueue_PushPop);
+        RUN_TEST(SPSCQueue_Overflow);
+        RUN_TEST(SPSCQueue_IndexWrap);
+#ifndef ARDUINO
+        RUN_TEST(SPSCQueue_ThreadStress);
+        RUN_TEST(SPSCQueue_ThreadOverflowAccounting);
+#endif
+    }
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup()
+{
+    delay(2000);
+    RunTests();
+}
+
+void loop() { }
+#else
+int main()
+{
+    RunTests();
+    return 0;
+}
+#endif
@@ -0,0 +1,145 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+
+#include "Logger/SamplingPlanner.h"
+
+StageCosts MakeCosts()
+{
+    StageCosts costs;
+    costs.m_imuRead = 500;
+    costs.m_imuFIFORead = 300;
+    costs.m_imuFIFOSample = 100;
+    costs.m_imuConvert = 100;
+    costs.m_baroConversion = 400;
+    costs.m_baroCompute = 1000;
+    costs.m_record = 200;
+    costs.m_storageBlock = 128; // 2us per byte
+    return costs;
+}
+
+SamplingRequest MakeRequest(uint16_t samplesPerSecond)
+{
+    SamplingRequest request;
+    request.m_samplesPerSecond = samplesPerSecond;
+    request.m_idleSamplesPerSecond = 40;
+    request.m_recordSize = 32;
+    request.m_storageCapacity = 32000;
+    request.m_maxLoad = 0.7f;
+    request.m_baroOSR = OSR::OSR_4096;
+    request.m_tempDecimation = 8;
+    request.m_baroMaxPeriods = 2;
+    request.m_imuFIFO = false;
+    request.m_imuFIFOODR = AccODR::ODR_1600_HZ;
+    request.m_imuFIFOMaxBatch = 16;
+    return request;
+}
+
+void SamplingPlanner_Default()
+{
+    SamplingPlan plan;
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)LoggerResult::Success, (uint8_t)PlanSampling(MakeRequest(100), MakeCosts(), plan));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)OSR::OSR_4096, (uint8_t)plan.m_baroOSR);
+    TEST_ASSERT_EQUAL_UINT8(8, plan.m_tempDecimation);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)AccODR::ODR_100_HZ, (uint8_t)plan.m_imuODR);
+    TEST_ASSERT_EQUAL_UINT8(0, plan.m_imuFIFOBatch);
+    TEST_ASSERT_EQUAL_UINT16(100, plan.m_recordsPerSecond);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.229f, plan.m_load);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 10.0f, plan.m_flightTime);
+
+    // The load allows 645Hz but a tick with a new pressure takes 2314us
+    TEST_ASSERT_UINT_WITHIN(1, 432, plan.m_maxSamplesPerSecond);
+}
+
+void SamplingPlanner_Barometer()
+{
+    SamplingPlan plan;
+
+    // OSR_4096 with a temperature every 8 pressures is 10170us, every 16 fits in two 5ms periods
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)LoggerResult::Success, (uint8_t)PlanSampling(MakeRequest(200), MakeCosts(), plan));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)OSR::OSR_4096, (uint8_t)plan.m_baroOSR);
+    TEST_ASSERT_EQUAL_UINT8(16, plan.m_tempDecimation);
+
+    // Only OSR_1024 fits in two 2ms periods (free stages so the CPU doesn't get in the way)
+    const StageCosts costs = {};
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)LoggerResult::Success, (uint8_t)PlanSampling(MakeRequest(500), costs, plan));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)OSR::OSR_1024, (uint8_t)plan.m_baroOSR);
+    TEST_ASSERT_EQUAL_UINT8(8, plan.m_tempDecimation);
+}
+
+void SamplingPlanner_IMUODR()
+{
+    SamplingPlan plan;
+
+    // Idle sampling sets the lowest ODR
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)LoggerResult::Success, (uint8_t)PlanSampling(MakeRequest(10), MakeCosts(), plan));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)AccODR::ODR_50_HZ, (uint8_t)plan.m_imuODR);
+
+    StageCosts costs = {};
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)LoggerResult::Success, (uint8_t)PlanSampling(MakeRequest(1600), costs, plan));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)AccODR::ODR_1600_HZ, (uint8_t)plan.m_imuODR);
+
+    // The IMU doesn't go any faster
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)LoggerResult::InfeasibleSamplingRate, (uint8_t)PlanSampling(MakeRequest(2000), costs, plan));
+}
+
+void SamplingPlanner_FIFO()
+{
+    SamplingRequest request = MakeRequest(100);
+    request.m_imuFIFO = true;
+
+    // 1600Hz needs 17 samples per batch (one spare)
+    SamplingPlan plan;
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)LoggerResult::Success, (uint8_t)PlanSampling(request, MakeCosts(), plan));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)AccODR::ODR_800_HZ, (uint8_t)plan.m_imuODR);
+    TEST_ASSERT_EQUAL_UINT8(9, plan.m_imuFIFOBatch);
+    TEST_ASSERT_EQUAL_UINT16(800, plan.m_recordsPerSecond);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.25f, plan.m_flightTime);
+
+    // Storing 800 records per second takes 55% of the CPU
+    request.m_maxLoad = 0.5f;
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)LoggerResult::Success, (uint8_t)PlanSampling(request, MakeCosts(), plan));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)AccODR::ODR_400_HZ, (uint8_t)plan.m_imuODR);
+    TEST_ASSERT_EQUAL_UINT8(5, plan.m_imuFIFOBatch);
+}
+
+void SamplingPlanner_Infeasible()
+{
+    // The barometer alone takes 57% of the CPU at OSR_1024
+    SamplingPlan plan;
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)LoggerResult::InfeasibleSamplingRate, (uint8_t)PlanSampling(MakeRequest(500), MakeCosts(), plan));
+    TEST_ASSERT_TRUE(plan.m_load > 0.7f);
+    TEST_ASSERT_UINT_WITHIN(1, 155, plan.m_maxSamplesPerSecond);
+
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)LoggerResult::InfeasibleSamplingRate, (uint8_t)PlanSampling(MakeRequest(0), MakeCosts(), plan));
+}
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(SamplingPlanner_Default);
+        RUN_TEST(SamplingPlanner_Barometer);
+        RUN_TEST(SamplingPlanner_IMUODR);
+        RUN_TEST(SamplingPlanner_FIFO);
+        RUN_TEST(SamplingPlanner_Infeasible);
+    }
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup()
+{
+    delay(2000);
+    RunTests();
+}
+
+void loop() { }
+#else
+int main()
+{
+    RunTests();
+    return 0;
+}
+#endif
@@ -0,0 +1,294 @@
+#include <unity.h>
+
+#include "HAL.h"
+#include "Sim/SimBoard.h"
+#include "Sim/SimFlight.h"
+#include "Logger/FRAMDirectory.h"
+#include "Storage/MB85RS2MTA/MB85RS2MTA.h"
+
+// Host only, the directory on the simulated FRAM
+
+// Fills a segment with bytes that depend on the offset and 'seed'
+static void FillSegment(SimFRAM& fram, const FRAMSegment& segment, uint8_t seed)
+{
+    for(uint32_t offset = 0; offset < segment.m_size; ++offset)
+    {
+        fram.GetData()[segment.m_start + offset] = (uint8_t)(offset * 13u + seed);
+    }
+}
+
+static bool CheckSegment(SimFRAM& fram, const FRAMSegment& segment, uint8_t seed)
+{
+    for(uint32_t offset = 0; offset < segment.m_size; ++offset)
+    {
+        if(fram.GetData()[segment.m_start + offset] != (uint8_t)(offset * 13u + seed))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Allocates a segment and trims it to 'size' bytes, like a finished flight
+static void AddSegment(FRAMDirectory& directory, SimFRAM& fram, uint32_t size, uint8_t seed)
+{
+    uint8_t index = 0;
+    FRAMSegment segment;
+    TEST_ASSERT_TRUE(directory.Allocate(size, index, segment));
+    TEST_ASSERT_TRUE(segment.m_state == FRAMSegmentState::Recording);
+    TEST_ASSERT_EQUAL_UINT32(SimFRAM::k_capacity, segment.m_start + segment.m_size);
+
+    segment.m_size = size;
+    segment.m_logEnd = size - 1;
+    segment.m_state = FRAMSegmentState::Recorded;
+    directory.WriteSegment(index, segment);
+    FillSegment(fram, segment, seed);
+}
+
+void SimFRAMDirectory_Load()
+{
+    SimFlight flight(GetDefaultFlightProfile());
+    SimBoard board(&flight);
+
+    MB85RS2MTA fram;
+    TEST_ASSERT_TRUE(fram.Init(SimBoard::k_framChipSelect, &SPI));
+
+    // A blank FRAM gets an empty directory, it's there on the next boot
+    FRAMDirectory directory;
+    TEST_ASSERT_FALSE(directory.Load(&fram));
+    TEST_ASSERT_EQUAL_UINT8(0, directory.GetNumSegments());
+    TEST_ASSERT_EQUAL_UINT32(SimFRAM::k_capacity - FRAMDirectory::k_dataStart, directory.GetFreeSpace());
+    AddSegment(directory, board.GetFRAM(), 1000, 1);
+
+    FRAMDirectory reloaded;
+    TEST_ASSERT_TRUE(reloaded.Load(&fram));
+    TEST_ASSERT_EQUAL_UINT8(1, reloaded.GetNumSegments());
+    FRAMSegment segment;
+    TEST_ASSERT_TRUE(reloaded.ReadSegment(0, segment));
+    TEST_ASSERT_EQUAL_UINT32(FRAMDirectory::k_dataStart, segment.m_start);
+    TEST_ASSERT_EQUAL_UINT32(1000, segment.m_size);
+    TEST_ASSERT_FALSE(reloaded.ReadSegment(1, segment));
+}
+
+void SimFRAMDirectory_Compact()
+{
+    SimFlight flight(GetDefaultFlightProfile());
+    SimBoard board(&flight);
+
+    MB85RS2MTA fram;
+    TEST_ASSERT_TRUE(fram.Init(SimBoard::k_framChipSelect, &SPI));
+    FRAMDirectory directory;
+    directory.Load(&fram);
+
+    const uint32_t sizes[3] = { 100000, 60000, 50000 };
+    for(uint8_t segmentIdx = 0; segmentIdx < 3; ++segmentIdx)
+    {
+        AddSegment(directory, board.GetFRAM(), sizes[segmentIdx], segmentIdx);
+    }
+    const uint32_t freeSpace = directory.GetFreeSpace();
+    TEST_ASSERT_EQUAL_UINT32(SimFRAM::k_capacity - FRAMDirectory::k_dataStart - 210000, freeSpace);
+
+    // Freeing leaves a gap, the last segment doesn't move
+    FRAMSegment last;
+    directory.ReadSegment(2, last);
+    directory.Free(0);
+    TEST_ASSERT_EQUAL_UINT8(2, directory.GetNumSegments());
+    TEST_ASSERT_EQUAL_UINT32(freeSpace, directory.GetFreeSpace());
+    FRAMSegment moved;
+    TEST_ASSERT_TRUE(directory.ReadSegment(1, moved));
+    TEST_ASSERT_EQUAL_UINT32(last.m_start, moved.m_start);
+
+    // There isn't room after the last one, the others move down to make it
+    uint8_t index = 0;
+    FRAMSegment segment;
+    TEST_ASSERT_TRUE(directory.Allocate(freeSpace + 1, index, segment));
+    TEST_ASSERT_EQUAL_UINT8(2, index);
+    TEST_ASSERT_EQUAL_UINT32(FRAMDirectory::k_dataStart + 110000, segment.m_start);
+    TEST_ASSERT_EQUAL_UINT32(0, board.GetFRAM().GetRejectedWrites());
+
+    for(uint8_t segmentIdx = 0; segmentIdx < 2; ++segmentIdx)
+    {
+        TEST_ASSERT_TRUE(directory.ReadSegment(segmentIdx, segment));
+        TEST_ASSERT_EQUAL_UINT32(sizes[segmentIdx + 1], segment.m_size);
+        TEST_ASSERT_TRUE(CheckSegment(board.GetFRAM(), segment, segmentIdx + 1));
+    }
+
+    // Not even compacting makes room for this one
+    directory.Free(2);
+    TEST_ASSERT_FALSE(directory.Allocate(SimFRAM::k_capacity, index, segment));
+    TEST_ASSERT_EQUAL_UINT8(2, directory.GetNumSegments());
+}
+
+// Two segments after a 'gap' byte one, the next Allocate has to move both down over themselves
+static void AddGap(FRAMDirectory& directory, SimFRAM& fram, uint32_t gap, const uint32_t* sizes)
+{
+    AddSegment(directory, fram, gap, 0);
+    for(uint8_t segmentIdx = 0; segmentIdx < 2; ++segmentIdx)
+    {
+        AddSegment(directory, fram, sizes[segmentIdx], segmentIdx + 1);
+    }
+    directory.Free(0);
+}
+
+// Cuts the power every few bytes of the Compact an Allocate does, then boots again
+static void CheckPowerLossCompact(SimFRAM& simFRAM, MB85RS2MTA& fram, uint32_t gap)
+{
+    // The bytes a whole Compact (and the new slot) writes
+    const uint32_t sizes[2] = { 60000, 50000 };
+    const uint32_t minSize = SimFRAM::k_capacity - FRAMDirectory::k_dataStart - 110000;
+    uint32_t compactBytes = 0;
+    {
+        simFRAM.Fill(0xFF);
+        FRAMDirectory directory;
+        directory.Load(&fram);
+        AddGap(directory, simFRAM, gap, sizes);
+        const uint32_t writtenBytes = simFRAM.GetWrittenBytes();
+        uint8_t index = 0;
+        FRAMSegment segment;
+        TEST_ASSERT_TRUE(directory.Allocate(minSize, index, segment));
+        compactBytes = simFRAM.GetWrittenBytes() - writtenBytes;
+        TEST_ASSERT_TRUE(compactBytes > 110000);
+    }
+
+    // The power goes anywhere in it: in a chunk, in a progress write, between the copy and the slot. The next boot
+    // finds both flights whole and the next Allocate still makes room
+    for(uint32_t cut = 0; cut < compactBytes; cut += 997)
+    {
+        simFRAM.Fill(0xFF);
+        {
+            FRAMDirectory directory;
+            directory.Load(&fram);
+            AddGap(directory, simFRAM, gap, sizes);
+            simFRAM.CutPowerAfter(cut);
+            uint8_t index = 0;
+            FRAMSegment segment;
+            directory.Allocate(minSize, index, segment);
+            simFRAM.RestorePower();
+        }
+
+        FRAMDirectory rebooted;
+        TEST_ASSERT_TRUE(rebooted.Load(&fram));
+        TEST_ASSERT_TRUE(rebooted.GetNumSegments() >= 2);
+        FRAMSegment segment;
+        for(uint8_t segmentIdx = 0; segmentIdx < 2; ++segmentIdx)
+        {
+            TEST_ASSERT_TRUE(rebooted.ReadSegment(segmentIdx, segment));
+            TEST_ASSERT_EQUAL_UINT32(sizes[segmentIdx], segment.m_size);
+            TEST_ASSERT_TRUE(CheckSegment(simFRAM, segment, segmentIdx + 1));
+        }
+        if(rebooted.GetNumSegments() > 2)
+        {
+            rebooted.Free(2);
+        }
+
+        uint8_t index = 0;
+        TEST_ASSERT_TRUE(rebooted.Allocate(minSize, index, segment));
+        TEST_ASSERT_EQUAL_UINT32(FRAMDirectory::k_dataStart + 110000, segment.m_start);
+        for(uint8_t segmentIdx = 0; segmentIdx < 2; ++segmentIdx)
+        {
+            TEST_ASSERT_TRUE(rebooted.ReadSegment(segmentIdx, segment));
+            TEST_ASSERT_TRUE(CheckSegment(simFRAM, segment, segmentIdx + 1));
+        }
+    }
+}
+
+void SimFRAMDirectory_PowerLossCompact()
+{
+    SimFlight flight(GetDefaultFlightProfile());
+    SimBoard board(&flight);
+
+    MB85RS2MTA fram;
+    TEST_ASSERT_TRUE(fram.Init(SimBoard::k_framChipSelect, &SPI));
+
+    // A gap shorter than a copy chunk too, the chunks get shorter so they don't overwrite their own source
+    CheckPowerLossCompact(board.GetFRAM(), fram, 1000);
+    CheckPowerLossCompact(board.GetFRAM(), fram, 40);
+    TEST_ASSERT_EQUAL_UINT32(0, board.GetFRAM().GetRejectedWrites());
+}
+
+void SimFRAMDirectory_Slots()
+{
+    SimFlight flight(GetDefaultFlightProfile());
+    SimBoard board(&flight);
+
+    MB85RS2MTA fram;
+    TEST_ASSERT_TRUE(fram.Init(SimBoard::k_framChipSelect, &SPI));
+    FRAMDirectory directory;
+    directory.Load(&fram);
+
+    for(uint8_t segmentIdx = 0; segmentIdx < k_maxFRAMSegments; ++segmentIdx)
+    {
+        AddSegment(directory, board.GetFRAM(), 100, segmentIdx);
+    }
+
+    uint8_t index = 0;
+    FRAMSegment segment;
+    TEST_ASSERT_FALSE(directory.Allocate(100, index, segment));
+
+    directory.Free(3);
+    TEST_ASSERT_TRUE(directory.Allocate(100, index, segment));
+    TEST_ASSERT_EQUAL_UINT8(k_maxFRAMSegments - 1, index);
+}
+
+void SimFRAMDirectory_Journal()
+{
+    SimFlight flight(GetDefaultFlightProfile());
+    SimBoard board(&flight);
+
+    MB85RS2MTA fram;
+    TEST_ASSERT_TRUE(fram.Init(SimBoard::k_framChipSelect, &SPI));
+    FRAMDirectory directory;
+    directory.Load(&fram);
+
+    uint8_t index = 0;
+    FRAMSegment segment;
+    FlightJournal journal;
+    TEST_ASSERT_TRUE(directory.Allocate(1000, index, segment));
+    TEST_ASSERT_FALSE(directory.ReadJournal(journal));
+
+    // The latest commit wins, a single write each
+    SPI.ResetStats();
+    directory.Commit(100, 0);
+    directory.Commit(612, 128);
+    directory.Commit(1124, 256);
+    TEST_ASSERT_EQUAL_UINT32(3 * (1 + 1 + 3 + sizeof(FlightJournal)), SPI.GetStats().m_bytes);
+    TEST_ASSERT_TRUE(directory.ReadJournal(journal));
+    TEST_ASSERT_EQUAL_UINT32(1124, journal.m_logEnd);
+    TEST_ASSERT_EQUAL_UINT32(256, journal.m_numSamples);
+
+    // A torn write leaves the previous commit
+    board.GetFRAM().GetData()[FRAMDirectory::k_journalAddress + sizeof(FlightJournal) + 6] ^= 0x40;
+    TEST_ASSERT_TRUE(directory.ReadJournal(journal));
+    TEST_ASSERT_EQUAL_UINT32(612, journal.m_logEnd);
+    TEST_ASSERT_EQUAL_UINT32(128, journal.m_numSamples);
+
+    // Another boot finds it, the next segment starts without one
+    FRAMDirectory reloaded;
+    TEST_ASSERT_TRUE(reloaded.Load(&fram));
+    TEST_ASSERT_TRUE(reloaded.ReadJournal(journal));
+    TEST_ASSERT_EQUAL_UINT32(612, journal.m_logEnd);
+    segment.m_size = journal.m_logEnd;
+    segment.m_state = FRAMSegmentState::Recorded;
+    reloaded.WriteSegment(0, segment);
+    TEST_ASSERT_TRUE(reloaded.Allocate(1000, index, segment));
+    TEST_ASSERT_FALSE(reloaded.ReadJournal(journal));
+}
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(SimFRAMDirectory_Load);
+        RUN_TEST(SimFRAMDirectory_Compact);
+        RUN_TEST(SimFRAMDirectory_PowerLossCompact);
+        RUN_TEST(SimFRAMDirectory_Slots);
+        RUN_TEST(SimFRAMDirectory_Journal);
+    }
+    UNITY_END();
+}
+
+int main()
+{
+    RunTests();
+    return 0;
+}
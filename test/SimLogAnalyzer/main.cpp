@@ -0,0 +1,145 @@
+#include <unity.h>
+
+#include <chrono>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "HAL.h"
+#include "Sim/SimFlight.h"
+#include "Sim/SimReplay.h"
+#include "Logger/LoggerApp.h"
+#include "Tools/LogAnalyzer.h"
+#include "Tools/LogConverter.h"
+
+// Host only, the logger dumps simulated flights to a temporary directory and the analysis reads them back
+
+static char g_sdRoot[] = "/tmp/RLoggerAnalyzerXXXXXX";
+
+static const uint8_t k_numFlights = 4;
+
+// Flies a flight with the dump on, it goes to the next free Log_N.bin
+static void DumpFlight(SimWorld* world)
+{
+    ReplaySettings settings = GetDefaultReplaySettings();
+    settings.m_dump = true;
+    settings.m_sdRoot = g_sdRoot;
+    TEST_ASSERT_TRUE(SimReplay::Fly(world, settings).m_landingDetected);
+}
+
+static void GetLogPath(uint8_t logIdx, char* path, size_t size)
+{
+    snprintf(path, size, "%s/Log_%u.bin", g_sdRoot, (unsigned)logIdx);
+}
+
+void SimLogAnalyzer_Flight()
+{
+    const SimFlightProfile profile = GetDefaultFlightProfile();
+    SimFlight flight(profile);
+    DumpFlight(&flight);
+
+    char path[64];
+    GetLogPath(0, path, sizeof(path));
+    LogFile log;
+    TEST_ASSERT_TRUE(log.Open(path));
+    const FlightAnalysis analysis = LogAnalyzer::Analyze(log, LoggerApp::GetDefaultDetectorSettings());
+
+    TEST_ASSERT_TRUE(analysis.m_valid);
+    TEST_ASSERT_TRUE(analysis.m_samples > log.GetHeader().m_numSamples);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, flight.GetApogeeHeight(), analysis.m_apogee);
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, profile.m_descentRate, analysis.m_descentRate);
+
+    // The IMU saturates (2G) while boosting, the burn is timed from where the acceleration went up
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 2.0f, analysis.m_maxAcceleration);
+    TEST_ASSERT_TRUE(analysis.m_liftoffTime > 0.0f && analysis.m_liftoffTime < analysis.m_burnoutTime);
+    TEST_ASSERT_TRUE(analysis.m_burnoutTime - analysis.m_liftoffTime < profile.m_boostTime);
+    TEST_ASSERT_TRUE(analysis.m_burnoutTime < analysis.m_apogeeTime);
+
+    // The re-run detection lands where the logger stopped
+    TEST_ASSERT_EQUAL_FLOAT(analysis.m_endTime, analysis.m_landingTime);
+}
+
+void SimLogAnalyzer_Batch()
+{
+    SimRandom random(7u);
+    for(uint8_t flightIdx = 1; flightIdx < k_numFlights; ++flightIdx)
+    {
+        SimFlight flight(GetRandomFlightProfile(random));
+        DumpFlight(&flight);
+    }
+
+    char paths[k_numFlights + 1][64];
+    const char* pathList[k_numFlights + 1];
+    for(uint8_t logIdx = 0; logIdx <= k_numFlights; ++logIdx)
+    {
+        GetLogPath(logIdx, paths[logIdx], sizeof(paths[logIdx]));
+        pathList[logIdx] = paths[logIdx];
+    }
+
+    // The last one isn't there
+    const DetectorSettings settings = LoggerApp::GetDefaultDetectorSettings();
+    FlightAnalysis serial[k_numFlights + 1];
+    const uint64_t numSamples = LogAnalyzer::AnalyzeBatch(pathList, k_numFlights + 1, settings, 1, serial);
+    TEST_ASSERT_FALSE(serial[k_numFlights].m_valid);
+
+    // Same results whatever the number of threads, in the same order
+    static const uint8_t k_numRuns = 20;
+    FlightAnalysis parallel[k_numFlights + 1];
+    const auto wallStart = std::chrono::steady_clock::now();
+    for(uint8_t runIdx = 0; runIdx < k_numRuns; ++runIdx)
+    {
+        TEST_ASSERT_TRUE(LogAnalyzer::AnalyzeBatch(pathList, k_numFlights + 1, settings, 4, parallel) == numSamples);
+    }
+    const double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    for(uint8_t logIdx = 0; logIdx < k_numFlights; ++logIdx)
+    {
+        TEST_ASSERT_TRUE(parallel[logIdx].m_valid);
+        TEST_ASSERT_EQUAL_UINT32(serial[logIdx].m_samples, parallel[logIdx].m_samples);
+        TEST_ASSERT_EQUAL_FLOAT(serial[logIdx].m_apogee, parallel[logIdx].m_apogee);
+        TEST_ASSERT_EQUAL_FLOAT(serial[logIdx].m_descentRate, parallel[logIdx].m_descentRate);
+        TEST_ASSERT_EQUAL_FLOAT(serial[logIdx].m_landingTime, parallel[logIdx].m_landingTime);
+        TEST_ASSERT_TRUE(parallel[logIdx].m_landingTime > 0.0f);
+    }
+
+    char message[128];
+    snprintf(message, sizeof(message), "%lu samples in %.2f ms on 4 threads, %.0f samples/s", (unsigned long)(numSamples * k_numRuns),
+        wallTime * 1000.0, wallTime > 0.0 ? numSamples * k_numRuns / wallTime : 0.0);
+    TEST_MESSAGE(message);
+
+    for(uint8_t logIdx = 0; logIdx < k_numFlights; ++logIdx)
+    {
+        remove(paths[logIdx]);
+    }
+}
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(SimLogAnalyzer_Flight);
+        RUN_TEST(SimLogAnalyzer_Batch);
+    }
+    UNITY_END();
+}
+
+int main()
+{
+    if(!mkdtemp(g_sdRoot))
+    {
+        return 1;
+    }
+
+    RunTests();
+
+    // The profiler output and the catalog go next to the logs
+    char path[64];
+    snprintf(path, sizeof(path), "%s/PROFILE.csv", g_sdRoot);
+    remove(path);
+    snprintf(path, sizeof(path), "%s/CATALOG.BIN", g_sdRoot);
+    remove(path);
+    rmdir(g_sdRoot);
+    return 0;
+}
@@ -0,0 +1,471 @@
+#include <unity.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "HAL.h"
+#include "Sim/SimBoard.h"
+#include "Sim/SimFlight.h"
+#include "Native/SimFileSystem.h"
+#include "Logger/LoggerApp.h"
+#include "Logger/LogCatalog.h"
+#include "Logger/FRAMDirectory.h"
+#include "Storage/MB85RS2MTA/MB85RS2MTA.h"
+#include "Storage/SD/SDCard.h"
+#include "Tools/LogConverter.h"
+
+// Host only, the whole logger flies the synthetic flight on the simulated board and dumps to a temporary directory
+
+static char g_sdRoot[] = "/tmp/RLoggerXXXXXX";
+
+struct FlightResult
+{
+    LoggerState m_state;
+    uint32_t m_rejectedWrites; // FRAM
+    char* m_csv;               // Dumped log converted to CSV (malloc'd, null terminated), nullptr if there is none
+    uint32_t m_imageSize;      // Log_0.bin
+    char* m_profile;           // PROFILE.csv, same as above
+    DumpStats m_dump;
+    JournalStats m_journal;
+};
+
+// Reads and removes a file of the SD card, the text is malloc'd (nullptr if the file isn't there)
+static char* TakeFile(const char* name, uint32_t* fileSize = nullptr)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "%s/%s", g_sdRoot, name);
+    FILE* file = fopen(path, "rb");
+    if(!file)
+    {
+        return nullptr;
+    }
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* text = (char*)malloc(size + 1);
+    const size_t readSize = fread(text, 1, size, file);
+    text[readSize] = '\0';
+    if(fileSize)
+    {
+        *fileSize = (uint32_t)readSize;
+    }
+    fclose(file);
+    remove(path);
+    return text;
+}
+
+// The convert tool output for a Log_N.bin (malloc'd, nullptr if it isn't valid). Frees the image
+static char* ConvertImage(char* image, uint32_t imageSize)
+{
+    LogFile log;
+    char* csv = nullptr;
+    if(image && log.Load((const uint8_t*)image, imageSize))
+    {
+        size_t csvSize = 0;
+        FILE* output = open_memstream(&csv, &csvSize);
+        LogConverter::WriteCSV(log, output);
+        fclose(output);
+    }
+    free(image);
+    return csv;
+}
+
+// Longest step between the TIME of consecutive rows, -1 if time goes back somewhere
+static float GetMaxTimeStep(const char* csv)
+{
+    float previous = 0.0f;
+    float longest = 0.0f;
+    bool hasPrevious = false;
+    for(const char* line = strchr(csv, '\n'); line; line = strchr(line, '\n'))
+    {
+        ++line;
+        if(*line == '\0' || *line == '#')
+        {
+            break;
+        }
+
+        const float time = strtof(line, nullptr);
+        if(hasPrevious)
+        {
+            if(time < previous)
+            {
+                return -1.0f;
+            }
+            longest = max(longest, time - previous);
+        }
+        previous = time;
+        hasPrevious = true;
+    }
+    return longest;
+}
+
+static FlightResult Fly(const SimFlightProfile& profile, int samplesPerSecond, RecordFormat format)
+{
+    FlightResult result = { LoggerState::Error, 0, nullptr, 0, nullptr, DumpStats(), JournalStats() };
+
+    SimFlight flight(profile);
+    SimBoard board(&flight, g_sdRoot);
+
+    LoggerApp app;
+    if(app.Init(samplesPerSecond, format) != LoggerResult::Success)
+    {
+        return result;
+    }
+
+    SimBoard::Run(app, (uint64_t)((flight.GetEndTime() + 60.0f) * 1000000.0f));
+    result.m_state = app.GetState();
+    result.m_rejectedWrites = board.GetFRAM().GetRejectedWrites();
+    result.m_dump = app.GetDumpStats();
+    result.m_journal = app.GetJournalStats();
+    char* image = TakeFile("Log_0.bin", &result.m_imageSize);
+    result.m_csv = ConvertImage(image, result.m_imageSize);
+    result.m_profile = TakeFile("PROFILE.csv");
+    free(TakeFile("CATALOG.BIN")); // Every flight starts with a blank card
+    return result;
+}
+
+// Highest ALTITUDE (second column) minus the first one, and the TIME it was reached at
+static float GetMaxHeight(const char* csv, float* apogeeTime = nullptr)
+{
+    float first = 0.0f;
+    float highest = -1000.0f;
+    bool hasFirst = false;
+    for(const char* line = strchr(csv, '\n'); line; line = strchr(line, '\n'))
+    {
+        ++line;
+        if(*line == '\0' || *line == '#')
+        {
+            break;
+        }
+
+        const char* separator = strchr(line, ',');
+        const float altitude = separator ? strtof(separator + 1, nullptr) : 0.0f;
+        if(!hasFirst)
+        {
+            first = altitude;
+            hasFirst = true;
+        }
+        if(altitude > highest)
+        {
+            highest = altitude;
+            if(apogeeTime)
+            {
+                *apogeeTime = strtof(line, nullptr);
+            }
+        }
+    }
+    return highest - first;
+}
+
+void SimLogger_Flight(RecordFormat format)
+{
+    const SimFlightProfile profile = GetDefaultFlightProfile();
+    SimFlight flight(profile);
+
+    FlightResult result = Fly(profile, 100, format);
+    TEST_ASSERT_TRUE(result.m_state == LoggerState::End);
+    TEST_ASSERT_EQUAL_UINT32(0, result.m_rejectedWrites);
+    TEST_ASSERT_TRUE(result.m_csv != nullptr);
+
+    const char* csv = result.m_csv;
+
+    // The pre-trigger part starts on the pad and the summary follows the records
+    TEST_ASSERT_TRUE(strncmp(csv, "TIME, ALTITUDE", 14) == 0);
+    TEST_ASSERT_TRUE(strstr(csv, "# SAMPLES=") != nullptr);
+    TEST_ASSERT_TRUE(strstr(csv, "OVERRUNS=0,") != nullptr);
+    float apogeeTime = 0.0f;
+    TEST_ASSERT_FLOAT_WITHIN(2.0f, flight.GetApogeeHeight(), GetMaxHeight(csv, &apogeeTime));
+
+    // The time base of the pre-trigger ring is recovered when reading, the log keeps the flight's time (the sampling
+    // timer starts after Init, ~0.3s in). No gap or step back where the ring meets the active log either (the Idle period is 25ms)
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, flight.GetApogeeTime(), apogeeTime);
+    const float maxTimeStep = GetMaxTimeStep(csv);
+    TEST_ASSERT_TRUE(maxTimeStep > 0.0f && maxTimeStep < 0.03f);
+
+    // The FRAM image streamed to a contiguous file, smaller than the CSV even with Float records
+    TEST_ASSERT_TRUE(result.m_dump.m_contiguous);
+    TEST_ASSERT_EQUAL_UINT32(result.m_imageSize, result.m_dump.m_size);
+    TEST_ASSERT_TRUE(result.m_imageSize < strlen(csv));
+    TEST_ASSERT_TRUE(GetDumpThroughput(result.m_dump) > 0);
+
+    // The power loss journal was committed all along for a few extra bytes
+    TEST_ASSERT_TRUE(result.m_journal.m_commits > 2);
+    TEST_ASSERT_TRUE(result.m_journal.m_logBytes > 0);
+    TEST_ASSERT_TRUE(GetWriteAmplification(result.m_journal) < 1.05f);
+
+#ifdef PROFILER_ENABLED
+    // A row per stage, all of them ran while Active (or dumping)
+    TEST_ASSERT_TRUE(result.m_profile != nullptr);
+    TEST_ASSERT_TRUE(strncmp(result.m_profile, "STAGE,COUNT,", 12) == 0);
+    for(const char* stage : { "\nBARO,", "\nALTITUDE,", "\nIMU,", "\nENCODE,", "\nFRAM,", "\nDETECTOR,", "\nDUMP," })
+    {
+        const char* row = strstr(result.m_profile, stage);
+        TEST_ASSERT_TRUE(row != nullptr);
+        TEST_ASSERT_TRUE(atoi(strchr(row + 1, ',') + 1) > 0);
+    }
+#else
+    TEST_ASSERT_TRUE(result.m_profile == nullptr);
+#endif
+
+    free(result.m_csv);
+    free(result.m_profile);
+}
+
+void SimLogger_FlightFloat()
+{
+    SimLogger_Flight(RecordFormat::Float);
+}
+
+void SimLogger_FlightCompressed()
+{
+    SimLogger_Flight(RecordFormat::Compressed);
+}
+
+void SimLogger_Catalog()
+{
+    // A log of the firmware before the catalog, the new ones go after it
+    char path[64];
+    snprintf(path, sizeof(path), "%s/Log_0.csv", g_sdRoot);
+    fclose(fopen(path, "w"));
+
+    const SimFlightProfile profile = GetDefaultFlightProfile();
+    for(uint8_t flightIdx = 0; flightIdx < 2; ++flightIdx)
+    {
+        SimFlight flight(profile);
+        SimBoard board(&flight, g_sdRoot);
+        LoggerApp app;
+        TEST_ASSERT_TRUE(app.Init(100, RecordFormat::Compressed) == LoggerResult::Success);
+        SimBoard::Run(app, (uint64_t)((flight.GetEndTime() + 60.0f) * 1000000.0f));
+        TEST_ASSERT_TRUE(app.GetState() == LoggerState::End);
+    }
+
+    SDCard sd;
+    TEST_ASSERT_TRUE(sd.Init(SimBoard::k_sdChipSelect));
+    LogCatalog catalog;
+    TEST_ASSERT_TRUE(catalog.Load(&sd));
+    TEST_ASSERT_EQUAL_UINT32(2, catalog.GetNumEntries());
+
+    // The summaries are there without opening the logs
+    SimFlight flight(profile);
+    for(uint32_t entryIdx = 0; entryIdx < 2; ++entryIdx)
+    {
+        CatalogEntry entry;
+        TEST_ASSERT_TRUE(catalog.ReadEntry(entryIdx, entry));
+        TEST_ASSERT_EQUAL_UINT32(entryIdx + 1, entry.m_sequence);
+        TEST_ASSERT_TRUE((entry.m_flags & (k_catalogLanded | k_catalogContiguous | k_catalogCSV)) == (k_catalogLanded | k_catalogContiguous));
+        TEST_ASSERT_EQUAL_UINT16(100, entry.m_samplesPerSecond);
+        TEST_ASSERT_TRUE(entry.m_recordFormat == RecordFormat::Compressed);
+        TEST_ASSERT_FLOAT_WITHIN(2.0f, flight.GetApogeeHeight(), entry.m_apogee);
+        TEST_ASSERT_TRUE(entry.m_numSamples > 0);
+
+        char name[k_maxLogNameLength];
+        LogCatalog::GetLogName(entry.m_sequence, "bin", name);
+        uint32_t fileSize = 0;
+        free(TakeFile(name, &fileSize));
+        TEST_ASSERT_EQUAL_UINT32(fileSize, entry.m_fileSize);
+    }
+    CatalogEntry entry;
+    TEST_ASSERT_FALSE(catalog.ReadEntry(2, entry));
+
+    // The next one is taken right away
+    uint32_t sequence = 0;
+    TEST_ASSERT_TRUE(catalog.Reserve(sequence));
+    TEST_ASSERT_EQUAL_UINT32(3, sequence);
+
+    remove(path);
+    free(TakeFile("CATALOG.BIN"));
+    free(TakeFile("PROFILE.csv"));
+}
+
+// Pulls the card once the logger starts dumping
+static bool PullCard(void* context)
+{
+    LoggerApp* app = static_cast<LoggerApp*>(context);
+    if(app->GetState() == LoggerState::Dump)
+    {
+        SimFileSystem::SetRoot("/nonexistent");
+    }
+    return true;
+}
+
+void SimLogger_FailedDump()
+{
+    const SimFlightProfile profile = GetDefaultFlightProfile();
+    uint8_t* fram = new uint8_t[SimFRAM::k_capacity];
+
+    // The dump fails, the flight stays in the FRAM through the power cycle
+    {
+        SimFlight flight(profile);
+        SimBoard board(&flight, g_sdRoot);
+        LoggerApp app;
+        TEST_ASSERT_TRUE(app.Init(100, RecordFormat::Compressed) == LoggerResult::Success);
+        SimBoard::Run(app, (uint64_t)((flight.GetEndTime() + 60.0f) * 1000000.0f), PullCard, &app);
+        TEST_ASSERT_TRUE(app.GetState() == LoggerState::Error);
+        TEST_ASSERT_EQUAL_UINT8(0, app.GetDumpStats().m_numLogs);
+        memcpy(fram, board.GetFRAM().GetData(), SimFRAM::k_capacity);
+    }
+
+    // The next flight goes after it, both are dumped in one batch and freed
+    SimFlight flight(profile);
+    SimBoard board(&flight, g_sdRoot);
+    memcpy(board.GetFRAM().GetData(), fram, SimFRAM::k_capacity);
+    delete[] fram;
+
+    LoggerApp app;
+    TEST_ASSERT_TRUE(app.Init(100, RecordFormat::Compressed) == LoggerResult::Success);
+    SimBoard::Run(app, (uint64_t)((flight.GetEndTime() + 60.0f) * 1000000.0f));
+    TEST_ASSERT_TRUE(app.GetState() == LoggerState::End);
+    TEST_ASSERT_EQUAL_UINT8(2, app.GetDumpStats().m_numLogs);
+
+    MB85RS2MTA framDriver;
+    TEST_ASSERT_TRUE(framDriver.Init(SimBoard::k_framChipSelect, &SPI));
+    FRAMDirectory directory;
+    TEST_ASSERT_TRUE(directory.Load(&framDriver));
+    TEST_ASSERT_EQUAL_UINT8(0, directory.GetNumSegments());
+
+    // Same flight twice, the older one first
+    char* csv[2] = {};
+    for(uint32_t sequence = 0; sequence < 2; ++sequence)
+    {
+        char name[k_maxLogNameLength];
+        LogCatalog::GetLogName(sequence, "bin", name);
+        uint32_t imageSize = 0;
+        char* image = TakeFile(name, &imageSize);
+        csv[sequence] = ConvertImage(image, imageSize);
+        TEST_ASSERT_TRUE(csv[sequence] != nullptr);
+        TEST_ASSERT_FLOAT_WITHIN(2.0f, flight.GetApogeeHeight(), GetMaxHeight(csv[sequence]));
+    }
+    TEST_ASSERT_TRUE(strstr(csv[0], "# SAMPLES=") != nullptr);
+    TEST_ASSERT_TRUE(strstr(csv[1], "# SAMPLES=") != nullptr);
+    free(csv[0]);
+    free(csv[1]);
+
+    free(TakeFile("CATALOG.BIN"));
+    free(TakeFile("PROFILE.csv"));
+}
+
+void SimLogger_MalformedDump()
+{
+    uint8_t file[sizeof(DumpFileHeader) + 64] = {};
+    DumpFileHeader header = {};
+    header.m_magic = k_dumpFileMagic;
+    header.m_version = k_dumpFileVersion;
+    header.m_headerSize = sizeof(DumpFileHeader);
+    header.m_imageSize = 64;
+    memcpy(file, &header, sizeof(header));
+
+    LogFile log;
+    TEST_ASSERT_TRUE(log.Load(file, sizeof(file)));
+
+    // The image doesn't fit in the file
+    header.m_imageSize = 65;
+    memcpy(file, &header, sizeof(header));
+    TEST_ASSERT_FALSE(log.Load(file, sizeof(file)));
+
+    // Header past the end of the file, the space left for the image can't underflow
+    header.m_headerSize = 255;
+    header.m_imageSize = 100000;
+    memcpy(file, &header, sizeof(header));
+    TEST_ASSERT_FALSE(log.Load(file, sizeof(DumpFileHeader)));
+    TEST_ASSERT_FALSE(log.Load(file, sizeof(file)));
+
+    // Shorter than the header
+    header.m_headerSize = sizeof(DumpFileHeader);
+    header.m_imageSize = 0;
+    memcpy(file, &header, sizeof(header));
+    TEST_ASSERT_FALSE(log.Load(file, sizeof(DumpFileHeader) - 1));
+}
+
+// Cuts the power (stops the run) two seconds past apogee
+static bool CutPower(void* context)
+{
+    const SimFlight* flight = static_cast<const SimFlight*>(context);
+    return SimClock::GetTime() < (uint64_t)((flight->GetApogeeTime() + 2.0f) * 1000000.0f);
+}
+
+void SimLogger_PowerLoss()
+{
+    const SimFlightProfile profile = GetDefaultFlightProfile();
+    uint8_t* fram = new uint8_t[SimFRAM::k_capacity];
+    {
+        SimFlight flight(profile);
+        SimBoard board(&flight, g_sdRoot);
+        LoggerApp app;
+        TEST_ASSERT_TRUE(app.Init(100, RecordFormat::Packed) == LoggerResult::Success);
+        SimBoard::Run(app, (uint64_t)((flight.GetEndTime() + 60.0f) * 1000000.0f), CutPower, &flight);
+        TEST_ASSERT_TRUE(app.GetState() == LoggerState::Active);
+        TEST_ASSERT_TRUE(app.GetJournalStats().m_commits > 1);
+        memcpy(fram, board.GetFRAM().GetData(), SimFRAM::k_capacity);
+    }
+
+    // Init finds it and dumps what was committed before anything else
+    SimFlight flight(profile);
+    SimBoard board(&flight, g_sdRoot);
+    memcpy(board.GetFRAM().GetData(), fram, SimFRAM::k_capacity);
+    delete[] fram;
+
+    LoggerApp app;
+    TEST_ASSERT_TRUE(app.Init(100, RecordFormat::Packed) == LoggerResult::Success);
+    TEST_ASSERT_EQUAL_UINT8(1, app.GetDumpStats().m_numLogs);
+
+    // Up to the last commit, the pre-trigger part and apogee are there. It was never finished, there's no summary
+    uint32_t imageSize = 0;
+    char* image = TakeFile("Log_0.bin", &imageSize);
+    char* csv = ConvertImage(image, imageSize);
+    TEST_ASSERT_TRUE(csv != nullptr);
+    TEST_ASSERT_FLOAT_WITHIN(2.0f, flight.GetApogeeHeight(), GetMaxHeight(csv));
+    TEST_ASSERT_TRUE(strstr(csv, "# SAMPLES=") == nullptr);
+    free(csv);
+
+    SDCard sd;
+    TEST_ASSERT_TRUE(sd.Init(SimBoard::k_sdChipSelect));
+    LogCatalog catalog;
+    TEST_ASSERT_TRUE(catalog.Load(&sd));
+    CatalogEntry entry;
+    TEST_ASSERT_TRUE(catalog.ReadEntry(0, entry));
+    TEST_ASSERT_TRUE((entry.m_flags & (k_catalogRecovered | k_catalogLanded)) == k_catalogRecovered);
+    TEST_ASSERT_TRUE(entry.m_numSamples > 0);
+
+    free(TakeFile("CATALOG.BIN"));
+}
+
+void SimLogger_SamplingPlan()
+{
+    SimFlight flight(GetDefaultFlightProfile());
+    SimBoard board(&flight, g_sdRoot);
+
+    // The stage costs come from the timing model, at 100kHz I2C the loop can't sample at 1kHz
+    LoggerApp app;
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)LoggerResult::InfeasibleSamplingRate, (uint8_t)app.Init(1000, RecordFormat::Compressed));
+    TEST_ASSERT_TRUE(app.GetSamplingPlan().m_load > 1.0f);
+    TEST_ASSERT_TRUE(app.GetSamplingPlan().m_maxSamplesPerSecond < 1000);
+}
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(SimLogger_FlightFloat);
+        RUN_TEST(SimLogger_FlightCompressed);
+        RUN_TEST(SimLogger_Catalog);
+        RUN_TEST(SimLogger_FailedDump);
+        RUN_TEST(SimLogger_MalformedDump);
+        RUN_TEST(SimLogger_PowerLoss);
+        RUN_TEST(SimLogger_SamplingPlan);
+    }
+    UNITY_END();
+}
+
+int main()
+{
+    if(!mkdtemp(g_sdRoot))
+    {
+        return 1;
+    }
+
+    RunTests();
+
+    rmdir(g_sdRoot);
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <unity.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "HAL.h"
+#include "Sim/SimFlight.h"
+#include "Sim/SimLogReplay.h"
+#include "Sim/SimReplay.h"
+
+// Host only, see SimReplay
+
+void SimReplay_SyntheticFlight()
+{
+    SimFlight flight(GetDefaultFlightProfile());
+    const ReplayResult result = SimReplay::Fly(&flight, GetDefaultReplaySettings());
+
+    TEST_ASSERT_TRUE(result.m_initialized);
+    TEST_ASSERT_TRUE(result.m_liftoffDetected);
+    TEST_ASSERT_FALSE(result.m_falseLiftoff);
+    TEST_ASSERT_TRUE(result.m_liftoffLatency > 0.0f && result.m_liftoffLatency < 0.5f);
+    TEST_ASSERT_TRUE(result.m_landingDetected);
+    TEST_ASSERT_TRUE(result.m_samples > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, result.m_samplesLost);
+}
+
+void SimReplay_DetectorSettings()
+{
+    // Nothing pushes that hard, it never leaves Idle
+    ReplaySettings settings = GetDefaultReplaySettings();
+    settings.m_detector.m_liftoffAcceleration = 1000.0f;
+
+    SimFlight flight(GetDefaultFlightProfile());
+    const ReplayResult result = SimReplay::Fly(&flight, settings);
+    TEST_ASSERT_TRUE(result.m_initialized);
+    TEST_ASSERT_FALSE(result.m_liftoffDetected);
+    TEST_ASSERT_FALSE(result.m_landingDetected);
+    TEST_ASSERT_EQUAL_UINT32(0, result.m_samples);
+}
+
+void SimReplay_LogEvents()
+{
+    // A log cut 10m above the pad while descending at 5m/s, 10 rows per second
+    char path[] = "/tmp/RLoggerReplayXXXXXX";
+    const int fd = mkstemp(path);
+    TEST_ASSERT_TRUE(fd >= 0);
+    FILE* file = fdopen(fd, "w");
+    fprintf(file, "TIME, ALTITUDE, TEMP, TEMP_AGE, ACCEL_X, ACCEL_Y, ACCEL_Z, RATE_X, RATE_Y, RATE_Z \n");
+    for(int row = 0; row <= 40; ++row)
+    {
+        const float time = 2.0f + row * 0.1f;
+        const float altitude = row < 10 ? 100.0f : (row < 20 ? 100.0f + (row - 10) * 5.0f : 150.0f - (row - 20) * 2.0f);
+        const float accel = row >= 10 && row < 13 ? 5.0f : 1.0f;
+        fprintf(file, "%.2f,%.2f,15.00,0.00,0.00,%.2f,0.00,0.00,0.00,0.00\n", time, altitude, accel);
+    }
+    fprintf(file, "# SAMPLES=41\n");
+    fclose(file);
+
+    SimLogReplay log;
+    TEST_ASSERT_TRUE(log.Load(path, 5.0f, 10.0f));
+    remove(path);
+
+    // The first row is held for the pad time, the descent goes on to the pad (at 20m/s)
+    TEST_ASSERT_EQUAL_UINT32(1 + 41 + 1, log.GetNumRows());
+
+    SimFlightEvents events;
+    log.GetEvents(events);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 6.0f, events.m_liftoffTime);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 7.0f, events.m_apogeeTime);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 9.0f + 10.0f / 20.0f, events.m_landingTime);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 19.5f, events.m_endTime);
+
+    SimPhysics physics;
+    log.GetPhysics(6150000, physics);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 5.0f * 9.80665f, physics.m_acceleration.y);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 15.0f, physics.m_temperature);
+}
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(SimReplay_SyntheticFlight);
+        RUN_TEST(SimReplay_DetectorSettings);
+        RUN_TEST(SimReplay_LogEvents);
+    }
+    UNITY_END();
+}
+
+int main()
+{
+    RunTests();
+    return 0;
+}
@@ -0,0 +1,260 @@
+#include <unity.h>
+
+#include "HAL.h"
+#include "Sim/SimBoard.h"
+#include "Sim/SimFlight.h"
+#include "Sensors/MS5611/MS5611.h"
+#include "Sensors/BMI160/BMI160.h"
+#include "Storage/MB85RS2MTA/MB85RS2MTA.h"
+#include "Storage/SD/SDCard.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Host only, the drivers talk to the simulated devices through the native HAL (see SimBoard)
+
+void SimSensors_BarometerPoll()
+{
+    SimFlight flight(GetDefaultFlightProfile());
+    SimBoard board(&flight);
+
+    MS5611 baro;
+    TEST_ASSERT_TRUE(baro.Init(&Wire, SimBoard::k_baroAddress));
+
+    // Poll never waits for the ADC, the sequence only moves on once the conversion time has passed
+    uint32_t numPolls = 0;
+    while(!baro.Poll())
+    {
+        SimClock::Advance(100);
+        ++numPolls;
+    }
+    TEST_ASSERT_GREATER_THAN(10, numPolls);
+    TEST_ASSERT_EQUAL_UINT32(3, board.GetBaro().GetNumConversions()); // D1, D2 and the next D1 already running
+
+    // Still on the pad
+    SimPhysics physics;
+    flight.GetPhysics(SimClock::GetTime(), physics);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, physics.m_pressure * 0.01f, baro.GetLastPressure());
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, physics.m_temperature, baro.GetLastTemperature());
+}
+
+// Main loop period with the barometer read in every iteration, the rest of the loop takes otherWork us
+static uint32_t GetLoopPeriod(bool poll, uint32_t numIterations, uint32_t otherWork, uint32_t& numPressures)
+{
+    SimFlight flight(GetDefaultFlightProfile());
+    SimBoard board(&flight);
+
+    MS5611 baro;
+    TEST_ASSERT_TRUE(baro.Init(&Wire, SimBoard::k_baroAddress));
+
+    numPressures = 0;
+    const uint64_t start = SimClock::GetTime();
+    for(uint32_t iteration = 0; iteration < numIterations; ++iteration)
+    {
+        float pressure = 0.0f;
+        if(poll ? baro.Poll() : baro.ReadPressure(pressure))
+        {
+            ++numPressures;
+        }
+        SimClock::Advance(otherWork);
+    }
+    return (uint32_t)((SimClock::GetTime() - start) / numIterations);
+}
+
+void SimSensors_BarometerLoopPeriod()
+{
+    // The blocking read waits out both conversions in every iteration, polling hides them behind the other work
+    const uint32_t numIterations = 200;
+    const uint32_t otherWork = 500;
+    uint32_t blockingPressures = 0;
+    uint32_t pollPressures = 0;
+    const uint32_t blockingPeriod = GetLoopPeriod(false, numIterations, otherWork, blockingPressures);
+    const uint32_t pollPeriod = GetLoopPeriod(true, numIterations, otherWork, pollPressures);
+
+    TEST_ASSERT_EQUAL_UINT32(numIterations, blockingPressures);
+    TEST_ASSERT_GREATER_THAN(0, pollPressures);
+    TEST_ASSERT_LESS_THAN(blockingPeriod, pollPeriod);
+    TEST_ASSERT_LESS_THAN(otherWork * 2, pollPeriod);
+}
+
+void SimSensors_BarometerDecimation()
+{
+    SimFlight flight(GetDefaultFlightProfile());
+    SimBoard board(&flight);
+
+    MS5611 baro;
+    TEST_ASSERT_TRUE(baro.Init(&Wire, SimBoard::k_baroAddress));
+    baro.SetTemperatureDecimation(4);
+
+    uint32_t numPressures = 0;
+    while(numPressures < 8)
+    {
+        if(baro.Poll())
+        {
+            ++numPressures;
+        }
+        SimClock::Advance(100);
+    }
+
+    // 8 pressures and 2 temperatures, plus the pressure conversion started after the last one
+    TEST_ASSERT_EQUAL_UINT32(11, board.GetBaro().GetNumConversions());
+}
+
+void SimSensors_IMUSample()
+{
+    SimFlight flight(GetDefaultFlightProfile());
+    SimBoard board(&flight);
+
+    BMI160 imu;
+    TEST_ASSERT_TRUE(imu.Init(&Wire));
+    imu.Configure(AccODR::ODR_400_HZ, AccRange::RANGE_2_G, GyrODR::ODR_400_HZ, GyrRange::RANGE_2000_DPS);
+    SimClock::Advance(10000);
+
+    // One register write and one burst read
+    Wire.ResetStats();
+    IMUSample sample;
+    TEST_ASSERT_TRUE(imu.ReadSample(sample));
+    TEST_ASSERT_EQUAL_UINT32(2, Wire.GetStats().m_transactions);
+    TEST_ASSERT_TRUE(sample.m_sensorTime != 0);
+
+    // At rest: 1G up and the profile spin on y
+    Vec3 acceleration;
+    Vec3 angularRate;
+    imu.ConvertSample(sample, acceleration, angularRate);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, acceleration.x);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, acceleration.y);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, acceleration.z);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 0.0f, angularRate.y);
+}
+
+void SimSensors_FRAMAppend()
+{
+    SimFlight flight(GetDefaultFlightProfile());
+    SimBoard board(&flight);
+
+    pinMode(SimBoard::k_framChipSelect, OUTPUT);
+    digitalWrite(SimBoard::k_framChipSelect, HIGH);
+
+    MB85RS2MTA fram;
+    TEST_ASSERT_TRUE(fram.Init(SimBoard::k_framChipSelect, &SPI));
+
+    uint8_t data[64];
+    for(uint32_t i = 0; i < sizeof(data); ++i)
+    {
+        data[i] = (uint8_t)(i * 7u);
+    }
+
+    // The appends are buffered and go out as a single WREN + WRITE once the write buffer fills up
+    const uint32_t start = 1000;
+    SPI.ResetStats();
+    fram.BeginAppend(start);
+    fram.Append(data, 20);
+    fram.Append(data + 20, 44);
+    fram.Flush();
+    TEST_ASSERT_EQUAL_UINT32(start + sizeof(data), fram.GetAppendAddress());
+    TEST_ASSERT_EQUAL_UINT32(2, SPI.GetStats().m_transactions);
+    TEST_ASSERT_EQUAL_UINT32(1 + 4 + sizeof(data), SPI.GetStats().m_bytes);
+    TEST_ASSERT_EQUAL_UINT32(0, board.GetFRAM().GetRejectedWrites());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, board.GetFRAM().GetData() + start, sizeof(data));
+
+    // Every write needs its own WREN, the latch doesn't survive the previous one
+    fram.Write(100, 0x5A);
+    fram.Write(101, 0xA5);
+    TEST_ASSERT_EQUAL_UINT32(0, board.GetFRAM().GetRejectedWrites());
+    TEST_ASSERT_EQUAL_UINT8(0x5A, fram.Read(100));
+    TEST_ASSERT_EQUAL_UINT8(0xA5, fram.Read(101));
+
+    uint8_t readBack[64];
+    fram.FastRead(start, readBack, sizeof(readBack));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, readBack, sizeof(readBack));
+
+    // Past the 16 bit transfer count of the AVR SPI, the read still goes out as one transaction
+    const uint32_t longSize = 100000;
+    uint8_t* longRead = new uint8_t[longSize];
+    SPI.ResetStats();
+    fram.Read(0, longRead, longSize);
+    TEST_ASSERT_EQUAL_UINT32(1, SPI.GetStats().m_transactions);
+    TEST_ASSERT_EQUAL_UINT32(4 + longSize, SPI.GetStats().m_bytes);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(board.GetFRAM().GetData(), longRead, longSize);
+    delete[] longRead;
+}
+
+void SimSensors_SDContiguous()
+{
+    char sdRoot[] = "/tmp/RLoggerSDXXXXXX";
+    TEST_ASSERT_TRUE(mkdtemp(sdRoot) != nullptr);
+
+    SimFlight flight(GetDefaultFlightProfile());
+    SimBoard board(&flight, sdRoot);
+
+    SDCard sd;
+    TEST_ASSERT_TRUE(sd.Init(SimBoard::k_sdChipSelect));
+
+    // Two and a bit sectors, in small prints
+    char expected[1100];
+    for(uint16_t lineIdx = 0; lineIdx < 100; ++lineIdx)
+    {
+        snprintf(expected + lineIdx * 11, 12, "line %05u\n", lineIdx);
+    }
+
+    const uint64_t spiStart = SimTiming::GetTotals().m_time[(uint8_t)SimCost::SPI];
+    Print* file = sd.CreateContiguousFile("A.csv", 4096);
+    TEST_ASSERT_TRUE(file != nullptr);
+    TEST_ASSERT_TRUE(sd.CreateContiguousFile("B.csv", 4096) == nullptr); // One file at a time
+    file->print(expected);
+    TEST_ASSERT_EQUAL_UINT32(1100, sd.CloseFile());
+
+    // Three blocks of 512 bytes at 8MHz, each with the per byte loop and the time the card is busy
+    const SimTimingConfig& config = SimTiming::GetConfig();
+    const uint64_t blockTime = 512u + 512u * config.m_spiByteCycles / 16u + config.m_sdStreamBlockBusy;
+    const uint64_t spiTime = SimTiming::GetTotals().m_time[(uint8_t)SimCost::SPI] - spiStart;
+    TEST_ASSERT_TRUE(spiTime == 3u * blockTime + config.m_sdBlockBusy);
+
+    // Trimmed to what was written
+    char path[64];
+    snprintf(path, sizeof(path), "%s/A.csv", sdRoot);
+    FILE* diskFile = fopen(path, "rb");
+    TEST_ASSERT_TRUE(diskFile != nullptr);
+    char text[2048];
+    const size_t size = fread(text, 1, sizeof(text), diskFile);
+    fclose(diskFile);
+    TEST_ASSERT_EQUAL_UINT32(1100, size);
+    TEST_ASSERT_TRUE(memcmp(expected, text, size) == 0);
+
+    // An existing file gets replaced, more than the preallocated size is an error
+    file = sd.CreateContiguousFile("A.csv", 100);
+    TEST_ASSERT_TRUE(file != nullptr);
+    TEST_ASSERT_EQUAL_UINT32(100, file->write((const uint8_t*)expected, 100));
+    TEST_ASSERT_EQUAL_UINT32(100, sd.CloseFile());
+    TEST_ASSERT_TRUE(sd.FileExists("A.csv"));
+
+    file = sd.CreateContiguousFile("A.csv", 100);
+    TEST_ASSERT_TRUE(file != nullptr);
+    file->write((const uint8_t*)expected, 1100);
+    TEST_ASSERT_TRUE(sd.CloseFile() < 1100u);
+
+    remove(path);
+    rmdir(sdRoot);
+}
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(SimSensors_BarometerPoll);
+        RUN_TEST(SimSensors_BarometerLoopPeriod);
+        RUN_TEST(SimSensors_BarometerDecimation);
+        RUN_TEST(SimSensors_IMUSample);
+        RUN_TEST(SimSensors_FRAMAppend);
+        RUN_TEST(SimSensors_SDContiguous);
+    }
+    UNITY_END();
+}
+
+int main()
+{
+    RunTests();
+    return 0;
+}
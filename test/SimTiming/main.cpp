@@ -0,0 +1,96 @@
+#include <unity.h>
+
+#include "HAL.h"
+#include "HALCost.h"
+#include "Sim/SimBoard.h"
+#include "Sim/SimFlight.h"
+#include "Sim/SimLoopTiming.h"
+
+// Host only, checks the timing model of the native HAL (SimTiming) and the loop time it predicts
+
+void SimTiming_Delay()
+{
+    SimFlight flight(GetDefaultFlightProfile());
+    SimBoard board(&flight);
+
+    const uint64_t start = SimClock::GetTime();
+    delay(3);
+    delayMicroseconds(250);
+    TEST_ASSERT_TRUE(SimClock::GetTime() - start == 3250u);
+    TEST_ASSERT_TRUE(SimTiming::GetTotals().m_time[(uint8_t)SimCost::Delay] == 3250u);
+}
+
+void SimTiming_MathOps()
+{
+    SimFlight flight(GetDefaultFlightProfile());
+    SimBoard board(&flight);
+
+    SimTimingConfig config = GetDefaultTimingConfig();
+    config.m_opCycles[(uint8_t)SimOp::FloatDiv] = 400; // 25us at 16MHz
+    SimTiming::SetConfig(config);
+
+    const uint64_t start = SimClock::GetTime();
+    HAL_COST(FloatDiv, 4);
+    TEST_ASSERT_TRUE(SimClock::GetTime() - start == 100u);
+    TEST_ASSERT_EQUAL_UINT32(4, SimTiming::GetTotals().m_ops[(uint8_t)SimOp::FloatDiv]);
+    TEST_ASSERT_TRUE(SimTiming::GetTotals().m_time[(uint8_t)SimCost::Math] == 100u);
+
+    // Less than a us per call still adds up
+    for(int callIdx = 0; callIdx < 16; ++callIdx)
+    {
+        SimTiming::ChargeCycles(SimCost::Code, 1);
+    }
+    TEST_ASSERT_TRUE(SimTiming::GetTotals().m_time[(uint8_t)SimCost::Code] == 1u);
+
+    SimTiming::SetConfig(GetDefaultTimingConfig());
+}
+
+void SimTiming_SPIClockCap()
+{
+    SimFlight flight(GetDefaultFlightProfile());
+    SimBoard board(&flight);
+
+    // Asking for 20MHz gets the 8MHz of the AVR: 64 bytes are 64us of clocks plus the per byte loop
+    SPI.begin();
+    SPI.beginTransaction(SPISettings(20000000, MSBFIRST, SPI_MODE0));
+    for(int byteIdx = 0; byteIdx < 64; ++byteIdx)
+    {
+        SPI.transfer(0);
+    }
+    SPI.endTransaction();
+
+    const uint64_t expected = 64u + 64u * GetDefaultTimingConfig().m_spiByteCycles / 16u;
+    TEST_ASSERT_TRUE(SimTiming::GetTotals().m_time[(uint8_t)SimCost::SPI] == expected);
+}
+
+void SimTiming_LoopFits()
+{
+    SimFlight flight(GetDefaultFlightProfile());
+
+    LoopTimingReport report;
+    TEST_ASSERT_TRUE(SimLoopTiming::Measure(&flight, 100, RecordFormat::Compressed, 0, report));
+    TEST_ASSERT_GREATER_THAN(500, report.m_iterations);
+    TEST_ASSERT_EQUAL_UINT32(0, report.m_overruns);
+    TEST_ASSERT_TRUE(report.m_worstBusy < report.m_period);
+
+    // The barometer reads at 100kHz take most of it
+    TEST_ASSERT_TRUE(report.m_total[(uint8_t)SimCost::I2C] > report.m_total[(uint8_t)SimCost::Math]);
+}
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(SimTiming_Delay);
+        RUN_TEST(SimTiming_MathOps);
+        RUN_TEST(SimTiming_SPIClockCap);
+        RUN_TEST(SimTiming_LoopFits);
+    }
+    UNITY_END();
+}
+
+int main()
+{
+    RunTests();
+    return 0;
+}
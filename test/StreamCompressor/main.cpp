@@ -0,0 +1,172 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+
+#include "BitStream.h"
+#include "Logger/StreamCompressor.h"
+
+#include <math.h>
+#include <string.h>
+
+static const uint16_t k_numSamples = 600;
+static const uint8_t k_maxBlocks = 40;
+
+// Smooth flight-like signals with some noise and a few steps
+void MakeChannels(uint16_t sampleIdx, int32_t* channels)
+{
+    const float t = sampleIdx * 0.01f;
+    const int32_t noise = (int32_t)((sampleIdx * 7919u) % 13u) - 6;
+    channels[(uint8_t)PackedChannel::TimeDelta] = 10 + (sampleIdx % 17 == 0 ? 1 : 0);
+    channels[(uint8_t)PackedChannel::Altitude] = (int32_t)(5000.0f * t * t) + noise;
+    channels[(uint8_t)PackedChannel::Temperature] = 2150 - sampleIdx / 50;
+    channels[(uint8_t)PackedChannel::TemperatureAge] = sampleIdx % 8;
+    channels[(uint8_t)PackedChannel::AccelX] = (int32_t)(2000.0f * sinf(t)) + noise;
+    channels[(uint8_t)PackedChannel::AccelY] = sampleIdx < 300 ? 30000 : -2000 + noise; // Burnout step
+    channels[(uint8_t)PackedChannel::AccelZ] = noise;
+    channels[(uint8_t)PackedChannel::RateX] = (int32_t)(500.0f * cosf(t * 3.0f));
+    channels[(uint8_t)PackedChannel::RateY] = sampleIdx == 200 ? -32768 : noise; // Spike, forces the escape code
+    channels[(uint8_t)PackedChannel::RateZ] = 32767;
+}
+
+void StreamCompressor_RoundTrip()
+{
+    static uint8_t blocks[k_maxBlocks][k_compressedBlockSize];
+    uint8_t numBlocks = 0;
+
+    StreamCompressor compressor;
+    int32_t channels[k_numPackedChannels];
+    for(uint16_t sampleIdx = 0; sampleIdx < k_numSamples; ++sampleIdx)
+    {
+        MakeChannels(sampleIdx, channels);
+        if(!compressor.Add(channels))
+        {
+            memcpy(blocks[numBlocks++], compressor.GetBlock(), k_compressedBlockSize);
+            compressor.Reset();
+            TEST_ASSERT_TRUE(compressor.Add(channels));
+        }
+    }
+    memcpy(blocks[numBlocks++], compressor.GetBlock(), k_compressedBlockSize);
+
+    // Must beat the packed format
+    TEST_ASSERT_LESS_THAN((uint32_t)k_numSamples * k_packedRecordSize, (uint32_t)numBlocks * k_compressedBlockSize);
+
+    StreamDecompressor decompressor;
+    int32_t expected[k_numPackedChannels];
+    uint16_t sampleIdx = 0;
+    for(uint8_t blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+    {
+        decompressor.BeginBlock(blocks[blockIdx]);
+        while(decompressor.Next(channels))
+        {
+            MakeChannels(sampleIdx++, expected);
+            for(uint8_t channel = 0; channel < k_numPackedChannels; ++channel)
+            {
+                TEST_ASSERT_EQUAL_INT32(expected[channel], channels[channel]);
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT16(k_numSamples, sampleIdx);
+}
+
+void StreamCompressor_BlockIsIndependent()
+{
+    StreamCompressor compressor;
+    int32_t channels[k_numPackedChannels];
+    uint16_t sampleIdx = 0;
+    for(; sampleIdx < k_numSamples; ++sampleIdx)
+    {
+        MakeChannels(sampleIdx, channels);
+        if(!compressor.Add(channels))
+        {
+            break;
+        }
+    }
+
+    // Start over from the record that didn't fit, the new block decodes without the previous one
+    const uint16_t firstSample = sampleIdx;
+    compressor.Reset();
+    for(; sampleIdx < firstSample + 20; ++sampleIdx)
+    {
+        MakeChannels(sampleIdx, channels);
+        TEST_ASSERT_TRUE(compressor.Add(channels));
+    }
+
+    StreamDecompressor decompressor;
+    decompressor.BeginBlock(compressor.GetBlock());
+    TEST_ASSERT_EQUAL_UINT8(20, decompressor.GetNumRecords());
+
+    int32_t expected[k_numPackedChannels];
+    for(uint16_t idx = firstSample; decompressor.Next(channels); ++idx)
+    {
+        MakeChannels(idx, expected);
+        TEST_ASSERT_EQUAL_INT32(expected[(uint8_t)PackedChannel::Altitude], channels[(uint8_t)PackedChannel::Altitude]);
+        TEST_ASSERT_EQUAL_INT32(expected[(uint8_t)PackedChannel::RateX], channels[(uint8_t)PackedChannel::RateX]);
+    }
+}
+
+void StreamCompressor_WorstCase()
+{
+    // Every channel jumping between its extremes needs the escape code, the block must still round trip
+    StreamCompressor compressor;
+    int32_t channels[k_numPackedChannels];
+    uint8_t numRecords = 0;
+    for(uint8_t sampleIdx = 0; ; ++sampleIdx)
+    {
+        for(uint8_t channel = 0; channel < k_numPackedChannels; ++channel)
+        {
+            const uint8_t bits = k_packedChannelBits[channel];
+            if(k_packedChannelSigned[channel])
+            {
+                channels[channel] = sampleIdx % 2 ? GetSignedMax(bits) : GetSignedMin(bits);
+            }
+            else
+            {
+                channels[channel] = sampleIdx % 2 ? (int32_t)((1ul << bits) - 1ul) : 0;
+            }
+        }
+        if(!compressor.Add(channels))
+        {
+            break;
+        }
+        ++numRecords;
+    }
+    TEST_ASSERT_GREATER_THAN(1, numRecords);
+
+    StreamDecompressor decompressor;
+    decompressor.BeginBlock(compressor.GetBlock());
+    uint8_t decoded = 0;
+    while(decompressor.Next(channels))
+    {
+        TEST_ASSERT_EQUAL_INT32(decoded % 2 ? GetSignedMax(24) : GetSignedMin(24), channels[(uint8_t)PackedChannel::Altitude]);
+        ++decoded;
+    }
+    TEST_ASSERT_EQUAL_UINT8(numRecords, decoded);
+}
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(StreamCompressor_RoundTrip);
+        RUN_TEST(StreamCompressor_BlockIsIndependent);
+        RUN_TEST(StreamCompressor_WorstCase);
+    }
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup()
+{
+    delay(2000);
+    RunTests();
+}
+
+void loop() { }
+#else
+int main()
+{
+    RunTests();
+    return 0;
+}
+#endif
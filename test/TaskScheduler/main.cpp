@@ -0,0 +1,199 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+
+#include "RMath.h"
+#include "TaskScheduler.h"
+#include "Logger/LoggerDefinitions.h"
+
+// Virtual clock, tasks advance it by their execution time
+static uint32_t g_now = 0;
+
+static uint32_t GetTime()
+{
+    return g_now;
+}
+
+struct SimTask
+{
+    uint32_t m_cost; // us
+    uint32_t m_runs;
+};
+
+static void RunSimTask(void* context)
+{
+    SimTask* task = (SimTask*)context;
+    g_now += task->m_cost;
+    ++task->m_runs;
+}
+
+// Runs the scheduler for 'duration' us, idle iterations cost 'idleCost' us
+static void Simulate(TaskScheduler& scheduler, uint32_t duration, uint32_t idleCost = 8)
+{
+    const uint32_t end = g_now + duration;
+    while((int32_t)(end - g_now) > 0)
+    {
+        if(!scheduler.RunNext())
+        {
+            g_now += idleCost;
+        }
+    }
+}
+
+void TaskScheduler_EarliestDeadlineFirst()
+{
+    g_now = 0;
+    SimTask slow = { 500, 0 };
+    SimTask urgent = { 100, 0 };
+
+    TaskScheduler scheduler(GetTime);
+    scheduler.AddTask("SLOW", RunSimTask, &slow, 10000);
+    scheduler.AddTask("URGENT", RunSimTask, &urgent, 10000, 200);
+    scheduler.Start();
+
+    // Both are released, the one with the earliest deadline goes first
+    TEST_ASSERT_TRUE(scheduler.RunNext());
+    TEST_ASSERT_EQUAL_UINT32(1, urgent.m_runs);
+    TEST_ASSERT_EQUAL_UINT32(0, slow.m_runs);
+    TEST_ASSERT_TRUE(scheduler.RunNext());
+    TEST_ASSERT_EQUAL_UINT32(1, slow.m_runs);
+    TEST_ASSERT_FALSE(scheduler.RunNext());
+
+    TEST_ASSERT_EQUAL_UINT32(100, scheduler.GetWorstExecution(1));
+    TEST_ASSERT_EQUAL_UINT32(500, scheduler.GetWorstExecution(0));
+#ifdef PROFILER_ENABLED
+    TEST_ASSERT_EQUAL_UINT32(600, scheduler.GetStats(0).m_worstResponse);
+#endif
+}
+
+void TaskScheduler_DetectsMisses()
+{
+    g_now = 0;
+    SimTask hog = { 3000, 0 };
+    SimTask task = { 100, 0 };
+
+    TaskScheduler scheduler(GetTime);
+    scheduler.AddTask("HOG", RunSimTask, &hog, 10000);
+    scheduler.AddTask("TASK", RunSimTask, &task, 1000);
+    scheduler.SetTimeBase(1);
+    scheduler.Start();
+
+    Simulate(scheduler, 100000);
+
+    // The hog blocks the short task past its deadline (no preemption)
+    TEST_ASSERT_TRUE(scheduler.GetDeadlineMisses() > 0);
+    TEST_ASSERT_TRUE(scheduler.GetTimeBaseStats().m_overruns > 0);
+#ifdef PROFILER_ENABLED
+    TEST_ASSERT_EQUAL_UINT32(scheduler.GetDeadlineMisses(), scheduler.GetStats(1).m_deadlineMisses);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.GetStats(0).m_deadlineMisses);
+#endif
+}
+
+void TaskScheduler_DisabledTasks()
+{
+    g_now = 0;
+    SimTask task = { 100, 0 };
+
+    TaskScheduler scheduler(GetTime);
+    scheduler.AddTask("TASK", RunSimTask, &task, 1000);
+    scheduler.Start();
+    scheduler.SetEnabled(0, false);
+
+    Simulate(scheduler, 10000);
+    TEST_ASSERT_EQUAL_UINT32(0, task.m_runs);
+
+    // The time base kept going while disabled
+    scheduler.SetEnabled(0, true);
+    Simulate(scheduler, 1000);
+    TEST_ASSERT_EQUAL_UINT32(1, task.m_runs);
+    TEST_ASSERT_EQUAL_UINT32(10, scheduler.GetTimer(0).GetTime());
+}
+
+// LoggerApp task set while Active, every task takes its worst case every time.
+// Execution times are the estimates for a 16MHz AVR with I2C at 100kHz:
+//  - Baro: ADC read and next conversion command (8 bytes) plus the compensation math
+//  - Sample: IMU burst read (18 bytes)
+//  - Record: quantize and rice code a record, plus writing a compressed block
+//  - Detector: median filter and vector length
+//  - Flush: 64 bytes of SPI
+static SimTask g_loggerTasks[k_numLoggerTasks];
+
+static void SimulateLoggerTasks(uint32_t samplesPerSecond, TaskScheduler& scheduler)
+{
+    g_loggerTasks[(uint8_t)LoggerTask::Baro] = { 1100, 0 };
+    g_loggerTasks[(uint8_t)LoggerTask::Sample] = { 2000, 0 };
+    g_loggerTasks[(uint8_t)LoggerTask::Record] = { 1000, 0 };
+    g_loggerTasks[(uint8_t)LoggerTask::Detector] = { 300, 0 };
+    g_loggerTasks[(uint8_t)LoggerTask::Flush] = { 250, 0 };
+    g_loggerTasks[(uint8_t)LoggerTask::Dump] = { 0, 0 };
+
+    const uint32_t period = 1000000u / samplesPerSecond;
+    scheduler.AddTask("BARO", RunSimTask, &g_loggerTasks[(uint8_t)LoggerTask::Baro], k_baroTaskPeriod);
+    scheduler.AddTask("SAMPLE", RunSimTask, &g_loggerTasks[(uint8_t)LoggerTask::Sample], period, GetSampleTaskDeadline(period));
+    scheduler.AddTask("RECORD", RunSimTask, &g_loggerTasks[(uint8_t)LoggerTask::Record], period, GetSampleTaskDeadline(period));
+    scheduler.AddTask("DETECTOR", RunSimTask, &g_loggerTasks[(uint8_t)LoggerTask::Detector], period, GetDetectorTaskDeadline(period));
+    scheduler.AddTask("FLUSH", RunSimTask, &g_loggerTasks[(uint8_t)LoggerTask::Flush], k_flushTaskPeriod);
+    scheduler.AddTask("DUMP", RunSimTask, &g_loggerTasks[(uint8_t)LoggerTask::Dump], k_dumpTaskPeriod);
+    scheduler.SetEnabled((uint8_t)LoggerTask::Dump, false);
+    scheduler.SetTimeBase((uint8_t)LoggerTask::Sample);
+
+    // All released together at the start, the worst case for a non preemptive scheduler
+    scheduler.Start();
+    Simulate(scheduler, 60000000u);
+}
+
+void TaskScheduler_LoggerWorstCase()
+{
+    g_now = 0;
+    TaskScheduler scheduler(GetTime);
+    SimulateLoggerTasks(100, scheduler);
+
+    TEST_ASSERT_EQUAL_UINT32(6000, g_loggerTasks[(uint8_t)LoggerTask::Sample].m_runs);
+    TEST_ASSERT_EQUAL_UINT32(6000, scheduler.GetTimeBaseStats().m_ticks);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.GetTimeBaseStats().m_overruns);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.GetDeadlineMisses());
+    TEST_ASSERT_EQUAL_UINT32(2000, scheduler.GetWorstExecution((uint8_t)LoggerTask::Sample));
+#ifdef PROFILER_ENABLED
+    TEST_ASSERT_EQUAL_UINT32(6000, scheduler.GetStats((uint8_t)LoggerTask::Sample).m_runs);
+#endif
+}
+
+void TaskScheduler_LoggerOverload()
+{
+    // Way past what the bus can do, the misses have to show up in the stats
+    g_now = 0;
+    TaskScheduler scheduler(GetTime);
+    SimulateLoggerTasks(400, scheduler);
+
+    TEST_ASSERT_TRUE(scheduler.GetDeadlineMisses() > 0);
+}
+
+void RunTests()
+{
+    UNITY_BEGIN();
+    {
+        RUN_TEST(TaskScheduler_EarliestDeadlineFirst);
+        RUN_TEST(TaskScheduler_DetectsMisses);
+        RUN_TEST(TaskScheduler_DisabledTasks);
+        RUN_TEST(TaskScheduler_LoggerWorstCase);
+        RUN_TEST(TaskScheduler_LoggerOverload);
+    }
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup()
+{
+    delay(2000);
+    RunTests();
+}
+
+void loop() { }
+#else
+int main()
+{
+    RunTests();
+    return 0;
+}
+#endif